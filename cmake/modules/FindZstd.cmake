@@ -0,0 +1,20 @@
+# Filename: FindZstd.cmake
+# Authors: agent (16 Oct, 2026)
+#
+# Usage:
+#   find_package(Zstd [REQUIRED] [QUIET])
+#
+# Once done this will define:
+#   ZSTD_FOUND       - system has Zstandard
+#   ZSTD_INCLUDE_DIR - the include directory containing zstd.h
+#   ZSTD_LIBRARY     - the path to the zstd library
+#
+
+find_path(ZSTD_INCLUDE_DIR NAMES "zstd.h")
+
+find_library(ZSTD_LIBRARY NAMES "zstd" "libzstd" "zstd_static" "libzstd_static")
+
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd DEFAULT_MSG ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
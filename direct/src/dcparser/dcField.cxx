@@ -14,6 +14,7 @@
 #include "dcField.h"
 #include "dcFile.h"
 #include "dcPacker.h"
+#include "dcFieldCodec.h"
 #include "dcClass.h"
 #include "hashGenerator.h"
 #include "dcmsgtypes.h"
@@ -23,7 +24,8 @@
  */
 DCField::
 DCField() :
-  _dclass(nullptr)
+  _dclass(nullptr),
+  _codec(nullptr)
 #ifdef WITHIN_PANDA
   ,
   _field_update_pcollector("DCField")
@@ -50,7 +52,8 @@ DCField() :
 DCField::
 DCField(const std::string &name, DCClass *dclass) :
   DCPackerInterface(name),
-  _dclass(dclass)
+  _dclass(dclass),
+  _codec(nullptr)
 #ifdef WITHIN_PANDA
   ,
   _field_update_pcollector(dclass->_class_update_pcollector, name)
@@ -71,11 +74,34 @@ DCField(const std::string &name, DCClass *dclass) :
   _has_fixed_structure = true;
 }
 
+/**
+ *
+ */
+DCField::
+DCField(const DCField &copy) :
+  DCPackerInterface(copy),
+  DCKeywordList(copy),
+  _dclass(copy._dclass),
+  _number(copy._number),
+  _default_value_stale(copy._default_value_stale),
+  _has_default_value(copy._has_default_value),
+  _bogus_field(copy._bogus_field),
+  _default_value(copy._default_value),
+  _codec(nullptr)
+#ifdef WITHIN_PANDA
+  ,
+  _field_update_pcollector(copy._field_update_pcollector)
+#endif
+{
+  // The codec is not shared with the copy; it may be compiled again.
+}
+
 /**
  *
  */
 DCField::
 ~DCField() {
+  delete _codec;
 }
 
 /**
@@ -248,6 +274,17 @@ set_name(const std::string &name) {
   }
 }
 
+/**
+ * Builds (or rebuilds) the DCFieldCodec for this field, if the field is
+ * eligible for one.  This is normally called by DCFile::compile_codecs() once
+ * the file has been completely read.
+ */
+void DCField::
+compile_codec() {
+  delete _codec;
+  _codec = DCFieldCodec::make_codec(this);
+}
+
 /**
  * Recomputes the default value of the field by repacking it.
  */
@@ -30,6 +30,7 @@ class DCMolecularField;
 class DCParameter;
 class DCSwitch;
 class DCClass;
+class DCFieldCodec;
 class HashGenerator;
 
 /**
@@ -39,6 +40,7 @@ class EXPCL_DIRECT_DCPARSER DCField : public DCPackerInterface, public DCKeyword
 public:
   DCField();
   DCField(const std::string &name, DCClass *dclass);
+  DCField(const DCField &copy);
   virtual ~DCField();
 
 PUBLISHED:
@@ -63,6 +65,7 @@ PUBLISHED:
   INLINE const vector_uchar &get_default_value() const;
 
   INLINE bool is_bogus_field() const;
+  INLINE bool has_codec() const;
 
   INLINE bool is_required() const;
   INLINE bool is_broadcast() const;
@@ -100,6 +103,9 @@ public:
   INLINE void set_class(DCClass *dclass);
   INLINE void set_default_value(vector_uchar default_value);
 
+  void compile_codec();
+  INLINE const DCFieldCodec *get_codec() const;
+
 protected:
   void refresh_default_value();
 
@@ -112,6 +118,7 @@ protected:
 
 private:
   vector_uchar _default_value;
+  DCFieldCodec *_codec;
 
 #ifdef WITHIN_PANDA
   PStatCollector _field_update_pcollector;
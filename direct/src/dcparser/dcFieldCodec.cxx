@@ -0,0 +1,316 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcFieldCodec.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "dcFieldCodec.h"
+#include "dcField.h"
+#include "dcParameter.h"
+#include "dcSimpleParameter.h"
+#include <math.h>
+
+/**
+ *
+ */
+DCFieldCodec::
+DCFieldCodec() :
+  _byte_size(0),
+  _scalar(false)
+{
+}
+
+/**
+ * Builds a new codec for the indicated field, if the field is eligible, or
+ * returns NULL if it is not.  The caller is responsible for deleting the
+ * returned codec.
+ */
+DCFieldCodec *DCFieldCodec::
+make_codec(const DCField *field) {
+  if (field->is_bogus_field() || !field->has_fixed_byte_size()) {
+    return nullptr;
+  }
+
+  DCFieldCodec *codec = new DCFieldCodec;
+
+  bool okflag = true;
+  if (field->as_parameter() != nullptr) {
+    codec->_scalar = true;
+    okflag = codec->add_element(field);
+
+  } else {
+    // An atomic field's nested fields are its parameters; a molecular
+    // field's nested fields are the parameters of all of its atomic fields,
+    // in order.  Either way, the packed field is just these, end to end.
+    int num_nested_fields = field->get_num_nested_fields();
+    for (int i = 0; i < num_nested_fields && okflag; ++i) {
+      okflag = codec->add_element(field->get_nested_field(i));
+    }
+  }
+
+  if (!okflag || codec->_elements.empty() ||
+      codec->_byte_size != field->get_fixed_byte_size()) {
+    delete codec;
+    return nullptr;
+  }
+
+  return codec;
+}
+
+/**
+ * Packs the nth element of the field from a signed integer, the same way
+ * DCPacker::pack_int64() would.  Returns true on success, or false if the
+ * value is outside the range of the element, in which case the caller should
+ * pack the field with DCPacker instead to get the proper error reporting.
+ */
+bool DCFieldCodec::
+pack_int64(char *data, size_t n, int64_t value) const {
+  const Element &element = _elements[n];
+  char *p = data + element._offset;
+
+  int64_t int_value = value;
+  if (element._divisor != 1) {
+    int64_t divisor = (int64_t)element._divisor;
+    if (value > INT64_MAX / divisor || value < INT64_MIN / divisor) {
+      return false;
+    }
+    int_value = value * divisor;
+  }
+
+  if (element._opcode == OP_float64) {
+    DCPackerInterface::do_pack_float64(p, (double)int_value);
+    return true;
+  }
+  if (element._opcode == OP_uint64) {
+    if (int_value < 0) {
+      return false;
+    }
+    DCPackerInterface::do_pack_uint64(p, (uint64_t)int_value);
+    return true;
+  }
+  return store_int(element._opcode, p, int_value);
+}
+
+/**
+ * Packs the nth element of the field from an unsigned integer, the same way
+ * DCPacker::pack_uint64() would.  Returns true on success, or false if the
+ * value is outside the range of the element.
+ */
+bool DCFieldCodec::
+pack_uint64(char *data, size_t n, uint64_t value) const {
+  const Element &element = _elements[n];
+  char *p = data + element._offset;
+
+  uint64_t int_value = value;
+  if (element._divisor != 1) {
+    uint64_t divisor = (uint64_t)element._divisor;
+    if (value > UINT64_MAX / divisor) {
+      return false;
+    }
+    int_value = value * divisor;
+  }
+
+  if (element._opcode == OP_float64) {
+    DCPackerInterface::do_pack_float64(p, (double)int_value);
+    return true;
+  }
+  if (element._opcode == OP_uint64) {
+    DCPackerInterface::do_pack_uint64(p, int_value);
+    return true;
+  }
+  if (int_value > (uint64_t)INT64_MAX) {
+    return false;
+  }
+  return store_int(element._opcode, p, (int64_t)int_value);
+}
+
+/**
+ * Packs the nth element of the field from a floating-point number, the same
+ * way DCPacker::pack_double() would: the value is scaled by the divisor and,
+ * for an integer element, rounded to the nearest integer.  Returns true on
+ * success, or false if the value is outside the range of the element.
+ */
+bool DCFieldCodec::
+pack_double(char *data, size_t n, double value) const {
+  const Element &element = _elements[n];
+  char *p = data + element._offset;
+
+  double real_value = value * element._divisor;
+  if (element._opcode == OP_float64) {
+    DCPackerInterface::do_pack_float64(p, real_value);
+    return true;
+  }
+
+  real_value = floor(real_value + 0.5);
+
+  // These comparisons are written so that a NaN fails them.
+  if (element._opcode == OP_uint64) {
+    if (!(real_value >= 0.0 && real_value < 18446744073709551616.0)) {
+      return false;
+    }
+    DCPackerInterface::do_pack_uint64(p, (uint64_t)real_value);
+    return true;
+  }
+  if (!(real_value >= -9223372036854775808.0 &&
+        real_value < 9223372036854775808.0)) {
+    return false;
+  }
+  return store_int(element._opcode, p, (int64_t)real_value);
+}
+
+/**
+ * Appends the indicated field, which should be a parameter, to the end of the
+ * codec.  Returns true if it was added, or false if it is not something the
+ * codec can handle.
+ */
+bool DCFieldCodec::
+add_element(const DCPackerInterface *element) {
+  const DCField *field = element->as_field();
+  if (field == nullptr) {
+    return false;
+  }
+  const DCParameter *param = field->as_parameter();
+  if (param == nullptr) {
+    return false;
+  }
+  const DCSimpleParameter *simple = param->as_simple_parameter();
+  if (simple == nullptr) {
+    return false;
+  }
+
+  // Range limits and moduli are rare on fields that are sent often enough to
+  // matter, and getting their error reporting exactly right isn't worth
+  // duplicating here.
+  if (simple->has_range_limits() || simple->has_modulus()) {
+    return false;
+  }
+
+  Element elem;
+  size_t size;
+  switch (simple->get_type()) {
+  case ST_int8:
+    elem._opcode = OP_int8;
+    size = 1;
+    break;
+
+  case ST_int16:
+    elem._opcode = OP_int16;
+    size = 2;
+    break;
+
+  case ST_int32:
+    elem._opcode = OP_int32;
+    size = 4;
+    break;
+
+  case ST_int64:
+    elem._opcode = OP_int64;
+    size = 8;
+    break;
+
+  case ST_uint8:
+    elem._opcode = OP_uint8;
+    size = 1;
+    break;
+
+  case ST_uint16:
+    elem._opcode = OP_uint16;
+    size = 2;
+    break;
+
+  case ST_uint32:
+    elem._opcode = OP_uint32;
+    size = 4;
+    break;
+
+  case ST_uint64:
+    elem._opcode = OP_uint64;
+    size = 8;
+    break;
+
+  case ST_float64:
+    elem._opcode = OP_float64;
+    size = 8;
+    break;
+
+  default:
+    // Strings, blobs, and chars, which unpack to strings rather than numbers.
+    return false;
+  }
+
+  elem._pack_type = simple->get_pack_type();
+  elem._divisor = (unsigned int)simple->get_divisor();
+  elem._offset = _byte_size;
+  _elements.push_back(elem);
+  _byte_size += size;
+  return true;
+}
+
+/**
+ * Writes a single integer of the indicated type to the buffer, after checking
+ * that it fits.  Not valid for OP_float64 or OP_uint64.  Returns true on
+ * success, false if the value is out of range.
+ */
+bool DCFieldCodec::
+store_int(Opcode opcode, char *p, int64_t value) {
+  switch (opcode) {
+  case OP_int8:
+    if (value < -128 || value > 127) {
+      return false;
+    }
+    DCPackerInterface::do_pack_int8(p, (int)value);
+    return true;
+
+  case OP_int16:
+    if (value < -32768 || value > 32767) {
+      return false;
+    }
+    DCPackerInterface::do_pack_int16(p, (int)value);
+    return true;
+
+  case OP_int32:
+    if (value < INT32_MIN || value > INT32_MAX) {
+      return false;
+    }
+    DCPackerInterface::do_pack_int32(p, (int)value);
+    return true;
+
+  case OP_int64:
+    DCPackerInterface::do_pack_int64(p, value);
+    return true;
+
+  case OP_uint8:
+    if (value < 0 || value > 255) {
+      return false;
+    }
+    DCPackerInterface::do_pack_uint8(p, (unsigned int)value);
+    return true;
+
+  case OP_uint16:
+    if (value < 0 || value > 65535) {
+      return false;
+    }
+    DCPackerInterface::do_pack_uint16(p, (unsigned int)value);
+    return true;
+
+  case OP_uint32:
+    if (value < 0 || value > (int64_t)UINT32_MAX) {
+      return false;
+    }
+    DCPackerInterface::do_pack_uint32(p, (unsigned int)value);
+    return true;
+
+  case OP_uint64:
+  case OP_float64:
+    break;
+  }
+
+  return false;
+}
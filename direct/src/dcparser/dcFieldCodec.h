@@ -0,0 +1,88 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcFieldCodec.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef DCFIELDCODEC_H
+#define DCFIELDCODEC_H
+
+#include "dcbase.h"
+#include "dcPackerInterface.h"
+#include "dcSubatomicType.h"
+
+class DCField;
+
+/**
+ * A precompiled description of a field whose packed form has a fixed layout:
+ * a flat sequence of numeric elements at known byte offsets.  This is built
+ * once for each eligible field by DCFile::compile_codecs(), and allows the
+ * field's values to be read and written directly, without walking the field
+ * tree with DCPacker's push() and pop() for every element.
+ *
+ * Only fields made up entirely of simple numeric parameters (optionally with
+ * a divisor, but without range limits or a modulus) get a codec.  Everything
+ * else, including any value the codec can't represent exactly the way DCPacker
+ * would, is left to DCPacker.
+ */
+class EXPCL_DIRECT_DCPARSER DCFieldCodec {
+public:
+  enum Opcode {
+    OP_int8,
+    OP_int16,
+    OP_int32,
+    OP_int64,
+    OP_uint8,
+    OP_uint16,
+    OP_uint32,
+    OP_uint64,
+    OP_float64,
+  };
+
+  class Element {
+  public:
+    Opcode _opcode;
+    DCPackType _pack_type;
+    unsigned int _divisor;
+    size_t _offset;
+  };
+
+  static DCFieldCodec *make_codec(const DCField *field);
+
+  INLINE bool is_scalar() const;
+  INLINE size_t get_byte_size() const;
+  INLINE size_t get_num_elements() const;
+  INLINE const Element &get_element(size_t n) const;
+
+  INLINE int64_t unpack_int64(const char *data, size_t n) const;
+  INLINE uint64_t unpack_uint64(const char *data, size_t n) const;
+  INLINE double unpack_double(const char *data, size_t n) const;
+
+  bool pack_int64(char *data, size_t n, int64_t value) const;
+  bool pack_uint64(char *data, size_t n, uint64_t value) const;
+  bool pack_double(char *data, size_t n, double value) const;
+
+private:
+  DCFieldCodec();
+  bool add_element(const DCPackerInterface *element);
+
+  INLINE static int64_t load_int(Opcode opcode, const char *p);
+  static bool store_int(Opcode opcode, char *p, int64_t value);
+
+private:
+  typedef pvector<Element> Elements;
+  Elements _elements;
+  size_t _byte_size;
+  bool _scalar;
+};
+
+#include "dcFieldCodec.I"
+
+#endif
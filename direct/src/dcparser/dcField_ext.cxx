@@ -31,6 +31,12 @@ pack_args(DCPacker &packer, PyObject *sequence) const {
   nassertr(!packer.had_error(), false);
   nassertr(packer.get_current_field() == _this, false);
 
+  const DCFieldCodec *codec = _this->get_codec();
+  if (codec != nullptr &&
+      invoke_extension(&packer).pack_codec_object(codec, sequence)) {
+    return true;
+  }
+
   invoke_extension(&packer).pack_object(sequence);
   if (!packer.had_error()) {
     /*
@@ -97,6 +103,17 @@ unpack_args(DCPacker &packer) const {
   nassertr(!packer.had_error(), nullptr);
   nassertr(packer.get_current_field() == _this, nullptr);
 
+  const DCFieldCodec *codec = _this->get_codec();
+  if (codec != nullptr) {
+    PyObject *object = invoke_extension(&packer).unpack_codec_object(codec);
+    if (object != nullptr) {
+      return object;
+    }
+    if (PyErr_Occurred()) {
+      return nullptr;
+    }
+  }
+
   size_t start_byte = packer.get_num_unpacked_bytes();
   PyObject *object = invoke_extension(&packer).unpack_object();
 
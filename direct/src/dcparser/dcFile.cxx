@@ -172,7 +172,12 @@ read(std::istream &in, const string &filename) {
   dcyyparse();
   dc_cleanup_parser();
 
-  return (dc_error_count() == 0);
+  if (dc_error_count() != 0) {
+    return false;
+  }
+
+  compile_codecs();
+  return true;
 }
 
 /**
@@ -422,6 +427,21 @@ get_hash() const {
   return hashgen.get_hash();
 }
 
+/**
+ * Compiles a DCFieldCodec for each field in the file that is eligible for
+ * one.  This is done automatically when the file is read; it need only be
+ * called again if fields are added or changed after that.
+ */
+void DCFile::
+compile_codecs() {
+  FieldsByIndex::iterator fi;
+  for (fi = _fields_by_index.begin(); fi != _fields_by_index.end(); ++fi) {
+    if ((*fi) != nullptr) {
+      (*fi)->compile_codec();
+    }
+  }
+}
+
 /**
  * Accumulates the properties of this file into the hash.
  */
@@ -70,6 +70,8 @@ PUBLISHED:
 
   unsigned long get_hash() const;
 
+  void compile_codecs();
+
 public:
   void generate_hash(HashGenerator &hashgen) const;
   bool add_class(DCClass *dclass);
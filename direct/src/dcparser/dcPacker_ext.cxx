@@ -284,6 +284,121 @@ unpack_object() {
   return object;
 }
 
+/**
+ * Packs the Python object into the packer using the indicated codec, which
+ * must have been compiled for the current field.  This produces exactly the
+ * same bytes as pack_object(), but without walking the field.
+ *
+ * Returns true if the object was packed, or false if it was not, in which
+ * case nothing has been written and no Python exception is set; the caller
+ * should then fall back to pack_object(), which will also take care of
+ * reporting any error.
+ */
+bool Extension<DCPacker>::
+pack_codec_object(const DCFieldCodec *codec, PyObject *object) {
+  if (_this->_mode != DCPacker::Mode::M_pack ||
+      _this->_current_field == nullptr) {
+    return false;
+  }
+
+  // The fields that get a codec are small; we pack into a local buffer first
+  // so that nothing needs to be undone if an element turns out not to fit.
+  char local_buffer[256];
+  size_t byte_size = codec->get_byte_size();
+  if (byte_size > sizeof(local_buffer)) {
+    return false;
+  }
+
+  size_t num_elements = codec->get_num_elements();
+  bool okflag = true;
+
+  if (codec->is_scalar()) {
+    okflag = pack_codec_element(codec, local_buffer, 0, object);
+
+  } else if (PyTuple_Check(object)) {
+    if ((size_t)PyTuple_GET_SIZE(object) != num_elements) {
+      return false;
+    }
+    for (size_t i = 0; i < num_elements && okflag; ++i) {
+      okflag = pack_codec_element(codec, local_buffer, i,
+                                  PyTuple_GET_ITEM(object, i));
+    }
+
+  } else if (PyList_Check(object)) {
+    Py_BEGIN_CRITICAL_SECTION(object);
+    if ((size_t)PyList_GET_SIZE(object) != num_elements) {
+      okflag = false;
+    }
+    for (size_t i = 0; i < num_elements && okflag; ++i) {
+      okflag = pack_codec_element(codec, local_buffer, i,
+                                  PyList_GET_ITEM(object, i));
+    }
+    Py_END_CRITICAL_SECTION();
+
+  } else {
+    okflag = false;
+  }
+
+  if (!okflag) {
+    return false;
+  }
+
+  _this->_pack_data.append_data(local_buffer, byte_size);
+  _this->advance();
+  return true;
+}
+
+/**
+ * Unpacks the current field from the stream using the indicated codec, which
+ * must have been compiled for the current field, and returns it as a Python
+ * object: a number if the field is a single parameter, or a tuple of numbers
+ * otherwise.  This returns the same object unpack_object() would.
+ *
+ * Returns NULL if the field cannot be unpacked this way, for instance because
+ * the data is truncated; in this case nothing has been consumed and the
+ * caller should fall back to unpack_object().
+ */
+PyObject *Extension<DCPacker>::
+unpack_codec_object(const DCFieldCodec *codec) {
+  if (_this->_mode != DCPacker::Mode::M_unpack ||
+      _this->_current_field == nullptr) {
+    return nullptr;
+  }
+
+  size_t byte_size = codec->get_byte_size();
+  if (_this->_unpack_p + byte_size > _this->_unpack_length) {
+    return nullptr;
+  }
+
+  const char *data = _this->_unpack_data + _this->_unpack_p;
+  size_t num_elements = codec->get_num_elements();
+
+  PyObject *object;
+  if (codec->is_scalar()) {
+    object = unpack_codec_element(codec, data, 0);
+    if (object == nullptr) {
+      return nullptr;
+    }
+  } else {
+    object = PyTuple_New(num_elements);
+    if (object == nullptr) {
+      return nullptr;
+    }
+    for (size_t i = 0; i < num_elements; ++i) {
+      PyObject *item = unpack_codec_element(codec, data, i);
+      if (item == nullptr) {
+        Py_DECREF(object);
+        return nullptr;
+      }
+      PyTuple_SET_ITEM(object, i, item);
+    }
+  }
+
+  _this->_unpack_p += byte_size;
+  _this->advance();
+  return object;
+}
+
 /**
  * Given that the current element is a ClassParameter for a Python class
  * object, try to extract the appropriate values from the class object and
@@ -449,4 +564,81 @@ get_class_element(const DCClass *dclass, PyObject *object,
   }
 }
 
+/**
+ * Packs a single Python number into the nth element of the codec's buffer,
+ * converting it the same way pack_object() would.  Returns true on success,
+ * or false if the object is not a number or does not fit.
+ */
+bool Extension<DCPacker>::
+pack_codec_element(const DCFieldCodec *codec, char *buffer, size_t n,
+                   PyObject *item) {
+  const DCFieldCodec::Element &element = codec->get_element(n);
+
+  if (PyFloat_Check(item)) {
+    return codec->pack_double(buffer, n, PyFloat_AS_DOUBLE(item));
+  }
+
+  if (!PyLong_Check(item)) {
+    return false;
+  }
+
+  if (element._pack_type == PT_uint || element._pack_type == PT_uint64) {
+    unsigned long long value = PyLong_AsUnsignedLongLong(item);
+    if (value == (unsigned long long)-1 && PyErr_Occurred()) {
+      PyErr_Clear();
+      return false;
+    }
+    return codec->pack_uint64(buffer, n, (uint64_t)value);
+  }
+
+  long long value = PyLong_AsLongLong(item);
+  if (value == -1 && PyErr_Occurred()) {
+    PyErr_Clear();
+    return false;
+  }
+
+  if (element._pack_type == PT_double) {
+    // pack_object() packs an integer into a field with a divisor using
+    // pack_int(), which scales it in int precision.  Leave anything that
+    // would overflow that to pack_object().
+    if (value < INT32_MIN || value > INT32_MAX) {
+      return false;
+    }
+    long long scaled = value * (long long)element._divisor;
+    if (scaled < INT32_MIN || scaled > INT32_MAX) {
+      return false;
+    }
+  }
+
+  return codec->pack_int64(buffer, n, (int64_t)value);
+}
+
+/**
+ * Returns a new reference to a Python number holding the nth element of the
+ * packed field beginning at data, of the same type unpack_object() would
+ * return for it.
+ */
+PyObject *Extension<DCPacker>::
+unpack_codec_element(const DCFieldCodec *codec, const char *data, size_t n) {
+  switch (codec->get_element(n)._pack_type) {
+  case PT_int:
+    return PyLong_FromLong((long)codec->unpack_int64(data, n));
+
+  case PT_uint:
+    return PyLong_FromUnsignedLong((unsigned long)codec->unpack_uint64(data, n));
+
+  case PT_int64:
+    return PyLong_FromLongLong(codec->unpack_int64(data, n));
+
+  case PT_uint64:
+    return PyLong_FromUnsignedLongLong(codec->unpack_uint64(data, n));
+
+  case PT_double:
+    return PyFloat_FromDouble(codec->unpack_double(data, n));
+
+  default:
+    return nullptr;
+  }
+}
+
 #endif  // HAVE_PYTHON
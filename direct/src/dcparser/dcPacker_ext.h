@@ -20,6 +20,7 @@
 
 #include "extension.h"
 #include "dcPacker.h"
+#include "dcFieldCodec.h"
 #include "py_panda.h"
 
 /**
@@ -32,12 +33,21 @@ public:
   void pack_object(PyObject *object);
   PyObject *unpack_object();
 
+  bool pack_codec_object(const DCFieldCodec *codec, PyObject *object);
+  PyObject *unpack_codec_object(const DCFieldCodec *codec);
+
   void pack_class_object(const DCClass *dclass, PyObject *object);
   PyObject *unpack_class_object(const DCClass *dclass);
   void set_class_element(PyObject *class_def, PyObject *&object,
                          const DCField *field);
   void get_class_element(const DCClass *dclass, PyObject *object,
                          const DCField *field);
+
+private:
+  static bool pack_codec_element(const DCFieldCodec *codec, char *buffer,
+                                 size_t n, PyObject *item);
+  static PyObject *unpack_codec_element(const DCFieldCodec *codec,
+                                        const char *data, size_t n);
 };
 
 #endif  // HAVE_PYTHON
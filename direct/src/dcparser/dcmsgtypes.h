@@ -18,13 +18,18 @@
 // duplicates some symbols defined in MsgTypes.py and AIMsgTypes.py.
 
 #define CLIENT_OBJECT_SET_FIELD                           120
+#define CLIENT_OBJECT_SET_FIELD_DELTA                     122
+#define CLIENT_OBJECT_LEAVING                             132
 #define CLIENT_ENTER_OBJECT_REQUIRED                      142
 #define CLIENT_ENTER_OBJECT_REQUIRED_OTHER                143
+#define CLIENT_OBJECT_LEAVING_OWNER                       161
 
 #define STATESERVER_CREATE_OBJECT_WITH_REQUIRED           2000
 #define STATESERVER_CREATE_OBJECT_WITH_REQUIRED_OTHER     2001
 #define STATESERVER_OBJECT_SET_FIELD                      2020
 
 #define CLIENT_OBJECT_GENERATE_CMU                        9002
+#define OBJECT_DISABLE_CMU                                9005
+#define OBJECT_DELETE_CMU                                 9006
 
 #endif
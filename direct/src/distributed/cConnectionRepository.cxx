@@ -15,6 +15,7 @@
 #include "dcmsgtypes.h"
 #include "dcClass.h"
 #include "dcPacker.h"
+#include "dcFieldCodec.h"
 
 #include "config_distributed.h"
 #include "config_downloader.h"
@@ -69,7 +70,10 @@ CConnectionRepository(bool has_owner_view, bool threaded_net) :
   _msg_sender(0),
   _msg_type(0),
   _want_message_bundling(true),
-  _bundling_msgs(0)
+  _bundling_msgs(0),
+  _want_update_coalescing(want_update_coalescing),
+  _last_update_flush_time(0.0),
+  _want_field_deltas(want_field_deltas)
 {
 #if defined(HAVE_NET) && defined(SIMULATE_NETWORK_DELAY)
   if (min_lag != 0.0 || max_lag != 0.0) {
@@ -180,6 +184,7 @@ connect_native(const URLSpec &url) {
   ReMutexHolder holder(_lock);
 
   _native=true;
+  reset_field_updates();
   Socket_Address addr;
   addr.set_host(url.get_server(),url.get_port());
   _bdc.ClearAddresses();
@@ -260,6 +265,8 @@ check_datagram() {
     _bdc.Flush();
   #endif //WANT_NATIVE_NET
 
+  consider_flush_field_updates();
+
   while (do_check_datagram()) {
     if (get_verbose()) {
       describe_message(nout, "RECV", _dg);
@@ -297,6 +304,31 @@ check_datagram() {
     }
 
     _msg_type = _di.get_uint16();
+
+    // A delta-encoded update is turned back into an ordinary one before
+    // anyone else gets to see it.  Deltas are only used on client
+    // connections, which have a single peer.
+    if (_client_datagram) {
+      if (_msg_type == CLIENT_OBJECT_SET_FIELD_DELTA) {
+        if (!decode_field_delta()) {
+          continue;
+        }
+      } else if (_want_field_deltas) {
+        switch (_msg_type) {
+        case CLIENT_OBJECT_SET_FIELD:
+          record_field_baseline();
+          break;
+
+        case CLIENT_OBJECT_LEAVING:
+        case CLIENT_OBJECT_LEAVING_OWNER:
+        case OBJECT_DISABLE_CMU:
+        case OBJECT_DELETE_CMU:
+          forget_field_baselines(_di);
+          break;
+        }
+      }
+    }
+
     // Is this a message that we can process directly?
     if (!_handle_datagrams_internally) {
       return true;
@@ -404,46 +436,16 @@ send_datagram(const Datagram &dg) {
     return true;
   }
 
-#ifdef WANT_NATIVE_NET
-  if (_native) {
-    bool result = _bdc.SendMessage(dg);
-    if (!result && _bdc.IsConnected()) {
-#ifdef HAVE_PYTHON
-      std::ostringstream s;
-      s << endl << "Error sending message: " << endl;
-      dg.dump_hex(s);
-      s << "Message data: " << dg.get_data() << endl;
-
-      string message = s.str();
-      PyErr_SetString(PyExc_ConnectionError, message.c_str());
-#endif
-    }
-    return result;
-  }
-#endif
-
-#ifdef HAVE_NET
-  if (_net_conn) {
-    _cw.send(dg, _net_conn);
+  if (_want_update_coalescing && queue_field_update(dg)) {
     return true;
   }
-#endif  // HAVE_NET
-
-#ifdef HAVE_OPENSSL
-  if (_http_conn) {
-    if (!_http_conn->send_datagram(dg)) {
-      distributed_cat.warning()
-        << "Could not send datagram.\n";
-      return false;
-    }
 
-    return true;
+  // Anything else must not overtake the updates that are already pending.
+  if (!_pending_updates.empty()) {
+    send_pending_updates();
   }
-#endif  // HAVE_OPENSSL
 
-  distributed_cat.warning()
-    << "Unable to send datagram after connection is closed.\n";
-  return false;
+  return do_send_datagram(dg);
 }
 
 /**
@@ -524,6 +526,21 @@ bundle_msg(const Datagram &dg) {
   _bundle_msgs.push_back(dg.get_message());
 }
 
+/**
+ * Immediately sends any field updates that are being held back because of
+ * set_want_update_coalescing().  This is also done automatically by
+ * consider_flush() and check_datagram() once update-coalesce-interval has
+ * elapsed, and by flush().
+ */
+void CConnectionRepository::
+flush_field_updates() {
+  ReMutexHolder holder(_lock);
+
+  if (!_pending_updates.empty() && !_simulated_disconnect) {
+    send_pending_updates();
+  }
+}
+
 /**
  * Sends the most recently queued data if enough time has elapsed.  This only
  * has meaning if set_collect_tcp() has been set to true.
@@ -536,6 +553,8 @@ consider_flush() {
     return false;
   }
 
+  consider_flush_field_updates();
+
 #ifdef WANT_NATIVE_NET
   if(_native)
     return true;  //Maybe we should just flush here for now?
@@ -567,6 +586,11 @@ flush() {
   if (_simulated_disconnect) {
     return false;
   }
+
+  if (!_pending_updates.empty()) {
+    send_pending_updates();
+  }
+
   #ifdef WANT_NATIVE_NET
   if(_native)
     return _bdc.Flush();
@@ -616,6 +640,7 @@ disconnect() {
   }
   #endif  // HAVE_OPENSSL
 
+  reset_field_updates();
   _simulated_disconnect = false;
 }
 
@@ -860,6 +885,425 @@ handle_update_field_owner() {
   return true;
 }
 
+/**
+ * Actually sends the indicated datagram on whichever connection is open,
+ * after delta-encoding it if appropriate.
+ */
+bool CConnectionRepository::
+do_send_datagram(const Datagram &orig_dg) {
+  Datagram delta;
+  bool use_delta = false;
+  if (_want_field_deltas && _client_datagram) {
+    use_delta = encode_field_delta(orig_dg, delta);
+
+    // The server will forget about the object if we delete it, so we should
+    // as well.
+    DatagramIterator di(orig_dg);
+    if (!use_delta && di.get_remaining_size() >= 2 &&
+        di.get_uint16() == OBJECT_DELETE_CMU) {
+      forget_field_baselines(di);
+    }
+  }
+  const Datagram &dg = use_delta ? delta : orig_dg;
+
+#ifdef WANT_NATIVE_NET
+  if (_native) {
+    bool result = _bdc.SendMessage(dg);
+    if (!result && _bdc.IsConnected()) {
+#ifdef HAVE_PYTHON
+      std::ostringstream s;
+      s << endl << "Error sending message: " << endl;
+      dg.dump_hex(s);
+      s << "Message data: " << dg.get_data() << endl;
+
+      string message = s.str();
+      PyErr_SetString(PyExc_ConnectionError, message.c_str());
+#endif
+    }
+    return result;
+  }
+#endif
+
+#ifdef HAVE_NET
+  if (_net_conn) {
+    _cw.send(dg, _net_conn);
+    return true;
+  }
+#endif  // HAVE_NET
+
+#ifdef HAVE_OPENSSL
+  if (_http_conn) {
+    if (!_http_conn->send_datagram(dg)) {
+      distributed_cat.warning()
+        << "Could not send datagram.\n";
+      return false;
+    }
+
+    return true;
+  }
+#endif  // HAVE_OPENSSL
+
+  distributed_cat.warning()
+    << "Unable to send datagram after connection is closed.\n";
+  return false;
+}
+
+
+
+/**
+ * If the indicated datagram is a field update of the kind this repository
+ * sends, fills in the size of its routing header (everything before the
+ * message type), the field it updates, and a key that identifies the
+ * destination, object and field, and returns true.  Returns false if the
+ * datagram is any other kind of message.
+ */
+bool CConnectionRepository::
+parse_field_update(const Datagram &dg, size_t &header_size, DCField *&field,
+                   string &key) const {
+  const unsigned char *data = (const unsigned char *)dg.get_data();
+  size_t length = dg.get_length();
+
+  unsigned int msg_type;
+  if (_client_datagram) {
+    header_size = 0;
+    msg_type = CLIENT_OBJECT_SET_FIELD;
+  } else {
+    if (length < 1) {
+      return false;
+    }
+    header_size = 1 + (size_t)data[0] * sizeof(CHANNEL_TYPE) + sizeof(CHANNEL_TYPE);
+    msg_type = STATESERVER_OBJECT_SET_FIELD;
+  }
+
+  // The message type, the doId and the field number.
+  if (length < header_size + 8) {
+    return false;
+  }
+  const unsigned char *p = data + header_size;
+  if ((unsigned int)(p[0] | (p[1] << 8)) != msg_type) {
+    return false;
+  }
+
+  int field_id = p[6] | (p[7] << 8);
+  field = _dc_file.get_field_by_index(field_id);
+  if (field == nullptr) {
+    return false;
+  }
+
+  key.assign((const char *)data, header_size);
+  key.append((const char *)p + 2, 6);
+  return true;
+}
+
+/**
+ * Holds back the indicated datagram until the next flush, if it is a field
+ * update, and returns true.  Returns false if it is some other kind of
+ * message, which should be sent normally.
+ */
+bool CConnectionRepository::
+queue_field_update(const Datagram &dg) {
+  size_t header_size;
+  DCField *field;
+  string key;
+  if (!parse_field_update(dg, header_size, field, key)) {
+    return false;
+  }
+
+  if (_pending_updates.empty()) {
+    _last_update_flush_time = ClockObject::get_global_clock()->get_real_time();
+  }
+
+  // Only the latest value of a small ram field matters; any update to it
+  // that hasn't been sent yet can be dropped in favor of this one.  Other
+  // fields may have side effects on every call, so we send them all.
+  if (field->is_ram() && field->has_fixed_byte_size() &&
+      field->get_fixed_byte_size() <= (size_t)update_coalesce_max_bytes) {
+    std::pair<PendingUpdatesByKey::iterator, bool> result =
+      _pending_updates_by_key.insert(PendingUpdatesByKey::value_type(key, _pending_updates.size()));
+    if (!result.second) {
+      _pending_updates[(*result.first).second]._superseded = true;
+      (*result.first).second = _pending_updates.size();
+    }
+  }
+
+  PendingUpdate update;
+  update._destination = key.substr(0, header_size);
+  update._dg = dg;
+  update._superseded = false;
+  _pending_updates.push_back(std::move(update));
+  return true;
+}
+
+/**
+ * Sends the pending field updates if they have been held for long enough.
+ */
+void CConnectionRepository::
+consider_flush_field_updates() {
+  if (!_pending_updates.empty()) {
+    double now = ClockObject::get_global_clock()->get_real_time();
+    if (now - _last_update_flush_time >= update_coalesce_interval) {
+      send_pending_updates();
+    }
+  }
+}
+
+/**
+ * Sends all of the pending field updates that have not been superseded,
+ * grouped by destination channel.  Updates to the same destination are sent
+ * in the order they were queued.
+ */
+void CConnectionRepository::
+send_pending_updates() {
+  // Since the updates are usually all for the same destination, a linear
+  // scan for each distinct destination is cheap.
+  size_t num_updates = _pending_updates.size();
+  pvector<bool> sent(num_updates, false);
+  for (size_t i = 0; i < num_updates; ++i) {
+    if (sent[i]) {
+      continue;
+    }
+    const string &destination = _pending_updates[i]._destination;
+    for (size_t j = i; j < num_updates; ++j) {
+      PendingUpdate &update = _pending_updates[j];
+      if (!sent[j] && update._destination == destination) {
+        sent[j] = true;
+        if (!update._superseded) {
+          do_send_datagram(update._dg);
+        }
+      }
+    }
+  }
+
+  _pending_updates.clear();
+  _pending_updates_by_key.clear();
+  _last_update_flush_time = ClockObject::get_global_clock()->get_real_time();
+}
+
+/**
+ * If the indicated datagram is an update to a field that can be
+ * delta-encoded, and a previous value of the field has already been sent,
+ * fills in delta with a delta-encoded version of the update and returns true.
+ * Otherwise, returns false, and the datagram should be sent as it is.
+ *
+ * The delta message is the same as the update, except for the message type,
+ * and that the field value is replaced by a bitmask of the elements that have
+ * changed, followed by the new values of just those elements.
+ */
+bool CConnectionRepository::
+encode_field_delta(const Datagram &dg, Datagram &delta) {
+  size_t header_size;
+  DCField *field;
+  string key;
+  if (!parse_field_update(dg, header_size, field, key)) {
+    return false;
+  }
+
+  const DCFieldCodec *codec = field->get_codec();
+  size_t value_start = header_size + 8;
+  if (codec == nullptr || dg.get_length() - value_start != codec->get_byte_size()) {
+    // The receiver won't keep a baseline for this one either.
+    _sent_baselines.erase(key);
+    return false;
+  }
+
+  const unsigned char *value = (const unsigned char *)dg.get_data() + value_start;
+  size_t byte_size = codec->get_byte_size();
+
+  FieldBaselines::iterator bi = _sent_baselines.find(key);
+  if (bi == _sent_baselines.end()) {
+    _sent_baselines[key] = vector_uchar(value, value + byte_size);
+    return false;
+  }
+  vector_uchar &baseline = (*bi).second;
+
+  size_t num_elements = codec->get_num_elements();
+  size_t mask_size = (num_elements + 7) / 8;
+  unsigned char mask[32];
+  if (mask_size > sizeof(mask)) {
+    baseline.assign(value, value + byte_size);
+    return false;
+  }
+  memset(mask, 0, mask_size);
+
+  size_t changed_size = 0;
+  for (size_t i = 0; i < num_elements; ++i) {
+    size_t offset = codec->get_element(i)._offset;
+    size_t size = ((i + 1 < num_elements) ? codec->get_element(i + 1)._offset : byte_size) - offset;
+    if (memcmp(&baseline[offset], value + offset, size) != 0) {
+      mask[i / 8] |= (1 << (i % 8));
+      changed_size += size;
+    }
+  }
+
+  if (mask_size + changed_size >= byte_size) {
+    // Not worth it.
+    baseline.assign(value, value + byte_size);
+    return false;
+  }
+
+  delta.append_data(dg.get_data(), header_size);
+  delta.add_uint16(CLIENT_OBJECT_SET_FIELD_DELTA);
+  delta.append_data((const unsigned char *)dg.get_data() + header_size + 2, 6);
+  delta.append_data(mask, mask_size);
+  for (size_t i = 0; i < num_elements; ++i) {
+    if (mask[i / 8] & (1 << (i % 8))) {
+      size_t offset = codec->get_element(i)._offset;
+      size_t size = ((i + 1 < num_elements) ? codec->get_element(i + 1)._offset : byte_size) - offset;
+      delta.append_data(value + offset, size);
+    }
+  }
+
+  baseline.assign(value, value + byte_size);
+  return true;
+}
+
+/**
+ * Called by check_datagram() when a delta-encoded update has been received,
+ * with _di positioned just after the message type.  Replaces _dg with the
+ * equivalent ordinary field update, and positions _di accordingly.  Returns
+ * true on success, or false if the message could not be decoded, in which
+ * case it should be ignored.
+ */
+bool CConnectionRepository::
+decode_field_delta() {
+  const unsigned char *data = (const unsigned char *)_dg.get_data();
+  size_t length = _dg.get_length();
+  size_t header_size = _di.get_current_index() - 2;
+
+  if (length < header_size + 8) {
+    distributed_cat.warning()
+      << "Received truncated field delta.\n";
+    return false;
+  }
+  const unsigned char *p = data + header_size;
+  int field_id = p[6] | (p[7] << 8);
+
+  DCField *field = _dc_file.get_field_by_index(field_id);
+  const DCFieldCodec *codec = (field != nullptr) ? field->get_codec() : nullptr;
+  if (codec == nullptr) {
+    distributed_cat.warning()
+      << "Received field delta for field " << field_id
+      << ", which cannot be delta-encoded.\n";
+    return false;
+  }
+
+  string key((const char *)data, header_size);
+  key.append((const char *)p + 2, 6);
+
+  FieldBaselines::iterator bi = _received_baselines.find(key);
+  if (bi == _received_baselines.end()) {
+    distributed_cat.warning()
+      << "Received field delta for " << field->get_name()
+      << " without a previous value; is want-field-deltas enabled?\n";
+    return false;
+  }
+  vector_uchar &baseline = (*bi).second;
+
+  size_t byte_size = codec->get_byte_size();
+  size_t num_elements = codec->get_num_elements();
+  size_t mask_size = (num_elements + 7) / 8;
+  const unsigned char *mask = p + 8;
+  const unsigned char *q = mask + mask_size;
+  const unsigned char *end = data + length;
+  if (q > end) {
+    distributed_cat.warning()
+      << "Received truncated field delta for " << field->get_name() << ".\n";
+    return false;
+  }
+
+  vector_uchar value(baseline);
+  for (size_t i = 0; i < num_elements; ++i) {
+    if (mask[i / 8] & (1 << (i % 8))) {
+      size_t offset = codec->get_element(i)._offset;
+      size_t size = ((i + 1 < num_elements) ? codec->get_element(i + 1)._offset : byte_size) - offset;
+      if (q + size > end) {
+        distributed_cat.warning()
+          << "Received truncated field delta for " << field->get_name() << ".\n";
+        return false;
+      }
+      memcpy(&value[offset], q, size);
+      q += size;
+    }
+  }
+  baseline = value;
+
+  Datagram dg;
+  dg.append_data(data, header_size);
+  dg.add_uint16(CLIENT_OBJECT_SET_FIELD);
+  dg.append_data(p + 2, 6);
+  dg.append_data(value);
+  _dg = std::move(dg);
+
+  _di = DatagramIterator(_dg, header_size + 2);
+  _msg_type = CLIENT_OBJECT_SET_FIELD;
+  return true;
+}
+
+/**
+ * Called by check_datagram() when an ordinary field update has been received,
+ * with _di positioned just after the message type.  Remembers the value of
+ * the field, if it is one that may subsequently be delta-encoded.
+ */
+void CConnectionRepository::
+record_field_baseline() {
+  const unsigned char *data = (const unsigned char *)_dg.get_data();
+  size_t length = _dg.get_length();
+  size_t header_size = _di.get_current_index() - 2;
+
+  if (length < header_size + 8) {
+    return;
+  }
+  const unsigned char *p = data + header_size;
+  int field_id = p[6] | (p[7] << 8);
+
+  string key((const char *)data, header_size);
+  key.append((const char *)p + 2, 6);
+
+  DCField *field = _dc_file.get_field_by_index(field_id);
+  const DCFieldCodec *codec = (field != nullptr) ? field->get_codec() : nullptr;
+  size_t value_start = header_size + 8;
+  if (codec == nullptr || length - value_start != codec->get_byte_size()) {
+    _received_baselines.erase(key);
+    return;
+  }
+
+  _received_baselines[key] = vector_uchar(data + value_start, data + length);
+}
+
+/**
+ * Forgets the values sent and received for all fields of the object whose
+ * doId is next in the indicated iterator, after it has been deleted or has
+ * left our interest.  If it is generated again, its fields will start over
+ * with full updates.
+ */
+void CConnectionRepository::
+forget_field_baselines(const DatagramIterator &di) {
+  if (di.get_remaining_size() < 4) {
+    return;
+  }
+
+  // On a client connection, the key starts with the doId.
+  string prefix((const char *)di.get_datagram().get_data() + di.get_current_index(), 4);
+  for (FieldBaselines *baselines : { &_sent_baselines, &_received_baselines }) {
+    FieldBaselines::iterator bi = baselines->lower_bound(prefix);
+    while (bi != baselines->end() && (*bi).first.compare(0, 4, prefix) == 0) {
+      bi = baselines->erase(bi);
+    }
+  }
+}
+
+/**
+ * Forgets all pending field updates and delta-encoding state.  Called when
+ * the connection is opened or closed.
+ */
+void CConnectionRepository::
+reset_field_updates() {
+  _pending_updates.clear();
+  _pending_updates_by_key.clear();
+  _sent_baselines.clear();
+  _received_baselines.clear();
+}
+
 /**
  * Unpacks the message and reformats it for user consumption, writing a
  * description on the indicated output stream.
@@ -25,6 +25,8 @@
 #include "clockObject.h"
 #include "reMutex.h"
 #include "reMutexHolder.h"
+#include "pmap.h"
+#include "pvector.h"
 
 #ifdef HAVE_NET
 #include "queuedConnectionManager.h"
@@ -140,6 +142,13 @@ PUBLISHED:
   BLOCKING void abandon_message_bundles();
   BLOCKING void bundle_msg(const Datagram &dg);
 
+  BLOCKING INLINE void set_want_update_coalescing(bool flag);
+  BLOCKING INLINE bool get_want_update_coalescing() const;
+  BLOCKING void flush_field_updates();
+
+  BLOCKING INLINE void set_want_field_deltas(bool flag);
+  BLOCKING INLINE bool get_want_field_deltas() const;
+
   BLOCKING bool consider_flush();
   BLOCKING bool flush();
 
@@ -161,6 +170,18 @@ private:
   bool handle_update_field();
   bool handle_update_field_owner();
 
+  bool do_send_datagram(const Datagram &dg);
+  bool parse_field_update(const Datagram &dg, size_t &header_size,
+                          DCField *&field, std::string &key) const;
+  bool queue_field_update(const Datagram &dg);
+  void consider_flush_field_updates();
+  void send_pending_updates();
+  bool encode_field_delta(const Datagram &dg, Datagram &delta);
+  bool decode_field_delta();
+  void record_field_baseline();
+  void forget_field_baselines(const DatagramIterator &di);
+  void reset_field_updates();
+
   void describe_message(std::ostream &out, const std::string &prefix,
                         const Datagram &dg) const;
 
@@ -212,6 +233,29 @@ private:
   typedef std::vector< std::string > BundledMsgVector;
   BundledMsgVector _bundle_msgs;
 
+  // Field updates held back while update coalescing is in effect, in the
+  // order they were sent.  An update that has been superseded by a newer one
+  // is left in place, but with _superseded set.
+  class PendingUpdate {
+  public:
+    std::string _destination;
+    Datagram _dg;
+    bool _superseded;
+  };
+  typedef pvector<PendingUpdate> PendingUpdates;
+  typedef pmap<std::string, size_t> PendingUpdatesByKey;
+  bool _want_update_coalescing;
+  PendingUpdates _pending_updates;
+  PendingUpdatesByKey _pending_updates_by_key;
+  double _last_update_flush_time;
+
+  // The most recent value sent and received for each field eligible for
+  // delta encoding, indexed by the object and field.
+  typedef pmap<std::string, vector_uchar> FieldBaselines;
+  bool _want_field_deltas;
+  FieldBaselines _sent_baselines;
+  FieldBaselines _received_baselines;
+
   static PStatCollector _update_pcollector;
 };
 
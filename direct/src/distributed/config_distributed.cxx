@@ -50,6 +50,36 @@ ConfigVariableBool handle_datagrams_internally
           "for performance reasons.  When it is false, all datagrams "
           "are handled by the Python implementation."));
 
+ConfigVariableBool want_update_coalescing
+("want-update-coalescing", false,
+ PRC_DESC("When this is true, outgoing field updates sent through the "
+          "cConnectionRepository are held and sent together, grouped by "
+          "destination channel, once every update-coalesce-interval "
+          "seconds.  A pending update to a small ram field is replaced by a "
+          "newer update to the same field of the same object."));
+
+ConfigVariableDouble update_coalesce_interval
+("update-coalesce-interval", 0.05,
+ PRC_DESC("The maximum time in seconds for which outgoing field updates are "
+          "held when want-update-coalescing is in effect."));
+
+ConfigVariableInt update_coalesce_max_bytes
+("update-coalesce-max-bytes", 64,
+ PRC_DESC("The largest ram field, in bytes, whose pending updates may be "
+          "replaced by a newer update when want-update-coalescing is in "
+          "effect.  Updates to larger fields, and to fields that are not "
+          "ram, are always sent."));
+
+ConfigVariableBool want_field_deltas
+("want-field-deltas", false,
+ PRC_DESC("When this is true, a client cConnectionRepository sends updates "
+          "to fixed-size numeric fields as a delta against the previous "
+          "value sent for the same field of the same object, and "
+          "reconstructs such deltas when it receives them.  Both ends of "
+          "the connection must have this enabled, and the server must decode "
+          "the deltas itself rather than forwarding them to other "
+          "clients."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -27,6 +27,10 @@ extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableInt game_server_timeout_ms;
 extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableDouble min_lag;
 extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableDouble max_lag;
 extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableBool handle_datagrams_internally;
+extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableBool want_update_coalescing;
+extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableDouble update_coalesce_interval;
+extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableInt update_coalesce_max_bytes;
+extern EXPCL_DIRECT_DISTRIBUTED ConfigVariableBool want_field_deltas;
 
 extern EXPCL_DIRECT_DISTRIBUTED void init_libdistributed();
 
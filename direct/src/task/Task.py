@@ -250,6 +250,7 @@ class TaskManager:
         frameBudget: float | None = None,
         frameSync: bool | None = None,
         timeslicePriority: bool | None = None,
+        workStealing: bool | None = None,
     ) -> None:
         """Defines a new task chain.  Each task chain executes tasks
         potentially in parallel with all of the other task chains (if
@@ -298,6 +299,13 @@ class TaskManager:
         meaning of priority so that certain tasks are run less often,
         in proportion to their time used and to their priority value.
         See AsyncTaskManager.setTimeslicePriority() for more.
+
+        workStealing is False in the default mode, in which all of
+        the threads of the task chain take their tasks from one shared
+        queue; or True to give each thread its own queue, from which
+        the other threads may steal tasks when they run out.  This
+        reduces lock contention when there are many threads and many
+        short tasks.  See AsyncTaskChain.setWorkStealing() for more.
         """
 
         chain = self.mgr.makeTaskChain(chainName)
@@ -313,6 +321,8 @@ class TaskManager:
             chain.setFrameSync(frameSync)
         if timeslicePriority is not None:
             chain.setTimeslicePriority(timeslicePriority)
+        if workStealing is not None:
+            chain.setWorkStealing(workStealing)
 
     def hasTaskNamed(self, taskName: str) -> bool:
         """Returns true if there is at least one task, active or
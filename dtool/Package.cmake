@@ -110,6 +110,8 @@ if(THIRDPARTY_DIRECTORY)
     VorbisFile
     VRPN
     ZLIB
+    LZ4
+    Zstd
   )
 
     string(TOLOWER "${_Package}" _package)
@@ -487,6 +489,25 @@ package_option(ZLIB
 
 package_status(ZLIB "zlib")
 
+# LZ4
+find_package(LZ4 QUIET MODULE)
+
+package_option(LZ4
+  "Enables the LZ4 codec, for very fast compression of Panda assets."
+  FOUND_AS LZ4)
+
+package_status(LZ4 "LZ4")
+
+# Zstandard
+find_package(Zstd QUIET MODULE)
+
+package_option(ZSTD
+  "Enables the Zstandard codec, for fast compression of Panda assets with a
+high compression ratio."
+  FOUND_AS Zstd)
+
+package_status(ZSTD "Zstandard")
+
 
 #
 # ------------ Image formats ------------
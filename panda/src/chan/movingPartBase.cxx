@@ -179,6 +179,19 @@ update_internals(PartBundle *, PartGroup *, bool, bool, Thread *) {
   return true;
 }
 
+/**
+ * This is called to apply the effects of update_internals() that reach
+ * outside of the PartBundle, such as changing the transform of a node in the
+ * scene graph.  Normally update_internals() calls it directly, but it may
+ * use PartBundle::defer_finish_update() instead, in which case it is called
+ * later, after the bundle's update has completed, with the same flags.
+ *
+ * The meaning of the flags is up to the derived class.
+ */
+void MovingPartBase::
+finish_update(PartBundle *, int, Thread *) {
+}
+
 /**
  * Walks the part hierarchy, looking for a suitable channel index number to
  * use.  Available index numbers are the elements of the holes set, as well as
@@ -38,6 +38,7 @@ class PartBundleNode;
 class PartBundleNode;
 class TransformState;
 class AnimPreloadTable;
+class MovingPartBase;
 
 /**
  * This is the root of a MovingPart hierarchy.  It defines the hierarchy of
@@ -50,6 +51,10 @@ public:
   // to specify the channels that are in effect.
   typedef pmap<AnimControl *, PN_stdfloat> ChannelBlend;
 
+  // This records the parts whose finish_update() has been postponed by a
+  // PartBundleUpdater, along with the flags that should be passed to it.
+  typedef pvector<std::pair<MovingPartBase *, int> > DeferredUpdates;
+
 protected:
   // The copy constructor is protected; use make_copy() or copy_subgraph().
   PartBundle(const PartBundle &copy);
@@ -151,6 +156,7 @@ public:
   virtual void control_activated(AnimControl *control);
   void control_removed(AnimControl *control);
   INLINE void set_update_delay(double delay);
+  INLINE bool defer_finish_update(MovingPartBase *part, int flags);
 
   bool do_bind_anim(AnimControl *control, AnimBundle *anim,
                     int hierarchy_match_flags, const PartSubset &subset);
@@ -176,6 +182,9 @@ private:
 
   double _update_delay;
 
+  // This is only set while a PartBundleUpdater is updating the bundle.
+  DeferredUpdates *_deferred_updates;
+
   // This is the data that must be cycled between pipeline stages.
   class CData : public CycleData {
   public:
@@ -239,6 +248,7 @@ private:
   friend class MovingPartBase;
   friend class MovingPartMatrix;
   friend class MovingPartScalar;
+  friend class PartBundleUpdater;
 };
 
 inline std::ostream &operator <<(std::ostream &out, const PartBundle &bundle) {
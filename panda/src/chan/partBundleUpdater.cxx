@@ -0,0 +1,114 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file partBundleUpdater.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "partBundleUpdater.h"
+#include "movingPartBase.h"
+#include "workerThreadPool.h"
+
+/**
+ * Adds the indicated bundle to the set of bundles to update on the next call
+ * to update().  If force is true, the bundle will be updated as if by
+ * PartBundle::force_update(); otherwise, as if by PartBundle::update().
+ *
+ * Adding the same bundle more than once has no further effect, except that
+ * the bundle is forced if any of the calls asked for it.
+ */
+void PartBundleUpdater::
+add_bundle(PartBundle *bundle, bool force) {
+  nassertv(bundle != nullptr);
+
+  std::pair<Index::iterator, bool> result =
+    _index.insert(Index::value_type(bundle, _entries.size()));
+  if (!result.second) {
+    _entries[(*result.first).second]._force |= force;
+    return;
+  }
+
+  Entry entry;
+  entry._bundle = bundle;
+  entry._force = force;
+  _entries.push_back(std::move(entry));
+}
+
+/**
+ * Removes all of the bundles that have been added, without updating them.
+ */
+void PartBundleUpdater::
+clear() {
+  _entries.clear();
+  _index.clear();
+}
+
+/**
+ * Updates all of the bundles that have been added, and then removes them
+ * from the updater, so that it may be filled again for the next frame.
+ * Returns true if any of the bundles changed as a result.
+ */
+bool PartBundleUpdater::
+update(Thread *current_thread) {
+  size_t num_entries = _entries.size();
+
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  if (num_entries < 2 || !pool->is_parallel()) {
+    return update_serial();
+  }
+
+  // Each bundle gets its own list of deferred updates, so that the workers
+  // never have to share anything.
+  pvector<PartBundle::DeferredUpdates> deferred(num_entries);
+  pvector<unsigned char> changed(num_entries, 0);
+  for (size_t i = 0; i < num_entries; ++i) {
+    _entries[i]._bundle->_deferred_updates = &deferred[i];
+  }
+
+  pool->parallel_for(num_entries, [&] (size_t i, Thread *thread) {
+    const Entry &entry = _entries[i];
+    if (entry._force ? entry._bundle->force_update() : entry._bundle->update()) {
+      changed[i] = 1;
+    }
+  }, current_thread);
+
+  // Now apply everything that was postponed, in the order in which it would
+  // have happened had we updated the bundles one at a time.
+  bool any_changed = false;
+  for (size_t i = 0; i < num_entries; ++i) {
+    PartBundle *bundle = _entries[i]._bundle;
+    bundle->_deferred_updates = nullptr;
+
+    for (const auto &item : deferred[i]) {
+      item.first->finish_update(bundle, item.second, current_thread);
+    }
+    if (changed[i]) {
+      any_changed = true;
+    }
+  }
+
+  clear();
+  return any_changed;
+}
+
+/**
+ * Updates all of the bundles one at a time on the calling thread.
+ */
+bool PartBundleUpdater::
+update_serial() {
+  bool any_changed = false;
+  for (const Entry &entry : _entries) {
+    if (entry._force ? entry._bundle->force_update() : entry._bundle->update()) {
+      any_changed = true;
+    }
+  }
+
+  clear();
+  return any_changed;
+}
@@ -0,0 +1,64 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file partBundleUpdater.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef PARTBUNDLEUPDATER_H
+#define PARTBUNDLEUPDATER_H
+
+#include "pandabase.h"
+#include "partBundle.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pmap.h"
+#include "thread.h"
+
+/**
+ * Collects a number of PartBundles that are to be updated in the same frame,
+ * and updates them all at once, spreading the bundles across the threads of
+ * the global WorkerThreadPool.
+ *
+ * The channel sampling, blending and joint hierarchy of each bundle are
+ * evaluated on the worker threads.  The effects that reach outside of a
+ * bundle, such as setting the transform of an exposed joint's node, are
+ * postponed and applied afterwards on the calling thread, in the same order
+ * as if the bundles had been updated one by one in the order they were
+ * added.  The results are therefore identical to calling update() on each
+ * bundle in turn.
+ */
+class EXPCL_PANDA_CHAN PartBundleUpdater {
+PUBLISHED:
+  PartBundleUpdater() = default;
+
+  void add_bundle(PartBundle *bundle, bool force = false);
+  INLINE size_t get_num_bundles() const;
+  void clear();
+
+  bool update(Thread *current_thread = Thread::get_current_thread());
+
+private:
+  bool update_serial();
+
+  class Entry {
+  public:
+    PT(PartBundle) _bundle;
+    bool _force;
+  };
+  typedef pvector<Entry> Entries;
+  Entries _entries;
+
+  typedef pmap<PartBundle *, size_t> Index;
+  Index _index;
+};
+
+#include "partBundleUpdater.I"
+
+#endif
@@ -418,6 +418,25 @@ update() {
   }
 }
 
+/**
+ * Like update(), but instead of recalculating the Character's joints
+ * immediately, adds its bundles to the indicated PartBundleUpdater, so that
+ * they may be recalculated together with those of other Characters by the
+ * next call to PartBundleUpdater::update().
+ */
+void Character::
+update(PartBundleUpdater &updater) {
+  LightMutexHolder holder(_lock);
+  double now = ClockObject::get_global_clock()->get_frame_time();
+  if (now != _last_auto_update) {
+    _last_auto_update = now;
+
+    for (PartBundleHandle *handle : _bundles) {
+      updater.add_bundle(handle->get_bundle(), even_animation);
+    }
+  }
+}
+
 /**
  * Recalculates the character even if we think it doesn't need it.
  */
@@ -21,6 +21,7 @@
 #include "characterVertexSlider.h"
 #include "jointVertexTransform.h"
 #include "partBundleNode.h"
+#include "partBundleUpdater.h"
 #include "vector_PartGroupStar.h"
 #include "pointerTo.h"
 #include "geom.h"
@@ -75,6 +76,7 @@ PUBLISHED:
 
   void update_to_now();
   void update();
+  void update(PartBundleUpdater &updater);
   void force_update();
 
 protected:
@@ -133,6 +133,31 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
   }
 
   if (net_changed) {
+    // Recompute the transform used by any vertices animated by this joint.
+    _skinning_matrix = _initial_net_transform_inverse * _net_transform;
+  }
+
+  int flags = 0;
+  if (net_changed) {
+    flags |= FF_net_changed;
+  }
+  if (self_changed && !_local_transform_nodes.empty()) {
+    flags |= FF_local_changed;
+  }
+  if (flags != 0 && !root->defer_finish_update(this, flags)) {
+    finish_update(root, flags, current_thread);
+  }
+
+  return self_changed || net_changed;
+}
+
+/**
+ * Passes the joint's new transforms on to the nodes that have been attached
+ * to it, and to the vertices that it animates.
+ */
+void CharacterJoint::
+finish_update(PartBundle *root, int flags, Thread *current_thread) {
+  if (flags & FF_net_changed) {
     if (!_net_transform_nodes.empty()) {
       CPT(TransformState) t = TransformState::make_mat(_net_transform);
 
@@ -145,9 +170,6 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
       }
     }
 
-    // Recompute the transform used by any vertices animated by this joint.
-    _skinning_matrix = _initial_net_transform_inverse * _net_transform;
-
     // Also tell our related JointVertexTransforms that we've changed their
     // underlying matrix.
     VertexTransforms::iterator vti;
@@ -156,7 +178,7 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
     }
   }
 
-  if (self_changed && !_local_transform_nodes.empty()) {
+  if (flags & FF_local_changed) {
     CPT(TransformState) t = TransformState::make_mat(_value);
 
     NodeList::iterator ai;
@@ -167,8 +189,6 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
       node->set_transform(t, current_thread);
     }
   }
-
-  return self_changed || net_changed;
 }
 
 /**
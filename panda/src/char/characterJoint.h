@@ -48,6 +48,8 @@ public:
   virtual bool update_internals(PartBundle *root, PartGroup *parent,
                                 bool self_changed, bool parent_changed,
                                 Thread *current_thread) final;
+  virtual void finish_update(PartBundle *root, int flags,
+                             Thread *current_thread) final;
   virtual void do_xform(const LMatrix4 &mat, const LMatrix4 &inv_mat);
 
 PUBLISHED:
@@ -74,6 +76,12 @@ PUBLISHED:
 private:
   void set_character(Character *character);
 
+  // The flags passed to finish_update().
+  enum FinishFlags {
+    FF_net_changed   = 0x0001,
+    FF_local_changed = 0x0002,
+  };
+
 private:
   // Not a reference-counted pointer.
   Character *_character;
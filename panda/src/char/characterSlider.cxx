@@ -71,15 +71,23 @@ make_copy() const {
  * or false otherwise.
  */
 bool CharacterSlider::
-update_internals(PartBundle *, PartGroup *, bool, bool, Thread *current_thread) {
-  // Tell our related CharacterVertexSliders that they now need to recompute
-  // themselves.
+update_internals(PartBundle *root, PartGroup *, bool, bool, Thread *current_thread) {
+  if (!root->defer_finish_update(this, 0)) {
+    finish_update(root, 0, current_thread);
+  }
+  return true;
+}
+
+/**
+ * Tells our related CharacterVertexSliders that they now need to recompute
+ * themselves.
+ */
+void CharacterSlider::
+finish_update(PartBundle *, int, Thread *current_thread) {
   VertexSliders::iterator vsi;
   for (vsi = _vertex_sliders.begin(); vsi != _vertex_sliders.end(); ++vsi) {
     (*vsi)->mark_modified(current_thread);
   }
-
-  return true;
 }
 
 /**
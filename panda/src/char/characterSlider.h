@@ -41,6 +41,8 @@ public:
   virtual bool update_internals(PartBundle *root, PartGroup *parent,
                                 bool self_changed, bool parent_changed,
                                 Thread *current_thread);
+  virtual void finish_update(PartBundle *root, int flags,
+                             Thread *current_thread);
 
 private:
   typedef pset<CharacterVertexSlider *> VertexSliders;
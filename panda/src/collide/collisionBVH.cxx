@@ -0,0 +1,357 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "collisionBVH.h"
+#include "geometricBoundingVolume.h"
+#include "finiteBoundingVolume.h"
+#include "boundingLine.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * Adds an item with the indicated axis-aligned bounds.  Must be called before
+ * build().
+ */
+void CollisionBVH::
+add_item(int index, const LPoint3 &min_point, const LPoint3 &max_point) {
+  BuildItem item;
+  item._index = index;
+  item._min = min_point;
+  item._max = max_point;
+  item._center = (min_point + max_point) * 0.5f;
+  _build_items.push_back(item);
+}
+
+/**
+ * Adds an item with the indicated bounding volume.  If the volume is not
+ * finite, the item is added as an unbounded item.  Must be called before
+ * build().
+ */
+void CollisionBVH::
+add_item(int index, const GeometricBoundingVolume *volume) {
+  const FiniteBoundingVolume *fbv = nullptr;
+  if (volume != nullptr && !volume->is_empty()) {
+    fbv = volume->as_finite_bounding_volume();
+  }
+  if (fbv != nullptr) {
+    add_item(index, fbv->get_min(), fbv->get_max());
+  } else {
+    add_unbounded_item(index);
+  }
+}
+
+/**
+ * Builds the hierarchy from the items that have been added.
+ */
+void CollisionBVH::
+build() {
+  _nodes.clear();
+  _items.clear();
+
+  if (!_build_items.empty()) {
+    // Every leaf ends up with at least two items, so there can't be more
+    // nodes than there are items.
+    _nodes.reserve(_build_items.size());
+    _items.reserve(_build_items.size());
+    r_build(0, _build_items.size());
+  }
+
+  BuildItems().swap(_build_items);
+  std::sort(_unbounded_items.begin(), _unbounded_items.end());
+}
+
+/**
+ * Fills the result vector with the indices of all of the items whose bounds
+ * may intersect the indicated volume, in increasing order.  Returns true on
+ * success, or false if the type of volume is not one that can be used to
+ * narrow down the items, in which case the caller should consider all of the
+ * items.
+ */
+bool CollisionBVH::
+get_overlapping_items(const GeometricBoundingVolume *volume,
+                      pvector<int> &result) const {
+  result.clear();
+  if (volume == nullptr) {
+    return false;
+  }
+  if (volume->is_empty()) {
+    return true;
+  }
+
+  const FiniteBoundingVolume *fbv = volume->as_finite_bounding_volume();
+  if (fbv != nullptr) {
+    find_box_overlaps(fbv->get_min(), fbv->get_max(), result);
+  } else {
+    const BoundingLine *line = volume->as_bounding_line();
+    if (line == nullptr) {
+      return false;
+    }
+    const LPoint3 &origin = line->get_point_a();
+    find_line_overlaps(origin, line->get_point_b() - origin, result);
+  }
+
+  result.insert(result.end(), _unbounded_items.begin(), _unbounded_items.end());
+  std::sort(result.begin(), result.end());
+  return true;
+}
+
+/**
+ * Returns true if the hierarchy is internally consistent and references only
+ * items in the range [0, num_items).  This is used to check a hierarchy that
+ * was read from a Bam file before it is trusted.
+ */
+bool CollisionBVH::
+is_valid(size_t num_items) const {
+  size_t num_nodes = _nodes.size();
+  for (size_t ni = 0; ni < num_nodes; ++ni) {
+    const Node &node = _nodes[ni];
+    if (node._count != 0) {
+      if ((size_t)node._first + node._count > _items.size()) {
+        return false;
+      }
+    } else {
+      // The children must follow their parent, or we could loop forever.
+      if (ni + 1 >= num_nodes || node._first <= ni + 1 ||
+          node._first >= num_nodes) {
+        return false;
+      }
+    }
+  }
+
+  Items::const_iterator ii;
+  for (ii = _items.begin(); ii != _items.end(); ++ii) {
+    if (*ii < 0 || (size_t)*ii >= num_items) {
+      return false;
+    }
+  }
+  for (ii = _unbounded_items.begin(); ii != _unbounded_items.end(); ++ii) {
+    if (*ii < 0 || (size_t)*ii >= num_items) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *
+ */
+void CollisionBVH::
+output(std::ostream &out) const {
+  out << "CollisionBVH, " << get_num_items() << " items in "
+      << _nodes.size() << " nodes";
+}
+
+/**
+ * Writes the contents of this object to the datagram for shipping out to a
+ * Bam file.
+ */
+void CollisionBVH::
+write_datagram(BamWriter *manager, Datagram &dg) const {
+  dg.add_uint32(_nodes.size());
+  Nodes::const_iterator ni;
+  for (ni = _nodes.begin(); ni != _nodes.end(); ++ni) {
+    (*ni)._min.write_datagram(dg);
+    (*ni)._max.write_datagram(dg);
+    dg.add_uint32((*ni)._first);
+    dg.add_uint32((*ni)._count);
+  }
+
+  dg.add_uint32(_items.size());
+  Items::const_iterator ii;
+  for (ii = _items.begin(); ii != _items.end(); ++ii) {
+    dg.add_int32(*ii);
+  }
+
+  dg.add_uint32(_unbounded_items.size());
+  for (ii = _unbounded_items.begin(); ii != _unbounded_items.end(); ++ii) {
+    dg.add_int32(*ii);
+  }
+}
+
+/**
+ * Reads the object that was previously written to a Bam file.
+ */
+void CollisionBVH::
+read_datagram(DatagramIterator &scan, BamReader *manager) {
+  size_t num_nodes = scan.get_uint32();
+  _nodes.clear();
+  _nodes.reserve(num_nodes);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    Node node;
+    node._min.read_datagram(scan);
+    node._max.read_datagram(scan);
+    node._first = scan.get_uint32();
+    node._count = scan.get_uint32();
+    _nodes.push_back(node);
+  }
+
+  size_t num_items = scan.get_uint32();
+  _items.clear();
+  _items.reserve(num_items);
+  for (size_t i = 0; i < num_items; ++i) {
+    _items.push_back(scan.get_int32());
+  }
+
+  size_t num_unbounded_items = scan.get_uint32();
+  _unbounded_items.clear();
+  _unbounded_items.reserve(num_unbounded_items);
+  for (size_t i = 0; i < num_unbounded_items; ++i) {
+    _unbounded_items.push_back(scan.get_int32());
+  }
+}
+
+/**
+ * Appends a node for the build items in the range [begin, end), followed by
+ * all of its descendants.
+ */
+void CollisionBVH::
+r_build(size_t begin, size_t end) {
+  nassertv(end > begin);
+
+  LPoint3 min_point = _build_items[begin]._min;
+  LPoint3 max_point = _build_items[begin]._max;
+  LPoint3 min_center = _build_items[begin]._center;
+  LPoint3 max_center = _build_items[begin]._center;
+  for (size_t i = begin + 1; i < end; ++i) {
+    const BuildItem &item = _build_items[i];
+    min_point = min_point.fmin(item._min);
+    max_point = max_point.fmax(item._max);
+    min_center = min_center.fmin(item._center);
+    max_center = max_center.fmax(item._center);
+  }
+
+  size_t ni = _nodes.size();
+  _nodes.push_back(Node());
+  _nodes[ni]._min = min_point;
+  _nodes[ni]._max = max_point;
+
+  if (end - begin <= max_leaf_items) {
+    _nodes[ni]._first = (uint32_t)_items.size();
+    _nodes[ni]._count = (uint32_t)(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      _items.push_back(_build_items[i]._index);
+    }
+    return;
+  }
+
+  // Split at the median item along the axis in which the item centers are
+  // most spread out.
+  LVector3 extent = max_center - min_center;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+
+  size_t mid = begin + (end - begin) / 2;
+  std::nth_element(_build_items.begin() + begin,
+                   _build_items.begin() + mid,
+                   _build_items.begin() + end,
+    [axis] (const BuildItem &a, const BuildItem &b) {
+      return a._center[axis] < b._center[axis];
+    });
+
+  _nodes[ni]._count = 0;
+  r_build(begin, mid);
+  _nodes[ni]._first = (uint32_t)_nodes.size();
+  r_build(mid, end);
+}
+
+/**
+ * Appends the items whose bounds overlap the indicated box.
+ */
+void CollisionBVH::
+find_box_overlaps(const LPoint3 &min_point, const LPoint3 &max_point,
+                  pvector<int> &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  uint32_t stack[max_depth + 1];
+  int sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const Node &node = _nodes[stack[--sp]];
+    if (node._min[0] > max_point[0] || node._max[0] < min_point[0] ||
+        node._min[1] > max_point[1] || node._max[1] < min_point[1] ||
+        node._min[2] > max_point[2] || node._max[2] < min_point[2]) {
+      continue;
+    }
+
+    if (node._count != 0) {
+      result.insert(result.end(), _items.begin() + node._first,
+                    _items.begin() + node._first + node._count);
+    } else {
+      nassertv(sp + 2 <= max_depth + 1);
+      stack[sp++] = node._first;
+      stack[sp++] = (uint32_t)(&node - &_nodes[0]) + 1;
+    }
+  }
+}
+
+/**
+ * Appends the items whose bounds are crossed by the indicated infinite line.
+ */
+void CollisionBVH::
+find_line_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                   pvector<int> &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  uint32_t stack[max_depth + 1];
+  int sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const Node &node = _nodes[stack[--sp]];
+
+    // Intersect the line with each pair of slabs in turn; if the ranges of
+    // the parameter don't overlap, the line misses the box.
+    bool hit = true;
+    double t_min = -std::numeric_limits<double>::infinity();
+    double t_max = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 3 && hit; ++i) {
+      if (IS_NEARLY_ZERO(direction[i])) {
+        hit = (origin[i] >= node._min[i] && origin[i] <= node._max[i]);
+      } else {
+        double t1 = (node._min[i] - origin[i]) / (double)direction[i];
+        double t2 = (node._max[i] - origin[i]) / (double)direction[i];
+        if (t1 > t2) {
+          std::swap(t1, t2);
+        }
+        t_min = std::max(t_min, t1);
+        t_max = std::min(t_max, t2);
+        hit = (t_min <= t_max);
+      }
+    }
+    if (!hit) {
+      continue;
+    }
+
+    if (node._count != 0) {
+      result.insert(result.end(), _items.begin() + node._first,
+                    _items.begin() + node._first + node._count);
+    } else {
+      nassertv(sp + 2 <= max_depth + 1);
+      stack[sp++] = node._first;
+      stack[sp++] = (uint32_t)(&node - &_nodes[0]) + 1;
+    }
+  }
+}
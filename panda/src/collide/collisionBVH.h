@@ -0,0 +1,109 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef COLLISIONBVH_H
+#define COLLISIONBVH_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "luse.h"
+#include "pvector.h"
+
+class GeometricBoundingVolume;
+class BamWriter;
+class BamReader;
+class Datagram;
+class DatagramIterator;
+
+/**
+ * A bounding volume hierarchy over a set of numbered items, such as the
+ * solids of a CollisionNode or the triangles of a Geom, used by the
+ * CollisionTraverser to quickly find the items that might intersect a
+ * collider without testing every one of them.
+ *
+ * The hierarchy is stored as a flat array of axis-aligned boxes in
+ * depth-first order, so that a query touches memory mostly sequentially.
+ * Items without a finite bounding volume are kept on a separate list and
+ * are returned by every query.
+ *
+ * This is static; if the items change, a new one must be built.
+ */
+class EXPCL_PANDA_COLLIDE CollisionBVH : public ReferenceCount {
+public:
+  CollisionBVH() = default;
+
+  void add_item(int index, const LPoint3 &min_point, const LPoint3 &max_point);
+  void add_item(int index, const GeometricBoundingVolume *volume);
+  INLINE void add_unbounded_item(int index);
+  void build();
+
+  INLINE size_t get_num_nodes() const;
+  INLINE size_t get_num_items() const;
+  bool is_valid(size_t num_items) const;
+
+  bool get_overlapping_items(const GeometricBoundingVolume *volume,
+                             pvector<int> &result) const;
+
+  void output(std::ostream &out) const;
+
+  void write_datagram(BamWriter *manager, Datagram &dg) const;
+  void read_datagram(DatagramIterator &scan, BamReader *manager);
+
+private:
+  void r_build(size_t begin, size_t end);
+  void find_box_overlaps(const LPoint3 &min_point, const LPoint3 &max_point,
+                         pvector<int> &result) const;
+  void find_line_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                          pvector<int> &result) const;
+
+  // Each node is either a leaf, which references _count consecutive entries
+  // of _items starting at _first, or an interior node, which has _count 0,
+  // and whose children are the node immediately following it and the node
+  // at index _first.
+  class Node {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    uint32_t _first;
+    uint32_t _count;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  typedef pvector<int> Items;
+  Items _items;
+  Items _unbounded_items;
+
+  // These are only used while building.
+  class BuildItem {
+  public:
+    int _index;
+    LPoint3 _min;
+    LPoint3 _max;
+    LPoint3 _center;
+  };
+  typedef pvector<BuildItem> BuildItems;
+  BuildItems _build_items;
+
+  static const size_t max_leaf_items = 4;
+  static const int max_depth = 64;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const CollisionBVH &bvh) {
+  bvh.output(out);
+  return out;
+}
+
+#include "collisionBVH.I"
+
+#endif
@@ -66,6 +66,9 @@ CollisionNode(const CollisionNode &copy) :
   _owner(nullptr),
   _owner_callback(nullptr)
 {
+  // The copy has the same solids, so it can share the same hierarchy.
+  LightMutexHolder holder(copy._bvh_lock);
+  _bvh = copy._bvh;
 }
 
 /**
@@ -116,6 +119,7 @@ xform(const LMatrix4 &mat) {
     solid->xform(mat);
   }
   mark_internal_bounds_stale();
+  mark_bvh_stale();
 }
 
 /**
@@ -144,6 +148,7 @@ combine_with(PandaNode *other) {
         const COWPT(CollisionSolid) *solids_end = solids_begin + cother->_solids.size();
         _solids.insert(_solids.end(), solids_begin, solids_end);
         mark_internal_bounds_stale();
+        mark_bvh_stale();
         return this;
       }
 
@@ -346,6 +351,43 @@ get_last_pos_state() {
 }
 
 
+/**
+ * Returns a bounding volume hierarchy over the solids in this node, which the
+ * CollisionTraverser uses to avoid testing against every solid of a node
+ * that has many of them.  The hierarchy is built the first time this is
+ * called after the solids have changed.
+ *
+ * Returns NULL if the node has fewer solids than collision-bvh-min-solids,
+ * in which case it isn't worth the trouble.
+ */
+CPT(CollisionBVH) CollisionNode::
+get_bvh() const {
+  int min_solids = collision_bvh_min_solids;
+  if (min_solids <= 0 || _solids.size() < (size_t)min_solids) {
+    return nullptr;
+  }
+
+  LightMutexHolder holder(_bvh_lock);
+  if (_bvh == nullptr) {
+    PT(CollisionBVH) bvh = new CollisionBVH;
+
+    int num_solids = (int)_solids.size();
+    for (int i = 0; i < num_solids; ++i) {
+      CPT(CollisionSolid) solid = _solids[i].get_read_pointer();
+      CPT(BoundingVolume) bounds = solid->get_bounds();
+      bvh->add_item(i, bounds->as_geometric_bounding_volume());
+    }
+    bvh->build();
+
+    if (collide_cat.is_debug()) {
+      collide_cat.debug()
+        << "Built " << *bvh << " for " << *this << "\n";
+    }
+    _bvh = std::move(bvh);
+  }
+  return _bvh;
+}
+
 /**
  * Tells the BamReader how to create objects of type CollisionNode.
  */
@@ -374,6 +416,15 @@ write_datagram(BamWriter *manager, Datagram &dg) {
   }
 
   dg.add_uint32(_from_collide_mask.get_word());
+
+  if (manager->get_file_minor_ver() >= 46) {
+    // Store the hierarchy as well, so that it need not be rebuilt on load.
+    CPT(CollisionBVH) bvh = get_bvh();
+    dg.add_bool(bvh != nullptr);
+    if (bvh != nullptr) {
+      bvh->write_datagram(manager, dg);
+    }
+  }
 }
 
 /**
@@ -430,4 +481,16 @@ fillin(DatagramIterator &scan, BamReader *manager) {
   }
 
   _from_collide_mask.set_word(scan.get_uint32());
+
+  _bvh.clear();
+  if (manager->get_file_minor_ver() >= 46 && scan.get_bool()) {
+    PT(CollisionBVH) bvh = new CollisionBVH;
+    bvh->read_datagram(scan, manager);
+    if (bvh->is_valid(num_solids)) {
+      _bvh = std::move(bvh);
+    } else {
+      collide_cat.warning()
+        << "Ignoring invalid collision hierarchy in " << *this << "\n";
+    }
+  }
 }
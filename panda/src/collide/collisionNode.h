@@ -17,9 +17,11 @@
 #include "pandabase.h"
 
 #include "collisionSolid.h"
+#include "collisionBVH.h"
 
 #include "collideMask.h"
 #include "pandaNode.h"
+#include "lightMutexHolder.h"
 
 /**
  * A node in the scene graph that can hold any number of CollisionSolids.
@@ -74,6 +76,8 @@ PUBLISHED:
   INLINE void set_collider_sort(int sort);
   MAKE_PROPERTY(collider_sort, get_collider_sort, set_collider_sort);
 
+  INLINE bool has_bvh() const;
+
   INLINE static CollideMask get_default_collide_mask();
   MAKE_PROPERTY(default_collide_mask, get_default_collide_mask);
 
@@ -82,6 +86,8 @@ public:
 
   INLINE void *get_owner() const;
 
+  CPT(CollisionBVH) get_bvh() const;
+
 #ifndef CPPPARSER
   INLINE void set_owner(void *owner, OwnerCallback *callback = nullptr);
   void clear_owner();
@@ -101,6 +107,7 @@ protected:
 
 private:
   CPT(RenderState) get_last_pos_state();
+  INLINE void mark_bvh_stale();
 
   // This data is not cycled, for now.  We assume the collision traversal will
   // take place in App only.  Perhaps we will revisit this later.
@@ -110,6 +117,11 @@ private:
   typedef pvector< COWPT(CollisionSolid) > Solids;
   Solids _solids;
 
+  // The hierarchy over the solids is built on demand, by whichever thread
+  // first needs it, and thrown away whenever the solids change.
+  mutable LightMutex _bvh_lock;
+  mutable PT(CollisionBVH) _bvh;
+
   void *_owner = nullptr;
   OwnerCallback *_owner_callback = nullptr;
 
@@ -24,6 +24,7 @@
 #include "collisionCapsule.h"
 #include "collisionPolygon.h"
 #include "collisionPlane.h"
+#include "collisionBVH.h"
 #include "config_collide.h"
 #include "boundingSphere.h"
 #include "transformState.h"
@@ -36,6 +37,10 @@
 #include "nodePath.h"
 #include "pStatTimer.h"
 #include "indent.h"
+#include "lightMutexHolder.h"
+#include "weakPointerTo.h"
+#include "workerThreadPool.h"
+#include "plist.h"
 
 #include <algorithm>
 
@@ -66,6 +71,181 @@ public:
   const CollisionTraverser &_trav;
 };
 
+// This caches a bounding volume hierarchy over the triangles of a collidable
+// Geom, used by compare_collider_to_geom().  Each one is kept until the Geom
+// or its vertex data is modified, or until it is pushed out of the cache by
+// collision-bvh-cache-size more recently used Geoms.
+class GeomTriangleBVH : public ReferenceCount {
+public:
+  static CPT(GeomTriangleBVH) get_bvh(const Geom *geom,
+                                      const GeomVertexData *data,
+                                      Thread *current_thread);
+
+  WCPT(Geom) _geom;
+  UpdateSeq _geom_modified;
+  WCPT(GeomVertexData) _data;
+  UpdateSeq _data_modified;
+
+  // False while the hierarchy is still being built by some thread.  This,
+  // and everything below, may only be looked at by other threads while
+  // holding _lock, until it becomes true.
+  bool _ready;
+
+  // Three vertices for each triangle, in the order the triangles appear in
+  // the Geom.  Degenerate triangles are left out.
+  pvector<LPoint3> _vertices;
+
+  // This is NULL if the Geom didn't have enough triangles to bother.
+  PT(CollisionBVH) _bvh;
+
+private:
+  void build(const Geom *geom, const GeomVertexData *data,
+             Thread *current_thread);
+
+  // Most recently used at the front.
+  typedef plist<const Geom *> LRU;
+
+  class CacheEntry {
+  public:
+    PT(GeomTriangleBVH) _bvh;
+    LRU::iterator _lru;
+  };
+  typedef pmap<const Geom *, CacheEntry> Cache;
+  static Cache *_cache;
+  static LRU *_lru;
+  static LightMutex _lock;
+};
+
+GeomTriangleBVH::Cache *GeomTriangleBVH::_cache = nullptr;
+GeomTriangleBVH::LRU *GeomTriangleBVH::_lru = nullptr;
+LightMutex GeomTriangleBVH::_lock("GeomTriangleBVH::_lock");
+
+/**
+ * Returns the hierarchy over the triangles of the indicated Geom, building it
+ * if necessary, or NULL if the Geom should just be tested triangle by
+ * triangle.  The data should be the Geom's vertex data.
+ *
+ * The hierarchy is built without holding the lock, so that threads
+ * traversing other Geoms aren't held up.  A thread that asks for a Geom whose
+ * hierarchy is still being built by another thread gets NULL, and tests that
+ * Geom triangle by triangle this time.
+ */
+CPT(GeomTriangleBVH) GeomTriangleBVH::
+get_bvh(const Geom *geom, const GeomVertexData *data, Thread *current_thread) {
+  int min_triangles = collision_bvh_min_solids;
+  if (min_triangles <= 0 || (int)geom->get_num_primitives() == 0) {
+    return nullptr;
+  }
+
+  // Animated vertices change every frame; it's not worth building a
+  // hierarchy for them.
+  CPT(GeomVertexData) orig_data = geom->get_vertex_data(current_thread);
+  if (orig_data->get_format()->get_animation().get_animation_type() != Geom::AT_none) {
+    return nullptr;
+  }
+
+  UpdateSeq geom_modified = geom->get_modified(current_thread);
+  UpdateSeq data_modified = data->get_modified(current_thread);
+
+  PT(GeomTriangleBVH) entry;
+  {
+    LightMutexHolder holder(_lock);
+    if (_cache == nullptr) {
+      _cache = new Cache;
+      _lru = new LRU;
+    }
+
+    Cache::iterator ci = _cache->find(geom);
+    if (ci != _cache->end()) {
+      CacheEntry &cache_entry = (*ci).second;
+      _lru->splice(_lru->begin(), *_lru, cache_entry._lru);
+
+      GeomTriangleBVH *existing = cache_entry._bvh;
+      if (!existing->_geom.was_deleted() &&
+          existing->_geom_modified == geom_modified &&
+          existing->_data == data && !existing->_data.was_deleted() &&
+          existing->_data_modified == data_modified) {
+        if (!existing->_ready || existing->_bvh == nullptr) {
+          return nullptr;
+        }
+        return existing;
+      }
+
+      // It's out of date; replace it.
+      entry = new GeomTriangleBVH;
+      cache_entry._bvh = entry;
+
+    } else {
+      entry = new GeomTriangleBVH;
+      _lru->push_front(geom);
+      CacheEntry &cache_entry = (*_cache)[geom];
+      cache_entry._bvh = entry;
+      cache_entry._lru = _lru->begin();
+
+      size_t max_size = (size_t)std::max((int)collision_bvh_cache_size, 1);
+      while (_cache->size() > max_size) {
+        _cache->erase(_lru->back());
+        _lru->pop_back();
+      }
+    }
+
+    entry->_geom = geom;
+    entry->_geom_modified = geom_modified;
+    entry->_data = data;
+    entry->_data_modified = data_modified;
+    entry->_ready = false;
+  }
+
+  // Nobody else touches the entry until it is marked ready, so we can build
+  // it without holding the lock.
+  entry->build(geom, data, current_thread);
+
+  {
+    LightMutexHolder holder(_lock);
+    entry->_ready = true;
+  }
+
+  return (entry->_bvh != nullptr) ? entry : nullptr;
+}
+
+/**
+ * Collects the triangles of the Geom and builds the hierarchy over them.
+ */
+void GeomTriangleBVH::
+build(const Geom *geom, const GeomVertexData *data, Thread *current_thread) {
+  GeomVertexReader vertex(data, InternalName::get_vertex(), current_thread);
+
+  int num_primitives = geom->get_num_primitives();
+  for (int i = 0; i < num_primitives; ++i) {
+    CPT(GeomPrimitive) tris = geom->get_primitive(i)->decompose();
+    nassertv(tris->is_of_type(GeomTriangles::get_class_type()));
+
+    int num_vertices = tris->get_num_vertices();
+    for (int vi = 0; vi + 2 < num_vertices; vi += 3) {
+      LPoint3 v[3];
+      for (int j = 0; j < 3; ++j) {
+        vertex.set_row_unsafe(tris->get_vertex(vi + j));
+        v[j] = vertex.get_data3();
+      }
+      if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
+        _vertices.insert(_vertices.end(), v, v + 3);
+      }
+    }
+  }
+
+  int num_triangles = (int)(_vertices.size() / 3);
+  if (num_triangles < collision_bvh_min_solids) {
+    return;
+  }
+
+  _bvh = new CollisionBVH;
+  for (int t = 0; t < num_triangles; ++t) {
+    const LPoint3 *v = &_vertices[t * 3];
+    _bvh->add_item(t, v[0].fmin(v[1]).fmin(v[2]), v[0].fmax(v[1]).fmax(v[2]));
+  }
+  _bvh->build();
+}
+
 /**
  *
  */
@@ -75,6 +255,7 @@ CollisionTraverser(const std::string &name) :
   _this_pcollector(_collisions_pcollector, name)
 {
   _respect_prev_transform = respect_prev_transform;
+  _parallel_traversal = parallel_collision_traversal;
   #ifdef DO_COLLISION_RECORDING
   _recorder = nullptr;
   #endif
@@ -273,8 +454,24 @@ traverse(const NodePath &root) {
   }
 
   bool traversal_done = false;
-  if ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
-      !allow_collider_multiple) {
+  if (_parallel_traversal && !_colliders.empty()) {
+    // Parallel traversal is not possible while a recorder is watching, since
+    // the recorder expects to be told about each test as it happens.
+    bool parallel = true;
+#ifdef DO_COLLISION_RECORDING
+    parallel = !has_recorder();
+#endif
+    if (parallel) {
+      // This is done even if the pool has no threads, so that the entries are
+      // delivered in the same order either way.
+      traverse_parallel(root, WorkerThreadPool::get_global_ptr());
+      traversal_done = true;
+    }
+  }
+
+  if (!traversal_done &&
+      ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
+       !allow_collider_multiple)) {
     // Use the single-word-at-a-time traverser, which might need to make lots
     // of passes.
     LevelStatesSingle level_states;
@@ -490,13 +687,15 @@ write(std::ostream &out, int indent_level) const {
  * use.
  *
  * This flavor uses a CollisionLevelStateSingle, which is limited to a certain
- * number of colliders per pass (typically 32).
+ * number of colliders per pass (typically 32).  A smaller limit may be given
+ * in order to divide the colliders into more passes.
  */
 void CollisionTraverser::
 prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
-                         const NodePath &root) {
+                         const NodePath &root, int max_colliders) {
+  nassertv(max_colliders > 0 &&
+           max_colliders <= CollisionLevelStateSingle::get_max_colliders());
   int num_colliders = _colliders.size();
-  int max_colliders = CollisionLevelStateSingle::get_max_colliders();
 
   CollisionLevelStateSingle level_state(root);
   // This reserve() call is only correct if there is exactly one solid per
@@ -594,9 +793,12 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           entry._from_node = from_node;
           entry._from_node_path = level_state.get_collider_node_path(c);
           entry._from = level_state.get_collider(c);
+          if (!_deferred_passes.empty()) {
+            _deferred_passes[pass]._collider = c;
+          }
 
           compare_collider_to_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -633,9 +835,12 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           #endif
           entry._from_node_path = level_state.get_collider_node_path(c);
           entry._from = level_state.get_collider(c);
+          if (!_deferred_passes.empty()) {
+            _deferred_passes[pass]._collider = c;
+          }
 
           compare_collider_to_geom_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -805,7 +1010,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -844,7 +1049,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -1014,7 +1219,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -1053,7 +1258,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry,
+              entry, pass,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -1113,11 +1318,77 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
   }
 }
 
+/**
+ * Performs the traversal using multiple threads from the indicated pool.  The
+ * colliders are divided into groups, one pass per group, and the passes run
+ * concurrently.  The detected collisions are held until all passes are done,
+ * and then handed to the handlers in collider order.
+ */
+void CollisionTraverser::
+traverse_parallel(const NodePath &root, WorkerThreadPool *pool) {
+  // Divide the solids evenly between the threads, but never more than will
+  // fit in a single-word mask.
+  int num_solids = 0;
+  OrderedColliders::const_iterator oci;
+  for (oci = _ordered_colliders.begin();
+       oci != _ordered_colliders.end();
+       ++oci) {
+    const CollisionNode *cnode = (const CollisionNode *)(*oci)._node_path.node();
+    num_solids += cnode->get_num_solids();
+  }
+  int num_jobs = pool->get_num_threads() + 1;
+  int max_colliders = (num_solids + num_jobs - 1) / num_jobs;
+  max_colliders = std::max(1, min(max_colliders,
+    CollisionLevelStateSingle::get_max_colliders()));
+
+  LevelStatesSingle level_states;
+  prepare_colliders_single(level_states, root, max_colliders);
+
+  size_t num_passes = level_states.size();
+  for (size_t pass = 0; pass < num_passes; ++pass) {
+    // Make sure the collectors exist before the threads need them.
+    get_pass_collector(pass);
+  }
+
+  nassertv(_deferred_passes.empty());
+  _deferred_passes.resize(num_passes);
+
+  pool->parallel_for(num_passes, [&] (size_t pass, Thread *current_thread) {
+#ifdef DO_PSTATS
+    PStatTimer pass_timer(_pass_collectors[pass], current_thread);
+#endif
+    if (level_states[pass].any_in_bounds()) {
+      r_traverse_single(level_states[pass], pass);
+    }
+  });
+
+  // Now hand the entries to the handlers.  The passes are consecutive ranges
+  // of the sorted colliders, so sorting within each pass (keeping the
+  // traversal order within each collider) yields the same order regardless
+  // of how the colliders were divided.
+  DeferredPasses passes;
+  passes.swap(_deferred_passes);
+
+  DeferredPasses::iterator dpi;
+  for (dpi = passes.begin(); dpi != passes.end(); ++dpi) {
+    DeferredEntries &entries = (*dpi)._entries;
+    std::stable_sort(entries.begin(), entries.end(),
+      [] (const DeferredEntry &a, const DeferredEntry &b) {
+        return a._collider < b._collider;
+      });
+
+    DeferredEntries::iterator dei;
+    for (dei = entries.begin(); dei != entries.end(); ++dei) {
+      (*dei)._handler->add_entry((*dei)._entry);
+    }
+  }
+}
+
 /**
  *
  */
 void CollisionTraverser::
-compare_collider_to_node(CollisionEntry &entry,
+compare_collider_to_node(CollisionEntry &entry, size_t pass,
                          const GeometricBoundingVolume *from_parent_gbv,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *into_node_gbv) {
@@ -1150,8 +1421,25 @@ compare_collider_to_node(CollisionEntry &entry,
       Colliders::const_iterator ci;
       ci = _colliders.find(entry.get_from_node_path());
       nassertv(ci != _colliders.end());
-      entry.test_intersection((*ci).second, this);
+      test_intersection(entry, pass, (*ci).second);
     } else {
+      // If the node has many solids, use its hierarchy to skip the ones that
+      // are nowhere near the collider.
+      CPT(CollisionBVH) bvh = cnode->get_bvh();
+      pvector<int> solids;
+      if (bvh != nullptr && bvh->get_overlapping_items(from_node_gbv, solids)) {
+        pvector<int>::const_iterator si;
+        for (si = solids.begin(); si != solids.end(); ++si) {
+          entry._into = cnode->_solids[*si].get_read_pointer(current_thread);
+
+          CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
+          const GeometricBoundingVolume *solid_gbv = solid_bv->as_geometric_bounding_volume();
+
+          compare_collider_to_solid(entry, pass, from_node_gbv, solid_gbv);
+        }
+        return;
+      }
+
       CollisionNode::Solids::const_iterator si;
       for (si = cnode->_solids.begin(); si != cnode->_solids.end(); ++si) {
         entry._into = (*si).get_read_pointer(current_thread);
@@ -1163,7 +1451,7 @@ compare_collider_to_node(CollisionEntry &entry,
         CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
         const GeometricBoundingVolume *solid_gbv = solid_bv->as_geometric_bounding_volume();
 
-        compare_collider_to_solid(entry, from_node_gbv, solid_gbv);
+        compare_collider_to_solid(entry, pass, from_node_gbv, solid_gbv);
       }
     }
   }
@@ -1173,7 +1461,7 @@ compare_collider_to_node(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_geom_node(CollisionEntry &entry,
+compare_collider_to_geom_node(CollisionEntry &entry, size_t pass,
                               const GeometricBoundingVolume *from_parent_gbv,
                               const GeometricBoundingVolume *from_node_gbv,
                               const GeometricBoundingVolume *into_node_gbv) {
@@ -1203,7 +1491,7 @@ compare_collider_to_geom_node(CollisionEntry &entry,
           geom_gbv = geom_bv->as_geometric_bounding_volume();
         }
 
-        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv);
+        compare_collider_to_geom(entry, pass, geom, from_node_gbv, geom_gbv);
       }
     }
   }
@@ -1213,7 +1501,7 @@ compare_collider_to_geom_node(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_solid(CollisionEntry &entry,
+compare_collider_to_solid(CollisionEntry &entry, size_t pass,
                           const GeometricBoundingVolume *from_node_gbv,
                           const GeometricBoundingVolume *solid_gbv) {
   bool within_solid_bounds = true;
@@ -1236,7 +1524,7 @@ compare_collider_to_solid(CollisionEntry &entry,
     Colliders::const_iterator ci;
     ci = _colliders.find(entry.get_from_node_path());
     nassertv(ci != _colliders.end());
-    entry.test_intersection((*ci).second, this);
+    test_intersection(entry, pass, (*ci).second);
   }
 }
 
@@ -1244,7 +1532,8 @@ compare_collider_to_solid(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+compare_collider_to_geom(CollisionEntry &entry, size_t pass,
+                         const Geom *geom,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *geom_gbv) {
   bool within_geom_bounds = true;
@@ -1261,6 +1550,25 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
     if (geom->get_primitive_type() == Geom::PT_polygons) {
       Thread *current_thread = Thread::get_current_thread();
       CPT(GeomVertexData) data = geom->get_animated_vertex_data(true, current_thread);
+
+      if (from_node_gbv != nullptr) {
+        // If the Geom has enough triangles, use a hierarchy to find the ones
+        // that are near the collider, rather than visiting every triangle.
+        CPT(GeomTriangleBVH) tri_bvh =
+          GeomTriangleBVH::get_bvh(geom, data, current_thread);
+        pvector<int> triangles;
+        if (tri_bvh != nullptr &&
+            tri_bvh->_bvh->get_overlapping_items(from_node_gbv, triangles)) {
+          pvector<int>::const_iterator ti;
+          for (ti = triangles.begin(); ti != triangles.end(); ++ti) {
+            compare_collider_to_triangle(entry, pass, (*ci).second,
+                                         &tri_bvh->_vertices[(*ti) * 3],
+                                         from_node_gbv);
+          }
+          return;
+        }
+      }
+
       GeomVertexReader vertex(data, InternalName::get_vertex());
 
       int num_primitives = geom->get_num_primitives();
@@ -1282,23 +1590,9 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
             vertex.set_row_unsafe(index.get_data1i());
             v[2] = vertex.get_data3();
 
-            // Generate a temporary CollisionGeom on the fly for each triangle
-            // in the Geom.
             if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
-              bool within_solid_bounds = true;
-              if (from_node_gbv != nullptr) {
-                BoundingSphere sphere;
-                sphere.around(v, v + 3);
-                within_solid_bounds = (sphere.contains(from_node_gbv) != 0);
-#ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
-#endif  // DO_PSTATS
-              }
-              if (within_solid_bounds) {
-                PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
-                entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
-              }
+              compare_collider_to_triangle(entry, pass, (*ci).second, v,
+                                           from_node_gbv);
             }
           }
         } else {
@@ -1312,23 +1606,9 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
             v[1] = vertex.get_data3();
             v[2] = vertex.get_data3();
 
-            // Generate a temporary CollisionGeom on the fly for each triangle
-            // in the Geom.
             if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
-              bool within_solid_bounds = true;
-              if (from_node_gbv != nullptr) {
-                BoundingSphere sphere;
-                sphere.around(v, v + 3);
-                within_solid_bounds = (sphere.contains(from_node_gbv) != 0);
-#ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
-#endif  // DO_PSTATS
-              }
-              if (within_solid_bounds) {
-                PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
-                entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
-              }
+              compare_collider_to_triangle(entry, pass, (*ci).second, v,
+                                           from_node_gbv);
             }
           }
         }
@@ -1337,6 +1617,63 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
   }
 }
 
+/**
+ * Tests the collider against a single triangle of a Geom, which must already
+ * have been verified with CollisionPolygon::verify_points().
+ */
+void CollisionTraverser::
+compare_collider_to_triangle(CollisionEntry &entry, size_t pass,
+                             CollisionHandler *handler, const LPoint3 *v,
+                             const GeometricBoundingVolume *from_node_gbv) {
+  bool within_solid_bounds = true;
+  if (from_node_gbv != nullptr) {
+    BoundingSphere sphere;
+    sphere.around(v, v + 3);
+    within_solid_bounds = (sphere.contains(from_node_gbv) != 0);
+#ifdef DO_PSTATS
+    CollisionGeom::_volume_pcollector.add_level(1);
+#endif  // DO_PSTATS
+  }
+  if (within_solid_bounds) {
+    // Generate a temporary CollisionGeom on the fly for the triangle.
+    PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
+    entry._into = cgeom;
+    test_intersection(entry, pass, handler);
+  }
+}
+
+/**
+ * Tests the "from" solid of the entry against its "into" solid, and passes
+ * the resulting CollisionEntry, if any, to the handler.  During a parallel
+ * traversal, the result is instead saved for the indicated pass, to be passed
+ * to the handler later.
+ */
+void CollisionTraverser::
+test_intersection(const CollisionEntry &entry, size_t pass,
+                  CollisionHandler *handler) {
+  if (_deferred_passes.empty()) {
+    entry.test_intersection(handler, this);
+    return;
+  }
+
+  PT(CollisionEntry) result = entry.get_from()->test_intersection(entry);
+#ifdef DO_PSTATS
+  ((CollisionSolid *)entry.get_into())->get_test_pcollector().add_level(1);
+#endif  // DO_PSTATS
+  if (handler->wants_all_potential_collidees() && result == nullptr) {
+    result = new CollisionEntry(entry);
+    result->reset_collided();
+  }
+  if (result != nullptr) {
+    DeferredPass &dpass = _deferred_passes[pass];
+    DeferredEntry dentry;
+    dentry._entry = std::move(result);
+    dentry._handler = handler;
+    dentry._collider = dpass._collider;
+    dpass._entries.push_back(std::move(dentry));
+  }
+}
+
 /**
  * Removes the indicated CollisionHandler from the list of handlers to be
  * processed, and returns the iterator to the next handler in the list.  This
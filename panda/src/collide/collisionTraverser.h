@@ -32,6 +32,7 @@ class CollisionVisualizer;
 class Geom;
 class NodePath;
 class CollisionEntry;
+class WorkerThreadPool;
 
 /**
  * This class manages the traversal through the scene graph to detect
@@ -53,6 +54,11 @@ PUBLISHED:
   MAKE_PROPERTY(respect_prev_transform, get_respect_prev_transform,
                                         set_respect_prev_transform);
 
+  INLINE void set_parallel_traversal(bool flag);
+  INLINE bool get_parallel_traversal() const;
+  MAKE_PROPERTY(parallel_traversal, get_parallel_traversal,
+                                    set_parallel_traversal);
+
   void add_collider(const NodePath &collider, CollisionHandler *handler);
   bool remove_collider(const NodePath &collider);
   bool has_collider(const NodePath &collider) const;
@@ -85,7 +91,8 @@ PUBLISHED:
 
 private:
   typedef pvector<CollisionLevelStateSingle> LevelStatesSingle;
-  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root);
+  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root,
+                                int max_colliders = CollisionLevelStateSingle::get_max_colliders());
   void r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass);
 
   typedef pvector<CollisionLevelStateDouble> LevelStatesDouble;
@@ -96,20 +103,29 @@ private:
   void prepare_colliders_quad(LevelStatesQuad &level_states, const NodePath &root);
   void r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass);
 
-  void compare_collider_to_node(CollisionEntry &entry,
+  void traverse_parallel(const NodePath &root, WorkerThreadPool *pool);
+
+  void compare_collider_to_node(CollisionEntry &entry, size_t pass,
                                 const GeometricBoundingVolume *from_parent_gbv,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *into_node_gbv);
-  void compare_collider_to_geom_node(CollisionEntry &entry,
+  void compare_collider_to_geom_node(CollisionEntry &entry, size_t pass,
                                      const GeometricBoundingVolume *from_parent_gbv,
                                      const GeometricBoundingVolume *from_node_gbv,
                                      const GeometricBoundingVolume *into_node_gbv);
-  void compare_collider_to_solid(CollisionEntry &entry,
+  void compare_collider_to_solid(CollisionEntry &entry, size_t pass,
                                  const GeometricBoundingVolume *from_node_gbv,
                                  const GeometricBoundingVolume *solid_gbv);
-  void compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+  void compare_collider_to_geom(CollisionEntry &entry, size_t pass,
+                                const Geom *geom,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *solid_gbv);
+  void compare_collider_to_triangle(CollisionEntry &entry, size_t pass,
+                                    CollisionHandler *handler,
+                                    const LPoint3 *v,
+                                    const GeometricBoundingVolume *from_node_gbv);
+  void test_intersection(const CollisionEntry &entry, size_t pass,
+                         CollisionHandler *handler);
 
   PStatCollector &get_pass_collector(int pass);
 
@@ -133,6 +149,26 @@ private:
   Handlers::iterator remove_handler(Handlers::iterator hi);
 
   bool _respect_prev_transform;
+  bool _parallel_traversal;
+
+  // During a parallel traversal, each pass stores the entries it detects
+  // here, to be passed on to the handlers in a deterministic order when all
+  // of the passes have finished.
+  class DeferredEntry {
+  public:
+    PT(CollisionEntry) _entry;
+    CollisionHandler *_handler;
+    int _collider;
+  };
+  typedef pvector<DeferredEntry> DeferredEntries;
+  class DeferredPass {
+  public:
+    DeferredEntries _entries;
+    int _collider;
+  };
+  typedef pvector<DeferredPass> DeferredPasses;
+  DeferredPasses _deferred_passes;
+
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder *_recorder;
   NodePath _collision_visualizer_np;
@@ -78,6 +78,14 @@ ConfigVariableBool allow_collider_multiple
           "false, a one-word BitMask is always used instead, which is faster "
           "per pass, but may require more passes."));
 
+ConfigVariableBool parallel_collision_traversal
+("parallel-collision-traversal", false,
+ PRC_DESC("Set this true to have new CollisionTraversers split the work of "
+          "each traversal across the threads of the shared worker thread "
+          "pool, by testing different groups of colliders on different "
+          "threads.  See CollisionTraverser::set_parallel_traversal().  The "
+          "number of threads is controlled by worker-thread-pool-size."));
+
 ConfigVariableBool flatten_collision_nodes
 ("flatten-collision-nodes", false,
  PRC_DESC("Set this true to allow NodePath::flatten_medium() and "
@@ -89,6 +97,21 @@ ConfigVariableBool flatten_collision_nodes
           "to be efficient, and combining CollisionNodes is likely "
           "to merge bounding volumes inappropriately."));
 
+ConfigVariableInt collision_bvh_min_solids
+("collision-bvh-min-solids", 16,
+ PRC_DESC("A CollisionNode with at least this many solids, or a collidable "
+          "Geom with at least this many triangles, gets a bounding volume "
+          "hierarchy, which the CollisionTraverser uses to find the solids "
+          "or triangles near a collider without testing against each one.  "
+          "Set this to 0 to disable the use of these hierarchies."));
+
+ConfigVariableInt collision_bvh_cache_size
+("collision-bvh-cache-size", 256,
+ PRC_DESC("The maximum number of collidable Geoms for which the hierarchy "
+          "over their triangles (see collision-bvh-min-solids) is kept "
+          "around.  When there are more, the ones that have gone the longest "
+          "without being collided with are discarded first."));
+
 ConfigVariableDouble collision_parabola_bounds_threshold
 ("collision-parabola-bounds-threshold", 10.0,
  PRC_DESC("This is the threshold size for a CollisionParabola to "
@@ -863,6 +863,8 @@ render_frame() {
     GeomCacheManager::_geom_cache_record_pcollector.clear_level();
     GeomCacheManager::_geom_cache_erase_pcollector.clear_level();
     GeomCacheManager::_geom_cache_evict_pcollector.clear_level();
+    GeomCacheManager::_geom_cache_hit_pcollector.clear_level();
+    GeomCacheManager::_geom_cache_miss_pcollector.clear_level();
 
     GraphicsStateGuardian::init_frame_pstats();
 
@@ -402,6 +402,26 @@ unlock_and_do_task() {
   nassertr(_manager != nullptr, DS_done);
   PT(ClockObject) clock = _manager->get_clock();
 
+  // It's important to release the lock while the task is being serviced.
+  _manager->_lock.unlock();
+
+  double dt = 0.0;
+  DoneStatus status = do_task_unlocked(clock, dt);
+
+  // Now reacquire the lock (so we can return with the lock held).
+  _manager->_lock.lock();
+
+  record_dt(dt);
+  return status;
+}
+
+/**
+ * Runs the task on the current thread, which must not hold the lock, and
+ * stores the time it took in dt.  The caller is responsible for passing this
+ * to record_dt() afterwards.
+ */
+AsyncTask::DoneStatus AsyncTask::
+do_task_unlocked(ClockObject *clock, double &dt) {
   // Indicate that this task is now the current task running on the thread.
   Thread *current_thread = Thread::get_current_thread();
   nassertr(current_thread->_current_task == nullptr, DS_interrupt);
@@ -422,23 +442,12 @@ unlock_and_do_task() {
   nassertr(current_thread->_current_task == this, DS_interrupt);
 #endif  // __GNUC__
 
-  // It's important to release the lock while the task is being serviced.
-  _manager->_lock.unlock();
-
   double start = clock->get_real_time();
   _task_pcollector.start();
   DoneStatus status = do_task();
   _task_pcollector.stop();
   double end = clock->get_real_time();
-
-  // Now reacquire the lock (so we can return with the lock held).
-  _manager->_lock.lock();
-
-  _dt = end - start;
-  _max_dt = std::max(_dt, _max_dt);
-  _total_dt += _dt;
-
-  _chain->_time_in_frame += _dt;
+  dt = end - start;
 
   // Now indicate that this is no longer the current task.
   nassertr(current_thread->_current_task == this, status);
@@ -459,6 +468,19 @@ unlock_and_do_task() {
   return status;
 }
 
+/**
+ * Updates the timing statistics of the task, and of its chain, after it has
+ * run for the indicated amount of time.  Assumes the lock is held.
+ */
+void AsyncTask::
+record_dt(double dt) {
+  _dt = dt;
+  _max_dt = std::max(_dt, _max_dt);
+  _total_dt += _dt;
+
+  _chain->_time_in_frame += _dt;
+}
+
 /**
  * Cancels this task.  This is equivalent to remove(), except for coroutines,
  * for which it will throw an exception into any currently pending await.
@@ -16,11 +16,14 @@
 
 #include "pandabase.h"
 #include "asyncFuture.h"
+#include "patomic.h"
 #include "namable.h"
 #include "pmutex.h"
 #include "conditionVar.h"
 #include "pStatCollector.h"
 
+class ClockObject;
+
 class AsyncTaskManager;
 class AsyncTaskChain;
 
@@ -123,6 +126,8 @@ PUBLISHED:
 protected:
   void jump_to_task_chain(AsyncTaskManager *manager);
   DoneStatus unlock_and_do_task();
+  DoneStatus do_task_unlocked(ClockObject *clock, double &dt);
+  void record_dt(double dt);
 
   virtual bool cancel();
   virtual bool is_task() const final {return true;}
@@ -142,8 +147,16 @@ protected:
   int _priority;
   unsigned int _implicit_sort;
 
-  State _state;
-  Thread *_servicing_thread;
+  // These are normally only changed while holding the manager's lock.  The
+  // exception is a chain in work-stealing mode, in which a thread takes a
+  // task off one of the chain's per-thread queues and marks it as being
+  // serviced while holding only that queue's lock.  They are atomic so that
+  // code holding the manager's lock may still read them at any time; it sees
+  // either the state before the task was taken or the state after.  Anything
+  // that needs to know for certain must take the queue's lock as well, as
+  // AsyncTaskChain::do_remove() does.
+  patomic<State> _state;
+  patomic<Thread *> _servicing_thread;
   AsyncTaskChain *_chain;
 
   double _start_time;
@@ -44,8 +44,10 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name, int num_threads,
   _cvar(manager->_lock),
   _tick_clock(false),
   _timeslice_priority(false),
+  _work_stealing(false),
   _num_threads(num_threads),
   _thread_priority(thread_priority),
+  _num_queued_tasks(0),
   _frame_budget(-1.0),
   _frame_sync(false),
   _num_busy_threads(0),
@@ -262,6 +264,46 @@ get_timeslice_priority() const {
   return _timeslice_priority;
 }
 
+/**
+ * Sets the work_stealing flag.  This changes the way the tasks are handed out
+ * to the threads of the task chain, and has no effect on a chain without
+ * threads.
+ *
+ * When this flag is false (the default), each thread takes the lock to pick
+ * up each task from a single shared queue, and takes it again to put the
+ * task back when it is done.  With many threads and many short tasks, the
+ * threads spend much of their time waiting on this lock.
+ *
+ * When this flag is true, the tasks of each sort value are instead dealt out
+ * to a separate queue for each thread, in priority order, and a thread that
+ * runs out of tasks steals them from the queues of the other threads.  A
+ * thread only takes the lock to requeue a batch of tasks it has finished.
+ * Tasks are still run in increasing order by sort value, and the
+ * frame_budget and timeslice_priority settings are still honored, although
+ * the order of tasks with different priorities is less strict.
+ */
+void AsyncTaskChain::
+set_work_stealing(bool work_stealing) {
+  MutexHolder holder(_manager->_lock);
+  if (_work_stealing != work_stealing) {
+    do_stop_threads();
+    _work_stealing = work_stealing;
+
+    if (_num_tasks != 0) {
+      do_start_threads();
+    }
+  }
+}
+
+/**
+ * Returns the work_stealing flag.  See set_work_stealing().
+ */
+bool AsyncTaskChain::
+get_work_stealing() const {
+  MutexHolder holder(_manager->_lock);
+  return _work_stealing;
+}
+
 /**
  * Stops any threads that are currently running.  If any tasks are still
  * pending and have not yet been picked up by a thread, they will not be
@@ -533,7 +575,17 @@ do_remove(AsyncTask *task, bool upon_death) {
           _next_active.erase(_next_active.begin() + index);
         } else {
           index = find_task_on_heap(_this_active, task);
-          nassertr(index != -1, false);
+          if (index == -1) {
+            // In work-stealing mode, it may be on one of the threads' queues.
+            // If it isn't, a thread must have just taken it off one to
+            // service it, without holding our lock.
+            nassertr(_work_stealing, false);
+            if (!remove_queued_task(task)) {
+              nassertr(task->_state == AsyncTask::S_servicing, false);
+              task->_state = AsyncTask::S_servicing_removed;
+              return true;
+            }
+          }
         }
       }
       cleanup_task(task, upon_death, false);
@@ -652,7 +704,8 @@ do_has_task(AsyncTask *task) const {
   return (find_task_on_heap(_active, task) != -1 ||
           find_task_on_heap(_next_active, task) != -1 ||
           find_task_on_heap(_sleeping, task) != -1 ||
-          find_task_on_heap(_this_active, task) != -1);
+          find_task_on_heap(_this_active, task) != -1 ||
+          has_queued_task(task));
 }
 
 /**
@@ -707,88 +760,342 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
     }
     task->_servicing_thread = nullptr;
 
-    if (task->_chain == this) {
-      if (task->_state == AsyncTask::S_servicing_removed) {
-        // This task wants to kill itself.
-        cleanup_task(task, true, false);
+    finish_servicing(task, ds);
 
-      } else if (task->_chain_name != get_name()) {
-        // The task wants to jump to a different chain.
-        PT(AsyncTask) hold_task = task;
-        cleanup_task(task, false, false);
-        task->jump_to_task_chain(_manager);
+    if (task_cat.is_spam()) {
+      task_cat.spam()
+        << "Done servicing " << *task << " in "
+        << *Thread::get_current_thread() << "\n";
+    }
+  }
+  thread_consider_yield();
+}
 
-      } else {
-        switch (ds) {
-        case AsyncTask::DS_cont:
-          // The task is still alive; put it on the next frame's active queue.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          _cvar.notify_all();
-          break;
-
-        case AsyncTask::DS_again:
-          // The task wants to sleep again.
-          {
-            double now = _manager->_clock->get_frame_time();
-            task->_wake_time = now + task->get_delay();
-            task->_start_time = task->_wake_time;
-            task->_state = AsyncTask::S_sleeping;
-            _sleeping.push_back(task);
-            push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
-            if (task_cat.is_spam()) {
-              task_cat.spam()
-                << "Sleeping " << *task << ", wake time at "
-                << task->_wake_time - now << "\n";
-            }
-            _cvar.notify_all();
-          }
-          break;
+/**
+ * Called after a task has been serviced, to put it back on the appropriate
+ * queue according to its return value, or to clean it up if it is done.
+ * Assumes the lock is held.
+ *
+ * Note that the lock may be temporarily released by this method.
+ */
+void AsyncTaskChain::
+finish_servicing(AsyncTask *task, AsyncTask::DoneStatus ds) {
+  if (task->_chain == this) {
+    if (task->_state == AsyncTask::S_servicing_removed) {
+      // This task wants to kill itself.
+      cleanup_task(task, true, false);
+
+    } else if (task->_chain_name != get_name()) {
+      // The task wants to jump to a different chain.
+      PT(AsyncTask) hold_task = task;
+      cleanup_task(task, false, false);
+      task->jump_to_task_chain(_manager);
 
-        case AsyncTask::DS_pickup:
-          // The task wants to run again this frame if possible.
-          task->_state = AsyncTask::S_active;
-          _this_active.push_back(task);
-          _cvar.notify_all();
-          break;
-
-        case AsyncTask::DS_interrupt:
-          // The task had an exception and wants to raise a big flag.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          if (_state == S_started) {
-            _state = S_interrupted;
-            _cvar.notify_all();
+    } else {
+      switch (ds) {
+      case AsyncTask::DS_cont:
+        // The task is still alive; put it on the next frame's active queue.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        _cvar.notify_all();
+        break;
+
+      case AsyncTask::DS_again:
+        // The task wants to sleep again.
+        {
+          double now = _manager->_clock->get_frame_time();
+          task->_wake_time = now + task->get_delay();
+          task->_start_time = task->_wake_time;
+          task->_state = AsyncTask::S_sleeping;
+          _sleeping.push_back(task);
+          push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
+          if (task_cat.is_spam()) {
+            task_cat.spam()
+              << "Sleeping " << *task << ", wake time at "
+              << task->_wake_time - now << "\n";
           }
-          break;
-
-        case AsyncTask::DS_await:
-          // The task wants to wait for another one to finish.
-          task->_state = AsyncTask::S_awaiting;
           _cvar.notify_all();
-          ++_num_awaiting_tasks;
-          break;
-
-        default:
-          // The task has finished.
-          cleanup_task(task, true, true);
         }
+        break;
+
+      case AsyncTask::DS_pickup:
+        // The task wants to run again this frame if possible.
+        task->_state = AsyncTask::S_active;
+        _this_active.push_back(task);
+        _cvar.notify_all();
+        break;
+
+      case AsyncTask::DS_interrupt:
+        // The task had an exception and wants to raise a big flag.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        if (_state == S_started) {
+          _state = S_interrupted;
+          _cvar.notify_all();
+        }
+        break;
+
+      case AsyncTask::DS_await:
+        // The task wants to wait for another one to finish.
+        task->_state = AsyncTask::S_awaiting;
+        _cvar.notify_all();
+        ++_num_awaiting_tasks;
+        break;
+
+      default:
+        // The task has finished.
+        cleanup_task(task, true, true);
       }
-    } else {
-      task_cat.error()
-        << "Task is no longer on chain " << get_name()
-        << ": " << *task << "\n";
+    }
+  } else {
+    task_cat.error()
+      << "Task is no longer on chain " << get_name()
+      << ": " << *task << "\n";
+  }
+}
+
+/**
+ * Called in work-stealing mode to deal out the tasks of the current sort
+ * value from the active queue to the queues of the threads.  The tasks are
+ * dealt in priority order, so that each thread's queue is itself in priority
+ * order, and the first tasks taken by all of the threads are the ones with
+ * the highest priority.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+distribute_sort_group() {
+  size_t num_threads = _queue_threads.size();
+  nassertv(num_threads != 0);
+
+  pvector<TaskHeap> deals(num_threads);
+  size_t ti = 0;
+  int num_dealt = 0;
+  while (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+    PT(AsyncTask) task = _active.front();
+    pop_heap(_active.begin(), _active.end(), AsyncTaskSortPriority());
+    _active.pop_back();
+
+    deals[ti].push_back(std::move(task));
+    ti = (ti + 1) % num_threads;
+    ++num_dealt;
+  }
+
+  for (ti = 0; ti < num_threads; ++ti) {
+    if (!deals[ti].empty()) {
+      AsyncTaskChainThread *thread = _queue_threads[ti];
+      MutexHolder holder(thread->_queue_lock);
+      thread->_queue.insert(thread->_queue.end(), deals[ti].begin(), deals[ti].end());
+    }
+  }
+  _num_queued_tasks.fetch_add(num_dealt);
+
+  if (task_cat.is_spam()) {
+    do_output(task_cat.spam());
+    task_cat.spam(false)
+      << ": dealt " << num_dealt << " tasks with sort " << _current_sort
+      << " to " << num_threads << " threads\n";
+  }
+  _cvar.notify_all();
+}
+
+/**
+ * Called in work-stealing mode by one of the threads to run a batch of tasks
+ * from the threads' queues.  Assumes the lock is held; it is released while
+ * the tasks are running, and held again when this returns.
+ */
+void AsyncTaskChain::
+service_queued_tasks(AsyncTaskChainThread *thread) {
+  if (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+    distribute_sort_group();
+  }
+
+  // If there is a frame budget, we must check it between tasks, which we can
+  // only do while holding the lock.
+  int max_tasks = (_frame_budget >= 0.0) ? 1 : max_tasks_per_batch;
+  PT(ClockObject) clock = _manager->_clock;
+
+  _manager->_lock.unlock();
+  for (int i = 0; i < max_tasks; ++i) {
+    PT(AsyncTask) task = take_queued_task(thread);
+    if (task == nullptr) {
+      break;
     }
 
     if (task_cat.is_spam()) {
       task_cat.spam()
-        << "Done servicing " << *task << " in "
-        << *Thread::get_current_thread() << "\n";
+        << "Servicing " << *task << " in " << *thread << "\n";
+    }
+
+    double dt = 0.0;
+    AsyncTask::DoneStatus ds = task->do_task_unlocked(clock, dt);
+
+    {
+      MutexHolder holder(thread->_queue_lock);
+      thread->_servicing = nullptr;
+      AsyncTaskChainThread::FinishedTask finished;
+      finished._task = std::move(task);
+      finished._status = ds;
+      finished._dt = dt;
+      thread->_finished.push_back(std::move(finished));
+    }
+
+    // A task that is done, or that is waiting on something else, may have
+    // others waiting on it in turn, so don't leave it in the batch.
+    if (ds != AsyncTask::DS_cont && ds != AsyncTask::DS_again &&
+        ds != AsyncTask::DS_pickup) {
+      break;
     }
   }
+  _manager->_lock.lock();
+
+  flush_finished_tasks(thread);
   thread_consider_yield();
 }
 
+/**
+ * Takes the next task off the indicated thread's queue, or, if it is empty,
+ * off the queue of one of the other threads, and marks it as being serviced
+ * by the indicated thread.  Returns nullptr if all of the queues are empty.
+ *
+ * This is called by the thread itself, without holding the lock.
+ */
+PT(AsyncTask) AsyncTaskChain::
+take_queued_task(AsyncTaskChainThread *thread) {
+  size_t num_threads = _queue_threads.size();
+  for (size_t i = 0; i < num_threads; ++i) {
+    // A thread that steals also takes the front of the queue, the same as
+    // the thread that owns it, since that is the highest-priority task.
+    AsyncTaskChainThread *victim = _queue_threads[(thread->_queue_index + i) % num_threads];
+    PT(AsyncTask) task;
+    {
+      MutexHolder holder(victim->_queue_lock);
+      if (victim->_queue.empty()) {
+        continue;
+      }
+      task = std::move(victim->_queue.front());
+      victim->_queue.pop_front();
+      _num_queued_tasks.fetch_sub(1);
+
+      // This must be done while the task is still protected by the queue's
+      // lock; see do_remove().
+      nassertr(task->_state == AsyncTask::S_active, nullptr);
+      task->_state = AsyncTask::S_servicing;
+      task->_servicing_thread = thread;
+    }
+
+    MutexHolder holder(thread->_queue_lock);
+    thread->_servicing = task;
+    return task;
+  }
+
+  return nullptr;
+}
+
+/**
+ * Called in work-stealing mode to requeue the tasks the indicated thread has
+ * finished running.  Assumes the lock is held.
+ *
+ * Note that the lock may be temporarily released by this method.
+ */
+void AsyncTaskChain::
+flush_finished_tasks(AsyncTaskChainThread *thread) {
+  AsyncTaskChainThread::FinishedTasks finished;
+  {
+    MutexHolder holder(thread->_queue_lock);
+    finished.swap(thread->_finished);
+  }
+
+  for (AsyncTaskChainThread::FinishedTask &ft : finished) {
+    AsyncTask *task = ft._task;
+    task->_servicing_thread = nullptr;
+    if (task->_chain == this) {
+      task->record_dt(ft._dt);
+    }
+    finish_servicing(task, ft._status);
+
+    if (task_cat.is_spam()) {
+      task_cat.spam()
+        << "Done servicing " << *task << " in " << *thread << "\n";
+    }
+  }
+}
+
+/**
+ * Moves all of the tasks that are waiting on the threads' queues back to the
+ * active queue.  This is done when the threads stop, or run out of frame
+ * budget.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+reclaim_queued_tasks() {
+  if (_num_queued_tasks.load() == 0) {
+    return;
+  }
+
+  for (AsyncTaskChainThread *thread : _queue_threads) {
+    MutexHolder holder(thread->_queue_lock);
+    _num_queued_tasks.fetch_sub((int)thread->_queue.size());
+    _active.insert(_active.end(), thread->_queue.begin(), thread->_queue.end());
+    thread->_queue.clear();
+  }
+  make_heap(_active.begin(), _active.end(), AsyncTaskSortPriority());
+}
+
+/**
+ * Removes the indicated task from whichever thread's queue it is on.
+ * Returns true if it was found, false otherwise.  Assumes the lock is held.
+ */
+bool AsyncTaskChain::
+remove_queued_task(AsyncTask *task) {
+  for (AsyncTaskChainThread *thread : _queue_threads) {
+    MutexHolder holder(thread->_queue_lock);
+    auto it = std::find(thread->_queue.begin(), thread->_queue.end(), task);
+    if (it != thread->_queue.end()) {
+      thread->_queue.erase(it);
+      _num_queued_tasks.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns true if the indicated task is waiting on one of the threads'
+ * queues.  Assumes the lock is held.
+ */
+bool AsyncTaskChain::
+has_queued_task(AsyncTask *task) const {
+  for (AsyncTaskChainThread *thread : _queue_threads) {
+    MutexHolder holder(thread->_queue_lock);
+    if (std::find(thread->_queue.begin(), thread->_queue.end(), task) != thread->_queue.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Adds the tasks that are currently in the hands of the threads to the
+ * indicated list: the ones being serviced, and, in work-stealing mode, the
+ * ones waiting on their queues or waiting to be requeued.  Assumes the lock
+ * is held.
+ */
+void AsyncTaskChain::
+get_servicing_tasks(TaskHeap &result) const {
+#ifdef HAVE_THREADS
+  Threads::const_iterator thi;
+  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
+    AsyncTaskChainThread *thread = (*thi);
+    MutexHolder holder(thread->_queue_lock);
+    if (thread->_servicing != nullptr) {
+      result.push_back(thread->_servicing);
+    }
+    result.insert(result.end(), thread->_queue.begin(), thread->_queue.end());
+    for (const AsyncTaskChainThread::FinishedTask &ft : thread->_finished) {
+      result.push_back(ft._task);
+    }
+  }
+#endif
+}
+
 /**
  * Called internally when a task has completed (or been interrupted) and is
  * about to be removed from the active queue.  Assumes the lock is held.
@@ -1060,6 +1367,10 @@ do_stop_threads() {
     _cvar.notify_all();
     _manager->_frame_cvar.notify_all();
 
+    // Any tasks still waiting on the threads' queues go back on the active
+    // queue, to be picked up again when the threads are restarted.
+    reclaim_queued_tasks();
+
 #ifdef HAVE_THREADS
     Threads wait_threads;
     wait_threads.swap(_threads);
@@ -1082,6 +1393,7 @@ do_stop_threads() {
       }
     }
     _manager->_lock.lock();
+    _queue_threads.clear();
 #endif
 
     _state = S_initial;
@@ -1118,10 +1430,13 @@ do_start_threads() {
         ostringstream strm;
         strm << _manager->get_name() << "_" << get_name() << "_" << i;
         PT(AsyncTaskChainThread) thread = new AsyncTaskChainThread(strm.str(), this);
+        thread->_queue_index = _threads.size();
         if (thread->start(_thread_priority, true)) {
           _threads.push_back(thread);
         }
       }
+
+      _queue_threads.assign(_threads.begin(), _threads.end());
     }
 #endif
   }
@@ -1135,16 +1450,14 @@ AsyncTaskCollection AsyncTaskChain::
 do_get_active_tasks() const {
   AsyncTaskCollection result;
 
-#ifdef HAVE_THREADS
-  Threads::const_iterator thi;
-  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
-    AsyncTask *task = (*thi)->_servicing;
-    if (task != nullptr) {
-      result.add_task(task);
-    }
-  }
-#endif
+  TaskHeap servicing;
+  get_servicing_tasks(servicing);
+
   TaskHeap::const_iterator ti;
+  for (ti = servicing.begin(); ti != servicing.end(); ++ti) {
+    AsyncTask *task = (*ti);
+    result.add_task(task);
+  }
   for (ti = _active.begin(); ti != _active.end(); ++ti) {
     AsyncTask *task = (*ti);
     result.add_task(task);
@@ -1304,6 +1617,10 @@ do_write(ostream &out, int indent_level) const {
     indent(out, indent_level + 2)
       << "timeslice priority\n";
   }
+  if (_work_stealing) {
+    indent(out, indent_level + 2)
+      << "work stealing\n";
+  }
   if (_tick_clock) {
     indent(out, indent_level + 2)
       << "tick clock\n";
@@ -1331,16 +1648,7 @@ do_write(ostream &out, int indent_level) const {
   TaskHeap tasks = _active;
   tasks.insert(tasks.end(), _this_active.begin(), _this_active.end());
   tasks.insert(tasks.end(), _next_active.begin(), _next_active.end());
-
-#ifdef HAVE_THREADS
-  Threads::const_iterator thi;
-  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
-    AsyncTask *task = (*thi)->_servicing;
-    if (task != nullptr) {
-      tasks.push_back(task);
-    }
-  }
-#endif
+  get_servicing_tasks(tasks);
 
   double now = _manager->_clock->get_frame_time();
 
@@ -1428,7 +1736,8 @@ AsyncTaskChain::AsyncTaskChainThread::
 AsyncTaskChainThread(const string &name, AsyncTaskChain *chain) :
   Thread(name, chain->get_name()),
   _chain(chain),
-  _servicing(nullptr)
+  _servicing(nullptr),
+  _queue_index(0)
 {
 }
 
@@ -1441,8 +1750,9 @@ thread_main() {
   MutexHolder holder(_chain->_manager->_lock);
   while (_chain->_state != S_shutdown && _chain->_state != S_interrupted) {
     thread_consider_yield();
-    if (!_chain->_active.empty() &&
-        _chain->_active.front()->get_sort() == _chain->_current_sort) {
+    if (_chain->_num_queued_tasks.load() != 0 ||
+        (!_chain->_active.empty() &&
+         _chain->_active.front()->get_sort() == _chain->_current_sort)) {
 
       int frame = _chain->_manager->_clock->get_frame_count();
       if (_chain->_current_frame != frame) {
@@ -1454,6 +1764,8 @@ thread_main() {
       // If we've exceeded our frame budget, sleep until the next frame.
       if (_chain->_block_till_next_frame ||
           (_chain->_frame_budget >= 0.0 && _chain->_time_in_frame >= _chain->_frame_budget)) {
+        // The tasks that were dealt out will be dealt again next frame.
+        _chain->reclaim_queued_tasks();
         while ((_chain->_block_till_next_frame ||
                 (_chain->_frame_budget >= 0.0 && _chain->_time_in_frame >= _chain->_frame_budget)) &&
                _chain->_state != S_shutdown && _chain->_state != S_interrupted) {
@@ -1472,7 +1784,11 @@ thread_main() {
 
       PStatTimer timer(_task_pcollector);
       _chain->_num_busy_threads++;
-      _chain->service_one_task(this);
+      if (_chain->_work_stealing) {
+        _chain->service_queued_tasks(this);
+      } else {
+        _chain->service_one_task(this);
+      }
       _chain->_num_busy_threads--;
       _chain->_cvar.notify_all();
 
@@ -25,6 +25,8 @@
 #include "pdeque.h"
 #include "pStatCollector.h"
 #include "clockObject.h"
+#include "pmutex.h"
+#include "patomic.h"
 
 class AsyncTaskManager;
 
@@ -46,6 +48,10 @@ class AsyncTaskManager;
  * parallelism.  Tasks with different sort values are never run in parallel
  * together, but tasks with different priority values might be (if there is
  * more than one thread).
+ *
+ * By default, all of the threads take their tasks from one shared queue.  See
+ * set_work_stealing() for an alternative that scales better to many threads
+ * and many short tasks.
  */
 class EXPCL_PANDA_EVENT AsyncTaskChain : public TypedReferenceCount, public Namable {
 public:
@@ -73,6 +79,9 @@ PUBLISHED:
   void set_timeslice_priority(bool timeslice_priority);
   bool get_timeslice_priority() const;
 
+  BLOCKING void set_work_stealing(bool work_stealing);
+  bool get_work_stealing() const;
+
   BLOCKING void stop_threads();
   void start_threads();
   INLINE bool is_started() const;
@@ -111,6 +120,15 @@ protected:
   int find_task_on_heap(const TaskHeap &heap, AsyncTask *task) const;
 
   void service_one_task(AsyncTaskChainThread *thread);
+  void finish_servicing(AsyncTask *task, AsyncTask::DoneStatus ds);
+  void distribute_sort_group();
+  void service_queued_tasks(AsyncTaskChainThread *thread);
+  PT(AsyncTask) take_queued_task(AsyncTaskChainThread *thread);
+  void flush_finished_tasks(AsyncTaskChainThread *thread);
+  void reclaim_queued_tasks();
+  bool remove_queued_task(AsyncTask *task);
+  bool has_queued_task(AsyncTask *task) const;
+  void get_servicing_tasks(TaskHeap &result) const;
   void cleanup_task(AsyncTask *task, bool upon_death, bool clean_exit);
   bool finish_sort_group();
   void filter_timeslice_priority();
@@ -135,6 +153,23 @@ protected:
 
     AsyncTaskChain *_chain;
     AsyncTask *_servicing;
+
+    // These are used only in work-stealing mode, and are protected by
+    // _queue_lock rather than by the manager's lock.  The queue holds the
+    // tasks of the current sort group that were dealt to this thread, and
+    // _finished the tasks it has run but not yet requeued.
+    class FinishedTask {
+    public:
+      PT(AsyncTask) _task;
+      AsyncTask::DoneStatus _status;
+      double _dt;
+    };
+    typedef pvector<FinishedTask> FinishedTasks;
+
+    mutable Mutex _queue_lock;
+    pdeque< PT(AsyncTask) > _queue;
+    FinishedTasks _finished;
+    size_t _queue_index;
   };
 
   class AsyncTaskSortWakeTime {
@@ -163,6 +198,7 @@ protected:
   };
 
   typedef pvector< PT(AsyncTaskChainThread) > Threads;
+  typedef pvector<AsyncTaskChainThread *> QueueThreads;
 
   AsyncTaskManager *_manager;
 
@@ -177,9 +213,17 @@ protected:
 
   bool _tick_clock;
   bool _timeslice_priority;
+  bool _work_stealing;
   int _num_threads;
   ThreadPriority _thread_priority;
   Threads _threads;
+
+  // A copy of _threads that the threads may look at without holding the
+  // lock, in order to steal work from each other.  It only changes while
+  // none of the threads are running.
+  QueueThreads _queue_threads;
+  patomic<int> _num_queued_tasks;
+
   double _frame_budget;
   bool _frame_sync;
   int _num_busy_threads;
@@ -200,6 +244,10 @@ protected:
 
   unsigned int _next_implicit_sort;
 
+  // The most tasks a thread will run in work-stealing mode before it takes
+  // the lock again to requeue them.
+  static const int max_tasks_per_batch = 16;
+
   static PStatCollector _task_pcollector;
   static PStatCollector _wait_pcollector;
 
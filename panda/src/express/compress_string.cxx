@@ -27,14 +27,18 @@ using std::string;
 /**
  * Compress the indicated source string at the given compression level (1
  * through 9).  Returns the compressed string.
+ *
+ * If a codec other than zlib is given, the result is in a format that can
+ * only be read back by this version of Panda or later.
  */
 string
-compress_string(const string &source, int compression_level) {
+compress_string(const string &source, int compression_level,
+                CompressionCodec::Codec codec) {
   ostringstream dest;
 
   {
     OCompressStream compress;
-    compress.open(&dest, false, compression_level);
+    compress.open(&dest, false, compression_level, true, codec);
     compress.write(source.data(), source.length());
 
     if (compress.fail()) {
@@ -71,7 +75,8 @@ decompress_string(const string &source) {
  * value is bool on success, or false on failure.
  */
 EXPCL_PANDA_EXPRESS bool
-compress_file(const Filename &source, const Filename &dest, int compression_level) {
+compress_file(const Filename &source, const Filename &dest, int compression_level,
+              CompressionCodec::Codec codec) {
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
   Filename source_filename = source;
   if (!source_filename.is_binary_or_text()) {
@@ -92,7 +97,7 @@ compress_file(const Filename &source, const Filename &dest, int compression_leve
     return false;
   }
 
-  bool result = compress_stream(*source_stream, *dest_stream, compression_level);
+  bool result = compress_stream(*source_stream, *dest_stream, compression_level, codec);
   vfs->close_read_file(source_stream);
   vfs->close_write_file(dest_stream);
   return result;
@@ -142,9 +147,10 @@ decompress_file(const Filename &source, const Filename &dest) {
  * The return value is bool on success, or false on failure.
  */
 bool
-compress_stream(istream &source, ostream &dest, int compression_level) {
+compress_stream(istream &source, ostream &dest, int compression_level,
+                CompressionCodec::Codec codec) {
   OCompressStream compress;
-  compress.open(&dest, false, compression_level);
+  compress.open(&dest, false, compression_level, true, codec);
 
   static const size_t buffer_size = 4096;
   char buffer[buffer_size];
@@ -19,22 +19,26 @@
 #ifdef HAVE_ZLIB
 
 #include "filename.h"
+#include "compressionCodec.h"
 
 BEGIN_PUBLISH
 
 EXPCL_PANDA_EXPRESS std::string
-compress_string(const std::string &source, int compression_level);
+compress_string(const std::string &source, int compression_level,
+                CompressionCodec::Codec codec = CompressionCodec::C_zlib);
 
 EXPCL_PANDA_EXPRESS std::string
 decompress_string(const std::string &source);
 
 EXPCL_PANDA_EXPRESS bool
-compress_file(const Filename &source, const Filename &dest, int compression_level);
+compress_file(const Filename &source, const Filename &dest, int compression_level,
+              CompressionCodec::Codec codec = CompressionCodec::C_zlib);
 EXPCL_PANDA_EXPRESS bool
 decompress_file(const Filename &source, const Filename &dest);
 
 EXPCL_PANDA_EXPRESS bool
-compress_stream(std::istream &source, std::ostream &dest, int compression_level);
+compress_stream(std::istream &source, std::ostream &dest, int compression_level,
+                CompressionCodec::Codec codec = CompressionCodec::C_zlib);
 EXPCL_PANDA_EXPRESS bool
 decompress_stream(std::istream &source, std::ostream &dest);
 
@@ -0,0 +1,258 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file compressionCodec.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "compressionCodec.h"
+#include "config_express.h"
+#include "string_utils.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <limits.h>
+
+/**
+ * Returns true if the indicated codec was compiled into this build of Panda,
+ * false otherwise.
+ */
+bool CompressionCodec::
+is_available(Codec codec) {
+  switch (codec) {
+  case C_zlib:
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+
+  case C_lz4:
+#ifdef HAVE_LZ4
+    return true;
+#else
+    return false;
+#endif
+
+  case C_zstd:
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  return false;
+}
+
+/**
+ * Returns the name of the indicated codec, as accepted in a Config.prc file.
+ */
+std::string CompressionCodec::
+get_name(Codec codec) {
+  switch (codec) {
+  case C_zlib:
+    return "zlib";
+
+  case C_lz4:
+    return "lz4";
+
+  case C_zstd:
+    return "zstd";
+  }
+
+  return "**invalid**";
+}
+
+/**
+ * Returns the size of the buffer that compress() needs in order to be
+ * guaranteed to succeed, given the size of the uncompressed data.  Returns 0
+ * if the codec is not available, or the data is too large for it.
+ */
+size_t CompressionCodec::
+get_max_compressed_size(Codec codec, size_t source_size) {
+  switch (codec) {
+  case C_zlib:
+#ifdef HAVE_ZLIB
+    if (source_size <= ULONG_MAX) {
+      return (size_t)compressBound((uLong)source_size);
+    }
+#endif
+    break;
+
+  case C_lz4:
+#ifdef HAVE_LZ4
+    if (source_size <= LZ4_MAX_INPUT_SIZE) {
+      return (size_t)LZ4_compressBound((int)source_size);
+    }
+#endif
+    break;
+
+  case C_zstd:
+#ifdef HAVE_ZSTD
+    return ZSTD_compressBound(source_size);
+#endif
+    break;
+  }
+
+  return 0;
+}
+
+/**
+ * Compresses source_size bytes from source into the dest buffer, which has
+ * room for dest_size bytes.  The meaning of compression_level depends on the
+ * codec; for zlib it ranges from 1 to 9, for Zstandard from 1 to 22, and it
+ * is ignored by LZ4.
+ *
+ * Returns the number of bytes written to dest, or 0 if the codec is not
+ * available or the result did not fit.
+ */
+size_t CompressionCodec::
+compress(Codec codec, unsigned char *dest, size_t dest_size,
+         const unsigned char *source, size_t source_size,
+         int compression_level) {
+  switch (codec) {
+  case C_zlib:
+#ifdef HAVE_ZLIB
+    if (source_size <= ULONG_MAX) {
+      uLongf dest_len = (uLongf)std::min(dest_size, (size_t)ULONG_MAX);
+      int result = compress2((Bytef *)dest, &dest_len, (const Bytef *)source,
+                             (uLong)source_size, compression_level);
+      if (result == Z_OK) {
+        return (size_t)dest_len;
+      }
+    }
+#endif
+    break;
+
+  case C_lz4:
+#ifdef HAVE_LZ4
+    if (source_size <= LZ4_MAX_INPUT_SIZE) {
+      int result = LZ4_compress_default((const char *)source, (char *)dest,
+                                        (int)source_size,
+                                        (int)std::min(dest_size, (size_t)INT_MAX));
+      if (result > 0) {
+        return (size_t)result;
+      }
+    }
+#endif
+    break;
+
+  case C_zstd:
+#ifdef HAVE_ZSTD
+    {
+      size_t result = ZSTD_compress(dest, dest_size, source, source_size,
+                                    compression_level);
+      if (!ZSTD_isError(result)) {
+        return result;
+      }
+    }
+#endif
+    break;
+  }
+
+  if (!is_available(codec)) {
+    express_cat.error()
+      << codec << " compression is not available in this build of Panda.\n";
+  }
+  return 0;
+}
+
+/**
+ * Decompresses source_size bytes from source into the dest buffer.  dest_size
+ * must be exactly the size of the uncompressed data.  Returns true on
+ * success, or false if the data was corrupt, or did not decompress to
+ * exactly dest_size bytes.
+ */
+bool CompressionCodec::
+decompress(Codec codec, unsigned char *dest, size_t dest_size,
+           const unsigned char *source, size_t source_size) {
+  switch (codec) {
+  case C_zlib:
+#ifdef HAVE_ZLIB
+    if (source_size <= ULONG_MAX && dest_size <= ULONG_MAX) {
+      uLongf dest_len = (uLongf)dest_size;
+      int result = uncompress((Bytef *)dest, &dest_len, (const Bytef *)source,
+                              (uLong)source_size);
+      return result == Z_OK && dest_len == (uLongf)dest_size;
+    }
+#endif
+    break;
+
+  case C_lz4:
+#ifdef HAVE_LZ4
+    if (source_size <= INT_MAX && dest_size <= INT_MAX) {
+      int result = LZ4_decompress_safe((const char *)source, (char *)dest,
+                                       (int)source_size, (int)dest_size);
+      return result >= 0 && (size_t)result == dest_size;
+    }
+#endif
+    break;
+
+  case C_zstd:
+#ifdef HAVE_ZSTD
+    {
+      size_t result = ZSTD_decompress(dest, dest_size, source, source_size);
+      return !ZSTD_isError(result) && result == dest_size;
+    }
+#endif
+    break;
+  }
+
+  if (!is_available(codec)) {
+    express_cat.error()
+      << codec << " compression is not available in this build of Panda.\n";
+  }
+  return false;
+}
+
+/**
+ *
+ */
+std::ostream &
+operator << (std::ostream &out, CompressionCodec::Codec codec) {
+  return out << CompressionCodec::get_name(codec);
+}
+
+/**
+ *
+ */
+std::istream &
+operator >> (std::istream &in, CompressionCodec::Codec &codec) {
+  std::string word;
+  in >> word;
+
+  if (cmp_nocase(word, "zlib") == 0) {
+    codec = CompressionCodec::C_zlib;
+
+  } else if (cmp_nocase(word, "lz4") == 0) {
+    codec = CompressionCodec::C_lz4;
+
+  } else if (cmp_nocase(word, "zstd") == 0 ||
+             cmp_nocase(word, "zstandard") == 0) {
+    codec = CompressionCodec::C_zstd;
+
+  } else {
+    express_cat.error()
+      << "Invalid CompressionCodec value: " << word << "\n";
+    codec = CompressionCodec::C_zlib;
+  }
+
+  return in;
+}
@@ -0,0 +1,59 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file compressionCodec.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef COMPRESSIONCODEC_H
+#define COMPRESSIONCODEC_H
+
+#include "pandabase.h"
+
+/**
+ * This class collects the general-purpose compression algorithms that Panda
+ * can use for its own data, such as vertex data pages, Multifile subfiles,
+ * model cache records and compressed streams.
+ *
+ * zlib is available whenever Panda is built with zlib.  LZ4 decompresses
+ * several times faster than zlib at a somewhat lower compression ratio, and
+ * Zstandard compresses better than zlib while still decompressing faster;
+ * these are only available if Panda was built with the respective library.
+ *
+ * The functions here compress and decompress whole blocks of memory at once.
+ * The uncompressed size of a block must be known in order to decompress it.
+ *
+ * @since 1.11.0
+ */
+class EXPCL_PANDA_EXPRESS CompressionCodec {
+PUBLISHED:
+  enum Codec {
+    C_zlib,
+    C_lz4,
+    C_zstd,
+  };
+
+  static bool is_available(Codec codec);
+  static std::string get_name(Codec codec);
+
+public:
+  static size_t get_max_compressed_size(Codec codec, size_t source_size);
+  static size_t compress(Codec codec, unsigned char *dest, size_t dest_size,
+                         const unsigned char *source, size_t source_size,
+                         int compression_level);
+  static bool decompress(Codec codec, unsigned char *dest, size_t dest_size,
+                         const unsigned char *source, size_t source_size);
+};
+
+EXPCL_PANDA_EXPRESS std::ostream &
+operator << (std::ostream &out, CompressionCodec::Codec codec);
+EXPCL_PANDA_EXPRESS std::istream &
+operator >> (std::istream &in, CompressionCodec::Codec &codec);
+
+#endif
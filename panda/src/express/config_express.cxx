@@ -77,6 +77,15 @@ ConfigVariableBool multifile_always_binary
           "or extracted in either binary or text mode, according to the "
           "set_binary() or set_text() flag on the Filename."));
 
+ConfigVariableBool multifile_mmap
+("multifile-mmap", false,
+ PRC_DESC("Set this true to map a Multifile that is opened for reading from "
+          "a file on disk into memory, and read its uncompressed, unencrypted "
+          "subfiles straight out of the mapping.  This avoids the copies "
+          "through the stream buffers, and allows several threads to read "
+          "from the same Multifile without contending for its stream.  "
+          "The file must not be modified or truncated while it is open."));
+
 ConfigVariableBool collect_tcp
 ("collect-tcp", false,
  PRC_DESC("Set this true to enable accumulation of several small consecutive "
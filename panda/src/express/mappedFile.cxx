@@ -0,0 +1,126 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "mappedFile.h"
+#include "config_express.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ *
+ */
+MappedFile::
+~MappedFile() {
+  close();
+}
+
+/**
+ * Maps the indicated file from the operating system's filesystem (not the
+ * virtual file system) into memory.  Returns true on success, false if the
+ * file could not be opened or mapped, or if it is empty.
+ */
+bool MappedFile::
+open(const Filename &filename) {
+  close();
+  _filename = filename;
+
+#ifdef _WIN32
+  std::wstring os_specific = filename.to_os_specific_w();
+  HANDLE file = CreateFileW(os_specific.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+      (uint64_t)size.QuadPart != (uint64_t)(size_t)size.QuadPart) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return false;
+  }
+
+  // The view keeps the mapping object alive until it is unmapped.
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    return false;
+  }
+
+  _data = (unsigned char *)data;
+  _size = (size_t)size.QuadPart;
+
+#else  // _WIN32
+  std::string os_specific = filename.to_os_specific();
+  int fd = ::open(os_specific.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+      (uint64_t)st.st_size != (uint64_t)(size_t)st.st_size) {
+    ::close(fd);
+    return false;
+  }
+
+  // The mapping keeps its own reference to the file.
+  void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  _data = (unsigned char *)data;
+  _size = (size_t)st.st_size;
+#endif  // _WIN32
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << _size << " bytes of " << _filename << "\n";
+  }
+  return true;
+}
+
+/**
+ * Unmaps the file, if it is mapped.  Any pointers into the mapping become
+ * invalid.
+ */
+void MappedFile::
+close() {
+  if (_data != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+#else
+    munmap(_data, _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+  }
+}
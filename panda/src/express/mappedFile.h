@@ -0,0 +1,54 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "filename.h"
+
+/**
+ * A read-only view of the entire contents of a file on disk, mapped into the
+ * address space of the process.  The pages are loaded by the operating
+ * system on first access, and are shared with its disk cache, so that reading
+ * from the mapping costs neither a system call nor an extra copy.
+ *
+ * The mapping remains valid for as long as the object exists, so anything
+ * that hands out pointers into it should hold a reference to it.
+ */
+class EXPCL_PANDA_EXPRESS MappedFile : public ReferenceCount {
+public:
+  INLINE MappedFile();
+  MappedFile(const MappedFile &copy) = delete;
+  ~MappedFile();
+
+  MappedFile &operator = (const MappedFile &copy) = delete;
+
+  bool open(const Filename &filename);
+  void close();
+
+  INLINE bool is_valid() const;
+  INLINE const Filename &get_filename() const;
+  INLINE const unsigned char *get_data() const;
+  INLINE size_t get_size() const;
+
+private:
+  Filename _filename;
+  unsigned char *_data;
+  size_t _size;
+};
+
+#include "mappedFile.I"
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStream.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef MAPPEDSTREAM_H
+#define MAPPEDSTREAM_H
+
+#include "pandabase.h"
+#include "mappedStreamBuf.h"
+
+/**
+ * An istream that reads a range of bytes of a MappedFile directly out of
+ * memory.  Unlike an ISubStream, it needs no buffer and no lock on a shared
+ * parent stream, so any number of threads may read from different
+ * IMappedStreams on the same file at once.
+ */
+class EXPCL_PANDA_EXPRESS IMappedStream : public std::istream {
+public:
+  INLINE IMappedStream();
+  INLINE explicit IMappedStream(MappedFile *source, size_t start, size_t end);
+
+#if _MSC_VER >= 1800
+  INLINE IMappedStream(const IMappedStream &copy) = delete;
+#endif
+
+  INLINE IMappedStream &open(MappedFile *source, size_t start, size_t end);
+  INLINE IMappedStream &close();
+
+private:
+  MappedStreamBuf _buf;
+};
+
+#include "mappedStream.I"
+
+#endif
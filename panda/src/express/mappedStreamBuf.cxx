@@ -0,0 +1,118 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "mappedStreamBuf.h"
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+using std::streamsize;
+
+/**
+ *
+ */
+MappedStreamBuf::
+MappedStreamBuf() {
+  setg(nullptr, nullptr, nullptr);
+  setp(nullptr, nullptr);
+}
+
+/**
+ *
+ */
+MappedStreamBuf::
+~MappedStreamBuf() {
+  close();
+}
+
+/**
+ * Makes the bytes in the range [start, end) of the mapped file available for
+ * reading.
+ */
+void MappedStreamBuf::
+open(MappedFile *source, size_t start, size_t end) {
+  close();
+  nassertv(source != nullptr && source->is_valid());
+  nassertv(start <= end && end <= source->get_size());
+
+  _source = source;
+
+  // The get area must be declared as non-const, but it is never written to;
+  // we don't allow putting back a character that differs from the one that
+  // was read.
+  char *data = (char *)source->get_data();
+  setg(data + start, data + start, data + end);
+}
+
+/**
+ * Releases the mapped file.
+ */
+void MappedStreamBuf::
+close() {
+  setg(nullptr, nullptr, nullptr);
+  _source.clear();
+}
+
+/**
+ * Implements seeking within the stream.
+ */
+streampos MappedStreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if ((which & ios::in) == 0) {
+    return -1;
+  }
+
+  streamoff size = egptr() - eback();
+  streamoff pos;
+  switch (dir) {
+  case ios::beg:
+    pos = off;
+    break;
+
+  case ios::cur:
+    pos = (gptr() - eback()) + off;
+    break;
+
+  case ios::end:
+    pos = size + off;
+    break;
+
+  default:
+    return -1;
+  }
+
+  if (pos < 0 || pos > size) {
+    return -1;
+  }
+
+  setg(eback(), eback() + pos, egptr());
+  return pos;
+}
+
+/**
+ * Implements seeking within the stream.
+ */
+streampos MappedStreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Returns the number of bytes that can be read without blocking, which is all
+ * of the remaining bytes.
+ */
+streamsize MappedStreamBuf::
+showmanyc() {
+  streamsize remaining = egptr() - gptr();
+  return (remaining > 0) ? remaining : -1;
+}
@@ -0,0 +1,44 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef MAPPEDSTREAMBUF_H
+#define MAPPEDSTREAMBUF_H
+
+#include "pandabase.h"
+#include "mappedFile.h"
+#include "pointerTo.h"
+
+/**
+ * The streambuf object that implements IMappedStream.  Its get area is the
+ * mapped memory itself, so reads are a straight copy out of the mapping.
+ */
+class EXPCL_PANDA_EXPRESS MappedStreamBuf : public std::streambuf {
+public:
+  MappedStreamBuf();
+  MappedStreamBuf(const MappedStreamBuf &copy) = delete;
+  virtual ~MappedStreamBuf();
+
+  void open(MappedFile *source, size_t start, size_t end);
+  void close();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+protected:
+  virtual std::streamsize showmanyc();
+
+private:
+  PT(MappedFile) _source;
+};
+
+#endif
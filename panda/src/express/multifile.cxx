@@ -21,6 +21,8 @@
 #include "encryptStream.h"
 #include "virtualFileSystem.h"
 #include "virtualFile.h"
+#include "mappedStream.h"
+#include "subfileInfo.h"
 
 #include <algorithm>
 #include <iterator>
@@ -118,6 +120,8 @@ Multifile() :
   _read = nullptr;
   _write = nullptr;
   _offset = 0;
+  _mapping_start = 0;
+  _mapping_size = 0;
   _owns_stream = false;
   _next_index = 0;
   _last_index = 0;
@@ -126,6 +130,7 @@ Multifile() :
   _timestamp = 0;
   _timestamp_dirty = false;
   _record_timestamp = true;
+  _compression_codec = CompressionCodec::C_zlib;
   _scale_factor = 1;
   _new_scale_factor = 1;
   _encryption_flag = false;
@@ -179,7 +184,32 @@ open_read(const Filename &multifile_name, const streampos &offset) {
   _owns_stream = true;
   _multifile_name = multifile_name;
   _offset = offset;
-  return read_index();
+  if (!read_index()) {
+    return false;
+  }
+
+  if (multifile_mmap) {
+    // If the Multifile lives in a file on disk, map it, so that we can read
+    // the plain subfiles directly out of memory.
+    SubfileInfo info;
+    if (vfile->get_system_info(info) && !info.is_empty()) {
+      PT(MappedFile) mapping = new MappedFile;
+      size_t start = (size_t)info.get_start();
+      size_t size = (size_t)info.get_size();
+      if (mapping->open(info.get_filename()) &&
+          start <= mapping->get_size() &&
+          size <= mapping->get_size() - start) {
+        _mapping = std::move(mapping);
+        _mapping_start = start;
+        _mapping_size = size;
+      } else if (express_cat.is_debug()) {
+        express_cat.debug()
+          << "Unable to map " << info.get_filename() << " for reading "
+          << multifile_name << "\n";
+      }
+    }
+  }
+  return true;
 }
 
 /**
@@ -345,6 +375,9 @@ close() {
   _read = nullptr;
   _write = nullptr;
   _offset = 0;
+  _mapping.clear();
+  _mapping_start = 0;
+  _mapping_size = 0;
   _owns_stream = false;
   _next_index = 0;
   _last_index = 0;
@@ -1542,6 +1575,19 @@ is_subfile_text(int index) const {
   return (_subfiles[index]->_flags & SF_text) != 0;
 }
 
+/**
+ * Returns true if the indicated subfile will be read directly from a memory
+ * mapping of the Multifile, or false if it will be read through a stream.
+ * Only subfiles that are stored without compression or encryption can be
+ * mapped, and only if multifile-mmap was set when the Multifile was opened.
+ */
+bool Multifile::
+is_subfile_mapped(int index) const {
+  nassertr(index >= 0 && index < (int)_subfiles.size(), false);
+  size_t start, end;
+  return get_mapped_range(_subfiles[index], start, end);
+}
+
 /**
  * Returns the first byte that is guaranteed to follow any index byte already
  * written to disk in the Multifile.
@@ -1917,7 +1963,13 @@ read_subfile(int index, vector_uchar &result) {
   result.reserve(subfile->_uncompressed_length);
 
   bool success = true;
-  if (subfile->_flags & (SF_encrypted | SF_compressed)) {
+  size_t map_start, map_end;
+  if (get_mapped_range(subfile, map_start, map_end)) {
+    // The Multifile is mapped into memory, so this is just a copy.
+    const unsigned char *data = _mapping->get_data();
+    result.assign(data + map_start, data + map_end);
+
+  } else if (subfile->_flags & (SF_encrypted | SF_compressed)) {
     // If the subfile is encrypted or compressed, we can't read it directly.
     // Fall back to the generic implementation.
     istream *in = open_read_subfile(index);
@@ -1997,6 +2049,7 @@ add_new_subfile(Subfile *subfile, int compression_level) {
 #else  // HAVE_ZLIB
     subfile->_flags |= SF_compressed;
     subfile->_compression_level = compression_level;
+    subfile->_compression_codec = _compression_codec;
 #endif  // HAVE_ZLIB
   }
 
@@ -2047,9 +2100,17 @@ open_read_subfile(Subfile *subfile) {
   nassertr(subfile->_source == nullptr &&
            subfile->_source_filename.empty(), nullptr);
 
+  nassertr(subfile->_data_start != (streampos)0, nullptr);
+
+  size_t map_start, map_end;
+  if (get_mapped_range(subfile, map_start, map_end)) {
+    // The Multifile is mapped into memory, so we can read a plain subfile
+    // directly out of the mapping.
+    return new IMappedStream(_mapping, map_start, map_end);
+  }
+
   // Return an ISubStream object that references into the open Multifile
   // istream.
-  nassertr(subfile->_data_start != (streampos)0, nullptr);
   istream *stream =
     new ISubStream(_read, _offset + subfile->_data_start,
                    _offset + subfile->_data_start + (streampos)subfile->_data_length);
@@ -2100,6 +2161,33 @@ open_read_subfile(Subfile *subfile) {
   return stream;
 }
 
+/**
+ * If the Multifile has been mapped into memory and the indicated subfile is
+ * stored without compression or encryption, fills in the range of bytes in
+ * the mapping that hold its data, and returns true.  Otherwise, returns
+ * false.
+ */
+bool Multifile::
+get_mapped_range(const Subfile *subfile, size_t &start, size_t &end) const {
+  if (_mapping == nullptr ||
+      (subfile->_flags & (SF_encrypted | SF_compressed)) != 0 ||
+      subfile->_source != nullptr || !subfile->_source_filename.empty()) {
+    return false;
+  }
+
+  streampos pos = _offset + subfile->_data_start;
+  if (pos < (streampos)0 || (size_t)pos > _mapping_size ||
+      subfile->_data_length > _mapping_size - (size_t)pos) {
+    // The subfile extends beyond the end of the file; let the stream path
+    // report the error.
+    return false;
+  }
+
+  start = _mapping_start + (size_t)pos;
+  end = start + subfile->_data_length;
+  return true;
+}
+
 /**
  * Returns the standard form of the subfile name.
  */
@@ -2688,7 +2776,8 @@ write_data(ostream &write, istream *read, streampos fpos,
 #else  // HAVE_ZLIB
     if ((_flags & SF_compressed) != 0) {
       // Write it compressed.
-      putter = new OCompressStream(putter, delete_putter, _compression_level);
+      putter = new OCompressStream(putter, delete_putter, _compression_level,
+                                   true, _compression_codec);
       delete_putter = true;
     }
 #endif  // HAVE_ZLIB
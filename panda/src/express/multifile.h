@@ -19,12 +19,15 @@
 #include "config_express.h"
 #include "streamWrapper.h"
 #include "subStream.h"
+#include "mappedFile.h"
+#include "pointerTo.h"
 #include "filename.h"
 #include "ordered_vector.h"
 #include "indirectLess.h"
 #include "referenceCount.h"
 #include "pvector.h"
 #include "vector_uchar.h"
+#include "compressionCodec.h"
 
 #ifdef HAVE_OPENSSL
 typedef struct x509_st X509;
@@ -64,6 +67,9 @@ PUBLISHED:
   INLINE void set_record_timestamp(bool record_timestamp);
   INLINE bool get_record_timestamp() const;
 
+  INLINE void set_compression_codec(CompressionCodec::Codec codec);
+  INLINE CompressionCodec::Codec get_compression_codec() const;
+
   void set_scale_factor(size_t scale_factor);
   INLINE size_t get_scale_factor() const;
 
@@ -122,6 +128,7 @@ PUBLISHED:
   bool is_subfile_compressed(int index) const;
   bool is_subfile_encrypted(int index) const;
   bool is_subfile_text(int index) const;
+  bool is_subfile_mapped(int index) const;
 
   std::streampos get_index_end() const;
   std::streampos get_subfile_internal_start(int index) const;
@@ -206,6 +213,7 @@ private:
     Filename _source_filename;
     int _flags;
     int _compression_level;  // Not preserved on disk.
+    CompressionCodec::Codec _compression_codec;  // Not preserved on disk.
 #ifdef HAVE_OPENSSL
     EVP_PKEY *_pkey;         // Not preserved on disk.
 #endif // HAVE_OPENSSL
@@ -218,6 +226,7 @@ private:
 
   void add_new_subfile(Subfile *subfile, int compression_level);
   std::istream *open_read_subfile(Subfile *subfile);
+  bool get_mapped_range(const Subfile *subfile, size_t &start, size_t &end) const;
   std::string standardize_subfile_name(const std::string &subfile_name) const;
 
   void clear_subfiles();
@@ -242,6 +251,13 @@ private:
 
   std::streampos _offset;
   IStreamWrapper *_read;
+
+  // If multifile-mmap is set, this maps the physical file that contains the
+  // Multifile, which begins at _mapping_start bytes within it, and is
+  // _mapping_size bytes long.
+  PT(MappedFile) _mapping;
+  size_t _mapping_start;
+  size_t _mapping_size;
   std::ostream *_write;
   bool _owns_stream;
   std::streampos _next_index;
@@ -252,6 +268,7 @@ private:
   time_t _timestamp;
   bool _timestamp_dirty;
   bool _record_timestamp;
+  CompressionCodec::Codec _compression_codec;
   size_t _scale_factor;
   size_t _new_scale_factor;
 
@@ -59,6 +59,10 @@ private:
  * compressed data, and write your uncompressed source data to the
  * OCompressStream.
  *
+ * A codec other than zlib may be specified, if it is available, in which case
+ * the data is written in a block-framed format that IDecompressStream
+ * recognizes automatically.
+ *
  * Seeking is not supported.
  */
 class EXPCL_PANDA_EXPRESS OCompressStream : public std::ostream {
@@ -66,7 +70,8 @@ PUBLISHED:
   INLINE OCompressStream();
   INLINE explicit OCompressStream(std::ostream *dest, bool owns_dest,
                                   int compression_level = 6,
-                                  bool header=true);
+                                  bool header=true,
+                                  CompressionCodec::Codec codec = CompressionCodec::C_zlib);
 
 #if _MSC_VER >= 1800
   INLINE OCompressStream(const OCompressStream &copy) = delete;
@@ -74,7 +79,8 @@ PUBLISHED:
 
   INLINE OCompressStream &open(std::ostream *dest, bool owns_dest,
                                int compression_level = 6,
-                               bool header=true);
+                               bool header=true,
+                               CompressionCodec::Codec codec = CompressionCodec::C_zlib);
   INLINE OCompressStream &close();
 
 private:
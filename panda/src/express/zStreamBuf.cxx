@@ -22,6 +22,15 @@ using std::ios;
 using std::streamoff;
 using std::streampos;
 
+// This begins a stream written in the block-framed format that is used for
+// codecs other than zlib.  It is followed by a byte indicating the codec, and
+// then by a series of blocks, each of which begins with the uncompressed and
+// compressed size as little-endian 32-bit integers.  If the two sizes are
+// equal, the block is stored without compression.  The stream is terminated
+// by an uncompressed size of 0.  The first byte is never valid at the start of
+// a zlib or gzip stream.
+static const char block_magic[4] = { '\x89', 'P', 'C', 'B' };
+
 #if !defined(USE_MEMORY_NOWRAPPERS) && !defined(CPPPARSER)
 // Define functions that hook zlib into panda's memory allocation system.
 static void *
@@ -92,6 +101,14 @@ open_read(std::istream *source, bool owns_source, std::streamsize source_length,
   _z_source.opaque = Z_NULL;
   _z_source.msg = (char *)"no error message";
 
+  _read_header = header;
+  _detect_header = header;
+  _read_blocks = false;
+  _read_block_eof = false;
+  _read_block.clear();
+  _read_block_pos = 0;
+  _read_total_out = 0;
+
   int result = inflateInit2(&_z_source, header ? 32 + 15 : -15);
   if (result < 0) {
     show_zlib_error("inflateInit2", result, _z_source);
@@ -124,13 +141,34 @@ close_read() {
 }
 
 /**
- *
+ * Prepares to write compressed data to the indicated stream.  If a codec
+ * other than zlib is specified, the block-framed format is written, and the
+ * header parameter is ignored; such a stream can only be read back with
+ * header=true.
  */
 void ZStreamBuf::
-open_write(std::ostream *dest, bool owns_dest, int compression_level, bool header) {
+open_write(std::ostream *dest, bool owns_dest, int compression_level, bool header,
+           CompressionCodec::Codec codec) {
   _dest = dest;
   _owns_dest = owns_dest;
 
+  if (codec != CompressionCodec::C_zlib &&
+      !CompressionCodec::is_available(codec)) {
+    express_cat.warning()
+      << codec << " compression is not available, using zlib instead.\n";
+    codec = CompressionCodec::C_zlib;
+  }
+
+  _write_codec = codec;
+  if (codec != CompressionCodec::C_zlib) {
+    _compression_level = compression_level;
+    _write_block.clear();
+    _write_block.reserve(block_size);
+    _dest->write(block_magic, sizeof(block_magic));
+    _dest->put((char)codec);
+    return;
+  }
+
   _z_dest.next_in = Z_NULL;
   _z_dest.avail_in = 0;
   _z_dest.next_out = Z_NULL;
@@ -164,11 +202,19 @@ close_write() {
     write_chars(pbase(), n, Z_FINISH);
     pbump(-(int)n);
 
-    int result = deflateEnd(&_z_dest);
-    if (result < 0) {
-      show_zlib_error("deflateEnd", result, _z_dest);
+    if (_write_codec != CompressionCodec::C_zlib) {
+      static const char terminator[4] = { 0, 0, 0, 0 };
+      _dest->write(terminator, sizeof(terminator));
+      _write_codec = CompressionCodec::C_zlib;
+      pvector<unsigned char>().swap(_write_block);
+      pvector<unsigned char>().swap(_compress_buffer);
+    } else {
+      int result = deflateEnd(&_z_dest);
+      if (result < 0) {
+        show_zlib_error("deflateEnd", result, _z_dest);
+      }
+      thread_consider_yield();
     }
-    thread_consider_yield();
 
     if (_owns_dest) {
       delete _dest;
@@ -191,7 +237,7 @@ seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
 
   // Determine the current position.
   size_t n = egptr() - gptr();
-  streampos gpos = _z_source.total_out - n;
+  streampos gpos = (_read_blocks ? _read_total_out : _z_source.total_out) - n;
 
   // Implement tellg() and seeks to current position.
   if ((dir == ios::cur && off == 0) ||
@@ -216,6 +262,12 @@ seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
     if (result < 0) {
       show_zlib_error("inflateReset", result, _z_source);
     }
+    _detect_header = _read_header;
+    _read_blocks = false;
+    _read_block_eof = false;
+    _read_block.clear();
+    _read_block_pos = 0;
+    _read_total_out = 0;
     return 0;
   }
 
@@ -311,6 +363,13 @@ underflow() {
  */
 size_t ZStreamBuf::
 read_chars(char *start, size_t length) {
+  if (_detect_header) {
+    detect_header();
+  }
+  if (_read_blocks) {
+    return read_block_chars(start, length);
+  }
+
   _z_source.next_out = (Bytef *)start;
   _z_source.avail_out = length;
 
@@ -364,6 +423,11 @@ read_chars(char *start, size_t length) {
  */
 void ZStreamBuf::
 write_chars(const char *start, size_t length, int flush) {
+  if (_write_codec != CompressionCodec::C_zlib) {
+    write_block_chars(start, length, flush);
+    return;
+  }
+
   static const size_t compress_buffer_size = 4096;
   char compress_buffer[compress_buffer_size];
 
@@ -404,6 +468,193 @@ write_chars(const char *start, size_t length, int flush) {
   }
 }
 
+/**
+ * Reads up to the indicated number of raw bytes from the source stream,
+ * respecting the source length limit.  Returns the number of bytes read.
+ */
+size_t ZStreamBuf::
+read_source(char *start, size_t length) {
+  if (_source_bytes_left == 0 || _source->eof() || _source->fail()) {
+    return 0;
+  }
+  if (_source_bytes_left >= 0) {
+    length = (size_t)std::min(_source_bytes_left, (std::streamsize)length);
+  }
+  _source->read(start, length);
+  size_t read_count = _source->gcount();
+  if (_source_bytes_left >= 0) {
+    _source_bytes_left -= read_count;
+  }
+  return read_count;
+}
+
+/**
+ * Called on the first read to determine whether the source stream is in the
+ * block-framed format.  If not, the bytes that were read are left for zlib.
+ */
+void ZStreamBuf::
+detect_header() {
+  _detect_header = false;
+
+  size_t read_count = read_source(decompress_buffer, sizeof(block_magic) + 1);
+  if (read_count == sizeof(block_magic) + 1 &&
+      memcmp(decompress_buffer, block_magic, sizeof(block_magic)) == 0) {
+    _read_blocks = true;
+    _read_codec = (CompressionCodec::Codec)(unsigned char)decompress_buffer[sizeof(block_magic)];
+    if (!CompressionCodec::is_available(_read_codec)) {
+      express_cat.error()
+        << "Stream is compressed with " << _read_codec
+        << ", which is not available in this build of Panda.\n";
+      _read_block_eof = true;
+    }
+  } else {
+    _z_source.next_in = (Bytef *)decompress_buffer;
+    _z_source.avail_in = read_count;
+  }
+}
+
+/**
+ * The block-framed equivalent of read_chars().
+ */
+size_t ZStreamBuf::
+read_block_chars(char *start, size_t length) {
+  size_t total = 0;
+  while (total < length) {
+    if (_read_block_pos >= _read_block.size()) {
+      if (_read_block_eof || !read_block()) {
+        _read_block_eof = true;
+        _read_block.clear();
+        _read_block_pos = 0;
+        break;
+      }
+    }
+    size_t count = std::min(length - total, _read_block.size() - _read_block_pos);
+    memcpy(start + total, &_read_block[_read_block_pos], count);
+    _read_block_pos += count;
+    total += count;
+  }
+
+  _read_total_out += total;
+  return total;
+}
+
+/**
+ * Reads the next block from the source stream into _read_block.  Returns
+ * false at the end of the stream, or if the stream is corrupt.
+ */
+bool ZStreamBuf::
+read_block() {
+  unsigned char sizes[8];
+  if (read_source((char *)sizes, 4) != 4) {
+    express_cat.warning()
+      << "Compressed stream is truncated.\n";
+    return false;
+  }
+  uint32_t usize = sizes[0] | (sizes[1] << 8) | (sizes[2] << 16) | ((uint32_t)sizes[3] << 24);
+  if (usize == 0) {
+    // This is the terminator.
+    return false;
+  }
+
+  if (read_source((char *)sizes + 4, 4) != 4) {
+    express_cat.warning()
+      << "Compressed stream is truncated.\n";
+    return false;
+  }
+  uint32_t csize = sizes[4] | (sizes[5] << 8) | (sizes[6] << 16) | ((uint32_t)sizes[7] << 24);
+  if (usize > max_block_size || csize > usize || csize == 0) {
+    express_cat.warning()
+      << "Compressed stream is corrupt.\n";
+    return false;
+  }
+
+  _read_block.resize(usize);
+  _read_block_pos = 0;
+
+  if (csize == usize) {
+    // This block was stored without compression.
+    if (read_source((char *)&_read_block[0], usize) != usize) {
+      express_cat.warning()
+        << "Compressed stream is truncated.\n";
+      return false;
+    }
+    return true;
+  }
+
+  _compress_buffer.resize(csize);
+  if (read_source((char *)&_compress_buffer[0], csize) != csize) {
+    express_cat.warning()
+      << "Compressed stream is truncated.\n";
+    return false;
+  }
+
+  bool success = CompressionCodec::decompress(_read_codec, &_read_block[0], usize,
+                                              &_compress_buffer[0], csize);
+  thread_consider_yield();
+  if (!success) {
+    express_cat.warning()
+      << "Failed to decompress " << _read_codec << " block.\n";
+  }
+  return success;
+}
+
+/**
+ * The block-framed equivalent of write_chars().  A partial block is only
+ * written if flush is nonzero.
+ */
+void ZStreamBuf::
+write_block_chars(const char *start, size_t length, int flush) {
+  while (length > 0) {
+    size_t count = std::min(length, (size_t)block_size - _write_block.size());
+    _write_block.insert(_write_block.end(), (const unsigned char *)start,
+                        (const unsigned char *)start + count);
+    start += count;
+    length -= count;
+    if (_write_block.size() >= (size_t)block_size) {
+      write_block();
+    }
+  }
+
+  if (flush != 0 && !_write_block.empty()) {
+    write_block();
+  }
+}
+
+/**
+ * Compresses the contents of _write_block and writes it to the dest stream.
+ */
+void ZStreamBuf::
+write_block() {
+  size_t usize = _write_block.size();
+  nassertv(usize > 0 && usize <= (size_t)max_block_size);
+
+  _compress_buffer.resize(CompressionCodec::get_max_compressed_size(_write_codec, usize));
+  size_t csize = 0;
+  if (!_compress_buffer.empty()) {
+    csize = CompressionCodec::compress(_write_codec, &_compress_buffer[0],
+                                       _compress_buffer.size(), &_write_block[0],
+                                       usize, _compression_level);
+  }
+
+  const unsigned char *data = _compress_buffer.data();
+  if (csize == 0 || csize >= usize) {
+    // It didn't get any smaller; store it as-is.
+    csize = usize;
+    data = &_write_block[0];
+  }
+
+  unsigned char sizes[8] = {
+    (unsigned char)usize, (unsigned char)(usize >> 8),
+    (unsigned char)(usize >> 16), (unsigned char)(usize >> 24),
+    (unsigned char)csize, (unsigned char)(csize >> 8),
+    (unsigned char)(csize >> 16), (unsigned char)(csize >> 24),
+  };
+  _dest->write((const char *)sizes, sizeof(sizes));
+  _dest->write((const char *)data, csize);
+  _write_block.clear();
+  thread_consider_yield();
+}
+
 /**
  * Reports a recent error code returned by zlib.
  */
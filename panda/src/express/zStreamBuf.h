@@ -19,10 +19,17 @@
 // This module is not compiled if zlib is not available.
 #ifdef HAVE_ZLIB
 
+#include "compressionCodec.h"
+#include "pvector.h"
 #include <zlib.h>
 
 /**
  * The streambuf object that implements IDecompressStream and OCompressStream.
+ *
+ * With the zlib codec, this reads and writes a standard zlib or raw deflate
+ * stream.  Other codecs write a simple block-framed format, which begins with
+ * a magic number; IDecompressStream detects this format automatically when
+ * reading with header=true.
  */
 class EXPCL_PANDA_EXPRESS ZStreamBuf : public std::streambuf {
 public:
@@ -32,7 +39,8 @@ public:
   void open_read(std::istream *source, bool owns_source, std::streamsize source_length=-1, bool header=true);
   void close_read();
 
-  void open_write(std::ostream *dest, bool owns_dest, int compression_level, bool header=true);
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level, bool header=true,
+                  CompressionCodec::Codec codec=CompressionCodec::C_zlib);
   void close_write();
 
   virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
@@ -46,6 +54,12 @@ protected:
 private:
   size_t read_chars(char *start, size_t length);
   void write_chars(const char *start, size_t length, int flush);
+  size_t read_source(char *start, size_t length);
+  void detect_header();
+  size_t read_block_chars(char *start, size_t length);
+  bool read_block();
+  void write_block_chars(const char *start, size_t length, int flush);
+  void write_block();
   void show_zlib_error(const char *function, int error_code, z_stream &z);
 
 private:
@@ -61,6 +75,25 @@ private:
 
   char *_buffer;
 
+  // These are used instead of the z_streams when a codec other than zlib is
+  // in use.  Data is compressed in blocks of up to block_size bytes.
+  enum {
+    block_size = 65536,
+    max_block_size = 16 * 1024 * 1024,
+  };
+  bool _read_header = false;
+  bool _detect_header = false;
+  bool _read_block_eof = false;
+  bool _read_blocks = false;
+  CompressionCodec::Codec _read_codec = CompressionCodec::C_zlib;
+  CompressionCodec::Codec _write_codec = CompressionCodec::C_zlib;
+  int _compression_level = 0;
+  pvector<unsigned char> _read_block;
+  size_t _read_block_pos = 0;
+  uint64_t _read_total_out = 0;
+  pvector<unsigned char> _write_block;
+  pvector<unsigned char> _compress_buffer;
+
   // We need to store the decompression buffer on the class object, because
   // zlib might not consume all of the input characters at each call to
   // inflate().  This isn't a problem on output because in that case we can
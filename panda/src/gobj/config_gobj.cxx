@@ -396,6 +396,13 @@ ConfigVariableInt geom_cache_min_frames
           "object will remain in the geom cache, even if geom-cache-size "
           "is exceeded."));
 
+ConfigVariableBool geom_munge_thread_cache
+("geom-munge-thread-cache", true,
+ PRC_DESC("Set this true to have each thread remember the results of its "
+          "most recent munge operations, in addition to the geom cache.  "
+          "This allows several threads to render the same Geoms without "
+          "contending for the locks that protect the geom cache."));
+
 ConfigVariableInt released_vbuffer_cache_size
 ("released-vbuffer-cache-size", 1048576,
  PRC_DESC("Specifies the size in bytes of the cache of vertex "
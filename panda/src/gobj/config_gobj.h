@@ -68,6 +68,7 @@ extern EXPCL_PANDA_GOBJ ConfigVariableEnum<ThreadPriority> texture_reload_thread
 
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_min_frames;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool geom_munge_thread_cache;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt released_vbuffer_cache_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt released_ibuffer_cache_size;
 
@@ -35,56 +35,66 @@ record(Thread *current_thread) {
   PT(GeomCacheEntry) keepme = this;
 
   GeomCacheManager *cache_mgr = GeomCacheManager::get_global_ptr();
-  LightMutexHolder holder(cache_mgr->_lock);
+  GeomCacheManager::Shard &shard = cache_mgr->get_shard(this);
+  int current_frame = ClockObject::get_global_clock()->get_frame_count(current_thread);
+  int max_size = GeomCacheManager::get_shard_max_size(cache_mgr->get_max_size());
+  bool over_limit;
+  {
+    LightMutexHolder holder(shard._lock);
+
+    if (gobj_cat.is_debug()) {
+      gobj_cat.debug()
+        << "recording cache entry: " << *this << ", shard size = "
+        << shard._size + 1 << "\n";
+    }
 
-  if (gobj_cat.is_debug()) {
-    gobj_cat.debug()
-      << "recording cache entry: " << *this << ", total_size = "
-      << cache_mgr->_total_size + 1 << "\n";
+    insert_before(shard._list);
+    ++shard._size;
+    _last_frame_queued = current_frame;
+    AtomicAdjust::set(_last_frame_used, current_frame);
+    AtomicAdjust::set(_recorded, 1);
+
+    // Increment our own reference count while we're in the queue, just so we
+    // don't have to play games with it later--this is inner-loop stuff.
+    ref();
+
+    over_limit = (shard._size > max_size);
   }
 
-  insert_before(cache_mgr->_list);
-  ++cache_mgr->_total_size;
-  cache_mgr->_geom_cache_size_pcollector.set_level(cache_mgr->_total_size);
+  AtomicAdjust::inc(cache_mgr->_total_size);
+  cache_mgr->_geom_cache_size_pcollector.set_level(cache_mgr->get_total_size());
   cache_mgr->_geom_cache_record_pcollector.add_level(1);
-  _last_frame_used = ClockObject::get_global_clock()->get_frame_count(current_thread);
 
   if (PStatClient::is_connected()) {
     GeomCacheManager::_geom_cache_active_pcollector.add_level(1);
   }
 
-  // Increment our own reference count while we're in the queue, just so we
-  // don't have to play games with it later--this is inner-loop stuff.
-  ref();
-
-  // Now remove any old entries if our cache is over the limit.  This may also
+  // Now remove any old entries if our shard is over the limit.  This may also
   // remove the entry we just added, especially if our cache size is set to 0.
   // This may actually remove this very object.
-  cache_mgr->evict_old_entries();
+  if (over_limit) {
+    cache_mgr->evict_shard(shard, max_size, true);
+  }
 
   return this;
 }
 
 /**
  * Marks the cache entry recently used, so it will not be evicted for a while.
+ * This doesn't need to acquire any lock; the entry is moved to the back of
+ * the queue the next time it comes up for eviction.
  */
 void GeomCacheEntry::
 refresh(Thread *current_thread) {
-  GeomCacheManager *cache_mgr = GeomCacheManager::get_global_ptr();
-  LightMutexHolder holder(cache_mgr->_lock);
-  nassertv(_next != nullptr && _prev != nullptr);
-
-  remove_from_list();
-  insert_before(cache_mgr->_list);
-
   int current_frame = ClockObject::get_global_clock()->get_frame_count(current_thread);
-  if (PStatClient::is_connected()) {
-    if (_last_frame_used != current_frame) {
-      GeomCacheManager::_geom_cache_active_pcollector.add_level(1);
+  AtomicAdjust::Integer last_frame_used = AtomicAdjust::get(_last_frame_used);
+  if (last_frame_used != current_frame) {
+    if (AtomicAdjust::compare_and_exchange(_last_frame_used, last_frame_used, current_frame) == last_frame_used) {
+      if (PStatClient::is_connected()) {
+        GeomCacheManager::_geom_cache_active_pcollector.add_level(1);
+      }
     }
   }
-
-  _last_frame_used = current_frame;
 }
 
 /**
@@ -104,16 +114,21 @@ erase() {
   }
 
   GeomCacheManager *cache_mgr = GeomCacheManager::get_global_ptr();
-  LightMutexHolder holder(cache_mgr->_lock);
+  GeomCacheManager::Shard &shard = cache_mgr->get_shard(this);
+  {
+    LightMutexHolder holder(shard._lock);
+    remove_from_list();
+    --shard._size;
+    AtomicAdjust::set(_recorded, 0);
+  }
 
-  remove_from_list();
-  --cache_mgr->_total_size;
-  cache_mgr->_geom_cache_size_pcollector.set_level(cache_mgr->_total_size);
+  AtomicAdjust::dec(cache_mgr->_total_size);
+  cache_mgr->_geom_cache_size_pcollector.set_level(cache_mgr->get_total_size());
   cache_mgr->_geom_cache_erase_pcollector.add_level(1);
 
   if (PStatClient::is_connected()) {
     int current_frame = ClockObject::get_global_clock()->get_frame_count();
-    if (_last_frame_used == current_frame) {
+    if (AtomicAdjust::get(_last_frame_used) == current_frame) {
       GeomCacheManager::_geom_cache_active_pcollector.sub_level(1);
     }
   }
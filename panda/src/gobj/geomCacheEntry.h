@@ -37,11 +37,18 @@ public:
   void refresh(Thread *current_thread);
   PT(GeomCacheEntry) erase();
 
+  INLINE bool is_recorded() const;
+
   virtual void evict_callback();
   virtual void output(std::ostream &out) const;
 
 private:
-  int _last_frame_used;
+  // This is updated without holding any lock when the entry is used.  The
+  // position in the list is only updated when the entry is found at the head
+  // of the list, at which point _last_frame_queued catches up with it.
+  AtomicAdjust::Integer _last_frame_used;
+  int _last_frame_queued;
+  AtomicAdjust::Integer _recorded;
 
   INLINE void remove_from_list();
   INLINE void insert_before(GeomCacheEntry *node);
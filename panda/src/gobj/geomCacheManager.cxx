@@ -17,6 +17,7 @@
 #include "lightMutexHolder.h"
 #include "lightReMutexHolder.h"
 #include "clockObject.h"
+#include "pvector.h"
 
 GeomCacheManager *GeomCacheManager::_global_ptr = nullptr;
 
@@ -25,20 +26,25 @@ PStatCollector GeomCacheManager::_geom_cache_active_pcollector("Geom cache size:
 PStatCollector GeomCacheManager::_geom_cache_record_pcollector("Geom cache operations:record");
 PStatCollector GeomCacheManager::_geom_cache_erase_pcollector("Geom cache operations:erase");
 PStatCollector GeomCacheManager::_geom_cache_evict_pcollector("Geom cache operations:evict");
+PStatCollector GeomCacheManager::_geom_cache_hit_pcollector("Geom cache operations:hit");
+PStatCollector GeomCacheManager::_geom_cache_miss_pcollector("Geom cache operations:miss");
 
 /**
  *
  */
 GeomCacheManager::
 GeomCacheManager() :
-  _lock("GeomCacheManager"),
-  _total_size(0)
+  _total_size(0),
+  _flush_seq(0)
 {
-  // We deliberately hang on to this pointer forever.
-  _list = new GeomCacheEntry;
-  _list->ref();
-  _list->_next = _list;
-  _list->_prev = _list;
+  for (size_t si = 0; si < num_shards; ++si) {
+    // We deliberately hang on to these pointers forever.
+    GeomCacheEntry *list = new GeomCacheEntry;
+    list->ref();
+    list->_next = list;
+    list->_prev = list;
+    _shards[si]._list = list;
+  }
 }
 
 /**
@@ -58,7 +64,7 @@ flush() {
   // Prevent deadlock
   LightReMutexHolder registry_holder(GeomMunger::get_registry()->_registry_lock);
 
-  LightMutexHolder holder(_lock);
+  AtomicAdjust::inc(_flush_seq);
   evict_old_entries(0, false);
 }
 
@@ -75,48 +81,102 @@ get_global_ptr() {
 
 /**
  * Trims the cache size down to the specified size by evicting old cache
- * entries as needed.  It is assumed that you already hold the lock before
- * calling this method.
+ * entries as needed.  Each shard is trimmed in turn to its share of the
+ * indicated size.
  */
 void GeomCacheManager::
 evict_old_entries(int max_size, bool keep_current) {
+  int shard_max_size = get_shard_max_size(max_size);
+  for (size_t si = 0; si < num_shards; ++si) {
+    evict_shard(_shards[si], shard_max_size, keep_current);
+  }
+}
+
+/**
+ * Trims the indicated shard down to the specified size by evicting old cache
+ * entries as needed.  If keep_current is true, the shard is trimmed somewhat
+ * further than that, so that a shard that is at its limit doesn't need to
+ * evict an entry each time a new one is recorded.
+ *
+ * Cache hits don't reorder the list, so an entry found at the head of the
+ * list that has been used since it was last queued is given a second chance,
+ * and moved back to the tail.
+ */
+void GeomCacheManager::
+evict_shard(Shard &shard, int max_size, bool keep_current) {
   int current_frame = ClockObject::get_global_clock()->get_frame_count();
   int min_frames = geom_cache_min_frames;
 
-  while (_total_size > max_size) {
-    PT(GeomCacheEntry) entry = _list->_next;
-    nassertv(entry != _list);
+  // We don't actually release the evicted entries until we have let go of the
+  // lock, since deleting an entry may delete whatever it was caching.
+  pvector<PT(GeomCacheEntry)> evicted;
+  int num_evicted = 0;
+  {
+    LightMutexHolder holder(shard._lock);
+    if (shard._size <= max_size) {
+      return;
+    }
+
+    int target_size = max_size;
+    if (keep_current) {
+      target_size -= max_size / 16;
+    }
+
+    int num_requeued = 0;
+    while (shard._size > target_size) {
+      GeomCacheEntry *entry = shard._list->_next;
+      nassertv(entry != shard._list);
+
+      int last_frame_used = (int)AtomicAdjust::get(entry->_last_frame_used);
+      if (keep_current && last_frame_used != entry->_last_frame_queued &&
+          num_requeued < shard._size) {
+        // This one has been used since we last looked at it.
+        entry->remove_from_list();
+        entry->insert_before(shard._list);
+        entry->_last_frame_queued = last_frame_used;
+        ++num_requeued;
+        continue;
+      }
+
+      if (keep_current && current_frame - last_frame_used < min_frames) {
+        // Never mind, this one is too new.
+        if (gobj_cat.is_debug()) {
+          gobj_cat.debug()
+            << "Oldest element in cache shard is "
+            << current_frame - last_frame_used
+            << " frames; keeping shard at " << shard._size << " entries.\n";
+        }
+        break;
+      }
 
-    if (keep_current && current_frame - entry->_last_frame_used < min_frames) {
-      // Never mind, this one is too new.
       if (gobj_cat.is_debug()) {
         gobj_cat.debug()
-          << "Oldest element in cache is "
-          << current_frame - entry->_last_frame_used
-          << " frames; keeping cache at " << _total_size << " entries.\n";
+          << "cache shard size = " << shard._size << " entries, max_size = "
+          << max_size << ", removing " << *entry << "\n";
       }
-      break;
-    }
-
-    entry->unref();
 
-    if (gobj_cat.is_debug()) {
-      gobj_cat.debug()
-        << "cache total_size = " << _total_size << " entries, max_size = "
-        << max_size << ", removing " << *entry << "\n";
-    }
+      // The reference that was held by the list is passed on to the vector.
+      evicted.push_back(nullptr);
+      evicted.back().cheat() = entry;
 
-    entry->evict_callback();
+      AtomicAdjust::set(entry->_recorded, 0);
+      entry->evict_callback();
 
-    if (PStatClient::is_connected()) {
-      if (entry->_last_frame_used == current_frame) {
-        GeomCacheManager::_geom_cache_active_pcollector.sub_level(1);
+      if (PStatClient::is_connected()) {
+        if (last_frame_used == current_frame) {
+          GeomCacheManager::_geom_cache_active_pcollector.sub_level(1);
+        }
       }
+
+      --shard._size;
+      entry->remove_from_list();
+      ++num_evicted;
     }
+  }
 
-    --_total_size;
-    entry->remove_from_list();
-    _geom_cache_evict_pcollector.add_level(1);
+  if (num_evicted != 0) {
+    AtomicAdjust::add(_total_size, -num_evicted);
+    _geom_cache_evict_pcollector.add_level(num_evicted);
   }
-  _geom_cache_size_pcollector.set_level(_total_size);
+  _geom_cache_size_pcollector.set_level(get_total_size());
 }
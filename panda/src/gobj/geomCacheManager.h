@@ -18,6 +18,7 @@
 #include "config_gobj.h"
 #include "lightMutex.h"
 #include "pStatCollector.h"
+#include "atomicAdjust.h"
 
 class GeomCacheEntry;
 
@@ -31,8 +32,12 @@ class GeomCacheEntry;
  * the cache data to propagate through the multiprocess pipeline.
  *
  * This structure actually caches any of a number of different types of
- * pointers, and mixes them all up in the same LRU cache list.  Some of them
+ * pointers, and mixes them all up in the same LRU cache lists.  Some of them
  * (such as GeomMunger) are reference-counted here in the cache; most are not.
+ *
+ * The entries are spread over a number of shards, each with its own lock and
+ * its own LRU list, so that threads munging different Geoms don't wait for
+ * each other.  Each shard is limited to its share of get_max_size().
  */
 class EXPCL_PANDA_GOBJ GeomCacheManager {
 protected:
@@ -54,24 +59,46 @@ public:
   void evict_old_entries(int max_size, bool keep_current);
   INLINE static void flush_level();
 
+  INLINE unsigned int get_flush_seq() const;
+
 private:
-  // This mutex protects all operations on this object, especially the linked-
-  // list operations.
-  LightMutex _lock;
+  class Shard {
+  public:
+    INLINE Shard();
+
+    // This mutex protects the linked-list operations within this shard.
+    LightMutex _lock;
+
+    int _size;
 
-  int _total_size;
+    // We maintain a doubly-linked list to keep the cache entries in
+    // approximately least-recently-used order: the items at the head of the
+    // list are ready to be flushed.  We use our own doubly-linked list
+    // instead of an STL list, just so we can avoid a tiny bit of overhead,
+    // especially in keeping the pointer directly into the list from the
+    // calling objects.
+
+    // The tail and the head of the list are both kept by the _prev and _next
+    // pointers, respectively, within the following object, which always
+    // exists solely to keep a handle to the list.  Keeping a token of the
+    // list this way avoids special cases for an empty list.
+    GeomCacheEntry *_list;
+  };
+
+  INLINE Shard &get_shard(const GeomCacheEntry *entry);
+  INLINE static int get_shard_max_size(int max_size);
+  void evict_shard(Shard &shard, int max_size, bool keep_current);
+
+private:
+  enum { shard_bits = 3 };
+  static const size_t num_shards = (size_t)1 << shard_bits;
+  Shard _shards[num_shards];
 
-  // We maintain a doubly-linked list to keep the cache entries in least-
-  // recently-used order: the items at the head of the list are ready to be
-  // flushed.  We use our own doubly-linked list instead of an STL list, just
-  // so we can avoid a tiny bit of overhead, especially in keeping the pointer
-  // directly into the list from the calling objects.
+  AtomicAdjust::Integer _total_size;
 
-  // The tail and the head of the list are both kept by the _prev and _next
-  // pointers, respectively, within the following object, which always exists
-  // solely to keep a handle to the list.  Keeping a token of the list this
-  // way avoids special cases for an empty list.
-  GeomCacheEntry *_list;
+  // This is incremented by flush(), so that anyone holding on to cache
+  // entries outside of the cache knows to let go of them.
+  AtomicAdjust::Integer _flush_seq;
 
   static GeomCacheManager *_global_ptr;
 
@@ -81,6 +108,8 @@ public:
   static PStatCollector _geom_cache_record_pcollector;
   static PStatCollector _geom_cache_erase_pcollector;
   static PStatCollector _geom_cache_evict_pcollector;
+  static PStatCollector _geom_cache_hit_pcollector;
+  static PStatCollector _geom_cache_miss_pcollector;
 
   friend class GeomCacheEntry;
 };
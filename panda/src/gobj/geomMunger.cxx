@@ -17,12 +17,60 @@
 #include "lightMutexHolder.h"
 #include "lightReMutexHolder.h"
 #include "pStatTimer.h"
+#include "weakPointerTo.h"
 
 GeomMunger::Registry *GeomMunger::_registry = nullptr;
 TypeHandle GeomMunger::_type_handle;
 
 PStatCollector GeomMunger::_munge_pcollector("*:Munge");
 
+namespace {
+  // Each thread keeps a small direct-mapped table of the cache entries it has
+  // most recently used, so that it can usually find them again without
+  // having to lock the Geom's cache.  The table only holds weak references,
+  // so that an entry that is evicted from the geom cache is still freed
+  // right away, along with its munged Geom and GeomVertexData.  Once locked,
+  // an entry keeps its key alive, so the GeomVertexData and GeomMunger
+  // pointers can be compared safely; the Geom is checked via is_recorded(),
+  // since a Geom erases its entries when it is destructed.
+  class ThreadMungeCache {
+  public:
+    enum { num_slots = 64 };
+
+    INLINE WPT(Geom::CacheEntry) &get_slot(const Geom *geom,
+                                           const GeomVertexData *data,
+                                           const GeomMunger *munger);
+
+    WPT(Geom::CacheEntry) _slots[num_slots];
+    unsigned int _flush_seq = 0;
+  };
+
+  thread_local ThreadMungeCache thread_munge_cache;
+}
+
+/**
+ * Returns the slot in which the result for the indicated Geom, data and
+ * munger would be stored.  Also empties the table if the geom cache has been
+ * flushed since it was last used.
+ */
+INLINE WPT(Geom::CacheEntry) &ThreadMungeCache::
+get_slot(const Geom *geom, const GeomVertexData *data,
+         const GeomMunger *munger) {
+  unsigned int flush_seq = GeomCacheManager::get_global_ptr()->get_flush_seq();
+  if (flush_seq != _flush_seq) {
+    for (size_t si = 0; si < num_slots; ++si) {
+      _slots[si].clear();
+    }
+    _flush_seq = flush_seq;
+  }
+
+  uint32_t bits = (uint32_t)((uintptr_t)geom >> 4);
+  bits ^= (uint32_t)((uintptr_t)data >> 4) * 31u;
+  bits ^= (uint32_t)((uintptr_t)munger >> 4) * 961u;
+  bits *= 2654435761u;
+  return _slots[bits >> 26];
+}
+
 /**
  *
  */
@@ -98,15 +146,40 @@ munge_geom(CPT(Geom) &geom, CPT(GeomVertexData) &data,
   // Look up the munger in the geom's cache--maybe we've recently applied it.
   PT(Geom::CacheEntry) entry;
 
+  // First check whether this thread has recently looked it up.
+  WPT(Geom::CacheEntry) *slot = nullptr;
+  if (geom_munge_thread_cache) {
+    slot = &thread_munge_cache.get_slot(geom, data, this);
+    PT(Geom::CacheEntry) slot_entry = slot->lock();
+    if (slot_entry != nullptr) {
+      if (!slot_entry->is_recorded()) {
+        // It has been evicted or erased; don't hold on to it any longer.
+        slot->clear();
+
+      } else if (slot_entry->_source == geom &&
+                 slot_entry->_key._source_data == data &&
+                 slot_entry->_key._modifier == this) {
+        entry = std::move(slot_entry);
+      }
+    }
+  }
+
   Geom::CacheKey key(data, this);
 
-  geom->_cache_lock.acquire();
-  Geom::Cache::const_iterator ci = geom->_cache.find(&key);
-  if (ci == geom->_cache.end()) {
-    geom->_cache_lock.release();
-  } else {
-    entry = (*ci).second;
+  if (entry == nullptr) {
+    geom->_cache_lock.acquire();
+    Geom::Cache::const_iterator ci = geom->_cache.find(&key);
+    if (ci != geom->_cache.end()) {
+      entry = (*ci).second;
+    }
     geom->_cache_lock.release();
+
+    if (entry != nullptr && slot != nullptr) {
+      *slot = entry;
+    }
+  }
+
+  if (entry != nullptr) {
     nassertr(entry->_source == geom, false);
 
     // Here's an element in the cache for this computation.  Record a cache
@@ -120,6 +193,7 @@ munge_geom(CPT(Geom) &geom, CPT(GeomVertexData) &data,
         geom->get_modified(current_thread) <= cdata->_geom_result->get_modified(current_thread) &&
         data->get_modified(current_thread) <= cdata->_data_result->get_modified(current_thread)) {
       // The cache entry is still good; use it.
+      GeomCacheManager::_geom_cache_hit_pcollector.add_level(1);
 
       geom = cdata->_geom_result;
       data = cdata->_data_result;
@@ -139,6 +213,7 @@ munge_geom(CPT(Geom) &geom, CPT(GeomVertexData) &data,
 
   // Ok, invoke the munger.
   PStatTimer timer(_munge_pcollector, current_thread);
+  GeomCacheManager::_geom_cache_miss_pcollector.add_level(1);
 
   PT(Geom) orig_geom = (Geom *)geom.p();
   data = munge_data(data);
@@ -162,6 +237,10 @@ munge_geom(CPT(Geom) &geom, CPT(GeomVertexData) &data,
     // And tell the cache manager about the new entry.  (It might immediately
     // request a delete from the cache of the thing we just added.)
     entry->record(current_thread);
+
+    if (slot != nullptr) {
+      *slot = entry;
+    }
   }
 
   // Finally, store the cached result on the entry.
@@ -24,6 +24,7 @@
 #include "simpleAllocator.h"
 #include "vertexDataBuffer.h"
 #include "pbitops.h"
+#include "workerThreadPool.h"
 
 using std::max;
 using std::min;
@@ -42,6 +43,10 @@ ConfigVariableInt vertex_data_page_size
           "This also controls the page size that is compressed or written "
           "to disk when vertex data pages are evicted from memory."));
 
+// Arrays smaller than this are reversed on the calling thread; it isn't worth
+// waking up the worker threads for them.
+static const size_t parallel_reverse_min_bytes = 64 * 1024;
+
 SimpleLru GeomVertexArrayData::_independent_lru("independent", max_independent_vertex_data);
 SimpleLru GeomVertexArrayData::_small_lru("small", max_independent_vertex_data);
 
@@ -343,34 +348,49 @@ clear_prepared(PreparedGraphicsObjects *prepared_objects) {
 /**
  * Fills a new data array with all numeric values expressed in the indicated
  * array reversed, byte-for-byte, to convert littleendian to bigendian and
- * vice-versa.
+ * vice-versa.  Large arrays are divided between the threads of the
+ * WorkerThreadPool.
  */
 void GeomVertexArrayData::
 reverse_data_endianness(unsigned char *dest, const unsigned char *source,
                         size_t size) {
   int num_columns = _array_format->get_num_columns();
-
-  // Walk through each row of the data.
-  for (size_t pi = 0; pi < size; pi += _array_format->get_stride()) {
-    // For each row, visit all of the columns; and for each column, visit all
-    // of the components of that column.
-    for (int ci = 0; ci < num_columns; ++ci) {
-      const GeomVertexColumn *col = _array_format->get_column(ci);
-      int component_bytes = col->get_component_bytes();
-      if (component_bytes > 1) {
-        // Get the index of the beginning of the column.
-        size_t ci = pi + col->get_start();
-
-        int num_components = col->get_num_components();
-        for (int cj = 0; cj < num_components; ++cj) {
-          // Reverse the bytes of each component.
-          ReversedNumericData nd(source + ci, component_bytes);
-          nd.store_value(dest + ci, component_bytes);
-          ci += component_bytes;
+  size_t stride = _array_format->get_stride();
+  nassertv(stride > 0);
+  size_t num_rows = (size + stride - 1) / stride;
+
+  // Each row is reversed independently of the others.
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for_ranges(num_rows, size, parallel_reverse_min_bytes,
+                            [&] (size_t begin, size_t end) {
+    // Start with a straight copy, so that single-byte components and any
+    // padding between the columns come through unchanged.
+    size_t begin_byte = begin * stride;
+    size_t end_byte = min(end * stride, size);
+    memcpy(dest + begin_byte, source + begin_byte, end_byte - begin_byte);
+
+    // Walk through each row of the data.
+    for (size_t pi = begin_byte; pi < end_byte; pi += stride) {
+      // For each row, visit all of the columns; and for each column, visit
+      // all of the components of that column.
+      for (int ci = 0; ci < num_columns; ++ci) {
+        const GeomVertexColumn *col = _array_format->get_column(ci);
+        int component_bytes = col->get_component_bytes();
+        if (component_bytes > 1) {
+          // Get the index of the beginning of the column.
+          size_t ci = pi + col->get_start();
+
+          int num_components = col->get_num_components();
+          for (int cj = 0; cj < num_components; ++cj) {
+            // Reverse the bytes of each component.
+            ReversedNumericData nd(source + ci, component_bytes);
+            nd.store_value(dest + ci, component_bytes);
+            ci += component_bytes;
+          }
         }
       }
     }
-  }
+  });
 }
 
 /**
@@ -548,10 +568,19 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
     _buffer.unclean_realloc(size);
     _buffer.set_size(size);
 
-    const unsigned char *source_data =
-      (const unsigned char *)scan.get_datagram().get_data();
-    memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
-    scan.skip_bytes(size);
+    if (manager->get_file_endian() == BamReader::BE_native &&
+        array_data->get_lru() == nullptr) {
+      // Nothing below looks at the data, so the BamReader may copy it in
+      // later, together with the data of the other arrays.  An array that
+      // isn't in an LRU can't be paged out, so the buffer stays put until
+      // then.
+      manager->extract_payload(scan, _buffer.get_write_pointer(), size);
+    } else {
+      const unsigned char *source_data =
+        (const unsigned char *)scan.get_datagram().get_data();
+      memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
+      scan.skip_bytes(size);
+    }
   }
 
   bool endian_reversed = false;
@@ -22,6 +22,14 @@
 #include "pset.h"
 #include "indent.h"
 
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+// SSE2 is available at compile time; use it for the float32 fast paths in
+// the table_xform_* functions.
+#define HAVE_SSE2_XFORM 1
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
 using std::ostream;
 
 TypeHandle GeomVertexData::_type_handle;
@@ -968,8 +976,9 @@ animate_vertices(bool force, Thread *current_thread) const {
   }
 
   CDWriter cdataw(((GeomVertexData *)this)->_cycler, cdata, false);
+  UpdateSeq last_modified = cdataw->_animated_vertices_modified;
   cdataw->_animated_vertices_modified = modified;
-  ((GeomVertexData *)this)->update_animated_vertices(cdataw, current_thread);
+  ((GeomVertexData *)this)->update_animated_vertices(cdataw, last_modified, current_thread);
 
   return cdataw->_animated_vertices;
 }
@@ -1428,10 +1437,13 @@ uint8_rgba_to_packed_argb(unsigned char *to, int to_stride,
 
 /**
  * Recomputes the results of computing the vertex animation on the CPU, and
- * applies them to the existing animated_vertices object.
+ * applies them to the existing animated_vertices object.  last_modified is
+ * the state of the transforms at the time the existing animated_vertices were
+ * computed, if any.
  */
 void GeomVertexData::
-update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
+update_animated_vertices(GeomVertexData::CData *cdata, UpdateSeq last_modified,
+                         Thread *current_thread) {
   PStatTimer timer(_char_pcollector, current_thread);
 
   int num_rows = get_num_rows();
@@ -1445,95 +1457,182 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
   const GeomVertexFormat *orig_format = cdata->_format;
   CPT(GeomVertexFormat) new_format = orig_format;
 
+  // If only some of the transforms have changed since the animated vertices
+  // were last computed, and there are no morphs, we only need to recompute
+  // the vertices that depend on those transforms.  This requires that the
+  // existing results are laid out the same as the original data, so that we
+  // can copy rows across directly.
+  bool incremental = false;
   if (cdata->_animated_vertices == nullptr) {
     new_format = orig_format->get_post_animated_format();
     cdata->_animated_vertices =
       new GeomVertexData(get_name(), new_format,
                          std::min(get_usage_hint(), UH_dynamic));
+
+  } else if (!last_modified.is_special() &&
+             cdata->_slider_table == nullptr &&
+             cdata->_animated_vertices->get_num_rows() == num_rows) {
+    const GeomVertexFormat *animated_format = cdata->_animated_vertices->get_format();
+    size_t num_arrays = animated_format->get_num_arrays();
+    incremental = (num_arrays <= orig_format->get_num_arrays());
+    for (size_t ai = 0; ai < num_arrays && incremental; ++ai) {
+      incremental = (animated_format->get_array(ai) == orig_format->get_array(ai));
+    }
   }
   PT(GeomVertexData) new_data = cdata->_animated_vertices;
 
-  // We have to make a complete copy of the data first so we can modify it.
-  // If we were clever, we could maybe just figure out the subset of the data
-  // that might have changed since last frame, but that's too much trouble
-  // (and isn't obviously faster than just copying the whole thing).
-  new_data->copy_from(this, true);
-
-  // First, apply all of the morphs.
-  CPT(SliderTable) slider_table = cdata->_slider_table;
-  if (slider_table != nullptr) {
-    PStatTimer timer2(_morphs_pcollector);
-    int num_morphs = orig_format->get_num_morphs();
-    for (int mi = 0; mi < num_morphs; mi++) {
-      CPT(InternalName) slider_name = orig_format->get_morph_slider(mi);
-
-      const SparseArray &sliders = slider_table->find_sliders(slider_name);
-      if (!sliders.is_zero()) {
-        nassertv(!sliders.is_inverse());
-        int num_slider_subranges = sliders.get_num_subranges();
-        for (int sni = 0; sni < num_slider_subranges; ++sni) {
-          int slider_begin = sliders.get_subrange_begin(sni);
-          int slider_end = sliders.get_subrange_end(sni);
-          for (int sn = slider_begin; sn < slider_end; ++sn) {
-            const VertexSlider *slider = slider_table->get_slider(sn);
-            const SparseArray &rows = slider_table->get_slider_rows(sn);
-            nassertv(!rows.is_inverse());
-
-            PN_stdfloat slider_value = slider->get_slider();
-            if (slider_value != 0.0f) {
-              CPT(InternalName) base_name = orig_format->get_morph_base(mi);
-              CPT(InternalName) delta_name = orig_format->get_morph_delta(mi);
-
-              GeomVertexRewriter data(new_data, base_name);
-              GeomVertexReader delta(this, delta_name);
-              int num_subranges = rows.get_num_subranges();
-
-              if (data.get_column()->get_num_values() == 4) {
-                if (data.get_column()->has_homogeneous_coord()) {
-                  // Scale the delta by the homogeneous coordinate.
-                  for (int i = 0; i < num_subranges; ++i) {
-                    int begin = rows.get_subrange_begin(i);
-                    int end = rows.get_subrange_end(i);
-                    data.set_row_unsafe(begin);
-                    delta.set_row_unsafe(begin);
-                    for (int j = begin; j < end; ++j) {
-                      LPoint4 vertex = data.get_data4();
-                      LPoint3 d = delta.get_data3();
-                      d *= slider_value * vertex[3];
-                      data.set_data4(vertex[0] + d[0],
-                                      vertex[1] + d[1],
-                                      vertex[2] + d[2],
-                                      vertex[3]);
+  // Recompute all the blends up front, so we don't have to test each one for
+  // staleness at each vertex.  We also gather the resulting matrices into a
+  // flat table while we're at it, so that each run of vertices below only
+  // needs to index into it.
+  CPT(TransformBlendTable) tb_table = cdata->_transform_blend_table.get_read_pointer(current_thread);
+  pvector<LMatrix4> blend_mats;
+  BlendRuns runs;
+  bool has_runs = false;
+  if (tb_table != nullptr) {
+    int num_blends = tb_table->get_num_blends();
+    blend_mats.resize(num_blends);
+    pvector<bool> dirty_blends(num_blends, false);
+    {
+      PStatTimer timer4(_blends_pcollector);
+      for (int bi = 0; bi < num_blends; bi++) {
+        const TransformBlend &blend = tb_table->get_blend(bi);
+        blend.update_blend(current_thread);
+        blend.get_blend(blend_mats[bi], current_thread);
+        dirty_blends[bi] = (last_modified < blend.get_modified(current_thread));
+      }
+    }
+
+    has_runs = collect_blend_runs(cdata, tb_table, runs, current_thread);
+    if (!has_runs) {
+      gobj_cat.warning()
+        << "Vertex data " << get_name()
+        << " has a transform_blend_table, but no transform_blend data.\n";
+      incremental = false;
+
+    } else if (incremental) {
+      // Keep only the runs whose transforms have changed.  If that's most of
+      // the vertices anyway, it's cheaper to just copy everything.
+      BlendRuns dirty_runs;
+      int num_dirty_rows = 0;
+      BlendRuns::const_iterator ri;
+      for (ri = runs.begin(); ri != runs.end(); ++ri) {
+        if (dirty_blends[(*ri)._bi]) {
+          dirty_runs.push_back(*ri);
+          num_dirty_rows += (*ri)._end - (*ri)._begin;
+        }
+      }
+      if (num_dirty_rows * 2 <= num_rows) {
+        runs.swap(dirty_runs);
+      } else {
+        incremental = false;
+      }
+    }
+  } else {
+    incremental = false;
+  }
+
+  if (incremental) {
+    // Restore the original vertices of just the runs we are about to
+    // transform; the rest of the rows still hold valid results.
+    PStatTimer timer2(_skinning_pcollector);
+    size_t num_arrays = new_data->get_num_arrays();
+    for (size_t ai = 0; ai < num_arrays; ++ai) {
+      CPT(GeomVertexArrayDataHandle) from =
+        new GeomVertexArrayDataHandle(cdata->_arrays[ai].get_read_pointer(current_thread), current_thread);
+      PT(GeomVertexArrayDataHandle) to = new_data->modify_array_handle(ai);
+      size_t stride = orig_format->get_array(ai)->get_stride();
+      const unsigned char *from_data = from->get_read_pointer(true);
+      unsigned char *to_data = to->get_write_pointer();
+
+      BlendRuns::const_iterator ri;
+      for (ri = runs.begin(); ri != runs.end(); ++ri) {
+        memcpy(to_data + (*ri)._begin * stride,
+               from_data + (*ri)._begin * stride,
+               ((*ri)._end - (*ri)._begin) * stride);
+      }
+    }
+
+  } else {
+    // We have to make a complete copy of the data first so we can modify it.
+    new_data->copy_from(this, true);
+
+    // First, apply all of the morphs.
+    CPT(SliderTable) slider_table = cdata->_slider_table;
+    if (slider_table != nullptr) {
+      PStatTimer timer2(_morphs_pcollector);
+      int num_morphs = orig_format->get_num_morphs();
+      for (int mi = 0; mi < num_morphs; mi++) {
+        CPT(InternalName) slider_name = orig_format->get_morph_slider(mi);
+
+        const SparseArray &sliders = slider_table->find_sliders(slider_name);
+        if (!sliders.is_zero()) {
+          nassertv(!sliders.is_inverse());
+          int num_slider_subranges = sliders.get_num_subranges();
+          for (int sni = 0; sni < num_slider_subranges; ++sni) {
+            int slider_begin = sliders.get_subrange_begin(sni);
+            int slider_end = sliders.get_subrange_end(sni);
+            for (int sn = slider_begin; sn < slider_end; ++sn) {
+              const VertexSlider *slider = slider_table->get_slider(sn);
+              const SparseArray &rows = slider_table->get_slider_rows(sn);
+              nassertv(!rows.is_inverse());
+
+              PN_stdfloat slider_value = slider->get_slider();
+              if (slider_value != 0.0f) {
+                CPT(InternalName) base_name = orig_format->get_morph_base(mi);
+                CPT(InternalName) delta_name = orig_format->get_morph_delta(mi);
+
+                GeomVertexRewriter data(new_data, base_name);
+                GeomVertexReader delta(this, delta_name);
+                int num_subranges = rows.get_num_subranges();
+
+                if (data.get_column()->get_num_values() == 4) {
+                  if (data.get_column()->has_homogeneous_coord()) {
+                    // Scale the delta by the homogeneous coordinate.
+                    for (int i = 0; i < num_subranges; ++i) {
+                      int begin = rows.get_subrange_begin(i);
+                      int end = rows.get_subrange_end(i);
+                      data.set_row_unsafe(begin);
+                      delta.set_row_unsafe(begin);
+                      for (int j = begin; j < end; ++j) {
+                        LPoint4 vertex = data.get_data4();
+                        LPoint3 d = delta.get_data3();
+                        d *= slider_value * vertex[3];
+                        data.set_data4(vertex[0] + d[0],
+                                        vertex[1] + d[1],
+                                        vertex[2] + d[2],
+                                        vertex[3]);
+                      }
+                    }
+                  } else {
+                    // Just apply the four-component delta.
+                    for (int i = 0; i < num_subranges; ++i) {
+                      int begin = rows.get_subrange_begin(i);
+                      int end = rows.get_subrange_end(i);
+                      data.set_row_unsafe(begin);
+                      delta.set_row_unsafe(begin);
+                      for (int j = begin; j < end; ++j) {
+                        const LPoint4 &vertex = data.get_data4();
+                        LPoint4 d = delta.get_data4();
+                        data.set_data4(vertex + d * slider_value);
+                      }
                     }
                   }
                 } else {
-                  // Just apply the four-component delta.
+                  // 3-component or smaller values; don't worry about a
+                  // homogeneous coordinate.
                   for (int i = 0; i < num_subranges; ++i) {
                     int begin = rows.get_subrange_begin(i);
                     int end = rows.get_subrange_end(i);
                     data.set_row_unsafe(begin);
                     delta.set_row_unsafe(begin);
                     for (int j = begin; j < end; ++j) {
-                      const LPoint4 &vertex = data.get_data4();
-                      LPoint4 d = delta.get_data4();
-                      data.set_data4(vertex + d * slider_value);
+                      const LPoint3 &vertex = data.get_data3();
+                      LPoint3 d = delta.get_data3();
+                      data.set_data3(vertex + d * slider_value);
                     }
                   }
                 }
-              } else {
-                // 3-component or smaller values; don't worry about a
-                // homogeneous coordinate.
-                for (int i = 0; i < num_subranges; ++i) {
-                  int begin = rows.get_subrange_begin(i);
-                  int end = rows.get_subrange_end(i);
-                  data.set_row_unsafe(begin);
-                  delta.set_row_unsafe(begin);
-                  for (int j = begin; j < end; ++j) {
-                    const LPoint3 &vertex = data.get_data3();
-                    LPoint3 d = delta.get_data3();
-                    data.set_data3(vertex + d * slider_value);
-                  }
-                }
               }
             }
           }
@@ -1543,214 +1642,131 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
   }
 
   // Then apply the transforms.
-  CPT(TransformBlendTable) tb_table = cdata->_transform_blend_table.get_read_pointer(current_thread);
-  if (tb_table != nullptr) {
-    // Recompute all the blends up front, so we don't have to test each one
-    // for staleness at each vertex.
-    {
-      PStatTimer timer4(_blends_pcollector);
-      int num_blends = tb_table->get_num_blends();
-      for (int bi = 0; bi < num_blends; bi++) {
-        tb_table->get_blend(bi).update_blend(current_thread);
-      }
-    }
-
-    // Now go through and apply the transforms.
+  if (has_runs) {
     PStatTimer timer3(_skinning_pcollector);
 
-    const SparseArray &rows = tb_table->get_rows();
-    int num_subranges = rows.get_num_subranges();
-
-    int blend_array_index = orig_format->get_array_with(InternalName::get_transform_blend());
-    if (blend_array_index < 0) {
-      gobj_cat.warning()
-        << "Vertex data " << get_name()
-        << " has a transform_blend_table, but no transform_blend data.\n";
-      return;
+    size_t ci;
+    BlendRuns::const_iterator ri;
+    for (ci = 0; ci < new_format->get_num_points(); ci++) {
+      GeomVertexRewriter data(new_data, new_format->get_point(ci));
+      for (ri = runs.begin(); ri != runs.end(); ++ri) {
+        new_data->do_transform_point_column(new_format, data, blend_mats[(*ri)._bi], (*ri)._begin, (*ri)._end);
+      }
     }
 
-    CPT(GeomVertexArrayFormat) blend_array_format = orig_format->get_array(blend_array_index);
-
-    if (blend_array_format->get_stride() == 2 &&
-        blend_array_format->get_column(0)->get_component_bytes() == 2) {
-      // The blend indices are a table of ushorts.  Optimize this common case.
-      CPT(GeomVertexArrayDataHandle) blend_array_handle =
-        new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
-      const unsigned short *blendt = (const unsigned short *)blend_array_handle->get_read_pointer(true);
-
-      size_t ci;
-      for (ci = 0; ci < new_format->get_num_points(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_point(ci));
-
-        for (int i = 0; i < num_subranges; ++i) {
-          int begin = rows.get_subrange_begin(i);
-          int end = rows.get_subrange_end(i);
-          nassertv(begin < end);
-
-          int first_vertex = begin;
-          int first_bi = blendt[first_vertex];
-
-          while (first_vertex < end) {
-            // At this point, first_vertex is the first of a series of
-            // vertices that shares the blend index first_bi.
-
-            // Scan for the end of this series of vertices--we're looking for
-            // the next vertex with a different blend index.
-            int next_vertex = first_vertex;
-            int next_bi = first_bi;
-            ++next_vertex;
-            while (next_vertex < end) {
-              next_bi = blendt[next_vertex];
-              if (next_bi != first_bi) {
-                break;
-              }
-              ++next_vertex;
-            }
-
-            // We've just reached the end of the vertices with a matching
-            // blend index.  Transform all those vertices as a block.
-            LMatrix4 mat;
-            tb_table->get_blend(first_bi).get_blend(mat, current_thread);
-            new_data->do_transform_point_column(new_format, data, mat, first_vertex, next_vertex);
-
-            first_vertex = next_vertex;
-            first_bi = next_bi;
-          }
-        }
+    // The vector columns need a different matrix per blend; in the case of
+    // normals, the scale needs to be taken out.  We compute these once per
+    // column, as needed.
+    pvector<LMatrix4> vector_mats;
+    pvector<bool> vector_normalize;
+
+    for (ci = 0; ci < new_format->get_num_vectors(); ci++) {
+      GeomVertexRewriter data(new_data, new_format->get_vector(ci));
+      compute_vector_xforms(data.get_column(), blend_mats, vector_mats, vector_normalize);
+      for (ri = runs.begin(); ri != runs.end(); ++ri) {
+        new_data->do_xform_vector_column(data, vector_mats[(*ri)._bi], vector_normalize[(*ri)._bi], (*ri)._begin, (*ri)._end);
       }
+    }
+  }
+}
 
-      for (ci = 0; ci < new_format->get_num_vectors(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_vector(ci));
-
-        for (int i = 0; i < num_subranges; ++i) {
-          int begin = rows.get_subrange_begin(i);
-          int end = rows.get_subrange_end(i);
-          nassertv(begin < end);
-
-          int first_vertex = begin;
-          int first_bi = blendt[first_vertex];
-
-          while (first_vertex < end) {
-            // At this point, first_vertex is the first of a series of
-            // vertices that shares the blend index first_bi.
-
-            // Scan for the end of this series of vertices--we're looking for
-            // the next vertex with a different blend index.
-            int next_vertex = first_vertex;
-            int next_bi = first_bi;
-            ++next_vertex;
-            while (next_vertex < end) {
-              next_bi = blendt[next_vertex];
-              if (next_bi != first_bi) {
-                break;
-              }
-              ++next_vertex;
-            }
-
-            // We've just reached the end of the vertices with a matching
-            // blend index.  Transform all those vertices as a block.
-            LMatrix4 mat;
-            tb_table->get_blend(first_bi).get_blend(mat, current_thread);
-            new_data->do_transform_vector_column(new_format, data, mat, first_vertex, next_vertex);
-
-            first_vertex = next_vertex;
-            first_bi = next_bi;
-          }
+/**
+ * Fills runs with the ranges of consecutive animated rows that share the same
+ * blend index, so that each one can be transformed as a block.  Returns false
+ * if the data has no transform_blend column.
+ */
+bool GeomVertexData::
+collect_blend_runs(const GeomVertexData::CData *cdata,
+                   const TransformBlendTable *tb_table, BlendRuns &runs,
+                   Thread *current_thread) const {
+  const GeomVertexFormat *format = cdata->_format;
+  int blend_array_index = format->get_array_with(InternalName::get_transform_blend());
+  if (blend_array_index < 0) {
+    return false;
+  }
+
+  int num_blends = tb_table->get_num_blends();
+  const SparseArray &rows = tb_table->get_rows();
+  int num_subranges = rows.get_num_subranges();
+
+  const GeomVertexArrayFormat *blend_array_format = format->get_array(blend_array_index);
+
+  if (blend_array_format->get_stride() == 2 &&
+      blend_array_format->get_column(0)->get_component_bytes() == 2) {
+    // The blend indices are a table of ushorts.  Optimize this common case.
+    CPT(GeomVertexArrayDataHandle) blend_array_handle =
+      new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
+    const unsigned short *blendt = (const unsigned short *)blend_array_handle->get_read_pointer(true);
+
+    for (int i = 0; i < num_subranges; ++i) {
+      int begin = rows.get_subrange_begin(i);
+      int end = rows.get_subrange_end(i);
+      nassertr(begin < end, true);
+
+      int first_vertex = begin;
+      while (first_vertex < end) {
+        // Scan for the end of the series of vertices that shares the blend
+        // index of first_vertex.
+        int first_bi = blendt[first_vertex];
+        int next_vertex = first_vertex + 1;
+        while (next_vertex < end && blendt[next_vertex] == first_bi) {
+          ++next_vertex;
         }
-      }
 
-    } else {
-      // The blend indices are anything else.  Use the GeomVertexReader to
-      // iterate through them.
-      GeomVertexReader blendi(this, InternalName::get_transform_blend());
-      nassertv(blendi.has_column());
-
-      size_t ci;
-      for (ci = 0; ci < new_format->get_num_points(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_point(ci));
-
-        for (int i = 0; i < num_subranges; ++i) {
-          int begin = rows.get_subrange_begin(i);
-          int end = rows.get_subrange_end(i);
-          nassertv(begin < end);
-          blendi.set_row_unsafe(begin);
-
-          int first_vertex = begin;
-          int first_bi = blendi.get_data1i();
-
-          while (first_vertex < end) {
-            // At this point, first_vertex is the first of a series of
-            // vertices that shares the blend index first_bi.
-
-            // Scan for the end of this series of vertices--we're looking for
-            // the next vertex with a different blend index.
-            int next_vertex = first_vertex;
-            int next_bi = first_bi;
-            ++next_vertex;
-            while (next_vertex < end) {
-              next_bi = blendi.get_data1i();
-              if (next_bi != first_bi) {
-                break;
-              }
-              ++next_vertex;
-            }
+        nassertr(first_bi >= 0 && first_bi < num_blends, true);
+        BlendRun run;
+        run._begin = first_vertex;
+        run._end = next_vertex;
+        run._bi = first_bi;
+        runs.push_back(run);
 
-            // We've just reached the end of the vertices with a matching
-            // blend index.  Transform all those vertices as a block.
-            LMatrix4 mat;
-            tb_table->get_blend(first_bi).get_blend(mat, current_thread);
-            new_data->do_transform_point_column(new_format, data, mat, first_vertex, next_vertex);
+        first_vertex = next_vertex;
+      }
+    }
 
-            first_vertex = next_vertex;
-            first_bi = next_bi;
+  } else {
+    // The blend indices are anything else.  Use the GeomVertexReader to
+    // iterate through them.
+    GeomVertexReader blendi(this, InternalName::get_transform_blend());
+    nassertr(blendi.has_column(), false);
+
+    for (int i = 0; i < num_subranges; ++i) {
+      int begin = rows.get_subrange_begin(i);
+      int end = rows.get_subrange_end(i);
+      nassertr(begin < end, true);
+      blendi.set_row_unsafe(begin);
+
+      int first_vertex = begin;
+      int first_bi = blendi.get_data1i();
+
+      while (first_vertex < end) {
+        // Scan for the end of the series of vertices that shares the blend
+        // index first_bi.
+        int next_vertex = first_vertex + 1;
+        int next_bi = first_bi;
+        while (next_vertex < end) {
+          next_bi = blendi.get_data1i();
+          if (next_bi != first_bi) {
+            break;
           }
+          ++next_vertex;
         }
-      }
 
-      for (ci = 0; ci < new_format->get_num_vectors(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_vector(ci));
-
-        for (int i = 0; i < num_subranges; ++i) {
-          int begin = rows.get_subrange_begin(i);
-          int end = rows.get_subrange_end(i);
-          nassertv(begin != end);
-          blendi.set_row_unsafe(begin);
-
-          int first_vertex = begin;
-          int first_bi = blendi.get_data1i();
-
-          while (first_vertex < end) {
-            // At this point, first_vertex is the first of a series of
-            // vertices that shares the blend index first_bi.
-
-            // Scan for the end of this series of vertices--we're looking for
-            // the next vertex with a different blend index.
-            int next_vertex = first_vertex;
-            int next_bi = first_bi;
-            ++next_vertex;
-            while (next_vertex < end) {
-              next_bi = blendi.get_data1i();
-              if (next_bi != first_bi) {
-                break;
-              }
-              ++next_vertex;
-            }
+        nassertr(first_bi >= 0 && first_bi < num_blends, true);
+        BlendRun run;
+        run._begin = first_vertex;
+        run._end = next_vertex;
+        run._bi = first_bi;
+        runs.push_back(run);
 
-            // We've just reached the end of the vertices with a matching
-            // blend index.  Transform all those vertices as a block.
-            LMatrix4 mat;
-            tb_table->get_blend(first_bi).get_blend(mat, current_thread);
-            new_data->do_transform_vector_column(new_format, data, mat, first_vertex, next_vertex);
-
-            first_vertex = next_vertex;
-            first_bi = next_bi;
-          }
-        }
+        first_vertex = next_vertex;
+        first_bi = next_bi;
       }
     }
   }
-}
 
+  return true;
+}
 
 /**
  * Transforms a range of vertices for one particular column, as a point.
@@ -1805,40 +1821,22 @@ do_transform_point_column(const GeomVertexFormat *format, GeomVertexRewriter &da
 void GeomVertexData::
 do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
                            const LMatrix4 &mat, int begin_row, int end_row) {
+  LMatrix4 xform;
+  bool normalize = compute_vector_xform(xform, mat, data.get_column()->get_contents() == C_normal);
+  do_xform_vector_column(data, xform, normalize, begin_row, end_row);
+}
+
+/**
+ * Transforms a range of vertices for one particular column, as a vector, by
+ * a matrix that was previously returned by compute_vector_xform().  If
+ * normalize is true, the vectors are normalized afterwards.
+ */
+void GeomVertexData::
+do_xform_vector_column(GeomVertexRewriter &data, const LMatrix4 &xform,
+                       bool normalize, int begin_row, int end_row) {
   const GeomVertexColumn *data_column = data.get_column();
   int num_values = data_column->get_num_values();
 
-  LMatrix4 xform;
-  bool normalize = false;
-  if (data_column->get_contents() == C_normal) {
-    // This is to preserve perpendicularity to the surface.
-    LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
-                       mat.get_row3(1).length_squared(),
-                       mat.get_row3(2).length_squared());
-    if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
-        IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
-      // There is a uniform scale.
-      LVecBase3 scale, shear, hpr;
-      if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
-        // No scale to worry about.
-        xform = mat;
-      } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
-        // Make a new matrix with scale/translate taken out of the equation.
-        compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
-      } else {
-        normalize = true;
-      }
-    } else {
-      // There is a non-uniform scale, so we need to do all this to preserve
-      // orthogonality to the surface.
-      xform.invert_from(mat);
-      xform.transpose_in_place();
-      normalize = true;
-    }
-  } else {
-    xform = mat;
-  }
-
   if ((num_values == 3 || num_values == 4) &&
       data_column->get_numeric_type() == NT_float32) {
     // The table of vectors is a table of LVector3f's or LVector4f's.
@@ -1879,6 +1877,108 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   }
 }
 
+/**
+ * Computes the matrix that should be used to transform a vector column by the
+ * indicated matrix.  For a normal, this is the matrix that preserves
+ * perpendicularity to the surface; otherwise it is the matrix itself.
+ * Returns true if the vectors need to be normalized after the transform.
+ */
+bool GeomVertexData::
+compute_vector_xform(LMatrix4 &xform, const LMatrix4 &mat, bool is_normal) {
+  if (!is_normal) {
+    xform = mat;
+    return false;
+  }
+
+  // This is to preserve perpendicularity to the surface.
+  LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
+                     mat.get_row3(1).length_squared(),
+                     mat.get_row3(2).length_squared());
+  if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
+      IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
+    // There is a uniform scale.
+    LVecBase3 scale, shear, hpr;
+    if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
+      // No scale to worry about.
+      xform = mat;
+      return false;
+    } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
+      // Make a new matrix with scale/translate taken out of the equation.
+      compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
+      return false;
+    } else {
+      xform = mat;
+      return true;
+    }
+  } else {
+    // There is a non-uniform scale, so we need to do all this to preserve
+    // orthogonality to the surface.
+    xform.invert_from(mat);
+    xform.transpose_in_place();
+    return true;
+  }
+}
+
+/**
+ * Fills in vector_mats and normalize with the result of compute_vector_xform()
+ * for each of the indicated blend matrices, as appropriate for the indicated
+ * column.
+ */
+void GeomVertexData::
+compute_vector_xforms(const GeomVertexColumn *column,
+                      const pvector<LMatrix4> &blend_mats,
+                      pvector<LMatrix4> &vector_mats,
+                      pvector<bool> &normalize) {
+  bool is_normal = (column->get_contents() == C_normal);
+  size_t num_blends = blend_mats.size();
+  vector_mats.resize(num_blends);
+  normalize.resize(num_blends);
+  for (size_t bi = 0; bi < num_blends; ++bi) {
+    normalize[bi] = compute_vector_xform(vector_mats[bi], blend_mats[bi], is_normal);
+  }
+}
+
+#ifdef HAVE_SSE2_XFORM
+/**
+ * Computes x * row0 + y * row1 + z * row2 for the SSE2 table transforms.
+ */
+static INLINE __m128
+sse2_xform_vec3(const float *v, __m128 row0, __m128 row1, __m128 row2) {
+  __m128 r = _mm_mul_ps(_mm_set1_ps(v[0]), row0);
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v[1]), row1));
+  return _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v[2]), row2));
+}
+
+/**
+ * Stores the first three components of the vector, leaving the memory
+ * following it untouched.
+ */
+static INLINE void
+sse2_store3(float *v, __m128 r) {
+  _mm_storel_pi((__m64 *)v, r);
+  _mm_store_ss(v + 2, _mm_movehl_ps(r, r));
+}
+
+/**
+ * Normalizes the first three components of the vector, following the same
+ * rules as LVecBase3f::normalize().  The fourth component must be zero.
+ */
+static INLINE __m128
+sse2_normalize3(__m128 r) {
+  __m128 sq = _mm_mul_ps(r, r);
+  __m128 len_sq = _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1))),
+                             _mm_movehl_ps(sq, sq));
+  float l2 = _mm_cvtss_f32(len_sq);
+  if (l2 == 0.0f) {
+    return _mm_setzero_ps();
+  } else if (IS_THRESHOLD_EQUAL(l2, 1.0f, (NEARLY_ZERO(float) * NEARLY_ZERO(float)))) {
+    return r;
+  }
+  __m128 len = _mm_sqrt_ss(len_sq);
+  return _mm_div_ps(r, _mm_shuffle_ps(len, len, _MM_SHUFFLE(0, 0, 0, 0)));
+}
+#endif  // HAVE_SSE2_XFORM
+
 /**
  * Transforms each of the LPoint3f objects in the indicated table by the
  * indicated matrix.
@@ -1886,12 +1986,43 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
 void GeomVertexData::
 table_xform_point3f(unsigned char *datat, size_t num_rows, size_t stride,
                     const LMatrix4f &matf) {
+#ifdef HAVE_SSE2_XFORM
+  // Keep the matrix in registers, and do four rows per iteration so that the
+  // multiplies of neighbouring rows can overlap.  We only ever touch the
+  // three floats of each row, so the stride doesn't matter.
+  const float *m = matf.get_data();
+  __m128 row0 = _mm_loadu_ps(m);
+  __m128 row1 = _mm_loadu_ps(m + 4);
+  __m128 row2 = _mm_loadu_ps(m + 8);
+  __m128 row3 = _mm_loadu_ps(m + 12);
+
+  size_t i = 0;
+  for (; i + 4 <= num_rows; i += 4) {
+    float *v0 = (float *)(datat + i * stride);
+    float *v1 = (float *)(datat + (i + 1) * stride);
+    float *v2 = (float *)(datat + (i + 2) * stride);
+    float *v3 = (float *)(datat + (i + 3) * stride);
+    __m128 r0 = _mm_add_ps(sse2_xform_vec3(v0, row0, row1, row2), row3);
+    __m128 r1 = _mm_add_ps(sse2_xform_vec3(v1, row0, row1, row2), row3);
+    __m128 r2 = _mm_add_ps(sse2_xform_vec3(v2, row0, row1, row2), row3);
+    __m128 r3 = _mm_add_ps(sse2_xform_vec3(v3, row0, row1, row2), row3);
+    sse2_store3(v0, r0);
+    sse2_store3(v1, r1);
+    sse2_store3(v2, r2);
+    sse2_store3(v3, r3);
+  }
+  for (; i < num_rows; ++i) {
+    float *v = (float *)(datat + i * stride);
+    sse2_store3(v, _mm_add_ps(sse2_xform_vec3(v, row0, row1, row2), row3));
+  }
+#else
   // We don't bother checking for the unaligned case here, because in practice
   // it doesn't matter with a 3-component point.
   for (size_t i = 0; i < num_rows; ++i) {
     LPoint3f &vertex = *(LPoint3f *)(&datat[i * stride]);
     vertex *= matf;
   }
+#endif  // HAVE_SSE2_XFORM
 }
 
 /**
@@ -1901,6 +2032,39 @@ table_xform_point3f(unsigned char *datat, size_t num_rows, size_t stride,
 void GeomVertexData::
 table_xform_normal3f(unsigned char *datat, size_t num_rows, size_t stride,
                      const LMatrix4f &matf) {
+#ifdef HAVE_SSE2_XFORM
+  const float *m = matf.get_data();
+  __m128 row0 = _mm_loadu_ps(m);
+  __m128 row1 = _mm_loadu_ps(m + 4);
+  __m128 row2 = _mm_loadu_ps(m + 8);
+
+  // The fourth lane of each row isn't part of the 3x3 transform, so clear it
+  // to keep it out of the length computation.
+  __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  row0 = _mm_and_ps(row0, mask);
+  row1 = _mm_and_ps(row1, mask);
+  row2 = _mm_and_ps(row2, mask);
+
+  size_t i = 0;
+  for (; i + 4 <= num_rows; i += 4) {
+    float *v0 = (float *)(datat + i * stride);
+    float *v1 = (float *)(datat + (i + 1) * stride);
+    float *v2 = (float *)(datat + (i + 2) * stride);
+    float *v3 = (float *)(datat + (i + 3) * stride);
+    __m128 r0 = sse2_xform_vec3(v0, row0, row1, row2);
+    __m128 r1 = sse2_xform_vec3(v1, row0, row1, row2);
+    __m128 r2 = sse2_xform_vec3(v2, row0, row1, row2);
+    __m128 r3 = sse2_xform_vec3(v3, row0, row1, row2);
+    sse2_store3(v0, sse2_normalize3(r0));
+    sse2_store3(v1, sse2_normalize3(r1));
+    sse2_store3(v2, sse2_normalize3(r2));
+    sse2_store3(v3, sse2_normalize3(r3));
+  }
+  for (; i < num_rows; ++i) {
+    float *v = (float *)(datat + i * stride);
+    sse2_store3(v, sse2_normalize3(sse2_xform_vec3(v, row0, row1, row2)));
+  }
+#else
   // We don't bother checking for the unaligned case here, because in practice
   // it doesn't matter with a 3-component vector.
   for (size_t i = 0; i < num_rows; ++i) {
@@ -1908,6 +2072,7 @@ table_xform_normal3f(unsigned char *datat, size_t num_rows, size_t stride,
     vertex *= matf;
     vertex.normalize();
   }
+#endif  // HAVE_SSE2_XFORM
 }
 
 /**
@@ -1917,12 +2082,39 @@ table_xform_normal3f(unsigned char *datat, size_t num_rows, size_t stride,
 void GeomVertexData::
 table_xform_vector3f(unsigned char *datat, size_t num_rows, size_t stride,
                      const LMatrix4f &matf) {
+#ifdef HAVE_SSE2_XFORM
+  const float *m = matf.get_data();
+  __m128 row0 = _mm_loadu_ps(m);
+  __m128 row1 = _mm_loadu_ps(m + 4);
+  __m128 row2 = _mm_loadu_ps(m + 8);
+
+  size_t i = 0;
+  for (; i + 4 <= num_rows; i += 4) {
+    float *v0 = (float *)(datat + i * stride);
+    float *v1 = (float *)(datat + (i + 1) * stride);
+    float *v2 = (float *)(datat + (i + 2) * stride);
+    float *v3 = (float *)(datat + (i + 3) * stride);
+    __m128 r0 = sse2_xform_vec3(v0, row0, row1, row2);
+    __m128 r1 = sse2_xform_vec3(v1, row0, row1, row2);
+    __m128 r2 = sse2_xform_vec3(v2, row0, row1, row2);
+    __m128 r3 = sse2_xform_vec3(v3, row0, row1, row2);
+    sse2_store3(v0, r0);
+    sse2_store3(v1, r1);
+    sse2_store3(v2, r2);
+    sse2_store3(v3, r3);
+  }
+  for (; i < num_rows; ++i) {
+    float *v = (float *)(datat + i * stride);
+    sse2_store3(v, sse2_xform_vec3(v, row0, row1, row2));
+  }
+#else
   // We don't bother checking for the unaligned case here, because in practice
   // it doesn't matter with a 3-component vector.
   for (size_t i = 0; i < num_rows; ++i) {
     LVector3f &vertex = *(LVector3f *)(&datat[i * stride]);
     vertex *= matf;
   }
+#endif  // HAVE_SSE2_XFORM
 }
 
 /**
@@ -1932,6 +2124,32 @@ table_xform_vector3f(unsigned char *datat, size_t num_rows, size_t stride,
 void GeomVertexData::
 table_xform_vecbase4f(unsigned char *datat, size_t num_rows, size_t stride,
                       const LMatrix4f &matf) {
+#ifdef HAVE_SSE2_XFORM
+  // Unaligned loads and stores cost next to nothing on modern hardware, so
+  // there's no need to treat the unaligned case separately.
+  const float *m = matf.get_data();
+  __m128 row0 = _mm_loadu_ps(m);
+  __m128 row1 = _mm_loadu_ps(m + 4);
+  __m128 row2 = _mm_loadu_ps(m + 8);
+  __m128 row3 = _mm_loadu_ps(m + 12);
+
+  size_t i = 0;
+  for (; i + 2 <= num_rows; i += 2) {
+    float *v0 = (float *)(datat + i * stride);
+    float *v1 = (float *)(datat + (i + 1) * stride);
+    __m128 r0 = _mm_add_ps(sse2_xform_vec3(v0, row0, row1, row2),
+                           _mm_mul_ps(_mm_set1_ps(v0[3]), row3));
+    __m128 r1 = _mm_add_ps(sse2_xform_vec3(v1, row0, row1, row2),
+                           _mm_mul_ps(_mm_set1_ps(v1[3]), row3));
+    _mm_storeu_ps(v0, r0);
+    _mm_storeu_ps(v1, r1);
+  }
+  if (i < num_rows) {
+    float *v = (float *)(datat + i * stride);
+    _mm_storeu_ps(v, _mm_add_ps(sse2_xform_vec3(v, row0, row1, row2),
+                                _mm_mul_ps(_mm_set1_ps(v[3]), row3)));
+  }
+#else
 #if defined(HAVE_EIGEN) && defined(LINMATH_ALIGN)
   // Check if the table is unaligned.  If it is, we can't use the LVecBase4f
   // object directly, which assumes 16-byte alignment.
@@ -1953,6 +2171,7 @@ table_xform_vecbase4f(unsigned char *datat, size_t num_rows, size_t stride,
     LVecBase4f &vertex = *(LVecBase4f *)(&datat[i * stride]);
     vertex *= matf;
   }
+#endif  // HAVE_SSE2_XFORM
 }
 
 /**
@@ -337,11 +337,31 @@ private:
   LightMutex _cache_lock;
 
 private:
-  void update_animated_vertices(CData *cdata, Thread *current_thread);
+  class BlendRun {
+  public:
+    int _begin;
+    int _end;
+    int _bi;
+  };
+  typedef pvector<BlendRun> BlendRuns;
+
+  void update_animated_vertices(CData *cdata, UpdateSeq last_modified,
+                                Thread *current_thread);
+  bool collect_blend_runs(const CData *cdata,
+                          const TransformBlendTable *tb_table,
+                          BlendRuns &runs, Thread *current_thread) const;
   void do_transform_point_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
                                  const LMatrix4 &mat, int begin_row, int end_row);
   void do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
                                   const LMatrix4 &mat, int begin_row, int end_row);
+  void do_xform_vector_column(GeomVertexRewriter &data, const LMatrix4 &xform,
+                              bool normalize, int begin_row, int end_row);
+  static bool compute_vector_xform(LMatrix4 &xform, const LMatrix4 &mat,
+                                   bool is_normal);
+  static void compute_vector_xforms(const GeomVertexColumn *column,
+                                    const pvector<LMatrix4> &blend_mats,
+                                    pvector<LMatrix4> &vector_mats,
+                                    pvector<bool> &normalize);
   static void table_xform_point3f(unsigned char *datat, size_t num_rows,
                                   size_t stride, const LMatrix4f &matf);
   static void table_xform_normal3f(unsigned char *datat, size_t num_rows,
@@ -44,6 +44,7 @@
 #include "texturePeeker.h"
 #include "convert_srgb.h"
 #include "asyncTaskManager.h"
+#include "workerThreadPool.h"
 
 #ifdef HAVE_SQUISH
 #include <squish.h>
@@ -51,6 +52,11 @@
 
 #include <stddef.h>
 
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TEXTURE_FILTER_SSE2
+#endif
+
 using std::endl;
 using std::istream;
 using std::max;
@@ -75,6 +81,147 @@ TypeHandle Texture::_type_handle;
 TypeHandle Texture::CData::_type_handle;
 AutoTextureScale Texture::_textures_power_2 = ATS_unspecified;
 
+// Below this many bytes of source image, it isn't worth the overhead of
+// handing the work of filtering or compressing an image to other threads.
+static const size_t parallel_image_min_bytes = 64 * 1024;
+
+// Filters a whole row of to_x_size destination pixels from the two source
+// rows q0 and q1, which are each 2 * to_x_size pixels wide.  These produce
+// exactly the same results as the per-component Filter2DComponent functions.
+typedef void Filter2DRow(unsigned char *p, const unsigned char *q0,
+                         const unsigned char *q1, int to_x_size);
+
+#ifdef TEXTURE_FILTER_SSE2
+/**
+ * Box-filters a row of four-component unsigned byte pixels.
+ */
+static void
+filter_2d_row_rgba8_sse2(unsigned char *p, const unsigned char *q0,
+                         const unsigned char *q1, int to_x_size) {
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 4 <= to_x_size; x += 4) {
+    // Load eight pixels from each source row, and separate the even pixels
+    // from the odd ones.
+    __m128 a0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)q0));
+    __m128 a1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(q0 + 16)));
+    __m128 b0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)q1));
+    __m128 b1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(q1 + 16)));
+    __m128i ae = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i ao = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+    __m128i be = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i bo = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+    __m128i lo = _mm_add_epi16(
+      _mm_add_epi16(_mm_unpacklo_epi8(ae, zero), _mm_unpacklo_epi8(ao, zero)),
+      _mm_add_epi16(_mm_unpacklo_epi8(be, zero), _mm_unpacklo_epi8(bo, zero)));
+    __m128i hi = _mm_add_epi16(
+      _mm_add_epi16(_mm_unpackhi_epi8(ae, zero), _mm_unpackhi_epi8(ao, zero)),
+      _mm_add_epi16(_mm_unpackhi_epi8(be, zero), _mm_unpackhi_epi8(bo, zero)));
+    lo = _mm_srli_epi16(lo, 2);
+    hi = _mm_srli_epi16(hi, 2);
+    _mm_storeu_si128((__m128i *)p, _mm_packus_epi16(lo, hi));
+    p += 16;
+    q0 += 32;
+    q1 += 32;
+  }
+  for (; x < to_x_size; ++x) {
+    for (int c = 0; c < 4; ++c) {
+      p[c] = (unsigned char)(((unsigned int)q0[c] + (unsigned int)q0[c + 4] +
+                              (unsigned int)q1[c] + (unsigned int)q1[c + 4]) >> 2);
+    }
+    p += 4;
+    q0 += 8;
+    q1 += 8;
+  }
+}
+
+/**
+ * Box-filters a row of single-component unsigned byte pixels.
+ */
+static void
+filter_2d_row_r8_sse2(unsigned char *p, const unsigned char *q0,
+                      const unsigned char *q1, int to_x_size) {
+  const __m128i mask = _mm_set1_epi16(0x00ff);
+  int x = 0;
+  for (; x + 8 <= to_x_size; x += 8) {
+    // Sum each pair of neighbouring pixels into a 16-bit lane.
+    __m128i a = _mm_loadu_si128((const __m128i *)q0);
+    __m128i b = _mm_loadu_si128((const __m128i *)q1);
+    __m128i sum = _mm_add_epi16(
+      _mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)),
+      _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+    sum = _mm_srli_epi16(sum, 2);
+    _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(sum, sum));
+    p += 8;
+    q0 += 16;
+    q1 += 16;
+  }
+  for (; x < to_x_size; ++x) {
+    *p = (unsigned char)(((unsigned int)q0[0] + (unsigned int)q0[1] +
+                          (unsigned int)q1[0] + (unsigned int)q1[1]) >> 2);
+    ++p;
+    q0 += 2;
+    q1 += 2;
+  }
+}
+
+/**
+ * Box-filters a row of four-component float pixels.  The samples are added
+ * in the same order as filter_2d_float(), so that the results are identical.
+ */
+static void
+filter_2d_row_rgba32f_sse2(unsigned char *p, const unsigned char *q0,
+                           const unsigned char *q1, int to_x_size) {
+  const __m128 quarter = _mm_set1_ps(0.25f);
+  float *pf = (float *)p;
+  const float *a = (const float *)q0;
+  const float *b = (const float *)q1;
+  for (int x = 0; x < to_x_size; ++x) {
+    __m128 sum = _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(a + 4));
+    sum = _mm_add_ps(sum, _mm_loadu_ps(b));
+    sum = _mm_add_ps(sum, _mm_loadu_ps(b + 4));
+    _mm_storeu_ps(pf, _mm_mul_ps(sum, quarter));
+    pf += 4;
+    a += 8;
+    b += 8;
+  }
+}
+
+/**
+ * Box-filters a row of single-component float pixels.
+ */
+static void
+filter_2d_row_r32f_sse2(unsigned char *p, const unsigned char *q0,
+                        const unsigned char *q1, int to_x_size) {
+  const __m128 quarter = _mm_set1_ps(0.25f);
+  float *pf = (float *)p;
+  const float *a = (const float *)q0;
+  const float *b = (const float *)q1;
+  int x = 0;
+  for (; x + 4 <= to_x_size; x += 4) {
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 b0 = _mm_loadu_ps(b);
+    __m128 b1 = _mm_loadu_ps(b + 4);
+    __m128 sum = _mm_add_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)),
+                            _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+    _mm_storeu_ps(pf, _mm_mul_ps(sum, quarter));
+    pf += 4;
+    a += 8;
+    b += 8;
+  }
+  for (; x < to_x_size; ++x) {
+    *pf = (a[0] + a[1] + b[0] + b[1]) / 4.0f;
+    ++pf;
+    a += 2;
+    b += 2;
+  }
+}
+#endif  // TEXTURE_FILTER_SSE2
+
 // Stuff to read and write DDS files.
 
 // little-endian, of course
@@ -6311,12 +6458,18 @@ do_compress_ram_image_bc4(const RamImage &uncompressed_image,
 
   static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
+  // Each row of blocks can be compressed independently of the others.
+  size_t num_rows = (size_t)num_pages * (size_t)y_blocks;
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for_ranges(num_rows, uncompressed_image._page_size * num_pages,
+                            parallel_image_min_bytes, [&] (size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t z = i / y_blocks;
+      size_t y = i % y_blocks;
+      unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size + y * x_blocks * 8;
+      unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size + y * 4 * x_size;
+
+      // Convert one 4 x 4 block at a time.
       for (int x = 0; x < x_blocks; ++x) {
         int a, b, c, d;
         float fac, add;
@@ -6385,10 +6538,9 @@ do_compress_ram_image_bc4(const RamImage &uncompressed_image,
         // Advance to the beginning of the next 4x4 block.
         src += 4;
       }
-      src += x_size * 3;
+      Thread::consider_yield();
     }
-    Thread::consider_yield();
-  }
+  });
 }
 
 /**
@@ -6410,12 +6562,18 @@ do_compress_ram_image_bc5(const RamImage &uncompressed_image,
 
   static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
+  // Each row of blocks can be compressed independently of the others.
+  size_t num_rows = (size_t)num_pages * (size_t)y_blocks;
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for_ranges(num_rows, uncompressed_image._page_size * num_pages,
+                            parallel_image_min_bytes, [&] (size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t z = i / y_blocks;
+      size_t y = i % y_blocks;
+      unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size + y * x_blocks * 16;
+      unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size + y * 4 * stride;
+
+      // Convert one 4 x 4 block at a time.
       for (int x = 0; x < x_blocks; ++x) {
         int a, b, c, d;
         float fac, add;
@@ -6544,10 +6702,9 @@ do_compress_ram_image_bc5(const RamImage &uncompressed_image,
         // Advance to the beginning of the next 4x4 block.
         src += 8;
       }
-      src += stride * 3;
+      Thread::consider_yield();
     }
-    Thread::consider_yield();
-  }
+  });
 }
 
 /**
@@ -9396,86 +9553,66 @@ do_filter_2d_mipmap_pages(const CData *cdata,
   }
 
   int num_pages = cdata->_z_size * cdata->_num_views;
-  for (int z = 0; z < num_pages; ++z) {
-    // For each level.
-    unsigned char *p = to._image.p() + z * to._page_size;
-    nassertv(p <= to._image.p() + to._image.size() + to._page_size);
-    const unsigned char *q = from._image.p() + z * from._page_size;
-    nassertv(q <= from._image.p() + from._image.size() + from._page_size);
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + z * to._page_size + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + z * from._page_size + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, row_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, row_size);
-          }
-        }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
-      }
-    } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
+  nassertv(from._page_size == (size_t)y_size * row_size);
+  nassertv(from._image.size() >= from._page_size * num_pages);
+
+  // If all of the components of a pixel are filtered alike, we may be able to
+  // filter a whole row at a time.
+  Filter2DRow *filter_row = nullptr;
+#ifdef TEXTURE_FILTER_SSE2
+  if (x_size != 1 && !is_srgb(cdata->_format)) {
+    if (cdata->_component_type == T_unsigned_byte) {
+      if (pixel_size == 4) {
+        filter_row = &filter_2d_row_rgba8_sse2;
+      } else if (pixel_size == 1) {
+        filter_row = &filter_2d_row_r8_sse2;
+      }
+    } else if (cdata->_component_type == T_float) {
+      if (pixel_size == 16) {
+        filter_row = &filter_2d_row_rgba32f_sse2;
+      } else if (pixel_size == 4) {
+        filter_row = &filter_2d_row_r32f_sse2;
+      }
+    }
+  }
+#endif  // TEXTURE_FILTER_SSE2
+
+  // A source dimension of 1 is not halved; instead, the same pixel or row is
+  // sampled twice.
+  size_t next_pixel = (x_size != 1) ? pixel_size : 0;
+  size_t next_row = (y_size != 1) ? row_size : 0;
+
+  // Every row of every page of the result can be computed independently.
+  size_t num_rows = (size_t)num_pages * (size_t)to_y_size;
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for_ranges(num_rows, from._page_size * num_pages,
+                            parallel_image_min_bytes, [&] (size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t z = i / to_y_size;
+      size_t y = i % to_y_size;
+      unsigned char *p = to._image.p() + z * to._page_size + y * to_row_size;
+      const unsigned char *q = from._image.p() + z * from._page_size + (y * 2) * row_size;
+
+      if (filter_row != nullptr) {
+        filter_row(p, q, q + next_row, to_x_size);
+
+      } else {
+        for (int x = 0; x < to_x_size; ++x) {
           // For each pixel.
           for (int c = 0; c < num_color_components; ++c) {
             // For each component.
-            filter_component(p, q, pixel_size, 0);
+            filter_component(p, q, next_pixel, next_row);
           }
           if (alpha) {
-            filter_alpha(p, q, pixel_size, 0);
+            filter_alpha(p, q, next_pixel, next_row);
           }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < num_color_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0);
-        }
-        if (alpha) {
-          filter_alpha(p, q, pixel_size, 0);
+          // Skip the odd pixel, which went into this one.
+          q += next_pixel;
         }
       }
+      Thread::consider_yield();
     }
-
-    nassertv(p == to._image.p() + (z + 1) * to._page_size);
-    nassertv(q == from._image.p() + (z + 1) * from._page_size);
-  }
+  });
 }
 
 /**
@@ -9918,75 +10055,106 @@ do_squish(CData *cdata, Texture::CompressionMode compression, int squish_flags)
     do_generate_ram_mipmap_images(cdata, false);
   }
 
-  RamImages compressed_ram_images;
-  compressed_ram_images.reserve(cdata->_ram_images.size());
+  // Every row of cells of every page of every mipmap level can be compressed
+  // independently of the others, so gather them all up first.
+  struct CellRow {
+    unsigned char *_dest;
+    const unsigned char *_source_page;
+    const unsigned char *_source_page_end;
+    int _x_size;
+    int _y;
+  };
+  pvector<CellRow> cell_rows;
+  size_t total_size = 0;
+
+  int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  RamImages compressed_ram_images(cdata->_ram_images.size());
   for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage compressed_image;
+    RamImage &compressed_image = compressed_ram_images[n];
+    const RamImage &source_image = cdata->_ram_images[n];
     int x_size = do_get_expected_mipmap_x_size(cdata, n);
     int y_size = do_get_expected_mipmap_y_size(cdata, n);
     int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
     int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+    int row_size = ((x_size + 3) / 4) * cell_size;
 
     compressed_image._page_size = page_size;
     compressed_image._image = PTA_uchar::empty_array(page_size * num_pages);
     for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = compressed_image._image.p() + z * page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * cdata->_ram_images[n]._page_size;
-      unsigned const char *source_page_end = source_page + cdata->_ram_images[n]._page_size;
-      // Convert one 4 x 4 cell at a time.
-      unsigned char *d = dest_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          int mask = 0;
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned const char *s = source_page + (yi * x_size + xi) * cdata->_num_components;
-            if (s < source_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 2:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = s[1];   // a
-                break;
+      CellRow row;
+      row._dest = compressed_image._image.p() + z * page_size;
+      row._source_page = source_image._image.p() + z * source_image._page_size;
+      row._source_page_end = row._source_page + source_image._page_size;
+      row._x_size = x_size;
+      for (row._y = 0; row._y < y_size; row._y += 4) {
+        cell_rows.push_back(row);
+        row._dest += row_size;
+      }
+    }
+    total_size += source_image._image.size();
+  }
 
-              case 3:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
+  int num_components = cdata->_num_components;
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for_ranges(cell_rows.size(), total_size,
+                            parallel_image_min_bytes, [&] (size_t begin, size_t end) {
+    for (size_t ri = begin; ri < end; ++ri) {
+      const CellRow &row = cell_rows[ri];
+      unsigned const char *source_page = row._source_page;
+      unsigned const char *source_page_end = row._source_page_end;
+      int x_size = row._x_size;
+      int y = row._y;
 
-              case 4:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = s[3];   // a
-                break;
-              }
-              mask |= (1 << i);
+      // Convert one 4 x 4 cell at a time.
+      unsigned char *d = row._dest;
+      for (int x = 0; x < x_size; x += 4) {
+        unsigned char tb[16 * 4];
+        int mask = 0;
+        unsigned char *t = tb;
+        for (int i = 0; i < 16; ++i) {
+          int xi = x + i % 4;
+          int yi = y + i / 4;
+          unsigned const char *s = source_page + (yi * x_size + xi) * num_components;
+          if (s < source_page_end) {
+            switch (num_components) {
+            case 1:
+              t[0] = s[0];   // r
+              t[1] = s[0];   // g
+              t[2] = s[0];   // b
+              t[3] = 255;    // a
+              break;
+
+            case 2:
+              t[0] = s[0];   // r
+              t[1] = s[0];   // g
+              t[2] = s[0];   // b
+              t[3] = s[1];   // a
+              break;
+
+            case 3:
+              t[0] = s[2];   // r
+              t[1] = s[1];   // g
+              t[2] = s[0];   // b
+              t[3] = 255;    // a
+              break;
+
+            case 4:
+              t[0] = s[2];   // r
+              t[1] = s[1];   // g
+              t[2] = s[0];   // b
+              t[3] = s[3];   // a
+              break;
             }
-            t += 4;
+            mask |= (1 << i);
           }
-          squish::CompressMasked(tb, mask, d, squish_flags);
-          d += cell_size;
-          Thread::consider_yield();
+          t += 4;
         }
+        squish::CompressMasked(tb, mask, d, squish_flags);
+        d += cell_size;
+        Thread::consider_yield();
       }
     }
-    compressed_ram_images.push_back(compressed_image);
-  }
+  });
   cdata->_ram_images.swap(compressed_ram_images);
   cdata->_ram_image_compression = compression;
   return true;
@@ -10670,7 +10838,7 @@ do_fillin_rawdata(CData *cdata, DatagramIterator &scan, BamReader *manager) {
     }
 
     PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
-    scan.extract_bytes(image.p(), u_size);
+    manager->extract_payload(scan, image.p(), u_size);
 
     cdata->_ram_images[n]._image = image;
   }
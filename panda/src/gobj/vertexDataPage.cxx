@@ -13,6 +13,7 @@
 
 #include "vertexDataPage.h"
 #include "configVariableInt.h"
+#include "configVariableEnum.h"
 #include "vertexDataSaveFile.h"
 #include "vertexDataBook.h"
 #include "vertexDataBlock.h"
@@ -47,6 +48,13 @@ ConfigVariableInt vertex_data_compression_level
           "vertex data.  The number should be in the range 1 to 9, where "
           "larger values are slower but give better compression."));
 
+ConfigVariableEnum<CompressionCodec::Codec> vertex_data_compression_codec
+("vertex-data-compression-codec", CompressionCodec::C_zlib,
+ PRC_DESC("Specifies the codec to use when compressing vertex data in "
+          "system RAM: zlib, lz4 or zstd.  lz4 decompresses much faster "
+          "than zlib, at the cost of a somewhat larger result.  If the "
+          "codec is not available in this build of Panda, zlib is used."));
+
 ConfigVariableInt max_disk_vertex_data
 ("max-disk-vertex-data", -1,
  PRC_DESC("Specifies the maximum number of bytes of vertex data "
@@ -114,6 +122,7 @@ VertexDataPage(size_t book_size) :
   _page_data = nullptr;
   _size = 0;
   _uncompressed_size = 0;
+  _codec = CompressionCodec::C_zlib;
   _ram_class = RC_resident;
   _pending_ram_class = RC_resident;
 }
@@ -134,6 +143,7 @@ VertexDataPage(VertexDataBook *book, size_t page_size, size_t block_size) :
   _size = page_size;
 
   _uncompressed_size = _size;
+  _codec = CompressionCodec::C_zlib;
   _pending_ram_class = RC_resident;
   set_ram_class(RC_resident);
 }
@@ -348,6 +358,14 @@ make_resident() {
   }
 
   if (_ram_class == RC_compressed) {
+    if (_codec != CompressionCodec::C_zlib) {
+      PStatTimer timer(_vdata_decompress_pcollector);
+      do_decompress_with_codec();
+      set_lru_size(_size);
+      set_ram_class(RC_resident);
+      return;
+    }
+
 #ifdef HAVE_ZLIB
     PStatTimer timer(_vdata_decompress_pcollector);
 
@@ -445,6 +463,18 @@ make_compressed() {
   if (_ram_class == RC_resident) {
     nassertv(_size == _uncompressed_size);
 
+    CompressionCodec::Codec codec = vertex_data_compression_codec;
+    if (codec != CompressionCodec::C_zlib &&
+        CompressionCodec::is_available(codec)) {
+      PStatTimer timer(_vdata_compress_pcollector);
+      if (do_compress_with_codec(codec)) {
+        set_lru_size(_size);
+        set_ram_class(RC_compressed);
+        return;
+      }
+    }
+    _codec = CompressionCodec::C_zlib;
+
 #ifdef HAVE_ZLIB
     PStatTimer timer(_vdata_compress_pcollector);
 
@@ -657,6 +687,81 @@ do_restore_from_disk() {
   }
 }
 
+/**
+ * Compresses the resident page data in one pass with the indicated codec,
+ * which should not be zlib.  Returns true on success, or false if the data
+ * could not be compressed, in which case the page is left unchanged.
+ *
+ * Assumes the lock is already held.
+ */
+bool VertexDataPage::
+do_compress_with_codec(CompressionCodec::Codec codec) {
+  size_t bound = CompressionCodec::get_max_compressed_size(codec, _uncompressed_size);
+  if (bound == 0) {
+    return false;
+  }
+
+  unsigned char *buffer = (unsigned char *)PANDA_MALLOC_ARRAY(bound);
+  size_t output_size =
+    CompressionCodec::compress(codec, buffer, bound, _page_data, _uncompressed_size,
+                               vertex_data_compression_level);
+  if (output_size == 0) {
+    PANDA_FREE_ARRAY(buffer);
+    return false;
+  }
+  Thread::consider_yield();
+
+  size_t new_allocated_size = round_up(output_size);
+  unsigned char *new_data = alloc_page_data(new_allocated_size);
+  memcpy(new_data, buffer, output_size);
+  PANDA_FREE_ARRAY(buffer);
+
+  free_page_data(_page_data, _allocated_size);
+  _page_data = new_data;
+  _size = output_size;
+  _allocated_size = new_allocated_size;
+  _codec = codec;
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Compressed " << *this << " with " << codec << " from "
+      << _uncompressed_size << " to " << _size << "\n";
+  }
+  return true;
+}
+
+/**
+ * Expands the page data that was compressed by do_compress_with_codec().
+ *
+ * Assumes the lock is already held.
+ */
+void VertexDataPage::
+do_decompress_with_codec() {
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Expanding page from " << _size
+      << " to " << _uncompressed_size << " with " << _codec << "\n";
+  }
+  size_t new_allocated_size = round_up(_uncompressed_size);
+  unsigned char *new_data = alloc_page_data(new_allocated_size);
+
+  bool success =
+    CompressionCodec::decompress(_codec, new_data, _uncompressed_size,
+                                 _page_data, _size);
+  Thread::consider_yield();
+  if (!success) {
+    free_page_data(new_data, new_allocated_size);
+    nassert_raise("decompression error");
+    return;
+  }
+
+  free_page_data(_page_data, _allocated_size);
+  _page_data = new_data;
+  _size = _uncompressed_size;
+  _allocated_size = new_allocated_size;
+  _codec = CompressionCodec::C_zlib;
+}
+
 /**
  * Called when the "book size"--the size of the page as recorded in its book's
  * table--has changed for some reason.  Assumes the lock is held.
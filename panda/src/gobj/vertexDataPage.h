@@ -24,6 +24,7 @@
 #include "thread.h"
 #include "mutexHolder.h"
 #include "pdeque.h"
+#include "compressionCodec.h"
 
 class VertexDataBook;
 class VertexDataBlock;
@@ -97,6 +98,8 @@ private:
 
   bool do_save_to_disk();
   void do_restore_from_disk();
+  bool do_compress_with_codec(CompressionCodec::Codec codec);
+  void do_decompress_with_codec();
 
   void adjust_book_size();
 
@@ -157,6 +160,7 @@ private:
 
   unsigned char *_page_data;
   size_t _size, _allocated_size, _uncompressed_size;
+  CompressionCodec::Codec _codec;  // Valid while RC_compressed or RC_disk.
   RamClass _ram_class;
   PT(VertexDataSaveBlock) _saved_block;
   size_t _book_size;
@@ -22,6 +22,8 @@
 #include "sceneGraphReducer.h"
 #include "omniBoundingVolume.h"
 #include "cullTraverserData.h"
+#include "lightMutexHolder.h"
+#include "pset.h"
 
 TypeHandle RigidBodyCombiner::_type_handle;
 
@@ -30,7 +32,11 @@ TypeHandle RigidBodyCombiner::_type_handle;
  *
  */
 RigidBodyCombiner::
-RigidBodyCombiner(const std::string &name) : PandaNode(name) {
+RigidBodyCombiner(const std::string &name) :
+  PandaNode(name),
+  _num_vertices(0),
+  _num_removed_vertices(0)
+{
   set_cull_callback();
 
   _internal_root = new PandaNode(name);
@@ -47,9 +53,15 @@ RigidBodyCombiner(const std::string &name) : PandaNode(name) {
  *
  */
 RigidBodyCombiner::
-RigidBodyCombiner(const RigidBodyCombiner &copy) : PandaNode(copy) {
+RigidBodyCombiner(const RigidBodyCombiner &copy) :
+  PandaNode(copy),
+  _bodies(copy._bodies),
+  _num_vertices(copy._num_vertices),
+  _num_removed_vertices(copy._num_removed_vertices)
+{
   set_cull_callback();
 
+  LightMutexHolder holder(copy._internal_lock);
   _internal_root = copy._internal_root;
   _internal_transforms = copy._internal_transforms;
 }
@@ -77,28 +89,148 @@ make_copy() const {
  *
  * This call must be made after adding any nodes to or removing any nodes from
  * the subgraph rooted at this node.  It should not be made too often, as it
- * is a relatively expensive call.  If you need to hide children of this node,
- * consider scaling them to zero (or very near zero), or moving them behind
- * the camera, instead.
+ * is a relatively expensive call.  If you have only added or removed direct
+ * children of this node, consider calling collect_changes() instead.  If you
+ * need to hide children of this node, consider scaling them to zero (or very
+ * near zero), or moving them behind the camera, instead.
  */
 void RigidBodyCombiner::
 collect() {
-  _internal_root = new GeomNode(get_name());
-  _internal_transforms.clear();
-  _vd_table.clear();
+  PT(GeomNode) root = new GeomNode(get_name());
+  Transforms transforms;
+  _bodies.clear();
+  _num_vertices = 0;
+  _num_removed_vertices = 0;
 
   Children cr = get_children();
   int num_children = cr.get_num_children();
   for (int i = 0; i < num_children; i++) {
-    r_collect(cr.get_child(i), RenderState::make_empty(), nullptr);
+    collect_body(cr.get_child(i), root, transforms);
   }
 
-  _vd_table.clear();
+  reduce_internal_scene(root);
 
-  SceneGraphReducer gr;
-  gr.apply_attribs(_internal_root);
-  gr.collect_vertex_data(_internal_root, ~(SceneGraphReducer::CVD_format | SceneGraphReducer::CVD_name | SceneGraphReducer::CVD_animation_type));
-  gr.unify(_internal_root, false);
+  LightMutexHolder holder(_internal_lock);
+  _internal_root = root;
+  _internal_transforms.swap(transforms);
+}
+
+/**
+ * Updates the internal scene to reflect the children that have been added to
+ * or removed from this node since the last call to collect() or
+ * collect_changes(), without rebuilding it from scratch.
+ *
+ * The Geoms of the newly added children are combined with each other, but not
+ * with those that were already collected, so each call may add a few more
+ * Geoms to the internal scene.  The vertices of removed children are not
+ * taken out of the combined Geoms; instead, their transforms are set to the
+ * zero matrix, which makes their triangles degenerate.  It is therefore a
+ * good idea to call collect() again once in a while if the set of children
+ * changes a lot; this is done automatically if most of the collected vertices
+ * belong to removed children.
+ *
+ * A removed child that had static geometry (that is, geometry that was not
+ * below a moving node) has no transform of its own to zero out, in which case
+ * this also falls back to a full collect().
+ *
+ * Changes made below the existing children are not noticed; you must call
+ * collect() for those.
+ */
+void RigidBodyCombiner::
+collect_changes() {
+  if (!_internal_root->is_geom_node()) {
+    // We've never been collected.
+    collect();
+    return;
+  }
+
+  pset<PandaNode *> children;
+  Children cr = get_children();
+  int num_children = cr.get_num_children();
+  for (int i = 0; i < num_children; i++) {
+    children.insert(cr.get_child(i));
+  }
+
+  // Sort the bodies we have already collected into those that are still
+  // there, and those that have gone away.
+  pset<PandaNode *> collected;
+  Bodies kept, removed;
+  int num_removed_vertices = _num_removed_vertices;
+  Bodies::const_iterator bi;
+  for (bi = _bodies.begin(); bi != _bodies.end(); ++bi) {
+    const Body &body = (*bi);
+    if (children.find(body._node) != children.end()) {
+      kept.push_back(body);
+      collected.insert(body._node);
+
+    } else if (body._has_static_geometry) {
+      collect();
+      return;
+
+    } else {
+      removed.push_back(body);
+      num_removed_vertices += body._num_vertices;
+    }
+  }
+
+  if (num_removed_vertices * 2 > _num_vertices) {
+    // Most of our vertices would be wasted; it's time to start over.
+    collect();
+    return;
+  }
+
+  // Collect the new children into a new batch of Geoms of their own.
+  PT(GeomNode) segment = new GeomNode(get_name());
+  Transforms transforms;
+  _bodies.swap(kept);
+  for (int i = 0; i < num_children; i++) {
+    PandaNode *child = cr.get_child(i);
+    if (collected.find(child) == collected.end()) {
+      collect_body(child, segment, transforms);
+    }
+  }
+
+  PT(GeomNode) root;
+  if (segment->get_num_geoms() != 0) {
+    reduce_internal_scene(segment);
+    root = DCAST(GeomNode, _internal_root->make_copy());
+    root->add_geoms_from(segment);
+  }
+
+  LightMutexHolder holder(_internal_lock);
+
+  // The transforms of the removed bodies are set to the zero matrix, which
+  // takes all of their vertices (w included) to zero, so that they no longer
+  // produce any visible triangles.
+  for (bi = removed.begin(); bi != removed.end(); ++bi) {
+    for (size_t ti = (*bi)._begin_transform; ti < (*bi)._end_transform; ++ti) {
+      InternalTransform &itrans = _internal_transforms[ti];
+      itrans._node.clear();
+      itrans._last_state.clear();
+      itrans._matrix = LMatrix4::zeros_mat();
+      itrans._transform->set_matrix(itrans._matrix);
+    }
+  }
+  _num_removed_vertices = num_removed_vertices;
+
+  // The new transforms, and the bodies that refer to them, are appended
+  // after the existing ones.
+  size_t offset = _internal_transforms.size();
+  Transforms::iterator ti;
+  for (ti = transforms.begin(); ti != transforms.end(); ++ti) {
+    if ((*ti)._prev >= 0) {
+      (*ti)._prev += (int)offset;
+    }
+    _internal_transforms.push_back(*ti);
+  }
+  for (size_t i = kept.size(); i < _bodies.size(); ++i) {
+    _bodies[i]._begin_transform += offset;
+    _bodies[i]._end_transform += offset;
+  }
+
+  if (root != nullptr) {
+    _internal_root = root;
+  }
 }
 
 /**
@@ -111,6 +243,7 @@ collect() {
  */
 NodePath RigidBodyCombiner::
 get_internal_scene() {
+  LightMutexHolder holder(_internal_lock);
   return NodePath(_internal_root);
 }
 
@@ -134,62 +267,131 @@ get_internal_scene() {
  */
 bool RigidBodyCombiner::
 cull_callback(CullTraverser *trav, CullTraverserData &data) {
-  // Pretend that all of our transforms have been modified (since we don't
-  // really know which ones have).
-  Thread *current_thread = Thread::get_current_thread();
-  Transforms::iterator ti;
-  for (ti = _internal_transforms.begin();
-       ti != _internal_transforms.end();
-       ++ti) {
-    (*ti)->mark_modified(current_thread);
+  Thread *current_thread = trav->get_current_thread();
+  PT(PandaNode) internal_root;
+  {
+    LightMutexHolder holder(_internal_lock);
+
+    // Update the matrices of the nodes that have moved since last time, and
+    // of any moving nodes below them.  The transforms are stored in the order
+    // they were encountered, so a transform always follows its _prev.  The
+    // vertices that depend on the other transforms won't be recomputed.
+    Transforms::iterator ti;
+    for (ti = _internal_transforms.begin();
+         ti != _internal_transforms.end();
+         ++ti) {
+      InternalTransform &itrans = (*ti);
+      itrans._changed = false;
+      if (itrans._node == nullptr) {
+        // This body has been removed.
+        continue;
+      }
+
+      CPT(TransformState) state = itrans._node->get_transform(current_thread);
+      const InternalTransform *prev = nullptr;
+      if (itrans._prev >= 0) {
+        prev = &_internal_transforms[itrans._prev];
+      }
+      if (state != itrans._last_state || (prev != nullptr && prev->_changed)) {
+        LMatrix4 matrix = state->get_mat();
+        if (prev != nullptr) {
+          matrix *= prev->_matrix;
+        }
+        itrans._matrix = matrix;
+        itrans._transform->set_matrix(matrix);
+        itrans._last_state = std::move(state);
+        itrans._changed = true;
+      }
+    }
+
+    internal_root = _internal_root;
   }
 
   // Render the internal scene only--this is the optimized scene.
-  trav->traverse_down(data, _internal_root);
+  trav->traverse_down(data, internal_root);
 
   // Do not directly render the nodes beneath this node.
   return false;
 }
 
+/**
+ * Collects the indicated child of this node into the indicated GeomNode,
+ * appending any moving nodes to transforms, and records it as a new Body.
+ */
+void RigidBodyCombiner::
+collect_body(PandaNode *node, GeomNode *root, Transforms &transforms) {
+  Body body;
+  body._node = node;
+  body._begin_transform = transforms.size();
+  body._num_vertices = 0;
+  body._has_static_geometry = false;
+
+  r_collect(node, RenderState::make_empty(), -1, root, transforms, body);
+  _vd_table.clear();
+
+  body._end_transform = transforms.size();
+  _num_vertices += body._num_vertices;
+  _bodies.push_back(body);
+}
+
 /**
  * Recursively visits each child or descedant of this node, accumulating state
  * and transform as we go.  When GeomNodes are encountered, their Geoms are
- * extracted and added to the _internal_root node.
+ * extracted and added to the indicated root node.
  */
 void RigidBodyCombiner::
-r_collect(PandaNode *node, const RenderState *state,
-          const VertexTransform *transform) {
+r_collect(PandaNode *node, const RenderState *state, int prev,
+          GeomNode *root, Transforms &transforms, Body &body) {
   CPT(RenderState) next_state = state->compose(node->get_state());
-  CPT(VertexTransform) next_transform = transform;
-  if (!node->get_transform()->is_identity() ||
+  int next_prev = prev;
+  CPT(TransformState) node_transform = node->get_transform();
+  if (!node_transform->is_identity() ||
       (node->is_of_type(ModelNode::get_class_type()) &&
        DCAST(ModelNode, node)->get_preserve_transform() != ModelNode::PT_none)) {
     // This node has a transform we need to keep.
-    PT(NodeVertexTransform) new_transform = new NodeVertexTransform(node, transform);
-    _internal_transforms.push_back(new_transform);
-    next_transform = new_transform.p();
+    LMatrix4 matrix = node_transform->get_mat();
+    if (prev >= 0) {
+      matrix *= transforms[prev]._matrix;
+    }
 
+    InternalTransform itrans;
+    itrans._transform = new UserVertexTransform(node->get_name());
+    itrans._transform->set_matrix(matrix);
+    itrans._matrix = matrix;
+    itrans._node = node;
+    itrans._last_state = node_transform;
+    itrans._prev = prev;
+    itrans._changed = false;
+    next_prev = (int)transforms.size();
+    transforms.push_back(itrans);
   }
 
   if (node->is_geom_node()) {
     GeomNode *gnode = DCAST(GeomNode, node);
-    GeomNode *root_gnode = DCAST(GeomNode, _internal_root);
+    const VertexTransform *transform = nullptr;
+    if (next_prev >= 0) {
+      transform = transforms[next_prev]._transform;
+    }
 
     int num_geoms = gnode->get_num_geoms();
     for (int i = 0; i < num_geoms; ++i) {
       PT(Geom) geom = gnode->get_geom(i)->make_copy();
-      if (next_transform != nullptr) {
-        geom->set_vertex_data(convert_vd(next_transform, geom->get_vertex_data()));
+      if (transform != nullptr) {
+        CPT(GeomVertexData) vdata = geom->get_vertex_data();
+        body._num_vertices += vdata->get_num_rows();
+        geom->set_vertex_data(convert_vd(transform, vdata));
+      } else {
+        body._has_static_geometry = true;
       }
       CPT(RenderState) gstate = next_state->compose(gnode->get_geom_state(i));
-      root_gnode->add_geom(geom, gstate);
+      root->add_geom(geom, gstate);
     }
   }
 
   Children cr = node->get_children();
   int num_children = cr.get_num_children();
   for (int i = 0; i < num_children; i++) {
-    r_collect(cr.get_child(i), next_state, next_transform);
+    r_collect(cr.get_child(i), next_state, next_prev, root, transforms, body);
   }
 }
 
@@ -241,3 +443,15 @@ convert_vd(const VertexTransform *transform, const GeomVertexData *orig) {
 
   return new_data;
 }
+
+/**
+ * Combines the Geoms that were collected into the indicated node into as few
+ * Geoms as possible.
+ */
+void RigidBodyCombiner::
+reduce_internal_scene(GeomNode *root) {
+  SceneGraphReducer gr;
+  gr.apply_attribs(root);
+  gr.collect_vertex_data(root, ~(SceneGraphReducer::CVD_format | SceneGraphReducer::CVD_name | SceneGraphReducer::CVD_animation_type));
+  gr.unify(root, false);
+}
@@ -17,7 +17,10 @@
 #include "pandabase.h"
 
 #include "pandaNode.h"
-#include "nodeVertexTransform.h"
+#include "geomNode.h"
+#include "userVertexTransform.h"
+#include "transformState.h"
+#include "lightMutex.h"
 #include "pvector.h"
 
 class NodePath;
@@ -34,10 +37,13 @@ class NodePath;
  * and later transforms applied to them will not be identified.
  *
  * You should call collect() only at startup or if you change the set of
- * children; it is a relatively expensive call.
+ * children; it is a relatively expensive call.  If you only add or remove
+ * children of this node, you may call collect_changes() instead, which
+ * processes just the children that have changed.
  *
  * Once you call collect(), you may change the transforms on the child nodes
- * freely without having to call collect() again.
+ * freely without having to call collect() again.  Only the vertices of nodes
+ * whose transforms have actually changed are recomputed each frame.
  *
  * RenderEffects such as Billboards are not supported below this node.
  */
@@ -50,6 +56,7 @@ protected:
 
 PUBLISHED:
   void collect();
+  void collect_changes();
 
   NodePath get_internal_scene();
   MAKE_PROPERTY(internal_scene, get_internal_scene);
@@ -59,15 +66,46 @@ public:
   virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data);
 
 private:
-  void r_collect(PandaNode *node, const RenderState *state,
-                 const VertexTransform *transform);
+  // One of these is recorded for each moving node found by collect().  The
+  // matrix of _transform is recomputed only when the node's transform, or
+  // the matrix of the _prev transform above it, has changed.
+  class InternalTransform {
+  public:
+    LMatrix4 _matrix;
+    PT(UserVertexTransform) _transform;
+    PT(PandaNode) _node;
+    CPT(TransformState) _last_state;
+    int _prev;
+    bool _changed;
+  };
+  typedef pvector<InternalTransform> Transforms;
+
+  // One of these is recorded for each child of this node that has been
+  // collected, along with the range of _internal_transforms created for it.
+  class Body {
+  public:
+    PT(PandaNode) _node;
+    size_t _begin_transform;
+    size_t _end_transform;
+    int _num_vertices;
+    bool _has_static_geometry;
+  };
+  typedef pvector<Body> Bodies;
+
+  void collect_body(PandaNode *node, GeomNode *root, Transforms &transforms);
+  void r_collect(PandaNode *node, const RenderState *state, int prev,
+                 GeomNode *root, Transforms &transforms, Body &body);
   PT(GeomVertexData) convert_vd(const VertexTransform *transform,
                                 const GeomVertexData *orig);
+  static void reduce_internal_scene(GeomNode *root);
 
   PT(PandaNode) _internal_root;
-
-  typedef pvector< PT(NodeVertexTransform) > Transforms;
   Transforms _internal_transforms;
+  LightMutex _internal_lock;
+
+  Bodies _bodies;
+  int _num_vertices;
+  int _num_removed_vertices;
 
   class VDUnifier {
   public:
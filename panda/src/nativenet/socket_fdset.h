@@ -30,6 +30,7 @@ private:
   inline bool isSetForNative(const SOCKET inid) const;
 
   friend struct Socket_Selector;
+  friend class ConnectionReader;
 
   SOCKET _maxid;
 
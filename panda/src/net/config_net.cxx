@@ -146,6 +146,39 @@ ConfigVariableEnum<ThreadPriority> net_thread_priority
  PRC_DESC("The default thread priority when creating threaded readers "
           "or writers."));
 
+ConfigVariableBool net_use_epoll
+("net-use-epoll", false,
+ PRC_DESC("Set this true to have ConnectionReaders and ConnectionListeners "
+          "wait for activity with epoll() instead of select(), on platforms "
+          "that support it.  This scales much better to a large number of "
+          "connections, and is not limited by FD_SETSIZE.  Each reader "
+          "thread gets its own epoll instance, and reads only the sockets "
+          "that were assigned to it.  This is consulted when the reader is "
+          "constructed."));
+
+ConfigVariableInt net_max_batch_size
+("net-max-batch-size", 32,
+ PRC_DESC("The maximum number of UDP datagrams that are read from or written "
+          "to a socket with a single system call, on platforms that support "
+          "recvmmsg() and sendmmsg().  This also limits the number of "
+          "datagrams a ConnectionWriter thread pulls off its queue at once. "
+          "Set this to 1 to read and write one datagram at a time."));
+
+ConfigVariableInt net_datagram_pool_size
+("net-datagram-pool-size", 256,
+ PRC_DESC("The number of receive buffers each ConnectionReader keeps around "
+          "for reuse.  Each incoming datagram is stored in one of these "
+          "buffers, which is then handed to the application without "
+          "copying; a buffer becomes available again once the application "
+          "has released every datagram that refers to it.  Set this to 0 "
+          "to allocate a fresh buffer for every datagram."));
+
+ConfigVariableInt net_datagram_pool_max_buffer
+("net-datagram-pool-max-buffer", 65536,
+ PRC_DESC("Receive buffers larger than this many bytes are not returned to "
+          "the ConnectionReader's buffer pool, so that an occasional very "
+          "large TCP datagram doesn't pin down memory indefinitely."));
+
 
 /**
  * Initializes the library.  This must be called at least once before any of
@@ -37,6 +37,10 @@ extern ConfigVariableInt net_max_read_per_epoch;
 extern ConfigVariableInt net_max_write_per_epoch;
 
 extern ConfigVariableEnum<ThreadPriority> net_thread_priority;
+extern ConfigVariableBool net_use_epoll;
+extern ConfigVariableInt net_max_batch_size;
+extern ConfigVariableInt net_datagram_pool_size;
+extern ConfigVariableInt net_datagram_pool_max_buffer;
 
 extern EXPCL_PANDA_NET void init_libnet();
 
@@ -26,6 +26,49 @@
 #include "socket_udp.h"
 #include "dcast.h"
 
+#ifdef NET_USE_SENDMSG
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+
+/**
+ * Writes the indicated buffers to a stream socket, calling sendmsg() again
+ * after a partial write until everything has gone out.  Returns true on
+ * success, false on error.  The iovec array is modified.
+ */
+static bool
+write_iovecs(SOCKET fd, struct iovec *iov, int iovcnt) {
+  while (iovcnt > 0) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = std::min(iovcnt, IOV_MAX);
+
+    ssize_t bytes_sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (bytes_sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    // Skip past the buffers that were written completely.
+    while (iovcnt > 0 && (size_t)bytes_sent >= iov->iov_len) {
+      bytes_sent -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (bytes_sent > 0) {
+      iov->iov_base = (char *)iov->iov_base + bytes_sent;
+      iov->iov_len -= bytes_sent;
+    }
+  }
+  return true;
+}
+#endif  // NET_USE_SENDMSG
+
 
 /**
  * Creates a connection.  Normally this constructor should not be used
@@ -298,6 +341,9 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
 
   if (_socket->is_exact_type(Socket_UDP::get_class_type())) {
     // We have to send UDP right away.
+#ifdef NET_USE_SENDMSG
+    return send_udp_batch(&datagram, 1, false);
+#else
     Socket_UDP *udp;
     DCAST_INTO_R(udp, _socket, false);
 
@@ -333,6 +379,7 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
     }
 
     return check_send_error(okflag);
+#endif  // NET_USE_SENDMSG
   }
 
   // We might queue up TCP packets for later sending.
@@ -344,6 +391,14 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
     return false;
   }
 
+#ifdef NET_USE_SENDMSG
+  if (!_collect_tcp) {
+    // Since we aren't collecting, there's no need to copy the datagram into
+    // _queued_data first; write the header and the payload directly.
+    return send_tcp_batch(&datagram, 1, tcp_header_size);
+  }
+#endif
+
   DatagramTCPHeader header(datagram, tcp_header_size);
 
   LightReMutexHolder holder(_write_mutex);
@@ -379,24 +434,25 @@ send_raw_datagram(const NetDatagram &datagram) {
     Socket_UDP *udp;
     DCAST_INTO_R(udp, _socket, false);
 
-    CPTA_uchar msg = datagram.get_array();
-    vector_uchar data;
-    data.insert(data.end(), msg.begin(), msg.end());
+    // There's no header to prepend, so we can send straight out of the
+    // datagram's own buffer.
+    const char *data = (const char *)datagram.get_data();
+    int data_size = (int)datagram.get_length();
 
     LightReMutexHolder holder(_write_mutex);
-    Socket_Address addr = datagram.get_address().get_addr();
-    bool okflag = udp->SendTo(data, addr);
+    const Socket_Address &addr = datagram.get_address().get_addr();
+    bool okflag = udp->SendTo(data, data_size, addr);
 #if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
     while (!okflag && udp->GetLastError() == LOCAL_BLOCKING_ERROR && udp->Active()) {
       Thread::force_yield();
-      okflag = udp->SendTo(data, addr);
+      okflag = udp->SendTo(data, data_size, addr);
     }
 #endif  // SIMPLE_THREADS
 
     if (net_cat.is_spam()) {
       net_cat.spam()
         << "Sent UDP datagram with "
-        << data.size() << " bytes to " << (void *)this
+        << data_size << " bytes to " << (void *)this
         << ", ok = " << okflag << "\n";
     }
 
@@ -404,6 +460,12 @@ send_raw_datagram(const NetDatagram &datagram) {
   }
 
   // We might queue up TCP packets for later sending.
+#ifdef NET_USE_SENDMSG
+  if (!_collect_tcp) {
+    return send_tcp_batch(&datagram, 1, 0);
+  }
+#endif
+
   LightReMutexHolder holder(_write_mutex);
   CPTA_uchar msg = datagram.get_array();
   _queued_data.insert(_queued_data.end(), msg.begin(), msg.end());
@@ -417,6 +479,199 @@ send_raw_datagram(const NetDatagram &datagram) {
   return true;
 }
 
+/**
+ * This method is intended only to be called by ConnectionWriter.  It writes
+ * the given datagrams, which must all be destined for this connection, to the
+ * socket, as with send_datagram() or send_raw_datagram() according to
+ * raw_mode.  Where the platform allows it, this uses as few system calls as
+ * possible.  Returns true if all of the datagrams were sent successfully.
+ */
+bool Connection::
+send_datagrams(const NetDatagram *datagrams, size_t num_datagrams,
+               int tcp_header_size, bool raw_mode) {
+  nassertr(_socket != nullptr, false);
+
+#ifdef NET_USE_SENDMSG
+  if (_socket->is_exact_type(Socket_UDP::get_class_type())) {
+    return send_udp_batch(datagrams, num_datagrams, raw_mode);
+  }
+  if (!_collect_tcp) {
+    return send_tcp_batch(datagrams, num_datagrams,
+                          raw_mode ? 0 : tcp_header_size);
+  }
+#endif  // NET_USE_SENDMSG
+
+  bool okflag = true;
+  for (size_t i = 0; i < num_datagrams; ++i) {
+    if (raw_mode) {
+      okflag = send_raw_datagram(datagrams[i]) && okflag;
+    } else {
+      okflag = send_datagram(datagrams[i], tcp_header_size) && okflag;
+    }
+  }
+  return okflag;
+}
+
+#ifdef NET_USE_SENDMSG
+/**
+ * Sends the indicated datagrams on this UDP socket with sendmmsg(), up to
+ * max_batch at a time.  Each datagram is sent to its own address, and unless
+ * raw_mode is true, is preceded by its DatagramUDPHeader, which is passed as
+ * a separate buffer so that the payload is never copied.
+ */
+bool Connection::
+send_udp_batch(const NetDatagram *datagrams, size_t num_datagrams,
+               bool raw_mode) {
+  static const size_t max_batch = 64;
+
+  Socket_UDP *udp;
+  DCAST_INTO_R(udp, _socket, false);
+  SOCKET fd = udp->GetSocket();
+
+  struct mmsghdr msgs[max_batch];
+  struct iovec iov[max_batch][2];
+  unsigned char headers[max_batch][datagram_udp_header_size];
+  size_t lengths[max_batch];
+
+  LightReMutexHolder holder(_write_mutex);
+
+  bool okflag = true;
+  size_t bi = 0;
+  while (bi < num_datagrams && okflag) {
+    size_t count = std::min(num_datagrams - bi, max_batch);
+
+    for (size_t i = 0; i < count; ++i) {
+      const NetDatagram &datagram = datagrams[bi + i];
+      int iovcnt = 0;
+      if (!raw_mode) {
+        DatagramUDPHeader header(datagram);
+        if (net_cat.is_debug()) {
+          header.verify_datagram(datagram);
+        }
+        memcpy(headers[i], header.get_array().p(), datagram_udp_header_size);
+        iov[i][iovcnt].iov_base = headers[i];
+        iov[i][iovcnt].iov_len = datagram_udp_header_size;
+        ++iovcnt;
+      }
+      iov[i][iovcnt].iov_base = (void *)datagram.get_data();
+      iov[i][iovcnt].iov_len = datagram.get_length();
+      ++iovcnt;
+      lengths[i] = (raw_mode ? 0 : datagram_udp_header_size) + datagram.get_length();
+
+      // The address is owned by the datagram, which outlives the call.
+      sockaddr *addr = (sockaddr *)&datagram.get_address().get_addr().GetAddressInfo();
+      memset(&msgs[i], 0, sizeof(msgs[i]));
+      msgs[i].msg_hdr.msg_name = addr;
+      msgs[i].msg_hdr.msg_namelen = SA_SIZEOF(addr);
+      msgs[i].msg_hdr.msg_iov = iov[i];
+      msgs[i].msg_hdr.msg_iovlen = iovcnt;
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+      int result = sendmmsg(fd, msgs + sent, count - sent, MSG_NOSIGNAL);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        okflag = false;
+        break;
+      }
+      for (int i = 0; i < result; ++i) {
+        if (msgs[sent + i].msg_len != lengths[sent + i]) {
+          okflag = false;
+        }
+      }
+      sent += result;
+    }
+
+    if (net_cat.is_spam()) {
+      net_cat.spam()
+        << "Sent " << sent << " UDP datagram(s) to " << (void *)this
+        << ", ok = " << okflag << "\n";
+    }
+    bi += count;
+  }
+
+  return check_send_error(okflag);
+}
+
+/**
+ * Writes the indicated datagrams on this TCP socket, each one preceded by a
+ * DatagramTCPHeader of the indicated size (which may be 0 for raw mode).  The
+ * headers and payloads are passed to sendmsg() as a scatter-gather list, so
+ * several datagrams go out in one call without being copied together first.
+ */
+bool Connection::
+send_tcp_batch(const NetDatagram *datagrams, size_t num_datagrams,
+               int header_size) {
+  static const size_t max_batch = 64;
+
+  Socket_TCP *tcp;
+  DCAST_INTO_R(tcp, _socket, false);
+  SOCKET fd = tcp->GetSocket();
+
+  struct iovec iov[max_batch * 2];
+  unsigned char headers[max_batch][4];
+  nassertr(header_size >= 0 && header_size <= 4, false);
+
+  LightReMutexHolder holder(_write_mutex);
+
+  // If anything is still waiting in _queued_data, it has to go out first.
+  if (!_queued_data.empty() && !do_flush()) {
+    return false;
+  }
+
+  bool okflag = true;
+  bool all_valid = true;
+  size_t total_bytes = 0;
+  size_t bi = 0;
+  while (bi < num_datagrams && okflag) {
+    size_t count = std::min(num_datagrams - bi, max_batch);
+
+    int iovcnt = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const NetDatagram &datagram = datagrams[bi + i];
+      if (header_size != 0) {
+        if (header_size == 2 && datagram.get_length() >= 0x10000) {
+          net_cat.error()
+            << "Attempt to send TCP datagram of " << datagram.get_length()
+            << " bytes--too long!\n";
+          nassert_raise("Datagram too long");
+          all_valid = false;
+          continue;
+        }
+
+        DatagramTCPHeader header(datagram, header_size);
+        if (net_cat.is_debug()) {
+          header.verify_datagram(datagram, header_size);
+        }
+        memcpy(headers[i], header.get_array().p(), header_size);
+        iov[iovcnt].iov_base = headers[i];
+        iov[iovcnt].iov_len = header_size;
+        ++iovcnt;
+      }
+      iov[iovcnt].iov_base = (void *)datagram.get_data();
+      iov[iovcnt].iov_len = datagram.get_length();
+      ++iovcnt;
+      total_bytes += header_size + datagram.get_length();
+    }
+
+    okflag = write_iovecs(fd, iov, iovcnt);
+    bi += count;
+  }
+
+  if (net_cat.is_spam()) {
+    net_cat.spam()
+      << "Sent " << num_datagrams << " TCP datagram(s) with "
+      << total_bytes << " total bytes to " << (void *)this
+      << ", ok = " << okflag << "\n";
+  }
+
+  return check_send_error(okflag) && all_valid;
+}
+#endif  // NET_USE_SENDMSG
+
 /**
  * The private implementation of flush(), this assumes the _write_mutex is
  * already held.
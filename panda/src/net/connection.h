@@ -24,6 +24,14 @@ class Socket_IP;
 class ConnectionManager;
 class NetDatagram;
 
+// On Linux, datagrams are written with sendmsg() and sendmmsg(), which take
+// the header and the payload as separate buffers and can send a batch of UDP
+// datagrams in one call.  SIMPLE_THREADS still needs the nonblocking,
+// piecewise writes of the portable path.
+#if defined(IS_LINUX) && !defined(SIMPLE_THREADS)
+#define NET_USE_SENDMSG 1
+#endif
+
 /**
  * Represents a single TCP or UDP socket for input or output.
  */
@@ -59,6 +67,14 @@ PUBLISHED:
 private:
   bool send_datagram(const NetDatagram &datagram, int tcp_header_size);
   bool send_raw_datagram(const NetDatagram &datagram);
+  bool send_datagrams(const NetDatagram *datagrams, size_t num_datagrams,
+                      int tcp_header_size, bool raw_mode);
+#ifdef NET_USE_SENDMSG
+  bool send_udp_batch(const NetDatagram *datagrams, size_t num_datagrams,
+                      bool raw_mode);
+  bool send_tcp_batch(const NetDatagram *datagrams, size_t num_datagrams,
+                      int header_size);
+#endif
   bool do_flush();
   bool check_send_error(bool okflag);
 
@@ -394,6 +394,7 @@ wait_for_readers(double timeout) {
     Socket_fdset fdset;
     fdset.clear();
     bool any_threaded = false;
+    bool any_ready = false;
 
     {
       LightMutexHolder holder(_set_mutex);
@@ -404,7 +405,9 @@ wait_for_readers(double timeout) {
         if (reader->is_polling()) {
           // If it's a polling reader, we can wait for its socket.  (If it's a
           // threaded reader, we can't do anything here.)
-          reader->accumulate_fdset(fdset);
+          if (reader->accumulate_fdset(fdset)) {
+            any_ready = true;
+          }
         } else {
           any_threaded = true;
           stop = now;
@@ -418,6 +421,11 @@ wait_for_readers(double timeout) {
       wait_timeout = std::min(wait_timeout, stop - now);
     }
 
+    if (any_ready) {
+      // One of the readers already knows it has data waiting.
+      return true;
+    }
+
     uint32_t wait_timeout_ms = (uint32_t)(wait_timeout * 1000.0);
     if (any_threaded) {
       // If there are any threaded ConnectionReaders, we can't block at all.
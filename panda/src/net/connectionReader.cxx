@@ -26,11 +26,196 @@
 #include "pnotify.h"
 #include "atomicAdjust.h"
 #include "config_downloader.h"
+#include "pset.h"
+
+#ifdef IS_LINUX
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#endif
 
 using std::min;
 
 static const int read_buffer_size = maximum_udp_datagram + datagram_udp_header_size;
 
+#ifdef IS_LINUX
+static const int epoll_max_events = 256;
+
+/**
+ * The per-thread state used by a ConnectionReader that waits with epoll.
+ */
+class ConnectionReader::EpollState {
+public:
+  EpollState();
+  ~EpollState();
+
+  void push_ready(uint64_t id);
+  uint64_t pop_ready();
+  bool has_ready() const;
+
+  int _fd;
+
+  // The sockets that were reported by epoll, or that still had data after we
+  // last read from them, and are waiting to be checked.  Since we use edge-
+  // triggered notification, we won't hear about these again until more data
+  // arrives.  A socket may be reported again while it is still queued, so
+  // _queued records which ones are in _ready, to keep each in there once.
+  pdeque<uint64_t> _ready;
+  pset<uint64_t> _queued;
+
+  // The number of sockets in _ready.  Only the thread that owns this state
+  // touches _ready, but this may be read from other threads, by has_ready().
+  AtomicAdjust::Integer _num_ready;
+
+  struct epoll_event _events[epoll_max_events];
+};
+
+/**
+ *
+ */
+ConnectionReader::EpollState::
+EpollState() : _num_ready(0) {
+  _fd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+/**
+ *
+ */
+ConnectionReader::EpollState::
+~EpollState() {
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+/**
+ * Queues the indicated socket to be checked, unless it is already queued.
+ */
+void ConnectionReader::EpollState::
+push_ready(uint64_t id) {
+  if (_queued.insert(id).second) {
+    _ready.push_back(id);
+    AtomicAdjust::inc(_num_ready);
+  }
+}
+
+/**
+ * Removes and returns the socket at the front of the queue, which must not
+ * be empty.
+ */
+uint64_t ConnectionReader::EpollState::
+pop_ready() {
+  uint64_t id = _ready.front();
+  _ready.pop_front();
+  _queued.erase(id);
+  AtomicAdjust::dec(_num_ready);
+  return id;
+}
+
+/**
+ * Returns true if any sockets are queued to be checked.  Unlike _ready
+ * itself, this may safely be called from any thread.
+ */
+bool ConnectionReader::EpollState::
+has_ready() const {
+  return AtomicAdjust::get(_num_ready) != 0;
+}
+
+/**
+ * Returns true if there is anything to be read from the indicated socket
+ * right now, including an end-of-file or an error condition, or an incoming
+ * connection on a rendezvous socket.
+ */
+static bool
+is_socket_readable(SOCKET fd) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  return ::poll(&pfd, 1, 0) > 0;
+}
+#endif  // IS_LINUX
+
+/**
+ * A simple pool of receive buffers.  The buffers are handed out as PTA_uchar
+ * references, and a buffer is considered free again as soon as the pool holds
+ * the only reference to it, i.e. once every NetDatagram that was built on it
+ * has been destructed or has moved on to another array.
+ */
+class ConnectionReader::BufferPool {
+public:
+  BufferPool(size_t max_buffers, size_t max_buffer_size);
+
+  void acquire(PTA_uchar *buffers, size_t num_buffers, size_t size);
+
+private:
+  LightMutex _lock;
+  pvector<PTA_uchar> _buffers;
+  size_t _next;
+  size_t _max_buffers;
+  size_t _max_buffer_size;
+};
+
+/**
+ *
+ */
+ConnectionReader::BufferPool::
+BufferPool(size_t max_buffers, size_t max_buffer_size) :
+  _next(0),
+  _max_buffers(max_buffers),
+  _max_buffer_size(max_buffer_size)
+{
+}
+
+/**
+ * Fills in the indicated number of buffers, each with room reserved for the
+ * indicated number of bytes.  The contents of the buffers are undefined; the
+ * caller should resize or assign them.  Free buffers from the pool are reused
+ * where they can be found quickly; otherwise new ones are allocated, and
+ * remembered by the pool in place of buffers that are still in use elsewhere.
+ */
+void ConnectionReader::BufferPool::
+acquire(PTA_uchar *buffers, size_t num_buffers, size_t size) {
+  // Don't look through the whole pool for a free buffer; if the ones just
+  // after the last one we handed out are all still in use, the application
+  // is holding on to its datagrams and we may as well allocate.
+  static const size_t max_probes = 4;
+
+  {
+    LightMutexHolder holder(_lock);
+    for (size_t bi = 0; bi < num_buffers; ++bi) {
+      size_t num_probes = std::min(max_probes, _buffers.size());
+      for (size_t pi = 0; pi < num_probes && buffers[bi] == nullptr; ++pi) {
+        PTA_uchar &buffer = _buffers[_next];
+        _next = (_next + 1) % _buffers.size();
+        if (buffer.get_ref_count() == 1) {
+          buffers[bi] = buffer;
+        }
+      }
+
+      if (buffers[bi] == nullptr) {
+        buffers[bi] = PTA_uchar::empty_array(0);
+        if (size <= _max_buffer_size && _max_buffers != 0) {
+          if (_buffers.size() < _max_buffers) {
+            _buffers.push_back(buffers[bi]);
+          } else {
+            _buffers[_next] = buffers[bi];
+            _next = (_next + 1) % _buffers.size();
+          }
+        }
+      }
+    }
+  }
+
+  // Now that these buffers are ours, they can be grown without the lock.
+  for (size_t bi = 0; bi < num_buffers; ++bi) {
+    buffers[bi].reserve(size);
+  }
+}
+
 /**
  *
  */
@@ -40,6 +225,8 @@ SocketInfo(const PT(Connection) &connection) :
 {
   _busy = false;
   _error = false;
+  _id = 0;
+  _epoll_index = -1;
 }
 
 /**
@@ -113,6 +300,34 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _currently_polling_thread = -1;
 
+  _use_epoll = false;
+  _next_socket_id = 1;
+  _next_epoll_index = 0;
+  _buffer_pool = new BufferPool(std::max((int)net_datagram_pool_size, 0),
+                                std::max((int)net_datagram_pool_max_buffer, 0));
+#ifdef IS_LINUX
+  if (net_use_epoll) {
+    // A polling reader still needs one epoll instance of its own.
+    int num_states = std::max(num_threads, 1);
+    _use_epoll = true;
+    for (int si = 0; si < num_states; ++si) {
+      EpollState *state = new EpollState;
+      _epoll_states.push_back(state);
+      if (state->_fd < 0) {
+        net_cat.error()
+          << "Unable to create epoll instance; falling back to select().\n";
+        _use_epoll = false;
+      }
+    }
+    if (!_use_epoll) {
+      for (EpollState *state : _epoll_states) {
+        delete state;
+      }
+      _epoll_states.clear();
+    }
+  }
+#endif  // IS_LINUX
+
   std::string reader_thread_name = thread_name;
   if (thread_name.empty()) {
     reader_thread_name = "ReaderThread";
@@ -158,6 +373,14 @@ ConnectionReader::
       sinfo->_connection.clear();
     }
   }
+
+#ifdef IS_LINUX
+  for (EpollState *state : _epoll_states) {
+    delete state;
+  }
+#endif
+
+  delete _buffer_pool;
 }
 
 /**
@@ -187,7 +410,12 @@ add_connection(Connection *connection) {
     }
   }
 
-  _sockets.push_back(new SocketInfo(connection));
+  SocketInfo *sinfo = new SocketInfo(connection);
+  _sockets.push_back(sinfo);
+
+  if (_use_epoll) {
+    epoll_add_socket(sinfo);
+  }
 
   return true;
 }
@@ -214,6 +442,10 @@ remove_connection(Connection *connection) {
     return false;
   }
 
+  if (_use_epoll) {
+    epoll_remove_socket(*si);
+  }
+
   _removed_sockets.push_back(*si);
   _sockets.erase(si);
 
@@ -386,6 +618,20 @@ flush_read_connection(Connection *connection) {
   // available on just this one socket; we can do this right here in this
   // thread, since we've already removed this connection from the reader.
 
+#ifdef IS_LINUX
+  if (_use_epoll) {
+    // The socket may well be beyond FD_SETSIZE, so we can't use select().
+    SOCKET fd = sinfo.get_socket()->GetSocket();
+    while (is_socket_readable(fd)) {
+      sinfo._busy = true;
+      if (!process_incoming_data(&sinfo)) {
+        break;
+      }
+    }
+    return;
+  }
+#endif  // IS_LINUX
+
   Socket_fdset fdset;
   fdset.clear();
   fdset.setForSocket(*(sinfo.get_socket()));
@@ -450,6 +696,9 @@ process_incoming_data(SocketInfo *sinfo) {
  */
 bool ConnectionReader::
 process_incoming_udp_data(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  return process_incoming_udp_batch(sinfo, false);
+#else
   Socket_UDP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
   Socket_Address addr;
@@ -519,7 +768,111 @@ process_incoming_udp_data(SocketInfo *sinfo) {
   }
 
   return true;
+#endif  // IS_LINUX
+}
+
+#ifdef IS_LINUX
+/**
+ * Reads the UDP datagrams that are waiting on the socket, up to
+ * net-max-batch-size of them, with a single call to recvmmsg().  The payload
+ * of each one is received directly into a buffer from the pool, which then
+ * becomes the datagram's data; only the header (when raw_mode is false) goes
+ * into a separate small buffer.  The buffers for any slots that were not
+ * filled go straight back to the pool.
+ */
+bool ConnectionReader::
+process_incoming_udp_batch(SocketInfo *sinfo, bool raw_mode) {
+  static const int max_batch = 64;
+
+  Socket_UDP *socket;
+  DCAST_INTO_R(socket, sinfo->get_socket(), false);
+
+  int count = std::max(std::min((int)net_max_batch_size, max_batch), 1);
+  int header_size = raw_mode ? 0 : datagram_udp_header_size;
+  size_t buffer_size = raw_mode ? read_buffer_size : maximum_udp_datagram;
+
+  // A buffer coming back from the pool has kept its storage, so growing it
+  // back to full size only has to clear the part past its last datagram.
+  PTA_uchar buffers[max_batch];
+  _buffer_pool->acquire(buffers, count, buffer_size);
+
+  struct mmsghdr msgs[max_batch];
+  struct iovec iov[max_batch][2];
+  unsigned char headers[max_batch][datagram_udp_header_size];
+  sockaddr_storage addrs[max_batch];
+
+  for (int i = 0; i < count; ++i) {
+    int iovcnt = 0;
+    if (!raw_mode) {
+      iov[i][iovcnt].iov_base = headers[i];
+      iov[i][iovcnt].iov_len = datagram_udp_header_size;
+      ++iovcnt;
+    }
+    buffers[i].v().resize(buffer_size);
+    iov[i][iovcnt].iov_base = buffers[i].v().data();
+    iov[i][iovcnt].iov_len = buffer_size;
+    ++iovcnt;
+
+    memset(&msgs[i], 0, sizeof(msgs[i]));
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = iov[i];
+    msgs[i].msg_hdr.msg_iovlen = iovcnt;
+  }
+
+  int num_received;
+  do {
+    num_received = recvmmsg(socket->GetSocket(), msgs, count, MSG_DONTWAIT, nullptr);
+  } while (num_received < 0 && errno == EINTR);
+
+  // Now that we've read all the data, it's time to finish the socket so
+  // another thread can read the next datagram.
+  finish_socket(sinfo);
+
+  if (num_received < 0) {
+    // If there was nothing to read after all, some other thread got to it
+    // first; that's not an error.
+    return (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+
+  for (int i = 0; i < num_received && !_shutdown; ++i) {
+    int bytes_read = (int)msgs[i].msg_len;
+    if (bytes_read < header_size) {
+      net_cat.error()
+        << "Did not read entire header, discarding UDP datagram.\n";
+      continue;
+    }
+
+    size_t data_size = std::min((size_t)(bytes_read - header_size), buffer_size);
+    buffers[i].v().resize(data_size);
+    NetDatagram datagram;
+    datagram.set_array(buffers[i]);
+
+    if (!raw_mode) {
+      DatagramUDPHeader header(headers[i]);
+      if (!header.verify_datagram(datagram)) {
+        net_cat.error()
+          << "Ignoring invalid UDP datagram.\n";
+        continue;
+      }
+    }
+
+    datagram.set_connection(sinfo->_connection);
+    datagram.set_address(NetAddress(Socket_Address(addrs[i])));
+
+    if (net_cat.is_spam()) {
+      net_cat.spam()
+        << "Received " << (raw_mode ? "raw " : "") << "UDP datagram with "
+        << bytes_read << " bytes on " << (void *)datagram.get_connection()
+        << " from " << datagram.get_address() << "\n";
+    }
+
+    receive_datagram(datagram);
+  }
+
+  return !_shutdown;
 }
+#endif  // IS_LINUX
 
 /**
  *
@@ -573,34 +926,43 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
   DatagramTCPHeader header(buffer, _tcp_header_size);
   int size = header.get_datagram_size(_tcp_header_size);
 
-  // We have to loop until the entire datagram is read.
-  NetDatagram datagram;
+  // We have to loop until the entire datagram is read.  The data is received
+  // directly into the array that will become the datagram's.  A small
+  // datagram gets a buffer of the full size up front; a larger one is grown
+  // as the data arrives, so that a bogus header can't make us allocate an
+  // enormous buffer before we've seen any of the data.
+  PTA_uchar data;
+  size_t received = 0;
+  if (size <= (int)net_datagram_pool_max_buffer) {
+    _buffer_pool->acquire(&data, 1, size);
+    data.resize(size);
+  } else {
+    data = PTA_uchar::empty_array(0);
+  }
 
-  while (!_shutdown && (int)datagram.get_length() < size) {
-    int bytes_read;
+  while (!_shutdown && received < (size_t)size) {
+    if (data.size() < (size_t)size) {
+      size_t grow = std::max(received, (size_t)read_buffer_size);
+      data.resize(std::min((size_t)size, received + grow));
+    }
 
-    int read_bytes = read_buffer_size;
+    int read_bytes = (int)(data.size() - received);
 #ifdef SIMPLE_THREADS
     // In the SIMPLE_THREADS case, we want to limit the number of bytes we
     // read in a single epoch, to minimize the impact on the other threads.
-    read_bytes = min(read_buffer_size, (int)net_max_read_per_epoch);
+    read_bytes = min(read_bytes, (int)net_max_read_per_epoch);
 #endif
 
-    bytes_read =
-      socket->RecvData(buffer, min(read_bytes,
-                                   (int)(size - datagram.get_length())));
+    char *dp = (char *)data.p() + received;
+    int bytes_read = socket->RecvData(dp, read_bytes);
 #if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
     while (bytes_read < 0 && socket->GetLastError() == LOCAL_BLOCKING_ERROR &&
            socket->Active()) {
       Thread::force_yield();
-      bytes_read =
-        socket->RecvData(buffer, min(read_bytes,
-                                     (int)(size - datagram.get_length())));
+      bytes_read = socket->RecvData(dp, read_bytes);
     }
 #endif  // SIMPLE_THREADS
 
-    char *dp = buffer;
-
     if (bytes_read <= 0) {
       // The socket was closed.  Report that and return.
       if (_manager != nullptr) {
@@ -610,20 +972,13 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
       return false;
     }
 
-    int datagram_bytes =
-      min(bytes_read, (int)(size - datagram.get_length()));
-    datagram.append_data(dp, datagram_bytes);
-
-    if (bytes_read > datagram_bytes) {
-      // There were some extra bytes at the end of the datagram.  Maybe the
-      // beginning of the next datagram?  Huh.
-      net_cat.error()
-        << "Discarding " << bytes_read - datagram_bytes
-        << " bytes following TCP datagram.\n";
-    }
+    received += bytes_read;
     Thread::consider_yield();
   }
 
+  NetDatagram datagram;
+  datagram.set_array(data);
+
   // Now that we've read all the data, it's time to finish the socket so
   // another thread can read the next datagram.
   finish_socket(sinfo);
@@ -659,6 +1014,9 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
  */
 bool ConnectionReader::
 process_raw_incoming_udp_data(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  return process_incoming_udp_batch(sinfo, true);
+#else
   Socket_UDP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
   Socket_Address addr;
@@ -707,6 +1065,7 @@ process_raw_incoming_udp_data(SocketInfo *sinfo) {
   receive_datagram(datagram);
 
   return true;
+#endif  // IS_LINUX
 }
 
 /**
@@ -717,8 +1076,11 @@ process_raw_incoming_tcp_data(SocketInfo *sinfo) {
   Socket_TCP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
 
-  // Read as many bytes as we can.
-  char buffer[read_buffer_size];
+  // Read as many bytes as we can, directly into the datagram's buffer.
+  PTA_uchar data;
+  _buffer_pool->acquire(&data, 1, read_buffer_size);
+  char *buffer = (char *)data.p();
+
   int bytes_read = socket->RecvData(buffer, read_buffer_size);
 #if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
   while (bytes_read < 0 && socket->GetLastError() == LOCAL_BLOCKING_ERROR &&
@@ -738,7 +1100,9 @@ process_raw_incoming_tcp_data(SocketInfo *sinfo) {
   }
 
   // In raw mode, we simply extract all the bytes and make that a datagram.
-  NetDatagram datagram(buffer, bytes_read);
+  data.resize(bytes_read);
+  NetDatagram datagram;
+  datagram.set_array(data);
 
   // Now that we've read all the data, it's time to finish the socket so
   // another thread can read the next datagram.
@@ -795,6 +1159,19 @@ thread_run(int thread_index) {
  */
 ConnectionReader::SocketInfo *ConnectionReader::
 get_next_available_socket(bool allow_block, int current_thread_index) {
+#ifdef IS_LINUX
+  if (_use_epoll) {
+    if (current_thread_index < 0) {
+      // A polling reader has only the one epoll instance, which is shared by
+      // all the threads that call poll().
+      MutexHolder holder(_select_mutex);
+      return get_next_available_epoll_socket(allow_block, _epoll_states[0]);
+    }
+    nassertr(current_thread_index < (int)_epoll_states.size(), nullptr);
+    return get_next_available_epoll_socket(allow_block, _epoll_states[current_thread_index]);
+  }
+#endif  // IS_LINUX
+
   // Go to sleep on the select() mutex.  This guarantees that only one thread
   // is in this function at a time.
   MutexHolder holder(_select_mutex);
@@ -895,7 +1272,17 @@ rebuild_select_list() {
 
   // This is also a fine time to delete the contents of the _removed_sockets
   // list.
+  purge_removed_sockets();
+}
+
+/**
+ * Deletes the SocketInfo objects of the sockets that have been removed and
+ * are no longer being read.  It is assumed the _sockets_mutex is held.
+ */
+void ConnectionReader::
+purge_removed_sockets() {
   if (!_removed_sockets.empty()) {
+    Sockets::const_iterator si;
     Sockets still_busy_sockets;
     for (si = _removed_sockets.begin(); si != _removed_sockets.end(); ++si) {
       SocketInfo *sinfo = (*si);
@@ -913,9 +1300,26 @@ rebuild_select_list() {
  * Adds the sockets from this ConnectionReader (or ConnectionListener) to the
  * indicated fdset.  This is used by ConnectionManager::block() to build an
  * fdset of all attached readers.
+ *
+ * If the reader is using epoll, this adds only its epoll instance, which
+ * becomes readable when any of its sockets has activity.  Returns true if
+ * there are sockets that are already known to have activity, in which case
+ * there is no need to wait for the fdset.
  */
-void ConnectionReader::
+bool ConnectionReader::
 accumulate_fdset(Socket_fdset &fdset) {
+#ifdef IS_LINUX
+  if (_use_epoll) {
+    MutexHolder holder(_select_mutex);
+    bool any_ready = false;
+    for (EpollState *state : _epoll_states) {
+      fdset.setForSocketNative(state->_fd);
+      any_ready = any_ready || state->has_ready();
+    }
+    return any_ready;
+  }
+#endif  // IS_LINUX
+
   LightMutexHolder holder(_sockets_mutex);
   Sockets::const_iterator si;
   for (si = _sockets.begin(); si != _sockets.end(); ++si) {
@@ -924,4 +1328,134 @@ accumulate_fdset(Socket_fdset &fdset) {
       fdset.setForSocket(*sinfo->get_socket());
     }
   }
+  return false;
+}
+
+/**
+ * The epoll equivalent of get_next_available_socket().  Each thread waits on
+ * its own epoll instance, and only ever returns the sockets that were
+ * assigned to it, so the threads don't have to wait for each other.
+ */
+ConnectionReader::SocketInfo *ConnectionReader::
+get_next_available_epoll_socket(bool allow_block, EpollState *state) {
+#ifdef IS_LINUX
+  while (!_shutdown) {
+    // First, check the sockets that have been reported previously.
+    while (!_shutdown && !state->_ready.empty()) {
+      uint64_t id = state->pop_ready();
+
+      SocketInfo *sinfo = nullptr;
+      {
+        LightMutexHolder holder(_sockets_mutex);
+        SocketsById::const_iterator si = _sockets_by_id.find(id);
+        if (si != _sockets_by_id.end() &&
+            !(*si).second->_busy && !(*si).second->_error) {
+          sinfo = (*si).second;
+          sinfo->_busy = true;
+        }
+      }
+
+      if (sinfo != nullptr) {
+        if (is_socket_readable(sinfo->get_socket()->GetSocket())) {
+          // There might be more where this came from, but we won't be told
+          // about it, so we check again after this datagram has been read.
+          state->push_ready(id);
+          return sinfo;
+        }
+        sinfo->_busy = false;
+      }
+    }
+
+    {
+      LightMutexHolder holder(_sockets_mutex);
+      purge_removed_sockets();
+    }
+
+    if (_shutdown) {
+      break;
+    }
+
+    int timeout = (int)(get_net_max_block() * 1000.0);
+    if (!allow_block) {
+      timeout = 0;
+    }
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+    // In the presence of SIMPLE_THREADS, we never wait at all, but rather we
+    // yield the thread if we come up empty (so that we won't block the entire
+    // process).
+    timeout = 0;
+#endif
+
+    int num_results = epoll_wait(state->_fd, state->_events, epoll_max_events, timeout);
+    if (num_results < 0) {
+      if (errno != EINTR) {
+        net_cat.error()
+          << "epoll_wait() failed: " << strerror(errno) << "\n";
+      }
+      // If we had an error, just return.  But yield the timeslice first.
+      Thread::force_yield();
+      return nullptr;
+    }
+
+    for (int i = 0; i < num_results; ++i) {
+      state->push_ready(state->_events[i].data.u64);
+    }
+
+    if (num_results == 0) {
+      if (!allow_block) {
+        return nullptr;
+      }
+      // If we reached net_max_block, go back and reconsider.  (We never
+      // timeout indefinitely, so we can check the shutdown flag every once in
+      // a while.)
+      Thread::force_yield();
+    }
+  }
+#endif  // IS_LINUX
+
+  return nullptr;
+}
+
+/**
+ * Assigns a newly added socket to one of the epoll instances.  It is assumed
+ * the _sockets_mutex is held.
+ */
+void ConnectionReader::
+epoll_add_socket(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  sinfo->_id = _next_socket_id++;
+  sinfo->_epoll_index = _next_epoll_index;
+  _next_epoll_index = (_next_epoll_index + 1) % (int)_epoll_states.size();
+  _sockets_by_id[sinfo->_id] = sinfo;
+
+  struct epoll_event event;
+  event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+  event.data.u64 = sinfo->_id;
+  SOCKET fd = sinfo->get_socket()->GetSocket();
+  if (epoll_ctl(_epoll_states[sinfo->_epoll_index]->_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+    net_cat.error()
+      << "Unable to add socket to epoll instance: " << strerror(errno) << "\n";
+    sinfo->_error = true;
+  }
+#endif  // IS_LINUX
+}
+
+/**
+ * Removes a socket from its epoll instance.  It is assumed the _sockets_mutex
+ * is held.  Any events for the socket that have already been reported will be
+ * ignored, since it will no longer be found in _sockets_by_id.
+ */
+void ConnectionReader::
+epoll_remove_socket(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  _sockets_by_id.erase(sinfo->_id);
+
+  // This may fail if the socket has already been closed, in which case it
+  // has already been removed from the epoll instance anyway.
+  SOCKET fd = sinfo->get_socket()->GetSocket();
+  if (fd >= 0) {
+    struct epoll_event event;
+    epoll_ctl(_epoll_states[sinfo->_epoll_index]->_fd, EPOLL_CTL_DEL, fd, &event);
+  }
+#endif  // IS_LINUX
 }
@@ -23,6 +23,8 @@
 #include "lightMutex.h"
 #include "pvector.h"
 #include "pset.h"
+#include "pmap.h"
+#include "pdeque.h"
 #include "socket_fdset.h"
 #include "atomicAdjust.h"
 
@@ -72,6 +74,7 @@ PUBLISHED:
 
   ConnectionManager *get_manager() const;
   INLINE bool is_polling() const;
+  INLINE bool is_using_epoll() const;
   int get_num_threads() const;
 
   void set_raw_mode(bool mode);
@@ -95,6 +98,10 @@ protected:
     PT(Connection) _connection;
     bool _busy;
     bool _error;
+
+    // These are only used when the reader is using epoll.
+    uint64_t _id;
+    int _epoll_index;
   };
   typedef pvector<SocketInfo *> Sockets;
 
@@ -106,6 +113,9 @@ protected:
   virtual bool process_incoming_tcp_data(SocketInfo *sinfo);
   virtual bool process_raw_incoming_udp_data(SocketInfo *sinfo);
   virtual bool process_raw_incoming_tcp_data(SocketInfo *sinfo);
+#ifdef IS_LINUX
+  bool process_incoming_udp_batch(SocketInfo *sinfo, bool raw_mode);
+#endif
 
 protected:
   ConnectionManager *_manager;
@@ -126,7 +136,16 @@ private:
                                         int current_thread_index);
 
   void rebuild_select_list();
-  void accumulate_fdset(Socket_fdset &fdset);
+  void purge_removed_sockets();
+  bool accumulate_fdset(Socket_fdset &fdset);
+
+  class EpollState;
+  SocketInfo *get_next_available_epoll_socket(bool allow_block,
+                                              EpollState *state);
+  void epoll_add_socket(SocketInfo *sinfo);
+  void epoll_remove_socket(SocketInfo *sinfo);
+
+  class BufferPool;
 
 private:
   bool _raw_mode;
@@ -162,6 +181,25 @@ private:
   // thread is so waiting.
   AtomicAdjust::Integer _currently_polling_thread;
 
+  // These are used instead of the above when the reader is using epoll.
+  // There is one EpollState for each thread (or just one, for a polling
+  // reader), and each socket is assigned to one of them when it is added.
+  // The epoll events identify sockets by _id, which is looked up in
+  // _sockets_by_id while holding _sockets_mutex, since the socket may have
+  // been removed in the meantime.
+  typedef pvector<EpollState *> EpollStates;
+  typedef pmap<uint64_t, SocketInfo *> SocketsById;
+  bool _use_epoll;
+  EpollStates _epoll_states;
+  SocketsById _sockets_by_id;
+  uint64_t _next_socket_id;
+  int _next_epoll_index;
+
+  // Incoming datagrams are received directly into buffers from this pool,
+  // which are then shared with the NetDatagram that is passed to
+  // receive_datagram().  A buffer is reused once nothing else refers to it.
+  BufferPool *_buffer_pool;
+
   friend class ConnectionManager;
   friend class ReaderThread;
 };
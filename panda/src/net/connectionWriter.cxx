@@ -320,13 +320,27 @@ void ConnectionWriter::
 thread_run(int thread_index) {
   nassertv(!_immediate);
 
-  NetDatagram datagram;
-  while (_queue.extract(datagram)) {
-    if (_raw_mode) {
-      datagram.get_connection()->send_raw_datagram(datagram);
-    } else {
-      datagram.get_connection()->send_datagram(datagram, _tcp_header_size);
+  // We take everything that is waiting in the queue at once (up to a limit),
+  // and hand each run of datagrams for the same connection to that
+  // connection together, so it can write them with a single system call.
+  size_t max_count = (size_t)std::max((int)net_max_batch_size, 1);
+  pvector<NetDatagram> datagrams;
+  datagrams.reserve(max_count);
+
+  while (_queue.extract(datagrams, max_count)) {
+    size_t i = 0;
+    while (i < datagrams.size()) {
+      Connection *connection = datagrams[i].get_connection();
+      size_t j = i + 1;
+      while (j < datagrams.size() && datagrams[j].get_connection() == connection) {
+        ++j;
+      }
+      connection->send_datagrams(&datagrams[i], j - i, _tcp_header_size, _raw_mode);
+      i = j;
     }
+
+    // Release the connection pointers before we go back to sleep.
+    datagrams.clear();
     Thread::consider_yield();
   }
 }
@@ -121,6 +121,42 @@ extract(NetDatagram &result) {
   return true;
 }
 
+/**
+ * Extracts up to max_count datagrams from the head of the queue into the
+ * result vector, replacing whatever it held before.  This is the same as the
+ * single-datagram version of extract(), except that it takes everything that
+ * is available at once (up to the limit), so the caller can write them all
+ * out with fewer system calls.
+ *
+ * The return value is true if at least one datagram was extracted, or false
+ * if the queue was destroyed while waiting.
+ */
+bool DatagramQueue::
+extract(pvector<NetDatagram> &result, size_t max_count) {
+  result.clear();
+  nassertr(max_count > 0, false);
+
+  MutexHolder holder(_cvlock);
+
+  while (_queue.empty() && !_shutdown) {
+    _cv.wait();
+  }
+
+  if (_shutdown) {
+    return false;
+  }
+
+  nassertr(!_queue.empty(), false);
+  size_t count = std::min(max_count, _queue.size());
+  result.insert(result.end(), _queue.begin(), _queue.begin() + count);
+  _queue.erase(_queue.begin(), _queue.begin() + count);
+
+  // Wake up any threads waiting to stuff things into the queue.
+  _cv.notify_all();
+
+  return true;
+}
+
 /**
  * Sets the maximum size the queue is allowed to grow to.  This is primarily
  * for a sanity check; this is a limit beyond which we can assume something
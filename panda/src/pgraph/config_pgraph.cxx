@@ -133,6 +133,39 @@ ConfigVariableBool debug_portal_cull
           "(You first need to enable portal culling, using the allow-portal-cull"
           "variable.)"));
 
+ConfigVariableBool parallel_cull
+("parallel-cull", false,
+ PRC_DESC("Set this true to allow the cull traversal of a large scene to be "
+          "divided between the threads of the worker thread pool (see "
+          "worker-thread-pool-size).  When a node has at least two children "
+          "that each contain parallel-cull-min-vertices vertices or more, its "
+          "children are traversed in parallel, and the results are passed on "
+          "in the original order.  Any cull callbacks on nodes in those "
+          "subtrees must be safe to call from another thread."));
+
+ConfigVariableInt parallel_cull_min_vertices
+("parallel-cull-min-vertices", 10000,
+ PRC_DESC("The minimum number of vertices that a subtree must contain to be "
+          "considered worth traversing on another thread, when parallel-cull "
+          "is enabled."));
+
+ConfigVariableBool parallel_flatten
+("parallel-flatten", false,
+ PRC_DESC("Set this true to allow the SceneGraphReducer to divide the work of "
+          "flattening a large scene between the threads of the worker thread "
+          "pool (see worker-thread-pool-size).  Subtrees that are not shared "
+          "with any other part of the graph are flattened in parallel, and "
+          "the vertex data combining and unify steps are done in parallel "
+          "for each GeomVertexData and GeomNode.  The result is the same as "
+          "when flattening on a single thread.  This has no effect unless "
+          "Panda was compiled with true threading and pipelining."));
+
+ConfigVariableInt parallel_flatten_min_nodes
+("parallel-flatten-min-nodes", 1000,
+ PRC_DESC("The minimum number of nodes that the unshared subtrees below a "
+          "node must contain between them to be considered worth flattening "
+          "on several threads, when parallel-flatten is enabled."));
+
 ConfigVariableBool show_occluder_volumes
 ("show-occluder-volumes", false,
  PRC_DESC("Set this true to enable debug visualization of the volumes used "
@@ -388,6 +421,22 @@ ConfigVariableBool filled_wireframe_apply_shader
           "the result of the fragment shader.  This is helpful when the shader "
           "alters the position of the vertices and makes the overlay wrong."));
 
+ConfigVariableBool instance_list_soa
+("instance-list-soa", true,
+ PRC_DESC("Set this true to let InstancedNode cull its instances in blocks, "
+          "using a structure-of-arrays copy of the instance matrices, and to "
+          "compose the instances of nested InstancedNodes without creating "
+          "a TransformState for each combination.  Set it false to test each "
+          "instance one at a time instead, as in earlier versions."));
+
+ConfigVariableInt instance_list_cluster_size
+("instance-list-cluster-size", 32,
+ PRC_DESC("The number of instances in each of the smallest clusters that an "
+          "InstanceList groups its instances into for culling, so that "
+          "clusters of instances can be culled at once.  Lists with fewer "
+          "than four times this many instances are not clustered.  Set this "
+          "to 0 to disable clustering."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
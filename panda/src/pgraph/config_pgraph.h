@@ -34,6 +34,10 @@ extern EXPCL_PANDA_PGRAPH ConfigVariableBool fake_view_frustum_cull;
 extern ConfigVariableBool clip_plane_cull;
 extern ConfigVariableBool allow_portal_cull;
 extern ConfigVariableBool debug_portal_cull;
+extern ConfigVariableBool parallel_cull;
+extern ConfigVariableInt parallel_cull_min_vertices;
+extern ConfigVariableBool parallel_flatten;
+extern ConfigVariableInt parallel_flatten_min_nodes;
 extern ConfigVariableBool show_occluder_volumes;
 extern ConfigVariableBool unambiguous_graph;
 extern ConfigVariableBool detect_graph_cycles;
@@ -76,6 +80,8 @@ extern ConfigVariableString default_model_extension;
 extern ConfigVariableBool allow_live_flatten;
 
 extern ConfigVariableBool filled_wireframe_apply_shader;
+extern ConfigVariableBool instance_list_soa;
+extern ConfigVariableInt instance_list_cluster_size;
 
 extern EXPCL_PANDA_PGRAPH void init_libpgraph();
 
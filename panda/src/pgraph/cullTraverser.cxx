@@ -35,6 +35,7 @@
 #include "geomLinestrips.h"
 #include "geomLines.h"
 #include "geomVertexWriter.h"
+#include "workerThreadPool.h"
 
 PStatCollector CullTraverser::_nodes_pcollector("Nodes");
 PStatCollector CullTraverser::_geom_nodes_pcollector("Nodes:GeomNodes");
@@ -44,6 +45,22 @@ PStatCollector CullTraverser::_geoms_occluded_pcollector("Geoms:Occluded");
 
 TypeHandle CullTraverser::_type_handle;
 
+/**
+ * This CullHandler is given to the CullTraversers that traverse a subtree on
+ * a worker thread.  It holds on to the objects it receives, so that they can
+ * be passed on to the real CullHandler afterwards, in the order in which a
+ * single-threaded traversal would have found them.
+ */
+class DeferredCullHandler final : public CullHandler {
+public:
+  virtual void record_object(CullableObject &&object,
+                             const CullTraverser *traverser) override {
+    _objects.push_back(std::move(object));
+  }
+
+  pvector<CullableObject> _objects;
+};
+
 /**
  *
  */
@@ -57,7 +74,8 @@ CullTraverser() :
   _initial_state(RenderState::make_empty()),
   _cull_handler(nullptr),
   _portal_clipper(nullptr),
-  _effective_incomplete_render(false)
+  _effective_incomplete_render(false),
+  _parallel_cull(false)
 {
 }
 
@@ -77,7 +95,8 @@ CullTraverser(const CullTraverser &copy) :
   _view_frustum(copy._view_frustum),
   _cull_handler(copy._cull_handler),
   _portal_clipper(copy._portal_clipper),
-  _effective_incomplete_render(copy._effective_incomplete_render)
+  _effective_incomplete_render(copy._effective_incomplete_render),
+  _parallel_cull(copy._parallel_cull)
 {
 }
 
@@ -107,6 +126,12 @@ set_scene(SceneSetup *scene_setup, GraphicsStateGuardianBase *gsg,
 #ifndef NDEBUG
   _fake_view_frustum_cull = fake_view_frustum_cull;
 #endif
+
+  // A derived traverser may keep state of its own during the traversal, which
+  // we can't know how to divide across threads.  The same goes for portal
+  // culling, which keeps its state in the PortalClipper.
+  _parallel_cull = parallel_cull && !allow_portal_cull &&
+    !_fake_view_frustum_cull && get_type() == CullTraverser::get_class_type();
 }
 
 /**
@@ -234,6 +259,11 @@ do_traverse(CullTraverserData &data) {
   PandaNode::Children children = node_reader->get_children();
   node_reader->release();
   int num_children = children.get_num_children();
+  if (_parallel_cull && num_children > 1 &&
+      should_traverse_parallel(children)) {
+    traverse_children_parallel(data, children);
+    return;
+  }
   for (int i = 0; i < num_children; ++i) {
     const PandaNode::DownConnection &child = children.get_child_connection(i);
     traverse_down(data, child, data._state);
@@ -289,6 +319,71 @@ do_fake_cull(const CullTraverserData &data, PandaNode *child,
 #endif
 }
 
+/**
+ * Visits the children of the node with the indicated data, in the same way as
+ * do_traverse(), but divides them between the threads of the worker thread
+ * pool.  Each child subtree is traversed serially by a copy of this
+ * traverser, after which the objects they found are passed on to our own
+ * CullHandler in the normal traversal order.
+ */
+void CullTraverser::
+traverse_children_parallel(CullTraverserData &data,
+                           const PandaNode::Children &children) {
+  // Make sure these have been created before the threads get to them.
+  get_bounds_outer_viz_state();
+  get_bounds_inner_viz_state();
+  get_depth_offset_state();
+
+  size_t num_children = (size_t)children.get_num_children();
+  pvector<DeferredCullHandler> handlers(num_children);
+
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for(num_children,
+    [&] (size_t n, Thread *current_thread) {
+      CullTraverser trav(*this);
+      trav._current_thread = current_thread;
+      trav._cull_handler = &handlers[n];
+
+      // We don't divide the work any further than this.
+      trav._parallel_cull = false;
+
+      CullTraverserData thread_data(data, current_thread);
+      trav.traverse_down(thread_data, children.get_child_connection((int)n),
+                         thread_data._state);
+    }, _current_thread);
+
+  for (DeferredCullHandler &handler : handlers) {
+    for (CullableObject &object : handler._objects) {
+      _cull_handler->record_object(std::move(object), this);
+    }
+  }
+}
+
+/**
+ * Returns true if at least two of the indicated children contain enough
+ * geometry to make it worth traversing them on separate threads.
+ */
+bool CullTraverser::
+should_traverse_parallel(const PandaNode::Children &children) const {
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  if (!pool->is_parallel()) {
+    return false;
+  }
+
+  int min_vertices = parallel_cull_min_vertices;
+  int num_large = 0;
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    PandaNode *child = children.get_child(i);
+    if (child->get_nested_vertices(_current_thread) >= min_vertices) {
+      if (++num_large >= 2) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 /**
  * Draws an appropriate visualization of the node's external bounding volume.
  */
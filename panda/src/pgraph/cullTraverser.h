@@ -113,6 +113,10 @@ public:
   static PStatCollector _geoms_occluded_pcollector;
 
 private:
+  void traverse_children_parallel(CullTraverserData &data,
+                                  const PandaNode::Children &children);
+  bool should_traverse_parallel(const PandaNode::Children &children) const;
+
   void show_bounds(CullTraverserData &data, bool tight);
   static PT(Geom) make_bounds_viz(const BoundingVolume *vol);
   PT(Geom) make_tight_bounds_viz(PandaNode *node) const;
@@ -134,6 +138,7 @@ private:
   CullHandler *_cull_handler;
   PortalClipper *_portal_clipper;
   bool _effective_incomplete_render;
+  bool _parallel_cull;
 
 public:
   static TypeHandle get_class_type() {
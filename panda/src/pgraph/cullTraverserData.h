@@ -55,6 +55,8 @@ public:
                            const TransformState *net_transform,
                            CPT(RenderState) state,
                            GeometricBoundingVolume *view_frustum);
+  INLINE CullTraverserData(const CullTraverserData &copy,
+                           Thread *current_thread);
 
 PUBLISHED:
   INLINE PandaNode *node() const;
@@ -30,6 +30,7 @@
 #include "textureAttrib.h"
 #include "colorAttrib.h"
 #include "config_pgraph.h"
+#include "workerThreadPool.h"
 
 PStatCollector GeomTransformer::_apply_vertex_collector("*:Flatten:apply:vertex");
 PStatCollector GeomTransformer::_apply_texcoord_collector("*:Flatten:apply:texcoord");
@@ -1083,7 +1084,11 @@ collect_vertex_data(GeomNode *node, int collect_bits, bool format_only) {
   }
 
   if (dynamic != nullptr) {
-    num_adjusted += dynamic->finish_collect(format_only);
+    if (SceneGraphReducer::get_flatten_pool() != nullptr) {
+      take_collected(*dynamic);
+    } else {
+      num_adjusted += dynamic->finish_collect(format_only);
+    }
     delete dynamic;
   }
 
@@ -1103,10 +1108,47 @@ int GeomTransformer::
 finish_collect(bool format_only) {
   int num_adjusted = 0;
 
+  // Each of the new GeomVertexDatas is built from a different set of source
+  // GeomVertexDatas for a different set of Geoms, so they can be built in
+  // parallel.  The exception is animated vertex data, since registering the
+  // new animation tables modifies the VertexTransforms they share.
+  WorkerThreadPool *pool = nullptr;
+  if (_new_collected_list.size() >= 2) {
+    pool = SceneGraphReducer::get_flatten_pool();
+  }
+
+  NewCollectedList serial_list;
+  if (pool != nullptr) {
+    NewCollectedList parallel_list;
+    for (NewCollectedData *ncd : _new_collected_list) {
+      if (ncd->has_animation_tables()) {
+        serial_list.push_back(ncd);
+      } else {
+        parallel_list.push_back(ncd);
+      }
+    }
+
+    vector_int parallel_adjusted(parallel_list.size(), 0);
+    pool->parallel_for(parallel_list.size(),
+      [&] (size_t n, Thread *current_thread) {
+        NewCollectedData *ncd = parallel_list[n];
+        if (format_only) {
+          parallel_adjusted[n] = ncd->apply_format_only_changes();
+        } else {
+          parallel_adjusted[n] = ncd->apply_collect_changes();
+        }
+        delete ncd;
+      });
+
+    for (int count : parallel_adjusted) {
+      num_adjusted += count;
+    }
+  } else {
+    serial_list.swap(_new_collected_list);
+  }
+
   NewCollectedList::iterator nci;
-  for (nci = _new_collected_list.begin();
-       nci != _new_collected_list.end();
-       ++nci) {
+  for (nci = serial_list.begin(); nci != serial_list.end(); ++nci) {
     NewCollectedData *ncd = (*nci);
     if (format_only) {
       num_adjusted += ncd->apply_format_only_changes();
@@ -1123,6 +1165,27 @@ finish_collect(bool format_only) {
   return num_adjusted;
 }
 
+/**
+ * Moves the GeomVertexDatas collected by a previous call to
+ * collect_vertex_data() on the other GeomTransformer to this one, so that
+ * they are combined by the next call to finish_collect() on this object
+ * instead.  They are not combined with any of the GeomVertexDatas collected
+ * by this object.
+ *
+ * This allows all of the GeomVertexDatas collected throughout a scene graph
+ * to be combined at once, which is useful when the work can be divided
+ * between several threads.
+ */
+void GeomTransformer::
+take_collected(GeomTransformer &other) {
+  _new_collected_list.insert(_new_collected_list.end(),
+                             other._new_collected_list.begin(),
+                             other._new_collected_list.end());
+  other._new_collected_list.clear();
+  other._new_collected_map.clear();
+  other._already_collected_map.clear();
+}
+
 /**
  * Uses the indicated munger to premunge the given Geom to optimize it for
  * eventual rendering.  See SceneGraphReducer::premunge().
@@ -1247,6 +1310,24 @@ apply_collect_changes() {
   return 1;
 }
 
+/**
+ * Returns true if any of the source GeomVertexDatas has a TransformTable,
+ * TransformBlendTable or SliderTable.
+ */
+bool GeomTransformer::NewCollectedData::
+has_animation_tables() const {
+  SourceDatas::const_iterator sdi;
+  for (sdi = _source_datas.begin(); sdi != _source_datas.end(); ++sdi) {
+    const GeomVertexData *vdata = (*sdi)._vdata;
+    if (vdata->get_transform_table() != nullptr ||
+        vdata->get_transform_blend_table() != nullptr ||
+        vdata->get_slider_table() != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * Appends the vertices from the indicated source GeomVertexData to the end of
  * the working data.
@@ -87,6 +87,7 @@ public:
   int collect_vertex_data(Geom *geom, int collect_bits, bool format_only);
   int collect_vertex_data(GeomNode *node, int collect_bits, bool format_only);
   int finish_collect(bool format_only);
+  void take_collected(GeomTransformer &other);
 
   PT(Geom) premunge_geom(const Geom *geom, GeomMunger *munger);
 
@@ -220,6 +221,7 @@ private:
     void add_source_data(const GeomVertexData *source_data);
     int apply_format_only_changes();
     int apply_collect_changes();
+    bool has_animation_tables() const;
 
     CPT(GeomVertexFormat) _new_format;
     std::string _vdata_name;
@@ -17,6 +17,23 @@
 #include "bamWriter.h"
 #include "bitArray.h"
 #include "geomVertexWriter.h"
+#include "boundingVolume.h"
+#include "lightMutexHolder.h"
+#include "config_pgraph.h"
+
+#if !defined(STDFLOAT_DOUBLE) && (defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#define INSTANCELIST_USE_SSE2 1
+#endif
+
+#include <algorithm>
+
+static const unsigned char result_outside = BoundingVolume::IF_no_intersection;
+static const unsigned char result_partial = BoundingVolume::IF_possible | BoundingVolume::IF_some;
+static const unsigned char result_inside = BoundingVolume::IF_possible | BoundingVolume::IF_some | BoundingVolume::IF_all;
+
+// We use the same determinant threshold as LMatrix4::invert_from().
+static const PN_stdfloat det_threshold = NEARLY_ZERO(PN_stdfloat) * NEARLY_ZERO(PN_stdfloat);
 
 TypeHandle InstanceList::_type_handle;
 
@@ -39,9 +56,25 @@ InstanceList() {
  *
  */
 InstanceList::
-InstanceList(const InstanceList &copy) :
-  _instances(copy._instances)
-{
+InstanceList(const InstanceList &copy) {
+  // A lazy list never modifies its matrices, so we can safely copy them even
+  // if another thread is busy materializing it.
+  if (copy._matrices_valid.load(std::memory_order_acquire)) {
+    _matrices = copy._matrices;
+    _num_matrices = copy._num_matrices;
+    _all_affine = copy._all_affine;
+    _matrices_valid.store(true, std::memory_order_relaxed);
+  }
+  if (copy._clusters_valid.load(std::memory_order_acquire)) {
+    _clusters = copy._clusters;
+    _cluster_items = copy._cluster_items;
+    _clusters_valid.store(true, std::memory_order_relaxed);
+  }
+  if (copy._lazy.load(std::memory_order_acquire)) {
+    _lazy.store(true, std::memory_order_relaxed);
+  } else {
+    _instances = copy._instances;
+  }
 }
 
 /**
@@ -80,6 +113,29 @@ without(const BitArray &mask) const {
   }
 
   InstanceList *new_list = new InstanceList;
+
+  if (_lazy.load(std::memory_order_acquire)) {
+    // Keep the result lazy, too.
+    size_t num_kept = num_instances - num_culled;
+    new_list->_matrices.resize(num_kept * MC_num_components);
+    PN_stdfloat *dest = new_list->_matrices.data();
+    const PN_stdfloat *src = _matrices.data();
+    size_t ni = 0;
+    for (size_t i = (size_t)mask.get_lowest_off_bit(); i < num_instances; ++i) {
+      if (!mask.get_bit(i)) {
+        for (int c = 0; c < MC_num_components; ++c) {
+          dest[c * num_kept + ni] = src[c * num_instances + i];
+        }
+        ++ni;
+      }
+    }
+    nassertr(ni == num_kept, new_list);
+    new_list->_num_matrices = num_kept;
+    new_list->_matrices_valid.store(true, std::memory_order_relaxed);
+    new_list->_lazy.store(true, std::memory_order_relaxed);
+    return new_list;
+  }
+
   new_list->_instances.reserve(num_instances - num_culled);
 
   for (size_t i = (size_t)mask.get_lowest_off_bit(); i < num_instances; ++i) {
@@ -112,8 +168,22 @@ get_array_data(const GeomVertexArrayFormat *format) const {
   {
     GeomVertexWriter writer(new_array, Thread::get_current_thread());
     writer.set_column(InternalName::get_instance_matrix());
-    for (size_t i = 0; i < num_instances; ++i) {
-      writer.set_matrix4(_instances[i].get_mat());
+    if (_lazy.load(std::memory_order_acquire)) {
+      // Write the matrices straight from the arrays, so that we don't need
+      // to create a TransformState for each instance.
+      const PN_stdfloat *m = _matrices.data();
+      size_t n = _num_matrices;
+      for (size_t i = 0; i < num_instances; ++i) {
+        writer.set_matrix4(LMatrix4(
+          m[MC_00 * n + i], m[MC_01 * n + i], m[MC_02 * n + i], 0,
+          m[MC_10 * n + i], m[MC_11 * n + i], m[MC_12 * n + i], 0,
+          m[MC_20 * n + i], m[MC_21 * n + i], m[MC_22 * n + i], 0,
+          m[MC_30 * n + i], m[MC_31 * n + i], m[MC_32 * n + i], 1));
+      }
+    } else {
+      for (size_t i = 0; i < num_instances; ++i) {
+        writer.set_matrix4(_instances[i].get_mat());
+      }
     }
   }
 
@@ -121,6 +191,327 @@ get_array_data(const GeomVertexArrayFormat *format) const {
   return new_array;
 }
 
+/**
+ * Returns a list containing, for each instance of the outer list, each of
+ * the instances of the inner list composed with it, in that order.  This is
+ * used when an InstancedNode appears below another InstancedNode.
+ *
+ * If both lists contain only affine transforms, the result is computed
+ * directly from their matrices, and the resulting list is lazy: it does not
+ * create a TransformState for each of its instances unless they are
+ * explicitly requested.
+ */
+CPT(InstanceList) InstanceList::
+compose(const InstanceList *outer, const InstanceList *inner) {
+  nassertr(outer != nullptr && inner != nullptr, nullptr);
+
+  size_t num_outer = outer->size();
+  size_t num_inner = inner->size();
+  PT(InstanceList) new_list = new InstanceList;
+
+  if (!instance_list_soa || !outer->fill_matrices() || !inner->fill_matrices()) {
+    new_list->_instances.reserve(num_outer * num_inner);
+    for (const Instance &outer_instance : *outer) {
+      for (const Instance &inner_instance : *inner) {
+        new_list->_instances.push_back(Instance(outer_instance.get_transform()->compose(inner_instance.get_transform())));
+      }
+    }
+    return new_list;
+  }
+
+  size_t n = num_outer * num_inner;
+  new_list->_matrices.resize(n * MC_num_components);
+  PN_stdfloat *dest = new_list->_matrices.data();
+  const PN_stdfloat *a = outer->_matrices.data();
+  const PN_stdfloat *b = inner->_matrices.data();
+
+  size_t di = 0;
+  for (size_t oi = 0; oi < num_outer; ++oi) {
+    PN_stdfloat am[MC_num_components];
+    for (int c = 0; c < MC_num_components; ++c) {
+      am[c] = a[c * num_outer + oi];
+    }
+    for (size_t ii = 0; ii < num_inner; ++ii) {
+      PN_stdfloat bm[MC_num_components];
+      for (int c = 0; c < MC_num_components; ++c) {
+        bm[c] = b[c * num_inner + ii];
+      }
+      compose_affine(dest, n, di++, bm, am);
+    }
+  }
+
+  new_list->_num_matrices = n;
+  new_list->_matrices_valid.store(true, std::memory_order_relaxed);
+  new_list->_lazy.store(true, std::memory_order_relaxed);
+  return new_list;
+}
+
+/**
+ * Returns a list in which each of the instances of the outer list is
+ * composed with the indicated transform.  This is like compose(), but for an
+ * inner list with just one instance.
+ */
+CPT(InstanceList) InstanceList::
+compose(const InstanceList *outer, const TransformState *inner) {
+  nassertr(outer != nullptr && inner != nullptr, nullptr);
+  if (inner->is_identity()) {
+    return outer;
+  }
+
+  size_t n = outer->size();
+  PT(InstanceList) new_list = new InstanceList;
+
+  const LMatrix4 &mat = inner->get_mat();
+  if (!instance_list_soa || !is_affine(mat) || !outer->fill_matrices()) {
+    new_list->_instances.reserve(n);
+    for (const Instance &outer_instance : *outer) {
+      new_list->_instances.push_back(Instance(outer_instance.get_transform()->compose(inner)));
+    }
+    return new_list;
+  }
+
+  PN_stdfloat bm[MC_num_components] = {
+    mat(0, 0), mat(0, 1), mat(0, 2),
+    mat(1, 0), mat(1, 1), mat(1, 2),
+    mat(2, 0), mat(2, 1), mat(2, 2),
+    mat(3, 0), mat(3, 1), mat(3, 2),
+    mat.get_upper_3().determinant(),
+  };
+
+  new_list->_matrices.resize(n * MC_num_components);
+  PN_stdfloat *dest = new_list->_matrices.data();
+  const PN_stdfloat *a = outer->_matrices.data();
+
+  for (size_t oi = 0; oi < n; ++oi) {
+    PN_stdfloat am[MC_num_components];
+    for (int c = 0; c < MC_num_components; ++c) {
+      am[c] = a[c * n + oi];
+    }
+    compose_affine(dest, n, oi, bm, am);
+  }
+
+  new_list->_num_matrices = n;
+  new_list->_matrices_valid.store(true, std::memory_order_relaxed);
+  new_list->_lazy.store(true, std::memory_order_relaxed);
+  return new_list;
+}
+
+/**
+ * Tests the sphere with the indicated center and radius, as transformed by
+ * each of the instances, against the indicated planes, and stores for each
+ * instance a set of BoundingVolume::IntersectionFlags in results, which
+ * must have room for size() entries.  The sphere is outside the volume if it
+ * is entirely in front of any of the planes, following the convention of
+ * BoundingHexahedron.  Instances with a singular transform are always
+ * reported as outside.
+ *
+ * The planes are tested in blocks of instances at a time, taken straight from
+ * the structure-of-arrays copy of the instance matrices.  Returns false if
+ * this can't be done because some of the transforms are not affine, in which
+ * case the caller should test the instances one at a time.
+ */
+bool InstanceList::
+test_spheres(unsigned char *results, const LPoint3 &center,
+             PN_stdfloat radius, const LPlane *planes,
+             size_t num_planes) const {
+  if (!fill_matrices()) {
+    return false;
+  }
+
+  const PN_stdfloat *m = _matrices.data();
+  size_t n = _num_matrices;
+
+  if (fill_clusters()) {
+    // Walk down the cluster hierarchy, only testing the instances of the
+    // clusters that straddle one of the planes.
+    memset(results, result_outside, n);
+
+    PN_stdfloat center_dist = center.length();
+    uint32_t stack[max_cluster_depth + 1];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+      uint32_t ci = stack[--sp];
+      const Cluster &cluster = _clusters[ci];
+
+      // Every instance of the cluster puts the sphere somewhere within this
+      // distance of the cluster's center.
+      PN_stdfloat cluster_radius = cluster._radius + (center_dist + radius) * cluster._max_scale;
+
+      bool outside = false;
+      bool inside = true;
+      for (size_t pi = 0; pi < num_planes; ++pi) {
+        const LPlane &plane = planes[pi];
+        PN_stdfloat dist = plane.dist_to_plane(cluster._center);
+        PN_stdfloat rr = cluster_radius * plane.get_normal().length();
+        if (dist > rr) {
+          outside = true;
+          break;
+        } else if (dist > -rr) {
+          inside = false;
+        }
+      }
+      if (outside) {
+        continue;
+      }
+
+      if (inside && !cluster._any_singular) {
+        for (uint32_t ii = cluster._begin; ii < cluster._end; ++ii) {
+          results[_cluster_items[ii]] = result_inside;
+        }
+      } else if (inside || cluster._second == 0) {
+        for (uint32_t ii = cluster._begin; ii < cluster._end; ++ii) {
+          uint32_t i = _cluster_items[ii];
+          results[i] = test_sphere(m, n, i, center, radius, planes, num_planes);
+        }
+      } else {
+        nassertr(sp + 2 <= max_cluster_depth + 1, false);
+        stack[sp++] = cluster._second;
+        stack[sp++] = ci + 1;
+      }
+    }
+    return true;
+  }
+
+  size_t i = 0;
+
+#ifdef INSTANCELIST_USE_SSE2
+  const __m128 cx = _mm_set1_ps(center[0]);
+  const __m128 cy = _mm_set1_ps(center[1]);
+  const __m128 cz = _mm_set1_ps(center[2]);
+  const __m128 r = _mm_set1_ps(radius);
+  const __m128 threshold = _mm_set1_ps(det_threshold);
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128 m00 = _mm_loadu_ps(m + MC_00 * n + i);
+    __m128 m01 = _mm_loadu_ps(m + MC_01 * n + i);
+    __m128 m02 = _mm_loadu_ps(m + MC_02 * n + i);
+    __m128 m10 = _mm_loadu_ps(m + MC_10 * n + i);
+    __m128 m11 = _mm_loadu_ps(m + MC_11 * n + i);
+    __m128 m12 = _mm_loadu_ps(m + MC_12 * n + i);
+    __m128 m20 = _mm_loadu_ps(m + MC_20 * n + i);
+    __m128 m21 = _mm_loadu_ps(m + MC_21 * n + i);
+    __m128 m22 = _mm_loadu_ps(m + MC_22 * n + i);
+    __m128 det = _mm_loadu_ps(m + MC_det * n + i);
+
+    // Transform the center of the sphere by the instance matrices.
+    __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, m00), _mm_mul_ps(cy, m10)),
+                           _mm_add_ps(_mm_mul_ps(cz, m20), _mm_loadu_ps(m + MC_30 * n + i)));
+    __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, m01), _mm_mul_ps(cy, m11)),
+                           _mm_add_ps(_mm_mul_ps(cz, m21), _mm_loadu_ps(m + MC_31 * n + i)));
+    __m128 pz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, m02), _mm_mul_ps(cy, m12)),
+                           _mm_add_ps(_mm_mul_ps(cz, m22), _mm_loadu_ps(m + MC_32 * n + i)));
+
+    __m128 outside = _mm_cmple_ps(_mm_andnot_ps(sign_mask, det), threshold);
+    __m128 partial = _mm_setzero_ps();
+
+    for (size_t pi = 0; pi < num_planes; ++pi) {
+      const LPlane &plane = planes[pi];
+      __m128 a = _mm_set1_ps(plane[0]);
+      __m128 b = _mm_set1_ps(plane[1]);
+      __m128 c = _mm_set1_ps(plane[2]);
+      __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, px), _mm_mul_ps(b, py)),
+                               _mm_add_ps(_mm_mul_ps(c, pz), _mm_set1_ps(plane[3])));
+
+      // The radius scales with the length of the plane normal brought into
+      // the space of the instance.
+      __m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, a), _mm_mul_ps(m01, b)), _mm_mul_ps(m02, c));
+      __m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, a), _mm_mul_ps(m11, b)), _mm_mul_ps(m12, c));
+      __m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, a), _mm_mul_ps(m21, b)), _mm_mul_ps(m22, c));
+      __m128 len_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+      __m128 rr = _mm_mul_ps(r, _mm_sqrt_ps(len_sq));
+
+      outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, rr));
+      partial = _mm_or_ps(partial, _mm_cmpgt_ps(dist, _mm_xor_ps(rr, sign_mask)));
+    }
+
+    int outside_bits = _mm_movemask_ps(outside);
+    int partial_bits = _mm_movemask_ps(partial);
+    for (int j = 0; j < 4; ++j) {
+      results[i + j] = (outside_bits & (1 << j)) ? result_outside :
+                       (partial_bits & (1 << j)) ? result_partial : result_inside;
+    }
+  }
+#endif
+
+  for (; i < n; ++i) {
+    results[i] = test_sphere(m, n, i, center, radius, planes, num_planes);
+  }
+
+  return true;
+}
+
+/**
+ * Computes, for each instance, the squared distance from the origin of the
+ * indicated point, as transformed by the instance and then by the indicated
+ * matrix, and stores it in results, which must have room for size() entries.
+ * This is used by LODNode to pick a switch level for each of the instances.
+ *
+ * Returns false if this can't be done because some of the transforms are not
+ * affine, or instance-list-soa is off, in which case the caller should
+ * compute the distances itself.
+ */
+bool InstanceList::
+get_distances_2(PN_stdfloat *results, const LPoint3 &point,
+                const LMatrix4 &mat) const {
+  if (!instance_list_soa || !is_affine(mat) || !fill_matrices()) {
+    return false;
+  }
+
+  const PN_stdfloat *m = _matrices.data();
+  size_t n = _num_matrices;
+  size_t i = 0;
+
+#ifdef INSTANCELIST_USE_SSE2
+  const __m128 cx = _mm_set1_ps(point[0]);
+  const __m128 cy = _mm_set1_ps(point[1]);
+  const __m128 cz = _mm_set1_ps(point[2]);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_loadu_ps(m + MC_00 * n + i)),
+                                      _mm_mul_ps(cy, _mm_loadu_ps(m + MC_10 * n + i))),
+                           _mm_add_ps(_mm_mul_ps(cz, _mm_loadu_ps(m + MC_20 * n + i)),
+                                      _mm_loadu_ps(m + MC_30 * n + i)));
+    __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_loadu_ps(m + MC_01 * n + i)),
+                                      _mm_mul_ps(cy, _mm_loadu_ps(m + MC_11 * n + i))),
+                           _mm_add_ps(_mm_mul_ps(cz, _mm_loadu_ps(m + MC_21 * n + i)),
+                                      _mm_loadu_ps(m + MC_31 * n + i)));
+    __m128 pz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_loadu_ps(m + MC_02 * n + i)),
+                                      _mm_mul_ps(cy, _mm_loadu_ps(m + MC_12 * n + i))),
+                           _mm_add_ps(_mm_mul_ps(cz, _mm_loadu_ps(m + MC_22 * n + i)),
+                                      _mm_loadu_ps(m + MC_32 * n + i)));
+
+    __m128 qx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(mat(0, 0))),
+                                      _mm_mul_ps(py, _mm_set1_ps(mat(1, 0)))),
+                           _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(mat(2, 0))),
+                                      _mm_set1_ps(mat(3, 0))));
+    __m128 qy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(mat(0, 1))),
+                                      _mm_mul_ps(py, _mm_set1_ps(mat(1, 1)))),
+                           _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(mat(2, 1))),
+                                      _mm_set1_ps(mat(3, 1))));
+    __m128 qz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(mat(0, 2))),
+                                      _mm_mul_ps(py, _mm_set1_ps(mat(1, 2)))),
+                           _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(mat(2, 2))),
+                                      _mm_set1_ps(mat(3, 2))));
+
+    _mm_storeu_ps(results + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                                          _mm_mul_ps(qz, qz)));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    LPoint3 p(point[0] * m[MC_00 * n + i] + point[1] * m[MC_10 * n + i] + point[2] * m[MC_20 * n + i] + m[MC_30 * n + i],
+              point[0] * m[MC_01 * n + i] + point[1] * m[MC_11 * n + i] + point[2] * m[MC_21 * n + i] + m[MC_31 * n + i],
+              point[0] * m[MC_02 * n + i] + point[1] * m[MC_12 * n + i] + point[2] * m[MC_22 * n + i] + m[MC_32 * n + i]);
+    LPoint3 q = p * mat;
+    results[i] = q.dot(q);
+  }
+
+  return true;
+}
+
 /**
  *
  */
@@ -211,3 +602,265 @@ fillin(DatagramIterator &scan, BamReader *manager) {
 
   _cached_array.clear();
 }
+
+/**
+ * Creates a TransformState for each of the instances of a lazy list.
+ */
+void InstanceList::
+do_materialize() const {
+  LightMutexHolder holder(_lock);
+  if (!_lazy.load(std::memory_order_relaxed)) {
+    // Another thread beat us to it.
+    return;
+  }
+
+  const PN_stdfloat *m = _matrices.data();
+  size_t n = _num_matrices;
+  _instances.clear();
+  _instances.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    _instances.push_back(Instance(TransformState::make_mat(LMatrix4(
+      m[MC_00 * n + i], m[MC_01 * n + i], m[MC_02 * n + i], 0,
+      m[MC_10 * n + i], m[MC_11 * n + i], m[MC_12 * n + i], 0,
+      m[MC_20 * n + i], m[MC_21 * n + i], m[MC_22 * n + i], 0,
+      m[MC_30 * n + i], m[MC_31 * n + i], m[MC_32 * n + i], 1))));
+  }
+
+  _lazy.store(false, std::memory_order_release);
+}
+
+/**
+ * Makes sure that the structure-of-arrays copy of the instance matrices is
+ * filled in.  Returns true if all of the instance matrices are affine, and
+ * can therefore be used, or false otherwise.
+ */
+bool InstanceList::
+fill_matrices() const {
+  if (_matrices_valid.load(std::memory_order_acquire)) {
+    return _all_affine;
+  }
+
+  LightMutexHolder holder(_lock);
+  if (_matrices_valid.load(std::memory_order_relaxed)) {
+    return _all_affine;
+  }
+
+  // A lazy list always has valid matrices.
+  nassertr(!_lazy.load(std::memory_order_relaxed), false);
+
+  size_t n = _instances.size();
+  _matrices.resize(n * MC_num_components);
+  _all_affine = true;
+
+  PN_stdfloat *m = _matrices.data();
+  for (size_t i = 0; i < n; ++i) {
+    const LMatrix4 &mat = _instances[i].get_mat();
+    if (!is_affine(mat)) {
+      _all_affine = false;
+    }
+    m[MC_00 * n + i] = mat(0, 0);
+    m[MC_01 * n + i] = mat(0, 1);
+    m[MC_02 * n + i] = mat(0, 2);
+    m[MC_10 * n + i] = mat(1, 0);
+    m[MC_11 * n + i] = mat(1, 1);
+    m[MC_12 * n + i] = mat(1, 2);
+    m[MC_20 * n + i] = mat(2, 0);
+    m[MC_21 * n + i] = mat(2, 1);
+    m[MC_22 * n + i] = mat(2, 2);
+    m[MC_30 * n + i] = mat(3, 0);
+    m[MC_31 * n + i] = mat(3, 1);
+    m[MC_32 * n + i] = mat(3, 2);
+    m[MC_det * n + i] = mat.get_upper_3().determinant();
+  }
+
+  _num_matrices = n;
+  _matrices_valid.store(true, std::memory_order_release);
+  return _all_affine;
+}
+
+/**
+ * Returns true if the last column of the matrix is (0, 0, 0, 1), so that it
+ * can be stored in the structure-of-arrays copy of the instance matrices.
+ */
+bool InstanceList::
+is_affine(const LMatrix4 &mat) {
+  return IS_NEARLY_EQUAL(mat(0, 3), 0.0f) &&
+         IS_NEARLY_EQUAL(mat(1, 3), 0.0f) &&
+         IS_NEARLY_EQUAL(mat(2, 3), 0.0f) &&
+         IS_NEARLY_EQUAL(mat(3, 3), 1.0f);
+}
+
+/**
+ * Stores the product of the two affine matrices, each given as an array of
+ * MatrixComponent values, into entry i of the structure-of-arrays dest with
+ * n entries per component.  The inner matrix is applied first.
+ */
+void InstanceList::
+compose_affine(PN_stdfloat *dest, size_t n, size_t i,
+               const PN_stdfloat *inner, const PN_stdfloat *outer) {
+  for (int row = 0; row < 4; ++row) {
+    PN_stdfloat r0 = inner[row * 3 + 0];
+    PN_stdfloat r1 = inner[row * 3 + 1];
+    PN_stdfloat r2 = inner[row * 3 + 2];
+    for (int col = 0; col < 3; ++col) {
+      PN_stdfloat value = r0 * outer[MC_00 + col] + r1 * outer[MC_10 + col] + r2 * outer[MC_20 + col];
+      if (row == 3) {
+        value += outer[MC_30 + col];
+      }
+      dest[(row * 3 + col) * n + i] = value;
+    }
+  }
+  dest[MC_det * n + i] = inner[MC_det] * outer[MC_det];
+}
+
+/**
+ * Tests the sphere as transformed by instance i of the indicated
+ * structure-of-arrays matrices against the planes.  This is the
+ * one-at-a-time version of test_spheres().
+ */
+unsigned char InstanceList::
+test_sphere(const PN_stdfloat *m, size_t n, size_t i, const LPoint3 &center,
+            PN_stdfloat radius, const LPlane *planes, size_t num_planes) {
+  PN_stdfloat m00 = m[MC_00 * n + i], m01 = m[MC_01 * n + i], m02 = m[MC_02 * n + i];
+  PN_stdfloat m10 = m[MC_10 * n + i], m11 = m[MC_11 * n + i], m12 = m[MC_12 * n + i];
+  PN_stdfloat m20 = m[MC_20 * n + i], m21 = m[MC_21 * n + i], m22 = m[MC_22 * n + i];
+
+  if (cabs(m[MC_det * n + i]) <= det_threshold) {
+    return result_outside;
+  }
+
+  LPoint3 p(center[0] * m00 + center[1] * m10 + center[2] * m20 + m[MC_30 * n + i],
+            center[0] * m01 + center[1] * m11 + center[2] * m21 + m[MC_31 * n + i],
+            center[0] * m02 + center[1] * m12 + center[2] * m22 + m[MC_32 * n + i]);
+
+  unsigned char result = result_inside;
+  for (size_t pi = 0; pi < num_planes; ++pi) {
+    const LPlane &plane = planes[pi];
+    PN_stdfloat dist = plane.dist_to_plane(p);
+    LVector3 normal(m00 * plane[0] + m01 * plane[1] + m02 * plane[2],
+                    m10 * plane[0] + m11 * plane[1] + m12 * plane[2],
+                    m20 * plane[0] + m21 * plane[1] + m22 * plane[2]);
+    PN_stdfloat rr = radius * normal.length();
+    if (dist > rr) {
+      return result_outside;
+    } else if (dist > -rr) {
+      result = result_partial;
+    }
+  }
+  return result;
+}
+
+/**
+ * Makes sure that the cluster hierarchy is built, if the list is large enough
+ * to benefit from one.  Returns true if there is a cluster hierarchy, false
+ * otherwise.  fill_matrices() must have returned true first.
+ */
+bool InstanceList::
+fill_clusters() const {
+  if (_clusters_valid.load(std::memory_order_acquire)) {
+    return !_clusters.empty();
+  }
+
+  int leaf_size = instance_list_cluster_size;
+  if (leaf_size <= 0 || _num_matrices < (size_t)leaf_size * 4) {
+    return false;
+  }
+
+  LightMutexHolder holder(_lock);
+  if (_clusters_valid.load(std::memory_order_relaxed)) {
+    return !_clusters.empty();
+  }
+
+  size_t n = _num_matrices;
+  _cluster_items.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    _cluster_items[i] = (uint32_t)i;
+  }
+
+  // Each leaf has at least leaf_size / 2 instances.
+  _clusters.clear();
+  _clusters.reserve(n / std::max(leaf_size / 2, 1) * 2 + 1);
+  r_build_clusters(0, n, (size_t)leaf_size);
+
+  _clusters_valid.store(true, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Appends a cluster for the instances in the range [begin, end) of
+ * _cluster_items, followed by all of its descendants.
+ */
+void InstanceList::
+r_build_clusters(size_t begin, size_t end, size_t leaf_size) const {
+  nassertv(end > begin);
+
+  const PN_stdfloat *m = _matrices.data();
+  size_t n = _num_matrices;
+
+  LPoint3 min_point, max_point;
+  PN_stdfloat max_scale_2 = 0;
+  bool any_singular = false;
+  for (size_t ii = begin; ii < end; ++ii) {
+    uint32_t i = _cluster_items[ii];
+    LPoint3 pos(m[MC_30 * n + i], m[MC_31 * n + i], m[MC_32 * n + i]);
+    if (ii == begin) {
+      min_point = pos;
+      max_point = pos;
+    } else {
+      min_point = min_point.fmin(pos);
+      max_point = max_point.fmax(pos);
+    }
+
+    // The Frobenius norm bounds how much the matrix can stretch a vector.
+    PN_stdfloat scale_2 = 0;
+    for (int c = MC_00; c <= MC_22; ++c) {
+      scale_2 += m[c * n + i] * m[c * n + i];
+    }
+    max_scale_2 = std::max(max_scale_2, scale_2);
+
+    if (cabs(m[MC_det * n + i]) <= det_threshold) {
+      any_singular = true;
+    }
+  }
+
+  size_t ci = _clusters.size();
+  _clusters.push_back(Cluster());
+  {
+    Cluster &cluster = _clusters[ci];
+    cluster._center = (min_point + max_point) * 0.5f;
+    cluster._radius = (max_point - min_point).length() * 0.5f;
+    cluster._max_scale = csqrt(max_scale_2);
+    cluster._begin = (uint32_t)begin;
+    cluster._end = (uint32_t)end;
+    cluster._second = 0;
+    cluster._any_singular = any_singular;
+  }
+
+  if (end - begin <= leaf_size) {
+    return;
+  }
+
+  // Split at the median instance along the axis in which the instances are
+  // most spread out.
+  LVector3 extent = max_point - min_point;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+  const PN_stdfloat *pos = m + (MC_30 + axis) * n;
+
+  size_t mid = begin + (end - begin) / 2;
+  std::nth_element(_cluster_items.begin() + begin,
+                   _cluster_items.begin() + mid,
+                   _cluster_items.begin() + end,
+    [pos] (uint32_t a, uint32_t b) {
+      return pos[a] < pos[b];
+    });
+
+  r_build_clusters(begin, mid, leaf_size);
+  _clusters[ci]._second = (uint32_t)_clusters.size();
+  r_build_clusters(mid, end, leaf_size);
+}
@@ -19,6 +19,9 @@
 #include "transformState.h"
 #include "pvector.h"
 #include "geomVertexArrayData.h"
+#include "plane.h"
+#include "lightMutex.h"
+#include "patomic.h"
 
 class BitArray;
 class FactoryParams;
@@ -98,6 +101,7 @@ public:
   typedef Instances::const_iterator const_iterator;
 
   INLINE bool empty() const;
+  INLINE bool is_lazy() const;
 
   INLINE iterator begin();
   INLINE const_iterator begin() const;
@@ -109,16 +113,84 @@ public:
 
   CPT(InstanceList) without(const BitArray &mask) const;
 
+  static CPT(InstanceList) compose(const InstanceList *outer,
+                                   const InstanceList *inner);
+  static CPT(InstanceList) compose(const InstanceList *outer,
+                                   const TransformState *inner);
+
+  bool test_spheres(unsigned char *results, const LPoint3 &center,
+                    PN_stdfloat radius, const LPlane *planes,
+                    size_t num_planes) const;
+  bool get_distances_2(PN_stdfloat *results, const LPoint3 &point,
+                       const LMatrix4 &mat) const;
+
   CPT(GeomVertexArrayData) get_array_data(const GeomVertexArrayFormat *format) const;
 
   virtual void output(std::ostream &out) const;
   virtual void write(std::ostream &out, int indent_level) const;
 
 private:
-  Instances _instances;
+  INLINE void materialize() const;
+  INLINE void modify();
+  void do_materialize() const;
+  bool fill_matrices() const;
+  bool fill_clusters() const;
+  static unsigned char test_sphere(const PN_stdfloat *m, size_t n, size_t i,
+                                   const LPoint3 &center, PN_stdfloat radius,
+                                   const LPlane *planes, size_t num_planes);
+  void r_build_clusters(size_t begin, size_t end, size_t leaf_size) const;
+  static bool is_affine(const LMatrix4 &mat);
+  static void compose_affine(PN_stdfloat *dest, size_t n, size_t i,
+                             const PN_stdfloat *inner,
+                             const PN_stdfloat *outer);
+
+private:
+  mutable Instances _instances;
 
   mutable CPT(GeomVertexArrayData) _cached_array;
 
+  // A structure-of-arrays copy of the instance matrices, used to cull many
+  // instances at once and to compose instance lists without creating a
+  // TransformState for every instance.  Each instance is stored as the 3x4
+  // affine part of its matrix plus the determinant of the upper 3x3, with
+  // one array of _num_matrices values per component.  A lazy list has only
+  // this, and builds _instances the first time it is needed.
+  enum MatrixComponent {
+    MC_00, MC_01, MC_02,
+    MC_10, MC_11, MC_12,
+    MC_20, MC_21, MC_22,
+    MC_30, MC_31, MC_32,
+    MC_det,
+    MC_num_components,
+  };
+  mutable pvector<PN_stdfloat> _matrices;
+  mutable size_t _num_matrices = 0;
+  mutable patomic<bool> _matrices_valid {false};
+  mutable patomic<bool> _lazy {false};
+  mutable bool _all_affine = true;
+
+  // A hierarchy of clusters of instances that are near each other, so that
+  // whole clusters can be culled or accepted at once.  It is stored in
+  // depth-first order; each cluster covers the range [_begin, _end) of
+  // _cluster_items, which lists the instance indices.  The children of an
+  // interior cluster are the cluster following it and the one at _second.
+  class Cluster {
+  public:
+    LPoint3 _center;
+    PN_stdfloat _radius;
+    PN_stdfloat _max_scale;
+    uint32_t _begin;
+    uint32_t _end;
+    uint32_t _second;
+    bool _any_singular;
+  };
+  static const int max_cluster_depth = 64;
+  mutable pvector<Cluster> _clusters;
+  mutable pvector<uint32_t> _cluster_items;
+  mutable patomic<bool> _clusters_valid {false};
+
+  mutable LightMutex _lock;
+
 public:
   static void register_with_read_factory();
   virtual void write_datagram(BamWriter *manager, Datagram &dg) override;
@@ -16,6 +16,8 @@
 #include "boundingSphere.h"
 #include "cullTraverserData.h"
 #include "cullPlanes.h"
+#include "boundingHexahedron.h"
+#include "config_pgraph.h"
 
 TypeHandle InstancedNode::_type_handle;
 TypeHandle InstancedNode::CData::_type_handle;
@@ -208,14 +210,7 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
 
   if (data._instances != nullptr) {
     // We are already under an instanced node.  Create a new combined list.
-    InstanceList *new_list = new InstanceList();
-    new_list->reserve(data._instances->size() * instances->size());
-    for (const InstanceList::Instance &parent_instance : *data._instances) {
-      for (const InstanceList::Instance &this_instance : *instances) {
-        new_list->append(parent_instance.get_transform()->compose(this_instance.get_transform()));
-      }
-    }
-    instances = new_list;
+    instances = InstanceList::compose(data._instances, instances);
   }
 
   if (data._view_frustum != nullptr || data._cull_planes != nullptr) {
@@ -223,9 +218,11 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     BitArray culled_instances;
     culled_instances.set_range(0, instances->size());
 
-    for (size_t ii = 0; ii < instances->size(); ++ii) {
-      if (data.is_instance_in_view((*instances)[ii].get_transform(), trav->get_camera_mask())) {
-        culled_instances.clear_bit(ii);
+    if (!instance_list_soa || !cull_instances(culled_instances, instances, trav, data)) {
+      for (size_t ii = 0; ii < instances->size(); ++ii) {
+        if (data.is_instance_in_view((*instances)[ii].get_transform(), trav->get_camera_mask())) {
+          culled_instances.clear_bit(ii);
+        }
       }
     }
 
@@ -258,6 +255,97 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
   return true;
 }
 
+/**
+ * Implements cull_callback() for many instances at a time, by testing a
+ * bounding sphere around the visible children against the view frustum for
+ * blocks of instances.  Only the instances for which this is inconclusive are
+ * tested against the frustum individually.  Clears the bits in
+ * culled_instances for the instances that are in view.
+ *
+ * Like is_instance_in_view(), this ignores the clip planes, which are only
+ * applied to the children themselves.
+ *
+ * Returns false if this can't be done, in which case the caller should test
+ * each of the instances itself.
+ */
+bool InstancedNode::
+cull_instances(BitArray &culled_instances, const InstanceList *instances,
+               CullTraverser *trav, CullTraverserData &data) const {
+  const BoundingHexahedron *frustum = nullptr;
+  if (data._view_frustum != nullptr) {
+    frustum = data._view_frustum->as_bounding_hexahedron();
+    if (frustum == nullptr || frustum->is_empty()) {
+      return false;
+    }
+  }
+
+  // Find a sphere around the children whose draw mask matches the camera.
+  // The draw mask doesn't depend on the instance, so an instance can only be
+  // in view if at least one of these children is.
+  BoundingSphere children_bounds;
+  bool any_visible = false;
+  PandaNode::Children children = data.node_reader()->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    const PandaNode::DownConnection &child = children.get_child_connection(i);
+    if (!child.compare_draw_mask(data._draw_mask, trav->get_camera_mask())) {
+      continue;
+    }
+    any_visible = true;
+
+    if (frustum != nullptr) {
+      const GeometricBoundingVolume *child_gbv = child.get_bounds();
+      nassertr(child_gbv != nullptr, false);
+      if (child_gbv->is_infinite()) {
+        return false;
+      }
+      children_bounds.extend_by(child_gbv);
+    }
+  }
+
+  if (!any_visible) {
+    // All instances are culled.
+    return true;
+  }
+
+  if (frustum == nullptr) {
+    // There is no frustum, so every instance is in view.
+    culled_instances.clear();
+    return true;
+  }
+
+  if (children_bounds.is_empty()) {
+    // There is nothing to see in any of the instances.
+    return true;
+  }
+
+  pvector<LPlane> planes;
+  int num_planes = frustum->get_num_planes();
+  for (int i = 0; i < num_planes; ++i) {
+    planes.push_back(frustum->get_plane(i));
+  }
+
+  size_t num_instances = instances->size();
+  pvector<unsigned char> results(num_instances);
+  if (!instances->test_spheres(results.data(), children_bounds.get_center(),
+                               children_bounds.get_radius(),
+                               planes.data(), planes.size())) {
+    return false;
+  }
+
+  for (size_t ii = 0; ii < num_instances; ++ii) {
+    int result = results[ii];
+    if (result == BoundingVolume::IF_no_intersection) {
+      continue;
+    }
+    if ((result & BoundingVolume::IF_all) != 0 ||
+        data.is_instance_in_view((*instances)[ii].get_transform(), trav->get_camera_mask())) {
+      culled_instances.clear_bit(ii);
+    }
+  }
+  return true;
+}
+
 /**
  *
  */
@@ -74,6 +74,11 @@ protected:
                                        int pipeline_stage,
                                        Thread *current_thread) const override;
 
+private:
+  bool cull_instances(BitArray &culled_instances,
+                      const InstanceList *instances,
+                      CullTraverser *trav, CullTraverserData &data) const;
+
 private:
   // This is the data that must be cycled between pipeline stages.
   class EXPCL_PANDA_PGRAPH CData final : public CycleData {
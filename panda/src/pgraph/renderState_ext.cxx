@@ -174,13 +174,14 @@ get_states() {
   extern struct Dtool_PyTypedObject Dtool_RenderState;
   LightReMutexHolder holder(*RenderState::_states_lock);
 
-  size_t num_states = RenderState::_states.get_num_entries();
+  RenderState::StateList states;
+  RenderState::get_all_states(states);
+
+  size_t num_states = states.size();
   PyObject *list = PyList_New(num_states);
   size_t i = 0;
 
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
+  for (const RenderState *state : states) {
     state->ref();
     PyObject *a =
       DTool_CreatePyInstanceTyped((void *)state, Dtool_RenderState,
@@ -203,9 +204,9 @@ get_unused_states() {
   LightReMutexHolder holder(*RenderState::_states_lock);
 
   PyObject *list = PyList_New(0);
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
+  RenderState::StateList states;
+  RenderState::get_all_states(states);
+  for (const RenderState *state : states) {
     if (state->get_cache_ref_count() == state->get_ref_count()) {
       state->ref();
       PyObject *a =
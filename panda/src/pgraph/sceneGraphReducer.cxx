@@ -19,9 +19,11 @@
 #include "pointerTo.h"
 #include "plist.h"
 #include "pmap.h"
+#include "pset.h"
 #include "geomNode.h"
 #include "config_gobj.h"
 #include "thread.h"
+#include "workerThreadPool.h"
 
 PStatCollector SceneGraphReducer::_flatten_collector("*:Flatten:flatten");
 PStatCollector SceneGraphReducer::_apply_collector("*:Flatten:apply");
@@ -92,17 +94,20 @@ flatten(PandaNode *root, int combine_siblings_bits) {
   do {
     num_pass_nodes = 0;
 
-    // Get a copy of the children list, so we don't have to worry about self-
-    // modifications.
-    PandaNode::Children cr = root->get_children();
-
-    // Now visit each of the children in turn.
-    int num_children = cr.get_num_children();
-    for (int i = 0; i < num_children; i++) {
-      PT(PandaNode) child_node = cr.get_child(i);
-      num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
+    // Find the subtrees that can be flattened in parallel, once for the
+    // whole pass.
+    if (get_flatten_pool() != nullptr) {
+      PandaNode::Children cr = root->get_children();
+      int num_children = cr.get_num_children();
+      for (int i = 0; i < num_children; ++i) {
+        r_count_unshared_nodes(cr.get_child(i));
+      }
     }
 
+    // Visit each of the children in turn.
+    num_pass_nodes += flatten_children(root, combine_siblings_bits, true);
+    _unshared_counts.clear();
+
     if (combine_siblings_bits != 0 &&
         root->get_num_children() >= 2 &&
         root->safe_to_combine_children()) {
@@ -183,7 +188,13 @@ unify(PandaNode *root, bool preserve_order) {
   if (_gsg != nullptr) {
     max_indices = std::min(max_indices, _gsg->get_max_vertices_per_primitive());
   }
-  r_unify(root, max_indices, preserve_order);
+
+  WorkerThreadPool *pool = get_flatten_pool();
+  if (pool != nullptr) {
+    unify_parallel(root, max_indices, preserve_order, pool);
+  } else {
+    r_unify(root, max_indices, preserve_order);
+  }
 }
 
 /**
@@ -368,12 +379,38 @@ r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
 }
 
 
+/**
+ * Returns the worker thread pool that should be used to divide up the work of
+ * flattening, or NULL if it should all be done on the current thread.
+ */
+WorkerThreadPool *SceneGraphReducer::
+get_flatten_pool() {
+#ifdef THREADED_PIPELINE
+  // Without a true threaded pipeline, the scene graph may not be safely
+  // modified from several threads at once.
+  if (parallel_flatten) {
+    WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+    if (pool->is_parallel()) {
+      return pool;
+    }
+  }
+#endif
+  return nullptr;
+}
+
 /**
  * The recursive implementation of flatten().
+ *
+ * If deferred_parent is not NULL, and parent_node is collapsed with its only
+ * child, the resulting node is stored there instead of taking the place of
+ * parent_node under grandparent_node; the caller must then call
+ * replace_node() on it.  This allows several children of grandparent_node to
+ * be flattened at once.
  */
 int SceneGraphReducer::
 r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
-          int combine_siblings_bits) {
+          int combine_siblings_bits, bool allow_parallel,
+          PT(PandaNode) *deferred_parent) {
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
       << "SceneGraphReducer::r_flatten(" << *grandparent_node << ", "
@@ -420,14 +457,8 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
     }
 
     // First, recurse on each of the children.
-    {
-      PandaNode::Children cr = parent_node->get_children();
-      int num_children = cr.get_num_children();
-      for (int i = 0; i < num_children; i++) {
-        PT(PandaNode) child_node = cr.get_child(i);
-        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
-      }
-    }
+    num_nodes += flatten_children(parent_node, combine_siblings_bits,
+                                  allow_parallel);
 
     // Now that the above loop has removed some children, the child list saved
     // above is no longer accurate, so hereafter we must ask the node for its
@@ -451,7 +482,8 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
         // Ok, do it.
         parent_node->remove_child(child_node);
 
-        if (do_flatten_child(grandparent_node, parent_node, child_node)) {
+        if (do_flatten_child(grandparent_node, parent_node, child_node,
+                             deferred_parent)) {
           // Done!
           num_nodes++;
         } else {
@@ -487,6 +519,136 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
   return num_nodes;
 }
 
+/**
+ * Calls r_flatten() on each of the children of the indicated node, and
+ * returns the total number of nodes removed.
+ *
+ * If allow_parallel is true and parallel-flatten is enabled, the children
+ * whose subtrees are not shared with any other part of the graph may be
+ * flattened on the threads of the worker thread pool.  Each of those subtrees
+ * is flattened serially by a single job, and any changes to parent_node
+ * itself are made afterwards in the original order of the children, so the
+ * result is the same as if they had been flattened one at a time.
+ */
+int SceneGraphReducer::
+flatten_children(PandaNode *parent_node, int combine_siblings_bits,
+                 bool allow_parallel) {
+  int num_nodes = 0;
+
+  // Get a copy of the children list, so we don't have to worry about self-
+  // modifications.
+  PandaNode::Children cr = parent_node->get_children();
+  int num_children = cr.get_num_children();
+
+  WorkerThreadPool *pool = nullptr;
+  if (allow_parallel && num_children >= 2 &&
+      parent_node->safe_to_flatten_below()) {
+    pool = get_flatten_pool();
+  }
+
+  // Find the children that can be handed off to another thread.  A subtree
+  // in which every node has only the one parent can't be reached from
+  // anywhere else in the graph, so it can be modified independently.
+  // Nodes that were created during this pass were not counted, so they stay
+  // on this thread.
+  pvector<int> unshared;
+  if (pool != nullptr) {
+    int total_nodes = 0;
+    for (int i = 0; i < num_children; ++i) {
+      UnsharedCounts::const_iterator ci = _unshared_counts.find(cr.get_child(i));
+      if (ci != _unshared_counts.end() && (*ci).second >= 0) {
+        unshared.push_back(i);
+        total_nodes += (*ci).second;
+      }
+    }
+    if (unshared.size() < 2 || total_nodes < parallel_flatten_min_nodes) {
+      unshared.clear();
+    }
+  }
+
+  if (unshared.empty()) {
+    // Visit each of the children in turn.
+    for (int i = 0; i < num_children; i++) {
+      PT(PandaNode) child_node = cr.get_child(i);
+      num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits,
+                             allow_parallel);
+    }
+    return num_nodes;
+  }
+
+  size_t num_unshared = unshared.size();
+  pvector<int> unshared_nodes(num_unshared, 0);
+  pvector<PT(PandaNode) > new_children(num_unshared);
+
+  pool->parallel_for(num_unshared,
+    [&] (size_t n, Thread *current_thread) {
+      // We don't divide the work any further than this.
+      unshared_nodes[n] =
+        r_flatten(parent_node, cr.get_child(unshared[n]),
+                  combine_siblings_bits, false, &new_children[n]);
+    });
+
+  // Now visit the children in order, putting the results of the parallel
+  // jobs in place, and flattening the remaining children as usual.
+  size_t n = 0;
+  for (int i = 0; i < num_children; i++) {
+    PT(PandaNode) child_node = cr.get_child(i);
+    if (n < num_unshared && unshared[n] == i) {
+      num_nodes += unshared_nodes[n];
+      if (new_children[n] != nullptr) {
+        new_children[n]->replace_node(child_node);
+      }
+      ++n;
+    } else {
+      num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits,
+                             allow_parallel);
+    }
+  }
+
+  return num_nodes;
+}
+
+/**
+ * Returns the number of nodes at the indicated node and below, including
+ * stashed nodes, or -1 if any of them has more than one parent.  The result
+ * is also recorded in _unshared_counts for this node and each node below it,
+ * so that each node is only visited once, even if it has several parents.
+ */
+int SceneGraphReducer::
+r_count_unshared_nodes(PandaNode *node) {
+  UnsharedCounts::const_iterator ci = _unshared_counts.find(node);
+  if (ci != _unshared_counts.end()) {
+    return (*ci).second;
+  }
+
+  int count = (node->get_num_parents() == 1) ? 1 : -1;
+
+  PandaNode::Children cr = node->get_children();
+  int num_children = cr.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    int child_count = r_count_unshared_nodes(cr.get_child(i));
+    if (child_count < 0) {
+      count = -1;
+    } else if (count >= 0) {
+      count += child_count;
+    }
+  }
+
+  PandaNode::Stashed stashed = node->get_stashed();
+  int num_stashed = stashed.get_num_stashed();
+  for (int i = 0; i < num_stashed; ++i) {
+    int child_count = r_count_unshared_nodes(stashed.get_stashed(i));
+    if (child_count < 0) {
+      count = -1;
+    } else if (count >= 0) {
+      count += child_count;
+    }
+  }
+
+  _unshared_counts[node] = count;
+  return count;
+}
+
 class SortByState {
 public:
   INLINE bool
@@ -646,10 +808,13 @@ consider_siblings(PandaNode *parent_node, PandaNode *child1,
  * Collapses together the indicated parent node and child node and leaves the
  * result attached to the grandparent.  The return value is true if the node
  * is successfully collapsed, false if we chickened out.
+ *
+ * If deferred_parent is not NULL, the resulting node is stored there instead,
+ * and the caller is responsible for putting it in place of parent_node.
  */
 bool SceneGraphReducer::
 do_flatten_child(PandaNode *grandparent_node, PandaNode *parent_node,
-                 PandaNode *child_node) {
+                 PandaNode *child_node, PT(PandaNode) *deferred_parent) {
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
       << "Collapsing " << *parent_node << " and " << *child_node << "\n";
@@ -668,7 +833,11 @@ do_flatten_child(PandaNode *grandparent_node, PandaNode *parent_node,
   choose_name(new_parent, parent_node, child_node);
 
   new_parent->replace_node(child_node);
-  new_parent->replace_node(parent_node);
+  if (deferred_parent != nullptr) {
+    *deferred_parent = new_parent;
+  } else {
+    new_parent->replace_node(parent_node);
+  }
 
   return true;
 }
@@ -829,7 +998,14 @@ r_collect_vertex_data(PandaNode *node, int collect_bits,
         r_collect_vertex_data(children.get_child(i), collect_bits, new_transformer, format_only);
     }
 
-    num_adjusted += new_transformer.finish_collect(format_only);
+    if (get_flatten_pool() != nullptr) {
+      // The collected vertex datas are combined along with all of the
+      // others, by the final call to finish_collect(), which divides them
+      // between the threads.
+      transformer.take_collected(new_transformer);
+    } else {
+      num_adjusted += new_transformer.finish_collect(format_only);
+    }
 
   } else {
     // Keep the same collection.
@@ -913,6 +1089,86 @@ r_unify(PandaNode *node, int max_indices, bool preserve_order) {
   Thread::consider_yield();
 }
 
+/**
+ * A parallel implementation of unify(), which unifies each GeomNode on one of
+ * the threads of the indicated pool.  GeomNodes that appear more than once in
+ * the graph, or that share a Geom with another GeomNode, are unified
+ * afterwards on the current thread, so that the result is the same as that of
+ * r_unify().
+ */
+void SceneGraphReducer::
+unify_parallel(PandaNode *root, int max_indices, bool preserve_order,
+               WorkerThreadPool *pool) {
+  pvector<GeomNode *> geom_nodes;
+  r_collect_geom_nodes(root, geom_nodes);
+
+  typedef pmap<GeomNode *, int> NodeCounts;
+  NodeCounts node_counts;
+  for (GeomNode *geom_node : geom_nodes) {
+    ++node_counts[geom_node];
+  }
+
+  // Count the number of different GeomNodes each Geom appears in.
+  typedef pmap<const Geom *, GeomNode *> GeomOwners;
+  GeomOwners geom_owners;
+  pset<GeomNode *> shared_geom_nodes;
+  for (NodeCounts::const_iterator ni = node_counts.begin();
+       ni != node_counts.end();
+       ++ni) {
+    GeomNode *geom_node = (*ni).first;
+    int num_geoms = geom_node->get_num_geoms();
+    for (int i = 0; i < num_geoms; ++i) {
+      std::pair<GeomOwners::iterator, bool> result =
+        geom_owners.insert(GeomOwners::value_type(geom_node->get_geom(i), geom_node));
+      if (!result.second && (*result.first).second != geom_node) {
+        shared_geom_nodes.insert(geom_node);
+        shared_geom_nodes.insert((*result.first).second);
+      }
+    }
+  }
+
+  // The remaining GeomNodes are independent of each other.  Keep them in
+  // traversal order, to make the work division repeatable.
+  pvector<GeomNode *> independent;
+  pvector<GeomNode *> dependent;
+  for (GeomNode *geom_node : geom_nodes) {
+    if (node_counts[geom_node] == 1 &&
+        shared_geom_nodes.find(geom_node) == shared_geom_nodes.end()) {
+      independent.push_back(geom_node);
+    } else {
+      dependent.push_back(geom_node);
+    }
+  }
+
+  pool->parallel_for(independent.size(),
+    [&] (size_t n, Thread *current_thread) {
+      independent[n]->unify(max_indices, preserve_order);
+    });
+
+  for (GeomNode *geom_node : dependent) {
+    geom_node->unify(max_indices, preserve_order);
+  }
+  Thread::consider_yield();
+}
+
+/**
+ * Appends all of the GeomNodes at the indicated node and below to the vector,
+ * in the order visited by r_unify().  A GeomNode that is reached by more than
+ * one path is added once for each path.
+ */
+void SceneGraphReducer::
+r_collect_geom_nodes(PandaNode *node, pvector<GeomNode *> &geom_nodes) {
+  if (node->is_geom_node()) {
+    geom_nodes.push_back(DCAST(GeomNode, node));
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_collect_geom_nodes(children.get_child(i), geom_nodes);
+  }
+}
+
 /**
  * Recursively calls GeomTransformer::register_vertices() on all GeomNodes at
  * the indicated root and below.
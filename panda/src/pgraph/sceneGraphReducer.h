@@ -24,9 +24,12 @@
 #include "pStatTimer.h"
 #include "typedObject.h"
 #include "pointerTo.h"
+#include "pmap.h"
 #include "graphicsStateGuardianBase.h"
 
 class PandaNode;
+class GeomNode;
+class WorkerThreadPool;
 
 /**
  * An interface for simplifying ("flattening") scene graphs by eliminating
@@ -141,12 +144,19 @@ PUBLISHED:
   INLINE void premunge(PandaNode *root, const RenderState *initial_state);
   bool check_live_flatten(PandaNode *node);
 
+public:
+  static WorkerThreadPool *get_flatten_pool();
+
 protected:
   void r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                        int attrib_types, GeomTransformer &transformer);
 
   int r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
-                int combine_siblings_bits);
+                int combine_siblings_bits, bool allow_parallel = true,
+                PT(PandaNode) *deferred_parent = nullptr);
+  int flatten_children(PandaNode *parent_node, int combine_siblings_bits,
+                       bool allow_parallel);
+  int r_count_unshared_nodes(PandaNode *node);
   int flatten_siblings(PandaNode *parent_node,
                        int combine_siblings_bits);
 
@@ -156,7 +166,8 @@ protected:
                          PandaNode *child2);
 
   bool do_flatten_child(PandaNode *grandparent_node,
-                        PandaNode *parent_node, PandaNode *child_node);
+                        PandaNode *parent_node, PandaNode *child_node,
+                        PT(PandaNode) *deferred_parent = nullptr);
 
   PandaNode *do_flatten_siblings(PandaNode *parent_node,
                                  PandaNode *child1, PandaNode *child2);
@@ -175,6 +186,9 @@ protected:
                             GeomTransformer &transformer, bool format_only);
   int r_make_nonindexed(PandaNode *node, int collect_bits);
   void r_unify(PandaNode *node, int max_indices, bool preserve_order);
+  void unify_parallel(PandaNode *root, int max_indices, bool preserve_order,
+                      WorkerThreadPool *pool);
+  void r_collect_geom_nodes(PandaNode *node, pvector<GeomNode *> &geom_nodes);
   void r_register_vertices(PandaNode *node, GeomTransformer &transformer);
   void r_decompose(PandaNode *node);
 
@@ -185,6 +199,11 @@ private:
   PN_stdfloat _combine_radius;
   GeomTransformer _transformer;
 
+  // The result of r_count_unshared_nodes() for each node, which is filled in
+  // at the start of each pass of a parallel flatten().
+  typedef pmap<PT(PandaNode), int> UnsharedCounts;
+  UnsharedCounts _unshared_counts;
+
   static PStatCollector _flatten_collector;
   static PStatCollector _apply_collector;
   static PStatCollector _remove_column_collector;
@@ -27,11 +27,10 @@
 using std::ostream;
 
 LightReMutex *TransformState::_states_lock = nullptr;
-TransformState::States TransformState::_states;
+TransformState::StatesShard *TransformState::_states_shards = nullptr;
 CPT(TransformState) TransformState::_identity_state;
 CPT(TransformState) TransformState::_invalid_state;
 UpdateSeq TransformState::_last_cycle_detect;
-size_t TransformState::_garbage_index = 0;
 bool TransformState::_uniquify_matrix = true;
 
 PStatCollector TransformState::_cache_update_pcollector("*:State Cache:Update");
@@ -757,17 +756,35 @@ unref() const {
     return ReferenceCount::unref();
   }
 
+  if (AtomicAdjust::get(_hash) == H_unknown) {
+    // A state that was never hashed has never been through return_new(), so
+    // it isn't in the cache, and there is no need to compute its hash just to
+    // find the shard it would belong to.
+    return ReferenceCount::unref();
+  }
+
   // Here is the normal refcounting case, with a normal cache, and without
   // garbage collection in effect.  In this case we will pull the object out
   // of the cache when its reference count goes to 0.
 
-  // We always have to grab the lock, since we will definitely need to be
-  // holding it if we happen to drop the reference count to 0. Having to grab
-  // the lock at every call to unref() is a big limiting factor on
-  // parallelization.
+  // Every decrement is made while holding the lock of the shard holding this
+  // state, so that while we hold it, the count may go up but not down.  As
+  // long as this isn't the last reference outside the cache, that is all we
+  // need; the _states_lock is only needed to break a cycle or to remove the
+  // state from the cache.
+  StatesShard &shard = get_states_shard(get_hash());
+  bool break_cycles = auto_break_cycles && uniquify_transforms;
+  {
+    LightMutexHolder shard_holder(shard._lock);
+    int min_count = break_cycles ? get_cache_ref_count() + 1 : 1;
+    if (get_ref_count() > min_count) {
+      return ReferenceCount::unref();
+    }
+  }
+
   LightReMutexHolder holder(*_states_lock);
 
-  if (auto_break_cycles && uniquify_transforms) {
+  if (break_cycles) {
     if (get_cache_ref_count() > 0 &&
         get_ref_count() == get_cache_ref_count() + 1) {
       // If we are about to remove the one reference that is not in the cache,
@@ -777,15 +794,22 @@ unref() const {
     }
   }
 
-  if (ReferenceCount::unref()) {
-    // The reference count is still nonzero.
-    return true;
-  }
+  {
+    LightMutexHolder shard_holder(shard._lock);
+    if (ReferenceCount::unref()) {
+      // The reference count is still nonzero.
+      return true;
+    }
 
-  // The reference count has just reached zero.  Make sure the object is
-  // removed from the global object pool, before anyone else finds it and
-  // tries to ref it.
-  ((TransformState *)this)->release_new();
+    // The reference count has just reached zero.  Make sure the object is
+    // removed from the global object pool, before anyone else finds it and
+    // tries to ref it.  This is what release_new() does, but we already hold
+    // the shard's lock.
+    if (_saved_entry != -1) {
+      ((TransformState *)this)->_saved_entry = -1;
+      nassertr_always(shard._states.remove(this), false);
+    }
+  }
   ((TransformState *)this)->remove_cache_pointers();
 
   return false;
@@ -955,8 +979,13 @@ write_composition_cache(ostream &out, int indent_level) const {
  */
 int TransformState::
 get_num_states() {
-  LightReMutexHolder holder(*_states_lock);
-  return _states.get_num_entries();
+  size_t num_states = 0;
+  for (size_t i = 0; i < num_states_shards; ++i) {
+    StatesShard &shard = _states_shards[i];
+    LightMutexHolder holder(shard._lock);
+    num_states += shard._states.get_num_entries();
+  }
+  return (int)num_states;
 }
 
 /**
@@ -982,9 +1011,9 @@ get_num_unused_states() {
   typedef pmap<const TransformState *, int> StateCount;
   StateCount state_count;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
+  StateList states;
+  get_all_states(states);
+  for (const TransformState *state : states) {
 
     std::pair<StateCount::iterator, bool> ir =
       state_count.insert(StateCount::value_type(state, 1));
@@ -1067,20 +1096,20 @@ clear_cache() {
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
-  int orig_size = _states.get_num_entries();
+  int orig_size = get_num_states();
 
   // First, we need to copy the entire set of states to a temporary vector,
   // reference-counting each object.  That way we can walk through the copy,
   // without fear of dereferencing (and deleting) the objects in the map as we
   // go.
   {
+    StateList states;
+    get_all_states(states);
+
     typedef pvector< CPT(TransformState) > TempStates;
     TempStates temp_states;
-    temp_states.reserve(orig_size);
-
-    size_t size = _states.get_num_entries();
-    for (size_t si = 0; si < size; ++si) {
-      const TransformState *state = _states.get_key(si);
+    temp_states.reserve(states.size());
+    for (const TransformState *state : states) {
       temp_states.push_back(state);
     }
 
@@ -1119,7 +1148,7 @@ clear_cache() {
     // the various objects' caches will go away.
   }
 
-  int new_size = _states.get_num_entries();
+  int new_size = get_num_states();
   return orig_size - new_size;
 }
 
@@ -1135,78 +1164,87 @@ garbage_collect() {
     return 0;
   }
 
-  LightReMutexHolder holder(*_states_lock);
-
   PStatTimer timer(_garbage_collect_pcollector);
-  size_t orig_size = _states.get_num_entries();
-
-  // How many elements to process this pass?
-  size_t size = orig_size;
-  size_t num_this_pass = std::max(0, int(size * garbage_collect_states_rate));
-  if (num_this_pass <= 0) {
-    return 0;
-  }
 
   bool break_and_uniquify = (auto_break_cycles && uniquify_transforms);
-
-  size_t si = _garbage_index;
-  if (si >= size) {
-    si = 0;
-  }
-
-  num_this_pass = std::min(num_this_pass, size);
-  size_t stop_at_element = (si + num_this_pass) % size;
-
-  do {
-    TransformState *state = (TransformState *)_states.get_key(si);
-    if (break_and_uniquify) {
-      if (state->get_cache_ref_count() > 0 &&
-          state->get_ref_count() == state->get_cache_ref_count()) {
-        // If we have removed all the references to this state not in the
-        // cache, leaving only references in the cache, then we need to
-        // check for a cycle involving this TransformState and break it if
-        // it exists.
-        state->detect_and_break_cycles();
+  int num_collected = 0;
+
+  // We process one shard at a time, letting go of the locks in between, so
+  // that a thread that needs one of them never has to wait for the whole
+  // collection pass to finish.
+  StateList states;
+  for (size_t i = 0; i < num_states_shards; ++i) {
+    StatesShard &shard = _states_shards[i];
+    LightReMutexHolder holder(*_states_lock);
+
+    // Collect the elements to process this pass.  No other thread can remove
+    // states from the shard while we hold the _states_lock, but they may
+    // still add new ones, so we don't hold on to the shard's own lock while
+    // we work.
+    states.clear();
+    {
+      LightMutexHolder shard_holder(shard._lock);
+      size_t size = shard._states.get_num_entries();
+      // Round up, so that even a shard with only a few states in it is
+      // eventually visited.
+      size_t num_this_pass = (size_t)std::max(0.0, ceil(size * garbage_collect_states_rate));
+      num_this_pass = std::min(num_this_pass, size);
+
+      size_t si = shard._garbage_index;
+      if (si >= size) {
+        si = 0;
       }
+      for (size_t n = 0; n < num_this_pass; ++n) {
+        states.push_back(shard._states.get_key(si));
+        si = (si + 1) % size;
+      }
+      shard._garbage_index = si;
     }
 
-    if (!state->unref_if_one()) {
-      // This state has recently been unreffed to 1 (the one we added when
-      // we stored it in the cache).  Now it's time to delete it.  This is
-      // safe, because we're holding the _states_lock, so it's not possible
-      // for some other thread to find the state in the cache and ref it
-      // while we're doing this.  Also, we've just made sure to unref it to 0,
-      // to ensure that another thread can't get it via a weak pointer.
-      state->release_new();
-      state->remove_cache_pointers();
-      state->cache_unref_only();
-      delete state;
-
-      // When we removed it from the hash map, it swapped the last element
-      // with the one we just removed.  So the current index contains one we
-      // still need to visit.
-      --size;
-      --si;
-      if (stop_at_element > 0) {
-        --stop_at_element;
-      }
+    if (states.empty()) {
+      continue;
     }
 
-    si = (si + 1) % size;
-  } while (si != stop_at_element);
-  _garbage_index = si;
+    for (const TransformState *const_state : states) {
+      TransformState *state = (TransformState *)const_state;
+      if (break_and_uniquify) {
+        if (state->get_cache_ref_count() > 0 &&
+            state->get_ref_count() == state->get_cache_ref_count()) {
+          // If we have removed all the references to this state not in the
+          // cache, leaving only references in the cache, then we need to
+          // check for a cycle involving this TransformState and break it if
+          // it exists.
+          state->detect_and_break_cycles();
+        }
+      }
 
-  nassertr(_states.get_num_entries() == size, 0);
+      if (!state->unref_if_one()) {
+        // This state has recently been unreffed to 1 (the one we added when
+        // we stored it in the cache).  Now it's time to delete it.  This is
+        // safe, because we're holding the _states_lock, so it's not possible
+        // for some other thread to find the state through the composition
+        // cache and ref it while we're doing this.  Also, we've just made sure
+        // to unref it to 0, to ensure that another thread can't get it via a
+        // weak pointer, or via the shard, see return_unique().
+        state->release_new();
+        state->remove_cache_pointers();
+        state->cache_unref_only();
+        delete state;
+        ++num_collected;
+      }
+    }
 
+    LightMutexHolder shard_holder(shard._lock);
 #ifdef _DEBUG
-  nassertr(_states.validate(), 0);
+    nassertr(shard._states.validate(), num_collected);
 #endif
 
-  // If we just cleaned up a lot of states, see if we can reduce the table in
-  // size.  This will help reduce iteration overhead in the future.
-  _states.consider_shrink_table();
+    // If we just cleaned up a lot of states, see if we can reduce the table
+    // in size.  This will help reduce iteration overhead in the future.
+    shard._states.consider_shrink_table();
+  }
 
-  return (int)orig_size - (int)size;
+  return num_collected;
 }
 
 /**
@@ -1230,9 +1268,9 @@ list_cycles(ostream &out) {
   VisitedStates visited;
   CompositionCycleDesc cycle_desc;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
+  StateList states;
+  get_all_states(states);
+  for (const TransformState *state : states) {
 
     bool inserted = visited.insert(state).second;
     if (inserted) {
@@ -1300,10 +1338,10 @@ void TransformState::
 list_states(ostream &out) {
   LightReMutexHolder holder(*_states_lock);
 
-  size_t size = _states.get_num_entries();
-  out << size << " states:\n";
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
+  StateList states;
+  get_all_states(states);
+  out << states.size() << " states:\n";
+  for (const TransformState *state : states) {
     state->write(out, 2);
   }
 }
@@ -1319,44 +1357,50 @@ validate_states() {
   PStatTimer timer(_transform_validate_pcollector);
 
   LightReMutexHolder holder(*_states_lock);
-  if (_states.is_empty()) {
-    return true;
-  }
 
-  if (!_states.validate()) {
-    pgraph_cat.error()
-      << "TransformState::_states cache is invalid!\n";
-    return false;
-  }
-
-  size_t size = _states.get_num_entries();
-  size_t si = 0;
-  nassertr(si < size, false);
-  nassertr(_states.get_key(si)->get_ref_count() >= 0, false);
-  size_t snext = si;
-  ++snext;
-  while (snext < size) {
-    nassertr(_states.get_key(snext)->get_ref_count() >= 0, false);
-    const TransformState *ssi = _states.get_key(si);
-    if (!ssi->validate_composition_cache()) {
-      return false;
+  for (size_t i = 0; i < num_states_shards; ++i) {
+    StatesShard &shard = _states_shards[i];
+    LightMutexHolder shard_holder(shard._lock);
+    const States &states = shard._states;
+    if (states.is_empty()) {
+      continue;
     }
-    const TransformState *ssnext = _states.get_key(snext);
-    bool c = (*ssi) == (*ssnext);
-    bool ci = (*ssnext) == (*ssi);
-    if (c != ci) {
+
+    if (!states.validate()) {
       pgraph_cat.error()
-        << "TransformState::operator == () not defined properly!\n";
-      pgraph_cat.error(false)
-        << "(a, b): " << c << "\n";
-      pgraph_cat.error(false)
-        << "(b, a): " << ci << "\n";
-      ssi->write(pgraph_cat.error(false), 2);
-      ssnext->write(pgraph_cat.error(false), 2);
+        << "TransformState::_states cache is invalid!\n";
       return false;
     }
-    si = snext;
+
+    size_t size = states.get_num_entries();
+    size_t si = 0;
+    nassertr(si < size, false);
+    nassertr(states.get_key(si)->get_ref_count() >= 0, false);
+    size_t snext = si;
     ++snext;
+    while (snext < size) {
+      nassertr(states.get_key(snext)->get_ref_count() >= 0, false);
+      const TransformState *ssi = states.get_key(si);
+      if (!ssi->validate_composition_cache()) {
+        return false;
+      }
+      const TransformState *ssnext = states.get_key(snext);
+      bool c = (*ssi) == (*ssnext);
+      bool ci = (*ssnext) == (*ssi);
+      if (c != ci) {
+        pgraph_cat.error()
+          << "TransformState::operator == () not defined properly!\n";
+        pgraph_cat.error(false)
+          << "(a, b): " << c << "\n";
+        pgraph_cat.error(false)
+          << "(b, a): " << ci << "\n";
+        ssi->write(pgraph_cat.error(false), 2);
+        ssnext->write(pgraph_cat.error(false), 2);
+        return false;
+      }
+      si = snext;
+      ++snext;
+    }
   }
 
   return true;
@@ -1387,6 +1431,7 @@ init_states() {
   // _states_lock without a startup race condition.  For the meantime, this is
   // OK because we guarantee that this method is called at static init time,
   // presumably when there is still only one thread in the world.
+  _states_shards = new StatesShard[num_states_shards];
   _states_lock = new LightReMutex("TransformState::_states_lock");
   _cache_stats.init();
   nassertv(Thread::get_current_thread() == Thread::get_main_thread());
@@ -1412,7 +1457,7 @@ init_states() {
                   | F_uniform_scale | F_identity_scale | F_is_2d
                   | F_norm_quat_known;
     state->cache_ref();
-    state->_saved_entry = _states.store(state, nullptr);
+    state->_saved_entry = get_states_shard(state->get_hash())._states.store(state, nullptr);
     _identity_state = state;
   }
   {
@@ -1421,7 +1466,7 @@ init_states() {
     state->_flags = F_is_singular | F_singular_known | F_components_known
                   | F_mat_known | F_is_invalid;
     state->cache_ref();
-    state->_saved_entry = _states.store(state, nullptr);
+    state->_saved_entry = get_states_shard(state->get_hash())._states.store(state, nullptr);
     _invalid_state = state;
   }
 }
@@ -1468,22 +1513,33 @@ return_unique(TransformState *state) {
 
   PStatTimer timer(_transform_new_pcollector);
 
-  LightReMutexHolder holder(*_states_lock);
+  // Save the state in a local PointerTo so that it will be freed at the end
+  // of this function if no one else uses it.  This must be declared before
+  // the holder below, since unref() may need the _states_lock, which may not
+  // be acquired while holding the lock of a shard.
+  CPT(TransformState) pt_state = state;
+
+  StatesShard &shard = get_states_shard(state->get_hash());
+  LightMutexHolder holder(shard._lock);
 
   if (state->_saved_entry != -1) {
-    // This state is already in the cache.  nassertr(_states.find(state) ==
-    // state->_saved_entry, state);
-    return state;
+    // This state is already in the cache.
+    return pt_state;
   }
 
-  // Save the state in a local PointerTo so that it will be freed at the end
-  // of this function if no one else uses it.
-  CPT(TransformState) pt_state = state;
-
-  int si = _states.find(state);
+  int si = shard._states.find(state);
   if (si != -1) {
-    // There's an equivalent state already in the set.  Return it.
-    return _states.get_key(si);
+    // There's an equivalent state already in the set.  Return it, unless
+    // another thread has just dropped the last reference to it and is about
+    // to remove it, in which case we take its place instead.
+    const TransformState *found = shard._states.get_key(si);
+    if (found->ref_if_nonzero()) {
+      CPT(TransformState) result;
+      result.cheat() = found;
+      return result;
+    }
+    ((TransformState *)found)->_saved_entry = -1;
+    shard._states.remove_element(si);
   }
 
   // Not already in the set; add it.
@@ -1493,7 +1549,7 @@ return_unique(TransformState *state) {
     // deleted while it's in it.
     state->cache_ref();
   }
-  si = _states.store(state, nullptr);
+  si = shard._states.store(state, nullptr);
 
   // Save the index and return the input state.
   state->_saved_entry = si;
@@ -1879,9 +1935,38 @@ void TransformState::
 release_new() {
   nassertv(_states_lock->debug_is_locked());
 
+  if (AtomicAdjust::get(_hash) == H_unknown) {
+    // It can't be in the set if it was never hashed.
+    return;
+  }
+
+  StatesShard &shard = get_states_shard(get_hash());
+  LightMutexHolder holder(shard._lock);
   if (_saved_entry != -1) {
     _saved_entry = -1;
-    nassertv_always(_states.remove(this));
+    nassertv_always(shard._states.remove(this));
+  }
+}
+
+/**
+ * Fills the indicated vector with all of the TransformStates in the cache, in
+ * no particular order.
+ *
+ * You must already be holding _states_lock before you call this method.  The
+ * pointers remain valid for as long as you continue to hold it, since states
+ * are never removed from the cache without it.
+ */
+void TransformState::
+get_all_states(StateList &states) {
+  nassertv(_states_lock->debug_is_locked());
+
+  for (size_t i = 0; i < num_states_shards; ++i) {
+    StatesShard &shard = _states_shards[i];
+    LightMutexHolder holder(shard._lock);
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      states.push_back(shard._states.get_key(si));
+    }
   }
 }
 
@@ -267,13 +267,35 @@ private:
   void release_new();
   void remove_cache_pointers();
 
+  typedef pvector<const TransformState *> StateList;
+  static void get_all_states(StateList &states);
+
 private:
-  // This mutex protects _states.  It also protects any modification to the
-  // cache, which is encoded in _composition_cache and
-  // _invert_composition_cache.
+  // This mutex protects any modification to the cache, which is encoded in
+  // _composition_cache and _invert_composition_cache.  It must also be held
+  // while removing a state from the set of unique states, below.
   static LightReMutex *_states_lock;
   typedef SimpleHashMap<const TransformState *, std::nullptr_t, indirect_equals_hash<const TransformState *> > States;
-  static States _states;
+
+  // The set of unique TransformStates is split by hash into a number of
+  // shards, each with its own lock, so that threads making new states need
+  // not wait for _states_lock or for each other.  When both are needed, the
+  // _states_lock must be acquired before the lock of a shard.
+  class StatesShard {
+  public:
+    INLINE StatesShard();
+
+    LightMutex _lock;
+    States _states;
+
+    // This keeps track of our current position through the garbage
+    // collection cycle.
+    size_t _garbage_index;
+  };
+  enum { states_shard_bits = 4 };
+  static const size_t num_states_shards = (size_t)1 << states_shard_bits;
+  static StatesShard *_states_shards;
+  INLINE static StatesShard &get_states_shard(size_t hash);
   static CPT(TransformState) _identity_state;
   static CPT(TransformState) _invalid_state;
 
@@ -307,10 +329,6 @@ private:
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
 
-  // This keeps track of our current position through the garbage collection
-  // cycle.
-  static size_t _garbage_index;
-
   static bool _uniquify_matrix;
 
   static PStatCollector _cache_update_pcollector;
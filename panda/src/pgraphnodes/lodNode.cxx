@@ -174,11 +174,18 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     size_t num_instances = data._instances->size();
     std::unique_ptr<BitArray[]> in_range(new BitArray[num_children]);
 
-    for (size_t ii = 0; ii < num_instances; ++ii) {
-      LPoint3 inst_center = cdata->_center *
-        rel_transform->compose((*data._instances)[ii].get_transform())->get_mat();
-      PN_stdfloat dist2 = inst_center.dot(inst_center);
+    pvector<PN_stdfloat> dist2s(num_instances);
+    if (!data._instances->get_distances_2(dist2s.data(), cdata->_center,
+                                          rel_transform->get_mat())) {
+      for (size_t ii = 0; ii < num_instances; ++ii) {
+        LPoint3 inst_center = cdata->_center *
+          rel_transform->compose((*data._instances)[ii].get_transform())->get_mat();
+        dist2s[ii] = inst_center.dot(inst_center);
+      }
+    }
 
+    for (size_t ii = 0; ii < num_instances; ++ii) {
+      PN_stdfloat dist2 = dist2s[ii];
       for (int index = 0; index < num_children; ++index) {
         const Switch &sw = cdata->_switch_vector[index];
         if (!sw.in_range_2(dist2 * lod_scale)) {
@@ -190,9 +197,12 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     for (int index = 0; index < num_children; ++index) {
       CPT(InstanceList) instances = data._instances->without(in_range[index]);
       if (!instances->empty()) {
-        // At least one instance is visible in this switch level.
+        // At least one instance is visible in this switch level.  Traverse
+        // the child with only those instances.
+        CullTraverserData level_data(data, trav->get_current_thread());
+        level_data._instances = std::move(instances);
         const PandaNode::DownConnection &child = children.get_child_connection(index);
-        trav->traverse_down(data, child);
+        trav->traverse_down(level_data, child);
       }
     }
   }
@@ -17,6 +17,7 @@
 #include "externalThread.h"
 #include "genericThread.h"
 #include "thread.h"
+#include "workerThreadPool.h"
 #include "pandaSystem.h"
 
 #include "dconfig.h"
@@ -57,6 +58,16 @@ ConfigVariableInt thread_stack_size
           "created for each newly-created thread.  Not all thread "
           "implementations respect this value."));
 
+ConfigVariableInt worker_thread_pool_size
+("worker-thread-pool-size", -1,
+ PRC_DESC("Specifies the number of threads in the shared WorkerThreadPool, "
+          "which is used by the subsystems that can optionally split up "
+          "their work across multiple CPU cores, such as a parallel "
+          "CollisionTraverser.  The default, -1, means to create one fewer "
+          "thread than the number of hardware threads, since the thread "
+          "that requests the work also takes part in it.  Set this to 0 to "
+          "run all such work on the requesting thread."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -79,6 +90,7 @@ init_libpipeline() {
   ExternalThread::init_type();
   GenericThread::init_type();
   Thread::init_type();
+  WorkerThreadPool::init_type();
 
 #ifdef HAVE_THREADS
  {
@@ -0,0 +1,243 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file workerThreadPool.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "workerThreadPool.h"
+#include "config_pipeline.h"
+#include "mutexHolder.h"
+
+#include <thread>
+
+#ifndef CPPPARSER
+
+patomic<WorkerThreadPool *> WorkerThreadPool::_global_ptr {nullptr};
+TypeHandle WorkerThreadPool::WorkerThread::_type_handle;
+
+/**
+ * Creates a pool with the indicated number of worker threads.  If
+ * num_threads is negative, one fewer thread than the number of hardware
+ * threads on the machine is created, so that together with the calling
+ * thread every core can be kept busy.  If num_threads is 0, or threading is
+ * not available, no threads are created and all jobs run on the caller.
+ */
+WorkerThreadPool::
+WorkerThreadPool(const std::string &name, int num_threads) :
+  _name(name),
+  _cvar(_lock),
+  _done_cvar(_lock),
+  _batch(nullptr),
+  _batch_seq(0),
+  _num_working(0),
+  _shutdown(false)
+{
+  if (num_threads < 0) {
+    num_threads = (int)std::thread::hardware_concurrency() - 1;
+  }
+
+  if (num_threads <= 0 || !Thread::is_true_threads()) {
+    return;
+  }
+
+  _threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    std::ostringstream strm;
+    strm << _name << "_" << i;
+    PT(WorkerThread) thread = new WorkerThread(strm.str(), _name, this);
+    if (!thread->start(TP_normal, true)) {
+      pipeline_cat.error()
+        << "Unable to start worker thread " << strm.str() << "\n";
+      break;
+    }
+    _threads.push_back(thread);
+  }
+
+  if (pipeline_cat.is_debug()) {
+    pipeline_cat.debug()
+      << "Started " << _threads.size() << " worker threads for " << _name
+      << "\n";
+  }
+}
+
+/**
+ * Stops and joins all of the worker threads.
+ */
+WorkerThreadPool::
+~WorkerThreadPool() {
+  {
+    MutexHolder holder(_lock);
+    nassertv(_batch == nullptr);
+    _shutdown = true;
+    _cvar.notify_all();
+  }
+
+  for (WorkerThread *thread : _threads) {
+    thread->join();
+  }
+  _threads.clear();
+}
+
+/**
+ * Calls func(n, thread) once for each n in the range [0, num_jobs), spreading
+ * the calls across the worker threads, and returns when all calls have
+ * completed.  The calling thread also runs jobs while it waits.
+ *
+ * Jobs may be picked up in any order, and by any thread, so the function
+ * must be safe to run concurrently with itself for different values of n.
+ * The worker threads run in the same pipeline stage as the calling thread.
+ */
+void WorkerThreadPool::
+parallel_for(size_t num_jobs, const JobFunc &func, Thread *current_thread) {
+  if (num_jobs == 0) {
+    return;
+  }
+
+  Batch batch(func, num_jobs, current_thread->get_pipeline_stage());
+
+  bool parallel = false;
+  if (num_jobs > 1 && !_threads.empty() &&
+      !current_thread->is_of_type(WorkerThread::get_class_type())) {
+    MutexHolder holder(_lock);
+    if (_batch == nullptr) {
+      // Nobody else is using the pool right now; hand the batch to the
+      // workers.  If the pool is busy, we just do the work ourselves rather
+      // than waiting for it to become available.
+      _batch = &batch;
+      ++_batch_seq;
+      _cvar.notify_all();
+      parallel = true;
+    }
+  }
+
+  batch.run(current_thread);
+
+  if (parallel) {
+    // All jobs have been claimed, but some may still be running on the
+    // workers.  Take the batch away so no other worker picks it up, and wait
+    // for the ones that did to finish, since the batch lives on our stack.
+    MutexHolder holder(_lock);
+    _batch = nullptr;
+    while (_num_working > 0) {
+      _done_cvar.wait();
+    }
+  }
+}
+
+/**
+ * Calls func(begin, end) on disjoint, consecutive ranges that together cover
+ * the items [0, num_items), spreading the calls across the worker threads,
+ * and returns when all of them have completed.
+ *
+ * total_cost is a measure of the work involved in processing all of the
+ * items, such as the number of bytes or samples they touch.  If it is less
+ * than min_cost, the job isn't worth splitting up, and func(0, num_items) is
+ * simply called on the calling thread.
+ */
+void WorkerThreadPool::
+parallel_for_ranges(size_t num_items, size_t total_cost, size_t min_cost,
+                    const RangeFunc &func, Thread *current_thread) {
+  if (num_items == 0) {
+    return;
+  }
+
+  if (num_items < 2 || !is_parallel() || total_cost < min_cost) {
+    func(0, num_items);
+    return;
+  }
+
+  // Use a few more ranges than there are threads, to even out the load.
+  size_t num_ranges = std::min(num_items, (size_t)(get_num_threads() + 1) * 4);
+  parallel_for(num_ranges, [&] (size_t n, Thread *) {
+    func((num_items * n) / num_ranges, (num_items * (n + 1)) / num_ranges);
+  }, current_thread);
+}
+
+/**
+ * Returns the pool shared by the various systems in Panda that can split
+ * their work across multiple threads.  Its size is controlled by the
+ * worker-thread-pool-size config variable.
+ */
+WorkerThreadPool *WorkerThreadPool::
+get_global_ptr() {
+  WorkerThreadPool *ptr = _global_ptr.load(std::memory_order_acquire);
+  if (ptr == nullptr) {
+    init_type();
+    WorkerThreadPool *new_ptr = new WorkerThreadPool("worker", worker_thread_pool_size);
+
+    // Another thread may have beaten us to it.
+    if (_global_ptr.compare_exchange_strong(ptr, new_ptr)) {
+      ptr = new_ptr;
+    } else {
+      delete new_ptr;
+    }
+  }
+  return ptr;
+}
+
+/**
+ * Claims and runs jobs from the batch until there are none left.
+ */
+void WorkerThreadPool::Batch::
+run(Thread *current_thread) {
+  size_t n = _next_job.fetch_add(1);
+  while (n < _num_jobs) {
+    _func(n, current_thread);
+    n = _next_job.fetch_add(1);
+  }
+}
+
+/**
+ *
+ */
+WorkerThreadPool::WorkerThread::
+WorkerThread(const std::string &name, const std::string &sync_name,
+             WorkerThreadPool *pool) :
+  Thread(name, sync_name),
+  _pool(pool)
+{
+}
+
+/**
+ * Waits for batches to be posted to the pool and helps to run them.
+ */
+void WorkerThreadPool::WorkerThread::
+thread_main() {
+  WorkerThreadPool *pool = _pool;
+  unsigned int last_seq = 0;
+
+  MutexHolder holder(pool->_lock);
+  while (true) {
+    while (!pool->_shutdown &&
+           (pool->_batch == nullptr || pool->_batch_seq == last_seq)) {
+      pool->_cvar.wait();
+    }
+    if (pool->_shutdown) {
+      break;
+    }
+
+    Batch *batch = pool->_batch;
+    last_seq = pool->_batch_seq;
+    ++pool->_num_working;
+
+    pool->_lock.release();
+    if (get_pipeline_stage() != batch->_pipeline_stage) {
+      set_pipeline_stage(batch->_pipeline_stage);
+    }
+    batch->run(this);
+    pool->_lock.acquire();
+
+    if (--pool->_num_working == 0) {
+      pool->_done_cvar.notify_all();
+    }
+  }
+}
+
+#endif  // CPPPARSER
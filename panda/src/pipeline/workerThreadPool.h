@@ -0,0 +1,135 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file workerThreadPool.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef WORKERTHREADPOOL_H
+#define WORKERTHREADPOOL_H
+
+#include "pandabase.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+#include "patomic.h"
+#include "pvector.h"
+
+#ifndef CPPPARSER
+#include <functional>
+
+/**
+ * A fixed set of worker threads that can be used to run a batch of
+ * independent jobs to completion, fork/join style.  This is intended for
+ * splitting up a synchronous operation (a collision traversal, a cull pass,
+ * a flatten) across several CPU cores; it is not a general-purpose
+ * asynchronous task system, for which see AsyncTaskManager.
+ *
+ * The thread that calls parallel_for() participates in the work and does not
+ * return until every job has finished.  If the pool has no threads, or if
+ * parallel_for() is called from within one of the pool's own jobs, the jobs
+ * are simply run in order on the calling thread.
+ *
+ * Each job is identified only by its index, so callers that need a
+ * deterministic result should have each job write into its own slot and
+ * merge the slots in index order afterwards.
+ */
+class EXPCL_PANDA_PIPELINE WorkerThreadPool {
+public:
+  typedef std::function<void(size_t n, Thread *current_thread)> JobFunc;
+  typedef std::function<void(size_t begin, size_t end)> RangeFunc;
+
+  explicit WorkerThreadPool(const std::string &name, int num_threads);
+  WorkerThreadPool(const WorkerThreadPool &copy) = delete;
+  ~WorkerThreadPool();
+
+  WorkerThreadPool &operator = (const WorkerThreadPool &copy) = delete;
+
+  INLINE const std::string &get_name() const;
+  INLINE int get_num_threads() const;
+  INLINE bool is_parallel() const;
+
+  void parallel_for(size_t num_jobs, const JobFunc &func,
+                    Thread *current_thread = Thread::get_current_thread());
+  void parallel_for_ranges(size_t num_items, size_t total_cost,
+                           size_t min_cost, const RangeFunc &func,
+                           Thread *current_thread = Thread::get_current_thread());
+
+  static WorkerThreadPool *get_global_ptr();
+
+private:
+  class Batch {
+  public:
+    INLINE Batch(const JobFunc &func, size_t num_jobs, int pipeline_stage);
+
+    void run(Thread *current_thread);
+
+    const JobFunc &_func;
+    size_t _num_jobs;
+    int _pipeline_stage;
+    patomic<size_t> _next_job;
+  };
+
+  class WorkerThread : public Thread {
+  public:
+    WorkerThread(const std::string &name, const std::string &sync_name,
+                 WorkerThreadPool *pool);
+
+  protected:
+    virtual void thread_main();
+
+  private:
+    WorkerThreadPool *_pool;
+
+  public:
+    static TypeHandle get_class_type() {
+      return _type_handle;
+    }
+    static void init_type() {
+      Thread::init_type();
+      register_type(_type_handle, "WorkerThreadPool::WorkerThread",
+                    Thread::get_class_type());
+    }
+    virtual TypeHandle get_type() const {
+      return get_class_type();
+    }
+    virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+  private:
+    static TypeHandle _type_handle;
+  };
+
+  std::string _name;
+
+  Mutex _lock;
+  ConditionVar _cvar;
+  ConditionVar _done_cvar;
+  Batch *_batch;
+  unsigned int _batch_seq;
+  int _num_working;
+  bool _shutdown;
+
+  typedef pvector<PT(WorkerThread)> Threads;
+  Threads _threads;
+
+  static patomic<WorkerThreadPool *> _global_ptr;
+
+public:
+  static void init_type() {
+    WorkerThread::init_type();
+  }
+
+  friend class WorkerThread;
+};
+
+#include "workerThreadPool.I"
+
+#endif  // CPPPARSER
+
+#endif  // WORKERTHREADPOOL_H
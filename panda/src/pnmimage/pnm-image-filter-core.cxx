@@ -21,75 +21,54 @@ FUNCTION_NAME(IMAGETYPE &dest, const IMAGETYPE &source,
     return;
   }
 
-  // First, set up a 2-d column-major matrix of StoreTypes, big enough to hold
-  // the image xelvals scaled in the A direction only.  This will hold the
-  // adjusted xel data from our first pass.
-
-  StoreType **matrix = (StoreType **)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType *));
-
-  int a, b;
-
-  for (a=0; a<dest.ASIZE(); a++) {
-    matrix[a] = (StoreType *)PANDA_MALLOC_ARRAY(source.BSIZE() * sizeof(StoreType));
-  }
+  int dest_a = dest.ASIZE();
+  int dest_b = dest.BSIZE();
+  int source_a = source.ASIZE();
+  int source_b = source.BSIZE();
+
+  // The filter weights are the same for every row and column, so compute
+  // them just once for each direction.
+  FilterTable a_table, b_table;
+  make_filter_table(a_table, dest_a, source_a, width, make_filter, true);
+  make_filter_table(b_table, dest_b, source_b, width, make_filter, true);
+
+  // Set up a 2-d row-major matrix of StoreTypes, big enough to hold the image
+  // xelvals scaled in the A direction only.  This will hold the adjusted xel
+  // data from our first pass.
+  StoreType *matrix = (StoreType *)PANDA_MALLOC_ARRAY((size_t)dest_a * source_b * sizeof(StoreType));
 
   // First, scale the image in the A direction.
-  float scale;
-  StoreType *temp_source, *temp_dest;
-
-  scale = (float)dest.ASIZE() / (float)source.ASIZE();
-  temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source.ASIZE() * sizeof(StoreType));
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType));
-
-  WorkType *filter;
-  float filter_width;
-  int actual_width;
-
-  make_filter(scale, width, filter, filter_width, actual_width);
+  filter_parallel(source_b, (size_t)max(source_a, dest_a), [&] (int begin, int end) {
+    StoreType *temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source_a * sizeof(StoreType));
 
-  for (b = 0; b < source.BSIZE(); b++) {
-    for (a = 0; a < source.ASIZE(); a++) {
-      temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
-    }
-
-    filter_row(temp_dest, dest.ASIZE(),
-               temp_source, source.ASIZE(),
-               scale,
-               filter, filter_width, actual_width);
+    for (int b = begin; b < end; b++) {
+      for (int a = 0; a < source_a; a++) {
+        temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
+      }
 
-    for (a = 0; a < dest.ASIZE(); a++) {
-      matrix[a][b] = temp_dest[a];
+      filter_row(matrix + (size_t)b * dest_a, a_table, temp_source);
+      Thread::consider_yield();
     }
-  }
-
-  PANDA_FREE_ARRAY(temp_source);
-  PANDA_FREE_ARRAY(temp_dest);
-  PANDA_FREE_ARRAY(filter);
 
-  // Now, scale the image in the B direction.
-  scale = (float)dest.BSIZE() / (float)source.BSIZE();
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.BSIZE() * sizeof(StoreType));
+    PANDA_FREE_ARRAY(temp_source);
+  });
 
-  make_filter(scale, width, filter, filter_width, actual_width);
+  // Now, scale the image in the B direction.  Each row of the result is a
+  // weighted sum of rows of the matrix.
+  filter_parallel(dest_b, (size_t)dest_a, [&] (int begin, int end) {
+    StoreType *temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest_a * sizeof(StoreType));
 
-  for (a = 0; a < dest.ASIZE(); a++) {
-    filter_row(temp_dest, dest.BSIZE(),
-               matrix[a], source.BSIZE(),
-               scale,
-               filter, filter_width, actual_width);
+    for (int b = begin; b < end; b++) {
+      filter_columns(temp_dest, dest_a, b_table, b, matrix);
 
-    for (b = 0; b < dest.BSIZE(); b++) {
-      dest.SETVAL(a, b, channel, (float)temp_dest[b]/(float)source_max);
+      for (int a = 0; a < dest_a; a++) {
+        dest.SETVAL(a, b, channel, (float)temp_dest[a]/(float)source_max);
+      }
+      Thread::consider_yield();
     }
-  }
-
-  PANDA_FREE_ARRAY(temp_dest);
-  PANDA_FREE_ARRAY(filter);
 
-  // Now, clean up our temp matrix and go home!
+    PANDA_FREE_ARRAY(temp_dest);
+  });
 
-  for (a = 0; a < dest.ASIZE(); a++) {
-    PANDA_FREE_ARRAY(matrix[a]);
-  }
   PANDA_FREE_ARRAY(matrix);
 }
@@ -23,95 +23,73 @@ FUNCTION_NAME(IMAGETYPE &dest, const IMAGETYPE &source,
     return;
   }
 
-  // First, set up a 2-d column-major matrix of StoreTypes, big enough to hold
-  // the image xelvals scaled in the A direction only.  This will hold the
-  // adjusted xel data from our first pass.
-
-  StoreType **matrix = (StoreType **)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType *));
-  StoreType **matrix_weight = (StoreType **)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType *));
-
-  int a, b;
-
-  for (a=0; a<dest.ASIZE(); a++) {
-    matrix[a] = (StoreType *)PANDA_MALLOC_ARRAY(source.BSIZE() * sizeof(StoreType));
-    matrix_weight[a] = (StoreType *)PANDA_MALLOC_ARRAY(source.BSIZE() * sizeof(StoreType));
-  }
+  int dest_a = dest.ASIZE();
+  int dest_b = dest.BSIZE();
+  int source_a = source.ASIZE();
+  int source_b = source.BSIZE();
+
+  // The filter weights are the same for every row and column, so compute
+  // them just once for each direction.  They are not normalized, since the
+  // net weight depends on which points are present.
+  FilterTable a_table, b_table;
+  make_filter_table(a_table, dest_a, source_a, width, make_filter, false);
+  make_filter_table(b_table, dest_b, source_b, width, make_filter, false);
+
+  // Set up a 2-d row-major matrix of StoreTypes, big enough to hold the image
+  // xelvals scaled in the A direction only, and another for their weights.
+  // These will hold the adjusted xel data from our first pass.
+  size_t matrix_size = (size_t)dest_a * source_b;
+  StoreType *matrix = (StoreType *)PANDA_MALLOC_ARRAY(matrix_size * sizeof(StoreType));
+  StoreType *matrix_weight = (StoreType *)PANDA_MALLOC_ARRAY(matrix_size * sizeof(StoreType));
 
   // First, scale the image in the A direction.
-  float scale;
-  StoreType *temp_source, *temp_source_weight, *temp_dest, *temp_dest_weight;
-
-  scale = (float)dest.ASIZE() / (float)source.ASIZE();
-  temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source.ASIZE() * sizeof(StoreType));
-  temp_source_weight = (StoreType *)PANDA_MALLOC_ARRAY(source.ASIZE() * sizeof(StoreType));
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType));
-  temp_dest_weight = (StoreType *)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType));
-
-  WorkType *filter;
-  float filter_width;
-  int actual_width;
-
-  make_filter(scale, width, filter, filter_width, actual_width);
-
-  for (b = 0; b < source.BSIZE(); b++) {
-    memset(temp_source, 0, source.ASIZE() * sizeof(StoreType));
-    memset(temp_source_weight, 0, source.ASIZE() * sizeof(StoreType));
-    for (a = 0; a < source.ASIZE(); a++) {
-      if (source.HASVAL(a, b)) {
-        temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
-        temp_source_weight[a] = filter_max;
+  filter_parallel(source_b, (size_t)max(source_a, dest_a), [&] (int begin, int end) {
+    StoreType *temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source_a * sizeof(StoreType));
+    StoreType *temp_source_weight = (StoreType *)PANDA_MALLOC_ARRAY(source_a * sizeof(StoreType));
+
+    for (int b = begin; b < end; b++) {
+      memset(temp_source, 0, source_a * sizeof(StoreType));
+      memset(temp_source_weight, 0, source_a * sizeof(StoreType));
+      for (int a = 0; a < source_a; a++) {
+        if (source.HASVAL(a, b)) {
+          temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
+          temp_source_weight[a] = filter_max;
+        }
       }
-    }
 
-    filter_sparse_row(temp_dest, temp_dest_weight, dest.ASIZE(),
-                      temp_source, temp_source_weight, source.ASIZE(),
-                      scale,
-                      filter, filter_width, actual_width);
-
-    for (a = 0; a < dest.ASIZE(); a++) {
-      matrix[a][b] = temp_dest[a];
-      matrix_weight[a][b] = temp_dest_weight[a];
+      size_t row = (size_t)b * dest_a;
+      filter_sparse_row(matrix + row, matrix_weight + row, a_table,
+                        temp_source, temp_source_weight);
+      Thread::consider_yield();
     }
-  }
 
-  PANDA_FREE_ARRAY(temp_source);
-  PANDA_FREE_ARRAY(temp_source_weight);
-  PANDA_FREE_ARRAY(temp_dest);
-  PANDA_FREE_ARRAY(temp_dest_weight);
-  PANDA_FREE_ARRAY(filter);
+    PANDA_FREE_ARRAY(temp_source);
+    PANDA_FREE_ARRAY(temp_source_weight);
+  });
 
   // Now, scale the image in the B direction.
-  scale = (float)dest.BSIZE() / (float)source.BSIZE();
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.BSIZE() * sizeof(StoreType));
-  temp_dest_weight = (StoreType *)PANDA_MALLOC_ARRAY(dest.BSIZE() * sizeof(StoreType));
-
-  make_filter(scale, width, filter, filter_width, actual_width);
-
-  for (a = 0; a < dest.ASIZE(); a++) {
-    filter_sparse_row(temp_dest, temp_dest_weight, dest.BSIZE(),
-                      matrix[a], matrix_weight[a], source.BSIZE(),
-                      scale,
-                      filter, filter_width, actual_width);
-
-    for (b = 0; b < dest.BSIZE(); b++) {
-      if (temp_dest_weight[b] != 0) {
-        // The temp_dest array has already been scaled by
-        // temp_dest_weight; we don't scale it again here.
-        dest.SETVAL(a, b, channel, (float)temp_dest[b]/(float)source_max);
+  filter_parallel(dest_b, (size_t)dest_a, [&] (int begin, int end) {
+    StoreType *temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest_a * sizeof(StoreType));
+    StoreType *temp_dest_weight = (StoreType *)PANDA_MALLOC_ARRAY(dest_a * sizeof(StoreType));
+
+    for (int b = begin; b < end; b++) {
+      filter_sparse_columns(temp_dest, temp_dest_weight, dest_a, b_table, b,
+                            matrix, matrix_weight);
+
+      for (int a = 0; a < dest_a; a++) {
+        if (temp_dest_weight[a] > 0) {
+          // The matrix values have already been scaled by their weights, so
+          // dividing by the net weight gives the weighted average.
+          dest.SETVAL(a, b, channel, (float)(temp_dest[a] / temp_dest_weight[a])/(float)source_max);
+        }
       }
+      Thread::consider_yield();
     }
-  }
 
-  PANDA_FREE_ARRAY(temp_dest);
-  PANDA_FREE_ARRAY(temp_dest_weight);
-  PANDA_FREE_ARRAY(filter);
+    PANDA_FREE_ARRAY(temp_dest);
+    PANDA_FREE_ARRAY(temp_dest_weight);
+  });
 
-  // Now, clean up our temp matrix and go home!
-
-  for (a = 0; a < dest.ASIZE(); a++) {
-    PANDA_FREE_ARRAY(matrix[a]);
-    PANDA_FREE_ARRAY(matrix_weight[a]);
-  }
   PANDA_FREE_ARRAY(matrix);
   PANDA_FREE_ARRAY(matrix_weight);
 }
@@ -29,14 +29,32 @@
 // the first convolution.  The entire process is then repeated for each
 // channel in the image.
 
+// Since the kernel weights depend only on the position along the axis, they
+// are computed once per axis into a FilterTable, rather than once per row.
+// Each pass is then split into bands of rows that are processed in parallel
+// on the WorkerThreadPool, and the inner loops are vectorized where SSE2 is
+// available.  Each output value is computed the same way regardless of the
+// number of threads, so the result is deterministic; it matches the original
+// one-row-at-a-time implementation to within floating-point rounding (a
+// relative error of about 1e-6), which may occasionally show up as a
+// difference of one unit in the last place of an 8-bit or 16-bit channel.
+
 #include "pandabase.h"
 #include <math.h>
 #include "cmath.h"
 #include "thread.h"
+#include "workerThreadPool.h"
 
 #include "pnmImage.h"
 #include "pfmFile.h"
 
+#include <functional>
+
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define PNM_FILTER_USE_SSE2
+#endif
+
 using std::max;
 using std::min;
 
@@ -95,9 +113,11 @@ static const WorkType source_max = 255;
 static const WorkType filter_max = 255;
 */
 
-// filter_row() filters a single row by convolving with a one-dimensional
-// kernel filter.  The kernel is defined by an array of weights in filter[],
-// where the ith element of filter corresponds to abs(d * scale), if
+// A FilterTable holds the one-dimensional kernel resolved for every sample
+// along one axis of the destination image: for each destination sample, the
+// first contributing source sample and the weights to apply to it and the
+// samples that follow.  The kernel is defined by an array of weights in
+// filter[], where the ith element of filter corresponds to abs(d * scale), if
 // scale>1.0, and abs(d), if scale<=1.0, where d is the offset from the center
 // and varies from -filter_width to filter_width.
 
@@ -105,13 +125,29 @@ static const WorkType filter_max = 255;
 // the radius of interest of the filter function.  The array may need to be
 // larger (by a factor of scale), to adequately cover all the values.
 
+class FilterTable {
+public:
+  // The weights for destination sample i are _weights[_offset[i]] through
+  // _weights[_offset[i + 1] - 1], and apply to the source samples starting
+  // at _first[i].
+  pvector<int> _first;
+  pvector<int> _offset;
+  pvector<WorkType> _weights;
+};
+
+typedef void FilterFunction(float scale, float width,
+                            WorkType *&filter, float &filter_width, int &actual_width);
+
 static void
-filter_row(StoreType dest[], int dest_len,
-           const StoreType source[], int source_len,
-           float scale,                    //  == dest_len / source_len
-           const WorkType filter[],
-           float filter_width,
-           int actual_width) {
+make_filter_table(FilterTable &table, int dest_len, int source_len,
+                  float width, FilterFunction *make_filter, bool normalize) {
+  float scale = (float)dest_len / (float)source_len;
+
+  WorkType *filter;
+  float filter_width;
+  int actual_width;
+  make_filter(scale, width, filter, filter_width, actual_width);
+
   // If we are expanding the row (scale > 1.0), we need to look at a
   // fractional granularity.  Hence, we scale our filter index by scale.  If
   // we are compressing (scale < 1.0), we don't need to fiddle with the filter
@@ -125,6 +161,10 @@ filter_row(StoreType dest[], int dest_len,
     iscale = scale;
   }
 
+  table._first.resize(dest_len);
+  table._offset.resize(dest_len + 1);
+  table._weights.clear();
+
   for (int dest_x = 0; dest_x < dest_len; dest_x++) {
     // The additional offset of 0.5 keeps the pixel centered.
     float center = (dest_x + 0.5f) / scale - 0.5f;
@@ -139,9 +179,11 @@ filter_row(StoreType dest[], int dest_len,
     // us to flip the sign of the offset when we cross the center point.
     int right_center = (int)cceil(center);
 
-    WorkType net_weight = 0;
-    WorkType net_value = 0;
+    size_t offset = table._weights.size();
+    table._first[dest_x] = left;
+    table._offset[dest_x] = (int)offset;
 
+    WorkType net_weight = 0;
     int index, source_x;
 
     // This loop is broken into two pieces--the left of center and the right
@@ -149,83 +191,131 @@ filter_row(StoreType dest[], int dest_len,
     // each time through the loop.
     for (source_x = left; source_x < right_center; source_x++) {
       index = (int)cfloor(iscale * (center - source_x) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
+      WorkType weight = 0;
+      nassertd(index >= 0 && index < actual_width) {
+        // Keep the weights lined up with the source samples.
+        table._weights.push_back(weight);
+        continue;
+      }
+      weight = filter[index];
+      table._weights.push_back(weight);
+      net_weight += weight;
     }
 
     for (; source_x <= right; source_x++) {
       index = (int)cfloor(iscale * (source_x - center) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
+      WorkType weight = 0;
+      nassertd(index >= 0 && index < actual_width) {
+        // Keep the weights lined up with the source samples.
+        table._weights.push_back(weight);
+        continue;
+      }
+      weight = filter[index];
+      table._weights.push_back(weight);
+      net_weight += weight;
     }
 
-    if (net_weight > 0) {
-      dest[dest_x] = (StoreType)(net_value / net_weight);
-    } else {
-      dest[dest_x] = 0;
+    if (normalize && net_weight > 0) {
+      for (size_t i = offset; i < table._weights.size(); ++i) {
+        table._weights[i] /= net_weight;
+      }
     }
   }
-  Thread::consider_yield();
+  table._offset[dest_len] = (int)table._weights.size();
+
+  PANDA_FREE_ARRAY(filter);
 }
 
-// As above, but we also accept an array of weight values per element, to
-// support scaling a sparse array (as in a PfmFile).
-static void
-filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
-                  const StoreType source[], const StoreType source_weight[], int source_len,
-                  float scale,                    //  == dest_len / source_len
-                  const WorkType filter[],
-                  float filter_width,
-                  int actual_width) {
-  // If we are expanding the row (scale > 1.0), we need to look at a
-  // fractional granularity.  Hence, we scale our filter index by scale.  If
-  // we are compressing (scale < 1.0), we don't need to fiddle with the filter
-  // index, so we leave it at one.
+// Returns the sum of weights[i] * source[i] for i in [0, count).
+static INLINE WorkType
+filter_dot(const WorkType *weights, const StoreType *source, int count) {
+  int i = 0;
+  WorkType net_value = 0;
+#ifdef PNM_FILTER_USE_SSE2
+  if (count >= 4) {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(weights), _mm_loadu_ps(source));
+    for (i = 4; i + 4 <= count; i += 4) {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(weights + i),
+                                       _mm_loadu_ps(source + i)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    net_value = _mm_cvtss_f32(sum);
+  }
+#endif
+  for (; i < count; ++i) {
+    net_value += weights[i] * source[i];
+  }
+  return net_value;
+}
 
-  float iscale;
-  if (scale < 1.0f) {
-    iscale = 1.0f;
-    filter_width /= scale;
-  } else {
-    iscale = scale;
+// Adds weight * source[i] to dest[i] for i in [0, len).
+static INLINE void
+filter_accumulate(StoreType *dest, const StoreType *source, WorkType weight,
+                  int len) {
+  int i = 0;
+#ifdef PNM_FILTER_USE_SSE2
+  __m128 weight4 = _mm_set1_ps(weight);
+  for (; i + 4 <= len; i += 4) {
+    _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i),
+                                       _mm_mul_ps(weight4, _mm_loadu_ps(source + i))));
+  }
+#endif
+  for (; i < len; ++i) {
+    dest[i] += weight * source[i];
   }
+}
 
+// filter_row() filters a single row by convolving with the kernel described
+// by a normalized FilterTable.
+static void
+filter_row(StoreType dest[], const FilterTable &table, const StoreType source[]) {
+  int dest_len = (int)table._first.size();
   for (int dest_x = 0; dest_x < dest_len; dest_x++) {
-    // The additional offset of 0.5 keeps the pixel centered.
-    float center = (dest_x + 0.5f) / scale - 0.5f;
+    int offset = table._offset[dest_x];
+    dest[dest_x] = (StoreType)filter_dot(&table._weights[0] + offset,
+                                         source + table._first[dest_x],
+                                         table._offset[dest_x + 1] - offset);
+  }
+}
 
-    // left and right are the starting and ending ranges of the radius of
-    // interest of the filter function.  We need to apply the filter to each
-    // value in this range.
-    int left = max((int)cfloor(center - filter_width), 0);
-    int right = min((int)cceil(center + filter_width), source_len - 1);
+// filter_columns() filters a whole row of columns at once, producing output
+// row dest_y from the rows of the matrix, each of which is row_len values
+// long.  Processing a row at a time lets the inner loop run over contiguous
+// memory.
+static void
+filter_columns(StoreType dest[], int row_len, const FilterTable &table,
+               int dest_y, const StoreType matrix[]) {
+  memset(dest, 0, row_len * sizeof(StoreType));
+
+  int first = table._first[dest_y];
+  int begin = table._offset[dest_y];
+  int end = table._offset[dest_y + 1];
+  for (int i = begin; i < end; ++i) {
+    const StoreType *source = matrix + (size_t)(first + i - begin) * row_len;
+    filter_accumulate(dest, source, table._weights[i], row_len);
+  }
+}
 
-    // right_center is the point just to the right of the center.  This allows
-    // us to flip the sign of the offset when we cross the center point.
-    int right_center = (int)cceil(center);
+// As filter_row(), but we also accept an array of weight values per element,
+// to support scaling a sparse array (as in a PfmFile).  The FilterTable must
+// not be normalized.
+static void
+filter_sparse_row(StoreType dest[], StoreType dest_weight[],
+                  const FilterTable &table,
+                  const StoreType source[], const StoreType source_weight[]) {
+  int dest_len = (int)table._first.size();
+  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
+    const WorkType *weights = &table._weights[0] + table._offset[dest_x];
+    int count = table._offset[dest_x + 1] - table._offset[dest_x];
+    int first = table._first[dest_x];
 
     WorkType net_weight = 0;
     WorkType net_value = 0;
-
-    int index, source_x;
-
-    // This loop is broken into two pieces--the left of center and the right
-    // of center--so we don't have to incur the overhead of calling fabs()
-    // each time through the loop.
-    for (source_x = left; source_x < right_center; source_x++) {
-      index = (int)cfloor(iscale * (center - source_x) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x] * source_weight[source_x];
-      net_weight += filter[index] * source_weight[source_x];
-    }
-
-    for (; source_x <= right; source_x++) {
-      index = (int)cfloor(iscale * (source_x - center) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x] * source_weight[source_x];
-      net_weight += filter[index] * source_weight[source_x];
+    for (int i = 0; i < count; ++i) {
+      WorkType weight = weights[i] * source_weight[first + i];
+      net_value += weight * source[first + i];
+      net_weight += weight;
     }
 
     if (net_weight > 0) {
@@ -235,7 +325,52 @@ filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
     }
     dest_weight[dest_x] = (StoreType)net_weight;
   }
-  Thread::consider_yield();
+}
+
+// The sparse equivalent of filter_columns().  The values are accumulated
+// into dest and their weights into dest_weight; the caller must divide.
+static void
+filter_sparse_columns(StoreType dest[], StoreType dest_weight[], int row_len,
+                      const FilterTable &table, int dest_y,
+                      const StoreType matrix[], const StoreType matrix_weight[]) {
+  memset(dest, 0, row_len * sizeof(StoreType));
+  memset(dest_weight, 0, row_len * sizeof(StoreType));
+
+  int first = table._first[dest_y];
+  int begin = table._offset[dest_y];
+  int end = table._offset[dest_y + 1];
+  for (int i = begin; i < end; ++i) {
+    size_t row = (size_t)(first + i - begin) * row_len;
+    const StoreType *source = matrix + row;
+    const StoreType *source_weight = matrix_weight + row;
+    WorkType filter_weight = table._weights[i];
+    for (int x = 0; x < row_len; ++x) {
+      WorkType weight = filter_weight * source_weight[x];
+      dest[x] += weight * source[x];
+      dest_weight[x] += weight;
+    }
+  }
+}
+
+// Below this number of samples in a pass, it isn't worth the overhead of
+// handing the work to other threads.
+static const size_t parallel_filter_min_samples = 64 * 1024;
+
+// Calls func(begin, end) on disjoint bands of the rows [0, num_rows),
+// spreading them over the WorkerThreadPool if the job is large enough.  Does
+// not return until all rows have been processed.
+static void
+filter_parallel(int num_rows, size_t row_len,
+                const std::function<void(int begin, int end)> &func) {
+  if (num_rows <= 0) {
+    return;
+  }
+
+  WorkerThreadPool::get_global_ptr()->parallel_for_ranges(
+    (size_t)num_rows, (size_t)num_rows * row_len, parallel_filter_min_samples,
+    [&] (size_t begin, size_t end) {
+      func((int)begin, (int)end);
+    });
 }
 
 
@@ -249,9 +384,6 @@ filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
 // 0..filter_max; the array must have enough elements to include all indices
 // corresponding to values in the range -filter_width to filter_width.
 
-typedef void FilterFunction(float scale, float width,
-                            WorkType *&filter, float &filter_width, int &actual_width);
-
 static void
 box_filter_impl(float scale, float width,
                 WorkType *&filter, float &filter_width,
@@ -777,36 +909,42 @@ quick_filter_from(const PNMImage &from, int xborder, int yborder) {
   int to_xoff = xborder / 2;
   int to_yoff = yborder / 2;
 
-  float from_x0, from_x1, from_y0, from_y1;
-  int to_x, to_y;
-
   float x_scale = (float)from_xs / (float)to_xs;
   float y_scale = (float)from_ys / (float)to_ys;
 
-  LColorf color;
+  int to_x_begin = max(0, -to_xoff);
+  int to_x_end = min(to_xs, get_x_size() - to_xoff);
+  int to_y_begin = max(0, -to_yoff);
+  int to_y_end = min(to_ys, get_y_size() - to_yoff);
 
-  from_y0 = max(0, -to_yoff) * y_scale;
-  for (to_y = max(0, -to_yoff);
-       to_y < min(to_ys, get_y_size()-to_yoff);
-       to_y++) {
-    from_y1 = (to_y+1) * y_scale;
+  auto filter_rows = [&] (int begin, int end) {
+    for (int to_y = to_y_begin + begin; to_y < to_y_begin + end; to_y++) {
+      float from_y0 = to_y * y_scale;
+      float from_y1 = (to_y+1) * y_scale;
 
-    from_x0 = max(0, -to_xoff) * x_scale;
-    for (to_x = max(0, -to_xoff);
-         to_x < min(to_xs, get_x_size()-to_xoff);
-         to_x++) {
-      from_x1 = (to_x+1) * x_scale;
+      float from_x0 = to_x_begin * x_scale;
+      for (int to_x = to_x_begin; to_x < to_x_end; to_x++) {
+        float from_x1 = (to_x+1) * x_scale;
 
-      // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-      // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-      color = box_filter_region(from,
-                                from_x0, from_y0, from_x1, from_y1);
+        // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
+        // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+        LColorf color = box_filter_region(from,
+                                          from_x0, from_y0, from_x1, from_y1);
 
-      set_xel_a(to_xoff + to_x, to_yoff + to_y, color);
+        set_xel_a(to_xoff + to_x, to_yoff + to_y, color);
 
-      from_x0 = from_x1;
+        from_x0 = from_x1;
+      }
+      Thread::consider_yield();
     }
-    from_y0 = from_y1;
-    Thread::consider_yield();
+  };
+
+  if (&from == this) {
+    // The rows must be processed in order if we're filtering in-place.
+    filter_rows(0, to_y_end - to_y_begin);
+  } else {
+    filter_parallel(to_y_end - to_y_begin,
+                    (size_t)max(0, to_x_end - to_x_begin) * max(1, (int)cceil(x_scale * y_scale)),
+                    filter_rows);
   }
 }
@@ -107,6 +107,37 @@ ConfigVariableDouble pstats_history
 ConfigVariableDouble pstats_average_time
 ("pstats-average-time", 3.0);
 
+ConfigVariableInt pstats_decode_threads
+("pstats-decode-threads", 0,
+ PRC_DESC("The number of threads the PStats server uses to decode the frame "
+          "data arriving from each client.  The frames from any one client "
+          "thread are always decoded by the same decode thread, so they stay "
+          "in order.  This may help a server that is falling behind a client "
+          "with many threads or collectors.  The default, 0, decodes the "
+          "frames on the thread that receives them."));
+
+ConfigVariableFilename pstats_session_dir
+("pstats-session-dir", "",
+ PRC_DESC("If this is nonempty, the PStats server streams the frame data of "
+          "each client to a session file in this directory as it arrives, "
+          "and keeps only the most recent pstats-resident-history seconds "
+          "of it in memory.  Older frames are read back from the file on "
+          "demand, which allows the server to retain much longer captures, "
+          "according to pstats-session-history."));
+
+ConfigVariableDouble pstats_session_history
+("pstats-session-history", 3600.0,
+ PRC_DESC("The number of seconds of frame data the PStats server retains "
+          "for each client thread when pstats-session-dir is in effect.  "
+          "This replaces pstats-history for such clients."));
+
+ConfigVariableDouble pstats_resident_history
+("pstats-resident-history", 10.0,
+ PRC_DESC("When pstats-session-dir is in effect, this is the number of "
+          "seconds of the most recent frame data that the PStats server "
+          "keeps in memory for each client thread.  Older frames are moved "
+          "out to the session file."));
+
 ConfigVariableBool pstats_mem_other
 ("pstats-mem-other", true,
  PRC_DESC("Set this true to collect memory categories smaller than 0.1% of "
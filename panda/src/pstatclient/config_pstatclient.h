@@ -22,6 +22,7 @@
 #include "configVariableInt.h"
 #include "configVariableDouble.h"
 #include "configVariableBool.h"
+#include "configVariableFilename.h"
 
 // Configure variables for pstats package.
 
@@ -44,6 +45,10 @@ extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_python_profiler;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_scroll_mode;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_history;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_average_time;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_decode_threads;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableFilename pstats_session_dir;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_session_history;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_resident_history;
 
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_mem_other;
 
@@ -157,6 +157,8 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Geom cache operations:record",     { 0.2, 0.4, 0.8 } },
   { 1, "Geom cache operations:erase",      { 0.4, 0.8, 0.2 } },
   { 1, "Geom cache operations:evict",      { 0.8, 0.2, 0.4 } },
+  { 1, "Geom cache operations:hit",        { 0.6, 0.6, 0.2 } },
+  { 1, "Geom cache operations:miss",       { 0.2, 0.6, 0.6 } },
   { 1, "Data transferred",                 { 0.0, 0.2, 0.4 },  "MB", 12, 1048576 },
   { 1, "Primitive batches",                { 0.2, 0.5, 0.9 },  "", 500 },
   { 1, "Primitive batches:Other",          { 0.2, 0.2, 0.2 } },
@@ -25,7 +25,9 @@
 #include "configVariableInt.h"
 #include "configVariableString.h"
 #include "configVariableFilename.h"
+#include "configVariableEnum.h"
 #include "virtualFileSystem.h"
+#include "zStream.h"
 
 using std::istream;
 using std::ostream;
@@ -86,6 +88,17 @@ BamCache() :
     ("model-cache-max-kbytes", 10485760,
      PRC_DESC("This is the maximum size of the model cache, in kilobytes."));
 
+  ConfigVariableInt model_cache_compression_level
+    ("model-cache-compression-level", 0,
+     PRC_DESC("Set this to a nonzero value to compress the files written to "
+              "the model cache at the indicated compression level.  This "
+              "does not affect the reading of existing cache files."));
+
+  ConfigVariableEnum<CompressionCodec::Codec> model_cache_compression_codec
+    ("model-cache-compression-codec", CompressionCodec::C_zlib,
+     PRC_DESC("The codec with which to compress model cache files, if "
+              "model-cache-compression-level is nonzero: zlib, lz4 or zstd."));
+
   _cache_models = model_cache_models;
   _cache_textures = model_cache_textures;
   _cache_compressed_textures = model_cache_compressed_textures;
@@ -93,6 +106,8 @@ BamCache() :
 
   _flush_time = model_cache_flush;
   _max_kbytes = model_cache_max_kbytes;
+  _compression_level = model_cache_compression_level;
+  _compression_codec = model_cache_compression_codec;
 
   if (!model_cache_dir.empty()) {
     set_root(model_cache_dir);
@@ -223,68 +238,48 @@ store(BamCacheRecord *record) {
   temp_pathname.set_extension(extension);
   temp_pathname.set_binary();
 
-  DatagramOutputFile dout;
-  if (!dout.open(temp_pathname)) {
-    util_cat.error()
-      << "Could not write cache file: " << temp_pathname << "\n";
-    vfs->delete_file(temp_pathname);
-    emergency_read_only();
-    return false;
-  }
-
-  if (!dout.write_header(_bam_header)) {
-    util_cat.error()
-      << "Unable to write to " << temp_pathname << "\n";
-    vfs->delete_file(temp_pathname);
-    return false;
-  }
-
-  {
-    BamWriter writer(&dout);
-    if (!writer.init()) {
+  bool success;
+#ifdef HAVE_ZLIB
+  if (_compression_level > 0) {
+    ostream *out = vfs->open_write_file(temp_pathname, false, true);
+    if (out == nullptr) {
       util_cat.error()
-        << "Unable to write Bam header to " << temp_pathname << "\n";
+        << "Could not write cache file: " << temp_pathname << "\n";
       vfs->delete_file(temp_pathname);
+      emergency_read_only();
       return false;
     }
 
-    TypeRegistry *type_registry = TypeRegistry::ptr();
-    TypeHandle texture_type = type_registry->find_type("Texture");
-    if (record->get_data()->is_of_type(texture_type)) {
-      // Texture objects write the actual texture image.
-      writer.set_file_texture_mode(BamWriter::BTM_rawdata);
-    } else {
-      // Any other kinds of objects write texture references.
-      writer.set_file_texture_mode(BamWriter::BTM_fullpath);
+    {
+      OCompressStream zout(out, false, _compression_level, true,
+                           _compression_codec);
+      DatagramOutputFile dout;
+      success = dout.open(zout, temp_pathname) &&
+                do_write_record(dout, record, temp_pathname);
     }
-
-    // This is necessary for relative NodePaths to work.
-    TypeHandle node_type = type_registry->find_type("PandaNode");
-    if (record->get_data()->is_of_type(node_type)) {
-      writer.set_root_node(record->get_data());
-    }
-
-    if (!writer.write_object(record)) {
-      util_cat.error()
-        << "Unable to write object to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
-    }
-
-    if (!writer.write_object(record->get_data())) {
+    success = success && !out->fail();
+    vfs->close_write_file(out);
+  } else
+#endif  // HAVE_ZLIB
+  {
+    DatagramOutputFile dout;
+    if (!dout.open(temp_pathname)) {
       util_cat.error()
-        << "Unable to write object data to " << temp_pathname << "\n";
+        << "Could not write cache file: " << temp_pathname << "\n";
       vfs->delete_file(temp_pathname);
+      emergency_read_only();
       return false;
     }
+    success = do_write_record(dout, record, temp_pathname);
+  }
 
-    // Now that we are done with the BamWriter, it's important to let it
-    // destruct now and clean itself up, or it might get mad if we delete any
-    // TypedWritables below that haven't been written yet.
+  if (!success) {
+    vfs->delete_file(temp_pathname);
+    return false;
   }
 
-  record->_record_size = dout.get_file_pos();
-  dout.close();
+  PT(VirtualFile) temp_file = vfs->get_file(temp_pathname);
+  record->_record_size = (temp_file != nullptr) ? temp_file->get_file_size() : 0;
 
   // Now move the file into place.
   if (!vfs->rename_file(temp_pathname, cache_pathname) && vfs->exists(temp_pathname)) {
@@ -861,6 +856,57 @@ read_record(const Filename &source_pathname,
   return record;
 }
 
+/**
+ * Writes the indicated record, and the object it contains, to the already-
+ * opened cache file.  Returns true on success, false on failure.
+ */
+bool BamCache::
+do_write_record(DatagramOutputFile &dout, BamCacheRecord *record,
+                const Filename &temp_pathname) {
+  if (!dout.write_header(_bam_header)) {
+    util_cat.error()
+      << "Unable to write to " << temp_pathname << "\n";
+    return false;
+  }
+
+  BamWriter writer(&dout);
+  if (!writer.init()) {
+    util_cat.error()
+      << "Unable to write Bam header to " << temp_pathname << "\n";
+    return false;
+  }
+
+  TypeRegistry *type_registry = TypeRegistry::ptr();
+  TypeHandle texture_type = type_registry->find_type("Texture");
+  if (record->get_data()->is_of_type(texture_type)) {
+    // Texture objects write the actual texture image.
+    writer.set_file_texture_mode(BamWriter::BTM_rawdata);
+  } else {
+    // Any other kinds of objects write texture references.
+    writer.set_file_texture_mode(BamWriter::BTM_fullpath);
+  }
+
+  // This is necessary for relative NodePaths to work.
+  TypeHandle node_type = type_registry->find_type("PandaNode");
+  if (record->get_data()->is_of_type(node_type)) {
+    writer.set_root_node(record->get_data());
+  }
+
+  if (!writer.write_object(record)) {
+    util_cat.error()
+      << "Unable to write object to " << temp_pathname << "\n";
+    return false;
+  }
+
+  if (!writer.write_object(record->get_data())) {
+    util_cat.error()
+      << "Unable to write object data to " << temp_pathname << "\n";
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Actually reads a record from the file.
  */
@@ -875,6 +921,38 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     return nullptr;
   }
 
+  istream &in = din.get_stream();
+  PT(BamCacheRecord) record;
+#ifdef HAVE_ZLIB
+  if (in.peek() != (unsigned char)_bam_header[0]) {
+    // This doesn't start like a cache file; it may be a compressed one.
+    IDecompressStream zin(&in, false);
+    DatagramInputFile zdin;
+    if (zdin.open(zin, cache_pathname)) {
+      record = do_read_record(zdin, cache_pathname, read_data);
+    }
+  } else
+#endif  // HAVE_ZLIB
+  {
+    record = do_read_record(din, cache_pathname, read_data);
+  }
+
+  if (record != nullptr) {
+    // Also get the total file size.
+    PT(VirtualFile) vfile = din.get_vfile();
+    in.clear();
+    record->_record_size = vfile->get_file_size(&in);
+  }
+
+  return record;
+}
+
+/**
+ * Reads a record from the already-opened cache file.
+ */
+PT(BamCacheRecord) BamCache::
+do_read_record(DatagramInputFile &din, const Filename &cache_pathname,
+               bool read_data) {
   string head;
   if (!din.read_header(head, _bam_header.size())) {
     if (util_cat.is_debug()) {
@@ -947,12 +1025,6 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     }
   }
 
-  // Also get the total file size.
-  PT(VirtualFile) vfile = din.get_vfile();
-  istream &in = din.get_stream();
-  in.clear();
-  record->_record_size = vfile->get_file_size(&in);
-
   // And the last access time is now, duh.
   record->_record_access_time = time(nullptr);
 
@@ -22,10 +22,13 @@
 #include "pvector.h"
 #include "reMutex.h"
 #include "reMutexHolder.h"
+#include "compressionCodec.h"
 
 #include <time.h>
 
 class BamCacheIndex;
+class DatagramInputFile;
+class DatagramOutputFile;
 
 /**
  * This class maintains a cache of Bam and/or Txo objects generated from model
@@ -68,6 +71,11 @@ PUBLISHED:
   INLINE void set_cache_max_kbytes(int max_kbytes);
   INLINE int get_cache_max_kbytes() const;
 
+  INLINE void set_compression_level(int compression_level);
+  INLINE int get_compression_level() const;
+  INLINE void set_compression_codec(CompressionCodec::Codec codec);
+  INLINE CompressionCodec::Codec get_compression_codec() const;
+
   INLINE void set_read_only(bool ro);
   INLINE bool get_read_only() const;
 
@@ -95,6 +103,8 @@ PUBLISHED:
   MAKE_PROPERTY(root, get_root, set_root);
   MAKE_PROPERTY(flush_time, get_flush_time, set_flush_time);
   MAKE_PROPERTY(cache_max_kbytes, get_cache_max_kbytes, set_cache_max_kbytes);
+  MAKE_PROPERTY(compression_level, get_compression_level, set_compression_level);
+  MAKE_PROPERTY(compression_codec, get_compression_codec, set_compression_codec);
   MAKE_PROPERTY(read_only, get_read_only, set_read_only);
 
 private:
@@ -120,8 +130,13 @@ private:
   PT(BamCacheRecord) read_record(const Filename &source_pathname,
                                  const Filename &cache_filename,
                                  int pass);
+  static bool do_write_record(DatagramOutputFile &dout, BamCacheRecord *record,
+                              const Filename &temp_pathname);
   static PT(BamCacheRecord) do_read_record(const Filename &cache_pathname,
                                            bool read_data);
+  static PT(BamCacheRecord) do_read_record(DatagramInputFile &din,
+                                           const Filename &cache_pathname,
+                                           bool read_data);
 
   static std::string hash_filename(const std::string &filename);
   static void make_global();
@@ -135,6 +150,8 @@ private:
   Filename _root;
   int _flush_time;
   int _max_kbytes;
+  int _compression_level;
+  CompressionCodec::Codec _compression_codec;
   static BamCache *_global_ptr;
 
   BamCacheIndex *_index;
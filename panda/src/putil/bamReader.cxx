@@ -19,6 +19,7 @@
 #include "datagramIterator.h"
 #include "config_putil.h"
 #include "pipelineCyclerBase.h"
+#include "workerThreadPool.h"
 
 using std::string;
 
@@ -49,6 +50,7 @@ BamReader(DatagramGenerator *source)
   _pta_id = -1;
   _long_object_id = false;
   _long_pta_id = false;
+  _pending_payload_bytes = 0;
 }
 
 
@@ -57,6 +59,7 @@ BamReader(DatagramGenerator *source)
  */
 BamReader::
 ~BamReader() {
+  flush_payloads();
   nassertv(_num_extra_objects == 0);
   nassertv(_nesting_level == 0);
 }
@@ -269,6 +272,10 @@ read_object(TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
     p_read_object();
   }
 
+  // All of the objects have been read, so now is the time to copy their
+  // payloads, if any were postponed.
+  flush_payloads();
+
   // Now look up the pointer of the object we read first.  It should be
   // available now.
   if (object_id == 0) {
@@ -326,6 +333,9 @@ resolve() {
   bool all_completed;
   bool any_completed_this_pass;
 
+  // complete_pointers() and finalize() may look at the payloads.
+  flush_payloads();
+
   do {
     if (bam_cat.is_spam()) {
       bam_cat.spam()
@@ -900,6 +910,8 @@ finalize_now(TypedWritable *whom) {
     return;
   }
 
+  flush_payloads();
+
   Finalize::iterator fi = _finalize_list.find(whom);
   if (fi != _finalize_list.end()) {
     _finalize_list.erase(fi);
@@ -1006,6 +1018,94 @@ free_object_ids(DatagramIterator &scan) {
 }
 
 
+/**
+ * Reads size bytes from the datagram into the indicated buffer, like
+ * DatagramIterator::extract_bytes().  However, if bam-parallel-read is
+ * enabled and the payload is large enough, the copy may be postponed, so
+ * that it can be done on the worker threads together with the payloads of
+ * the other objects in the same read_object() call.
+ *
+ * This may only be called from the fillin() of the object currently being
+ * read, and the buffer must belong to that object.  The buffer must stay
+ * where it is, and must not be read, until the postponed copy has been
+ * made.  It is made before read_object() returns, and before
+ * complete_pointers() or finalize() is called on any object.  If the object
+ * has gone away by then, because its factory function failed, the copy is
+ * discarded.
+ *
+ * This is intended for the bulk data of objects, such as vertex arrays and
+ * texture images, that is copied from the file as-is.
+ */
+void BamReader::
+extract_payload(DatagramIterator &scan, unsigned char *into, size_t size) {
+  if (!bam_parallel_read || size < (size_t)bam_parallel_read_min_payload ||
+      size > scan.get_remaining_size() ||
+      _now_creating == _created_objs.end()) {
+    scan.extract_bytes(into, size);
+    return;
+  }
+
+  PendingPayload payload;
+  payload._datagram = scan.get_datagram();
+  payload._object_id = (*_now_creating).first;
+  size_t start = scan.get_current_index();
+  for (size_t offset = 0; offset < size; offset += payload_piece_size) {
+    payload._start = start + offset;
+    payload._into = into + offset;
+    payload._size = std::min(payload_piece_size, size - offset);
+    _pending_payloads.push_back(payload);
+  }
+  scan.skip_bytes(size);
+
+  _pending_payload_bytes += size;
+  if (_pending_payload_bytes >= max_pending_payload_bytes) {
+    flush_payloads();
+  }
+}
+
+/**
+ * Performs all of the copies that were postponed by extract_payload(),
+ * spreading them across the threads of the worker thread pool.
+ */
+void BamReader::
+flush_payloads() {
+  if (_pending_payloads.empty()) {
+    return;
+  }
+
+  if (bam_cat.is_debug()) {
+    bam_cat.debug()
+      << "Copying " << _pending_payload_bytes << " bytes of payload in "
+      << _pending_payloads.size() << " pieces\n";
+  }
+
+  // Make sure that the objects we are copying into are all still there.
+  // Until read_object() returns, they are held by _created_objs, so they are
+  // only missing if their factory function failed.
+  PendingPayloads::iterator pi = _pending_payloads.begin();
+  while (pi != _pending_payloads.end()) {
+    CreatedObjs::const_iterator ci = _created_objs.find((*pi)._object_id);
+    if (ci == _created_objs.end() || (*ci).second._ptr == nullptr) {
+      bam_cat.error()
+        << "Discarding payload of object " << (*pi)._object_id
+        << ", which failed to read.\n";
+      pi = _pending_payloads.erase(pi);
+    } else {
+      ++pi;
+    }
+  }
+
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  pool->parallel_for(_pending_payloads.size(), [this] (size_t n, Thread *) {
+    const PendingPayload &payload = _pending_payloads[n];
+    const unsigned char *source = (const unsigned char *)payload._datagram.get_data();
+    memcpy(payload._into, source + payload._start, payload._size);
+  }, Thread::get_current_thread());
+
+  _pending_payloads.clear();
+  _pending_payload_bytes = 0;
+}
+
 /**
  * Reads an object id from the datagram.
  */
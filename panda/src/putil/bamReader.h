@@ -191,6 +191,8 @@ public:
 
   void finalize_now(TypedWritable *whom);
 
+  void extract_payload(DatagramIterator &scan, unsigned char *into, size_t size);
+
   void *get_pta(DatagramIterator &scan);
   void register_pta(void *ptr);
 
@@ -222,6 +224,7 @@ private:
   bool resolve_cycler_pointers(PipelineCyclerBase *cycler, const vector_int &pointer_ids,
                                bool require_fully_complete);
   void finalize();
+  void flush_payloads();
 
   INLINE bool get_datagram(Datagram &datagram);
 
@@ -319,6 +322,27 @@ private:
   PTAMap _pta_map;
   int _pta_id;
 
+  // These are the copies postponed by extract_payload(), to be performed all
+  // at once by flush_payloads().  Each holds a reference to the datagram it
+  // copies from, and the id of the object that owns the buffer it copies to.
+  class PendingPayload {
+  public:
+    Datagram _datagram;
+    int _object_id;
+    size_t _start;
+    unsigned char *_into;
+    size_t _size;
+  };
+  typedef pvector<PendingPayload> PendingPayloads;
+  PendingPayloads _pending_payloads;
+  size_t _pending_payload_bytes;
+
+  // Large payloads are split into pieces of this size, so that they can be
+  // spread across threads.  Once this many bytes are pending, they are
+  // flushed, to limit the number of datagrams we keep around.
+  static const size_t payload_piece_size = 1 << 20;
+  static const size_t max_pending_payload_bytes = 64 << 20;
+
   // This is a queue of the currently-pending file data blocks that we have
   // recently encountered in the stream and still expect a subsequent object
   // to request.
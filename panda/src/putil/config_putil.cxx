@@ -89,6 +89,21 @@ ConfigVariableEnum<BamEnums::BamTextureMode> bam_texture_mode
  PRC_DESC("Set this to specify how textures should be written into Bam files."
           "See the panda source or documentation for available options."));
 
+ConfigVariableBool bam_parallel_read
+("bam-parallel-read", false,
+ PRC_DESC("Set this true to allow the BamReader to postpone copying the "
+          "large payloads of the objects it reads, such as vertex arrays "
+          "and texture images, until the end of each read_object() call, "
+          "and then copy them all at once on the threads of the worker "
+          "thread pool.  The order in which objects are completed and "
+          "finalized is not affected."));
+
+ConfigVariableInt bam_parallel_read_min_payload
+("bam-parallel-read-min-payload", 65536,
+ PRC_DESC("When bam-parallel-read is true, this is the smallest payload, in "
+          "bytes, that is worth postponing; smaller payloads are copied "
+          "immediately."));
+
 ConfigureFn(config_putil) {
   init_libputil();
 }
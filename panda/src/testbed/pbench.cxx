@@ -0,0 +1,1019 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pbench.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "pandaSystem.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "randomizer.h"
+#include "panda_getopt.h"
+#include "preprocess_argv.h"
+#include "filename.h"
+#include "transformState.h"
+#include "renderState.h"
+#include "colorAttrib.h"
+#include "transparencyAttrib.h"
+#include "depthWriteAttrib.h"
+#include "cullFaceAttrib.h"
+#include "nodePath.h"
+#include "pandaNode.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexReader.h"
+#include "geomVertexWriter.h"
+#include "camera.h"
+#include "perspectiveLens.h"
+#include "sceneSetup.h"
+#include "cullTraverser.h"
+#include "cullHandler.h"
+#include "cullableObject.h"
+#include "graphicsStateGuardian.h"
+#include "collisionTraverser.h"
+#include "collisionHandlerQueue.h"
+#include "collisionNode.h"
+#include "collisionSphere.h"
+#include "collisionRay.h"
+#include "collisionPolygon.h"
+#include "asyncTaskManager.h"
+#include "asyncTaskChain.h"
+#include "patomic.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <stdint.h>
+
+using std::cerr;
+using std::endl;
+using std::ostream;
+using std::string;
+
+/**
+ * The base class of each of the benchmarks.  A benchmark sets up whatever
+ * it needs in setup(), and then has run() called repeatedly to measure how
+ * long the operation takes.
+ */
+class Benchmark {
+public:
+  Benchmark(const string &name, const string &unit) :
+    _name(name), _unit(unit) {}
+  virtual ~Benchmark() {}
+
+  // Returns false if the benchmark cannot run in this environment.
+  virtual bool setup() { return true; }
+  virtual void teardown() {}
+
+  // Performs the operation the indicated number of times, and returns the
+  // number of units of work done.
+  virtual uint64_t run(uint64_t iterations)=0;
+
+  string _name;
+  string _unit;
+};
+
+/**
+ * The result of running one of the benchmarks.
+ */
+class BenchmarkResult {
+public:
+  string _name;
+  string _unit;
+  bool _skipped;
+  uint64_t _units_per_sample;
+  pvector<double> _ns_per_unit;
+};
+
+/**
+ * Summarizes the samples of a benchmark.
+ */
+class SampleStats {
+public:
+  explicit SampleStats(const pvector<double> &samples) {
+    pvector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t n = sorted.size();
+    _min = sorted.front();
+    _max = sorted.back();
+    if (n % 2 == 0) {
+      _median = (sorted[n / 2 - 1] + sorted[n / 2]) * 0.5;
+    } else {
+      _median = sorted[n / 2];
+    }
+
+    _mean = 0.0;
+    for (double ns : sorted) {
+      _mean += ns;
+    }
+    _mean /= n;
+  }
+
+  double _min;
+  double _median;
+  double _mean;
+  double _max;
+};
+
+// Keeps the results of the operations alive, so that the compiler can't
+// optimize them away.
+static CPT(TransformState) sink_transform;
+static CPT(RenderState) sink_state;
+static double sink_value = 0.0;
+
+static LPoint3
+random_point(Randomizer &random, PN_stdfloat range) {
+  return LPoint3(random.random_real(range * 2) - range,
+                 random.random_real(range * 2) - range,
+                 random.random_real(range * 2) - range);
+}
+
+/**
+ * Builds a GeomNode with a single small triangle.
+ */
+static PT(GeomNode)
+make_triangle_node(const string &name, int num_vertices) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    (name, GeomVertexFormat::get_v3n3t2(), Geom::UH_static);
+  vdata->unclean_set_num_rows(num_vertices);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  for (int i = 0; i < num_vertices; ++i) {
+    PN_stdfloat a = (PN_stdfloat)i / (PN_stdfloat)num_vertices;
+    vertex.set_data3(a, (i % 3) * 0.5f, 0.0f);
+    normal.set_data3(0.0f, 0.0f, 1.0f);
+    texcoord.set_data2(a, 1.0f - a);
+  }
+  for (int i = 0; i + 2 < num_vertices; i += 3) {
+    tris->add_vertices(i, i + 1, i + 2);
+  }
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  PT(GeomNode) node = new GeomNode(name);
+  node->add_geom(geom);
+  return node;
+}
+
+/**
+ * Composes pairs of a fixed set of transforms, which will mostly be served
+ * from the composition cache.
+ */
+class TransformCompose : public Benchmark {
+public:
+  TransformCompose() : Benchmark("transform_compose", "compose") {}
+
+  virtual bool setup() {
+    Randomizer random(1);
+    for (int i = 0; i < num_states; ++i) {
+      _states[i] = TransformState::make_pos_hpr_scale
+        (random_point(random, 100), random_point(random, 180),
+         LVecBase3(1.0f + random.random_real(1)));
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sink_transform = _states[i % num_states]->compose(_states[(i * 7 + 3) % num_states]);
+    }
+    return iterations;
+  }
+
+  static const int num_states = 64;
+  CPT(TransformState) _states[num_states];
+};
+
+/**
+ * Composes transforms that have never been seen before, so that each
+ * operation also creates a new TransformState and adds it to the caches.
+ */
+class TransformComposeUncached : public Benchmark {
+public:
+  TransformComposeUncached() : Benchmark("transform_compose_uncached", "compose"), _counter(0) {}
+
+  virtual bool setup() {
+    _base = TransformState::make_hpr(LVecBase3(30, 45, 0));
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      ++_counter;
+      CPT(TransformState) pos = TransformState::make_pos(LVecBase3((PN_stdfloat)_counter, 1, 2));
+      sink_transform = _base->compose(pos);
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    sink_transform.clear();
+    _base.clear();
+  }
+
+  CPT(TransformState) _base;
+  uint64_t _counter;
+};
+
+/**
+ * Computes the relative transform between pairs of a fixed set of
+ * transforms.
+ */
+class TransformInvertCompose : public Benchmark {
+public:
+  TransformInvertCompose() : Benchmark("transform_invert_compose", "invert_compose") {}
+
+  virtual bool setup() {
+    Randomizer random(2);
+    for (int i = 0; i < num_states; ++i) {
+      _states[i] = TransformState::make_pos_hpr_scale
+        (random_point(random, 100), random_point(random, 180),
+         LVecBase3(1.0f + random.random_real(1)));
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sink_transform = _states[i % num_states]->invert_compose(_states[(i * 5 + 1) % num_states]);
+    }
+    return iterations;
+  }
+
+  static const int num_states = 64;
+  CPT(TransformState) _states[num_states];
+};
+
+/**
+ * Composes pairs of a fixed set of render states with a handful of
+ * attributes each.
+ */
+class RenderStateCompose : public Benchmark {
+public:
+  RenderStateCompose() : Benchmark("render_state_compose", "compose") {}
+
+  virtual bool setup() {
+    for (int i = 0; i < num_states; ++i) {
+      CPT(RenderState) state = RenderState::make
+        (ColorAttrib::make_flat(LColor((i & 3) * 0.25f, (i & 12) * 0.0625f, 0.5f, 1)));
+      if (i & 1) {
+        state = state->add_attrib(TransparencyAttrib::make(TransparencyAttrib::M_alpha));
+      }
+      if (i & 2) {
+        state = state->add_attrib(DepthWriteAttrib::make(DepthWriteAttrib::M_off));
+      }
+      if (i & 4) {
+        state = state->add_attrib(CullFaceAttrib::make(CullFaceAttrib::M_cull_none));
+      }
+      _states[i] = state;
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sink_state = _states[i % num_states]->compose(_states[(i * 7 + 3) % num_states]);
+    }
+    return iterations;
+  }
+
+  static const int num_states = 32;
+  CPT(RenderState) _states[num_states];
+};
+
+/**
+ * Moves a set of nodes around with NodePath::set_pos().
+ */
+class NodePathSetPos : public Benchmark {
+public:
+  NodePathSetPos() : Benchmark("nodepath_set_pos", "set_pos") {}
+
+  virtual bool setup() {
+    _root = NodePath("root");
+    for (int i = 0; i < num_nodes; ++i) {
+      _nodes[i] = _root.attach_new_node("node");
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      _nodes[i % num_nodes].set_pos((PN_stdfloat)(i & 0xff), 1.0f, 2.0f);
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    _root.remove_node();
+  }
+
+  static const int num_nodes = 1024;
+  NodePath _root;
+  NodePath _nodes[num_nodes];
+};
+
+/**
+ * Computes the net transform of the leaf of a deep hierarchy.  If dirty is
+ * true, the root is moved before each computation, so the cached net
+ * transforms can't be used.
+ */
+class NodePathNetTransform : public Benchmark {
+public:
+  NodePathNetTransform(bool dirty) :
+    Benchmark(dirty ? "nodepath_get_net_transform_dirty" : "nodepath_get_net_transform",
+              "get_net_transform"),
+    _dirty(dirty) {}
+
+  virtual bool setup() {
+    _root = NodePath("root");
+    _leaf = _root;
+    for (int i = 0; i < depth; ++i) {
+      _leaf = _leaf.attach_new_node("node");
+      _leaf.set_pos_hpr(1, 0, 0, 10, 0, 0);
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      if (_dirty) {
+        _root.set_x((PN_stdfloat)(i & 0xff));
+      }
+      sink_transform = _leaf.get_net_transform();
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    sink_transform.clear();
+    _root.remove_node();
+  }
+
+  static const int depth = 16;
+  bool _dirty;
+  NodePath _root;
+  NodePath _leaf;
+};
+
+/**
+ * A CullHandler that just counts the objects it is given.
+ */
+class CountingCullHandler : public CullHandler {
+public:
+  virtual void record_object(CullableObject &&object,
+                             const CullTraverser *traverser) {
+    _count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  patomic<int> _count {0};
+};
+
+/**
+ * Culls a synthetic scene of many small GeomNodes in a grid of groups, about
+ * half of which are outside the view frustum.
+ */
+class CullTraverse : public Benchmark {
+public:
+  CullTraverse() : Benchmark("cull_traverse", "traversal") {}
+
+  virtual bool setup() {
+    _render = NodePath("render");
+    PT(GeomNode) model = make_triangle_node("tri", 3);
+    for (int g = 0; g < grid_size * grid_size; ++g) {
+      NodePath group = _render.attach_new_node("group");
+      group.set_pos((g % grid_size - grid_size / 2) * 20.0f,
+                    (g / grid_size) * 20.0f, 0.0f);
+      for (int i = 0; i < nodes_per_group; ++i) {
+        NodePath np = group.attach_new_node(model->copy_subgraph());
+        np.set_pos((i % 4) * 4.0f, (i / 4) * 4.0f, 0.0f);
+      }
+    }
+
+    PT(Camera) camera = new Camera("camera", new PerspectiveLens);
+    _camera = _render.attach_new_node(camera);
+    _camera.set_pos(0, -10, 5);
+
+    // We never draw anything, so we don't need a real GSG.
+    _gsg = new GraphicsStateGuardian(CS_default, nullptr, nullptr);
+
+    _scene_setup = new SceneSetup;
+    _scene_setup->set_scene_root(_render);
+    _scene_setup->set_camera_path(_camera);
+    _scene_setup->set_camera_node(camera);
+    _scene_setup->set_lens(camera->get_lens());
+    _scene_setup->set_initial_state(RenderState::make_empty());
+    _scene_setup->set_camera_transform(_camera.get_transform(NodePath()));
+    _scene_setup->set_world_transform(NodePath().get_transform(_camera));
+    CPT(TransformState) cs_transform = _gsg->get_cs_transform_for(camera->get_lens()->get_coordinate_system());
+    _scene_setup->set_cs_transform(cs_transform);
+    _scene_setup->set_cs_world_transform(cs_transform->compose(_scene_setup->get_world_transform()));
+
+    PT(BoundingVolume) bv = _scene_setup->get_cull_bounds();
+    PT(GeometricBoundingVolume) frustum = bv->make_copy()->as_geometric_bounding_volume();
+    frustum->xform(_camera.get_mat(NodePath()));
+    _scene_setup->set_view_frustum(frustum);
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      CountingCullHandler handler;
+      CullTraverser trav;
+      trav.set_cull_handler(&handler);
+      trav.set_scene(_scene_setup, _gsg, false);
+      trav.traverse(_render);
+      trav.end_traverse();
+      sink_value += handler._count.load();
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    _scene_setup.clear();
+    _gsg.clear();
+    _render.remove_node();
+  }
+
+  static const int grid_size = 16;
+  static const int nodes_per_group = 16;
+  NodePath _render;
+  NodePath _camera;
+  PT(GraphicsStateGuardian) _gsg;
+  PT(SceneSetup) _scene_setup;
+};
+
+/**
+ * Tests a set of spheres or rays, moving around above it, against a soup of
+ * triangles in a single CollisionNode.
+ */
+class CollisionPolySoup : public Benchmark {
+public:
+  CollisionPolySoup(bool rays) :
+    Benchmark(rays ? "collision_ray_polygons" : "collision_sphere_polygons", "traversal"),
+    _rays(rays) {}
+
+  virtual bool setup() {
+    _root = NodePath("root");
+    PT(CollisionNode) soup = new CollisionNode("soup");
+    soup->set_from_collide_mask(CollideMask::all_off());
+    for (int y = 0; y < grid_size; ++y) {
+      for (int x = 0; x < grid_size; ++x) {
+        // Give the ground a bit of a slope and some bumps.
+        LPoint3 a(x, y, (x * y) % 3 * 0.1f);
+        LPoint3 b(x + 1, y, ((x + 1) * y) % 3 * 0.1f);
+        LPoint3 c(x + 1, y + 1, ((x + 1) * (y + 1)) % 3 * 0.1f);
+        LPoint3 d(x, y + 1, (x * (y + 1)) % 3 * 0.1f);
+        soup->add_solid(new CollisionPolygon(a, b, c));
+        soup->add_solid(new CollisionPolygon(a, c, d));
+      }
+    }
+    _root.attach_new_node(soup);
+
+    _handler = new CollisionHandlerQueue;
+    for (int i = 0; i < num_colliders; ++i) {
+      PT(CollisionNode) cnode = new CollisionNode("collider");
+      if (_rays) {
+        cnode->add_solid(new CollisionRay(LPoint3(0, 0, 1), LVector3(0, 0, -1)));
+      } else {
+        cnode->add_solid(new CollisionSphere(LPoint3(0, 0, 0), 0.75f));
+      }
+      cnode->set_into_collide_mask(CollideMask::all_off());
+      _colliders[i] = _root.attach_new_node(cnode);
+      _trav.add_collider(_colliders[i], _handler);
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    Randomizer random(3);
+    for (uint64_t i = 0; i < iterations; ++i) {
+      for (int c = 0; c < num_colliders; ++c) {
+        _colliders[c].set_pos(random.random_real(grid_size),
+                              random.random_real(grid_size), 0.5f);
+      }
+      _trav.traverse(_root);
+      sink_value += _handler->get_num_entries();
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    _trav.clear_colliders();
+    _handler.clear();
+    _root.remove_node();
+  }
+
+  static const int grid_size = 64;
+  static const int num_colliders = 16;
+  bool _rays;
+  NodePath _root;
+  NodePath _colliders[num_colliders];
+  CollisionTraverser _trav;
+  PT(CollisionHandlerQueue) _handler;
+};
+
+/**
+ * Writes the vertices, normals and texcoords of a large vertex table with
+ * GeomVertexWriter.
+ */
+class VertexWriterBench : public Benchmark {
+public:
+  VertexWriterBench() : Benchmark("geom_vertex_writer", "row") {}
+
+  virtual bool setup() {
+    _vdata = new GeomVertexData("bench", GeomVertexFormat::get_v3n3t2(), Geom::UH_static);
+    _vdata->unclean_set_num_rows(num_rows);
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      GeomVertexWriter vertex(_vdata, InternalName::get_vertex());
+      GeomVertexWriter normal(_vdata, InternalName::get_normal());
+      GeomVertexWriter texcoord(_vdata, InternalName::get_texcoord());
+      for (int r = 0; r < num_rows; ++r) {
+        vertex.set_data3((PN_stdfloat)r, 1.0f, 2.0f);
+        normal.set_data3(0.0f, 0.0f, 1.0f);
+        texcoord.set_data2((PN_stdfloat)r, 0.5f);
+      }
+    }
+    return iterations * num_rows;
+  }
+
+  virtual void teardown() {
+    _vdata.clear();
+  }
+
+  static const int num_rows = 65536;
+  PT(GeomVertexData) _vdata;
+};
+
+/**
+ * Reads back the vertices, normals and texcoords of a large vertex table
+ * with GeomVertexReader.
+ */
+class VertexReaderBench : public Benchmark {
+public:
+  VertexReaderBench() : Benchmark("geom_vertex_reader", "row") {}
+
+  virtual bool setup() {
+    _vdata = new GeomVertexData("bench", GeomVertexFormat::get_v3n3t2(), Geom::UH_static);
+    _vdata->unclean_set_num_rows(num_rows);
+    GeomVertexWriter vertex(_vdata, InternalName::get_vertex());
+    GeomVertexWriter normal(_vdata, InternalName::get_normal());
+    GeomVertexWriter texcoord(_vdata, InternalName::get_texcoord());
+    for (int r = 0; r < num_rows; ++r) {
+      vertex.set_data3((PN_stdfloat)r, 1.0f, 2.0f);
+      normal.set_data3(0.0f, 0.0f, 1.0f);
+      texcoord.set_data2((PN_stdfloat)r, 0.5f);
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      GeomVertexReader vertex(_vdata, InternalName::get_vertex());
+      GeomVertexReader normal(_vdata, InternalName::get_normal());
+      GeomVertexReader texcoord(_vdata, InternalName::get_texcoord());
+      PN_stdfloat sum = 0.0f;
+      while (!vertex.is_at_end()) {
+        sum += vertex.get_data3()[0] + normal.get_data3()[2] + texcoord.get_data2()[1];
+      }
+      sink_value += sum;
+    }
+    return iterations * num_rows;
+  }
+
+  virtual void teardown() {
+    _vdata.clear();
+  }
+
+  static const int num_rows = 65536;
+  PT(GeomVertexData) _vdata;
+};
+
+/**
+ * Decodes a scene of many GeomNodes from an in-memory bam stream.
+ */
+class BamLoad : public Benchmark {
+public:
+  BamLoad() : Benchmark("bam_load", "load") {}
+
+  virtual bool setup() {
+    NodePath root("root");
+    for (int i = 0; i < num_nodes; ++i) {
+      NodePath np = root.attach_new_node(make_triangle_node("node", 96));
+      np.set_pos((PN_stdfloat)i, 0.0f, 0.0f);
+    }
+    _data = root.encode_to_bam_stream();
+    root.remove_node();
+    return !_data.empty();
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      NodePath np = NodePath::decode_from_bam_stream(_data);
+      sink_value += np.get_num_children();
+      np.remove_node();
+    }
+    return iterations;
+  }
+
+  virtual void teardown() {
+    _data.clear();
+  }
+
+  static const int num_nodes = 1024;
+  vector_uchar _data;
+};
+
+/**
+ * Runs an epoch of many trivial tasks on a task chain without threads, by
+ * calling poll().
+ */
+class TaskDispatchPoll : public Benchmark {
+public:
+  TaskDispatchPoll() : Benchmark("task_dispatch_poll", "task") {}
+
+  virtual bool setup() {
+    _manager = new AsyncTaskManager("pbench");
+    AsyncTaskChain *chain = _manager->make_task_chain("default");
+    for (int i = 0; i < num_tasks; ++i) {
+      chain->add([] (AsyncTask *) {
+        sink_value += 1.0;
+        return AsyncTask::DS_cont;
+      }, "task", i % 4, i % 16);
+    }
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      _manager->poll();
+    }
+    return iterations * num_tasks;
+  }
+
+  virtual void teardown() {
+    _manager->cleanup();
+    _manager.clear();
+  }
+
+  static const int num_tasks = 1000;
+  PT(AsyncTaskManager) _manager;
+};
+
+/**
+ * Dispatches many short tasks to a task chain with several threads, either
+ * from its shared queue or in work-stealing mode.
+ */
+class TaskDispatchThreaded : public Benchmark {
+public:
+  TaskDispatchThreaded(bool work_stealing) :
+    Benchmark(work_stealing ? "task_dispatch_threads_stealing" : "task_dispatch_threads", "task"),
+    _work_stealing(work_stealing) {}
+
+  virtual bool setup() {
+    if (!Thread::is_true_threads()) {
+      return false;
+    }
+    _manager = new AsyncTaskManager("pbench");
+    _chain = _manager->make_task_chain("threads", num_threads, TP_normal);
+    _chain->set_work_stealing(_work_stealing);
+    return true;
+  }
+
+  virtual uint64_t run(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      for (int t = 0; t < num_tasks; ++t) {
+        _chain->add([] (AsyncTask *) {
+          return AsyncTask::DS_done;
+        }, "task", 0, t % 16);
+      }
+      _chain->wait_for_tasks();
+    }
+    return iterations * num_tasks;
+  }
+
+  virtual void teardown() {
+    _manager->cleanup();
+    _manager.clear();
+  }
+
+  static const int num_threads = 4;
+  static const int num_tasks = 1000;
+  bool _work_stealing;
+  PT(AsyncTaskManager) _manager;
+  AsyncTaskChain *_chain;
+};
+
+/**
+ * Runs the benchmark, first finding a number of iterations that takes at
+ * least min_time seconds, and then timing that many iterations num_samples
+ * times.
+ */
+static BenchmarkResult
+run_benchmark(Benchmark *bench, double min_time, int num_samples) {
+  BenchmarkResult result;
+  result._name = bench->_name;
+  result._unit = bench->_unit;
+  result._skipped = false;
+  result._units_per_sample = 0;
+
+  if (!bench->setup()) {
+    result._skipped = true;
+    return result;
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  // Warm up the caches, and calibrate.
+  uint64_t iterations = 1;
+  while (true) {
+    double start = clock->get_short_time();
+    bench->run(iterations);
+    double elapsed = clock->get_short_time() - start;
+    if (elapsed >= min_time || iterations >= ((uint64_t)1 << 40)) {
+      break;
+    }
+    double factor = (elapsed > 0.0) ? (min_time * 1.2 / elapsed) : 100.0;
+    iterations = (uint64_t)(iterations * std::min(std::max(factor, 2.0), 100.0));
+  }
+
+  for (int s = 0; s < num_samples; ++s) {
+    double start = clock->get_short_time();
+    uint64_t units = bench->run(iterations);
+    double elapsed = clock->get_short_time() - start;
+    result._units_per_sample = units;
+    result._ns_per_unit.push_back(elapsed * 1.0e9 / (double)units);
+  }
+
+  bench->teardown();
+  return result;
+}
+
+/**
+ * Writes the string, quoted and escaped as a JSON string.
+ */
+static void
+write_json_string(ostream &out, const string &str) {
+  out << '"';
+  for (char ch : str) {
+    switch (ch) {
+    case '"': out << "\\\""; break;
+    case '\\': out << "\\\\"; break;
+    case '\n': out << "\\n"; break;
+    case '\t': out << "\\t"; break;
+    default:
+      if ((unsigned char)ch < 0x20) {
+        char buffer[8];
+        sprintf(buffer, "\\u%04x", (unsigned char)ch);
+        out << buffer;
+      } else {
+        out << ch;
+      }
+    }
+  }
+  out << '"';
+}
+
+static void
+write_json(ostream &out, const pvector<BenchmarkResult> &results,
+           double min_time, int num_samples) {
+  PandaSystem *ps = PandaSystem::get_global_ptr();
+  out << "{\n  \"panda_version\": ";
+  write_json_string(out, ps->get_version_string());
+  out << ",\n  \"platform\": ";
+  write_json_string(out, ps->get_platform());
+  out << ",\n  \"compiler\": ";
+  write_json_string(out, ps->get_compiler());
+  out << ",\n  \"build_date\": ";
+  write_json_string(out, ps->get_build_date());
+  out << ",\n  \"true_threads\": " << (Thread::is_true_threads() ? "true" : "false")
+      << ",\n  \"min_sample_time\": " << min_time
+      << ",\n  \"num_samples\": " << num_samples
+      << ",\n  \"benchmarks\": [";
+
+  bool first = true;
+  for (const BenchmarkResult &result : results) {
+    out << (first ? "\n" : ",\n") << "    {\"name\": ";
+    first = false;
+    write_json_string(out, result._name);
+    out << ", \"unit\": ";
+    write_json_string(out, result._unit);
+    if (result._skipped) {
+      out << ", \"skipped\": true}";
+      continue;
+    }
+
+    SampleStats stats(result._ns_per_unit);
+    out << ", \"units_per_sample\": " << result._units_per_sample
+        << ", \"ns_per_unit\": {\"min\": " << stats._min
+        << ", \"median\": " << stats._median
+        << ", \"mean\": " << stats._mean
+        << ", \"max\": " << stats._max
+        << "}, \"units_per_second\": " << 1.0e9 / stats._median
+        << ", \"samples\": [";
+    for (size_t i = 0; i < result._ns_per_unit.size(); ++i) {
+      out << (i == 0 ? "" : ", ") << result._ns_per_unit[i];
+    }
+    out << "]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+static void
+write_csv(ostream &out, const pvector<BenchmarkResult> &results) {
+  out << "name,unit,units_per_sample,min_ns,median_ns,mean_ns,max_ns\n";
+  for (const BenchmarkResult &result : results) {
+    if (result._skipped) {
+      out << result._name << "," << result._unit << ",0,,,,\n";
+      continue;
+    }
+    SampleStats stats(result._ns_per_unit);
+    out << result._name << "," << result._unit << ","
+        << result._units_per_sample << "," << stats._min << ","
+        << stats._median << "," << stats._mean << "," << stats._max
+        << "\n";
+  }
+}
+
+static void
+usage() {
+  cerr <<
+    "\n"
+    "Usage: pbench [opts] [name ...]\n"
+    "       pbench -h\n\n";
+}
+
+static void
+help() {
+  usage();
+  cerr <<
+    "pbench measures the performance of some of the core operations of\n"
+    "Panda3D, such as composing transforms, culling and collision detection,\n"
+    "and writes the results in a machine-readable format, so that they can\n"
+    "be compared between builds.\n\n"
+
+    "If any names are given, only the benchmarks whose names contain one of\n"
+    "them are run.\n\n"
+
+    "Options:\n\n"
+
+    "  -o filename\n"
+    "      Write the results to the indicated file, rather than to standard\n"
+    "      output.\n\n"
+
+    "  -f json|csv\n"
+    "      Select the output format.  The default is json.\n\n"
+
+    "  -t seconds\n"
+    "      The minimum duration of each sample.  The default is 0.2.\n\n"
+
+    "  -n count\n"
+    "      The number of samples to take of each benchmark.  The default is 5.\n\n"
+
+    "  -l\n"
+    "      List the names of the benchmarks, and exit.\n\n"
+
+    "  -h\n"
+    "      Display this help text.\n\n";
+}
+
+int
+main(int argc, char **argv) {
+  preprocess_argv(argc, argv);
+
+  Filename output_filename;
+  string format = "json";
+  double min_time = 0.2;
+  int num_samples = 5;
+  bool list_only = false;
+
+  extern char *optarg;
+  extern int optind;
+  static const char *optflags = "o:f:t:n:lh";
+  int flag = getopt(argc, argv, optflags);
+
+  while (flag != EOF) {
+    switch (flag) {
+    case 'o':
+      output_filename = Filename::from_os_specific(optarg);
+      break;
+
+    case 'f':
+      format = optarg;
+      if (format != "json" && format != "csv") {
+        cerr << "Unknown format: " << format << endl;
+        return 1;
+      }
+      break;
+
+    case 't':
+      min_time = atof(optarg);
+      break;
+
+    case 'n':
+      num_samples = std::max(atoi(optarg), 1);
+      break;
+
+    case 'l':
+      list_only = true;
+      break;
+
+    case 'h':
+      help();
+      return 1;
+
+    case '?':
+      usage();
+      return 1;
+
+    default:
+      cerr << "Unhandled switch: " << flag << endl;
+      break;
+    }
+    flag = getopt(argc, argv, optflags);
+  }
+  argc -= (optind - 1);
+  argv += (optind - 1);
+
+  pvector<Benchmark *> benchmarks;
+  benchmarks.push_back(new TransformCompose);
+  benchmarks.push_back(new TransformComposeUncached);
+  benchmarks.push_back(new TransformInvertCompose);
+  benchmarks.push_back(new RenderStateCompose);
+  benchmarks.push_back(new NodePathSetPos);
+  benchmarks.push_back(new NodePathNetTransform(false));
+  benchmarks.push_back(new NodePathNetTransform(true));
+  benchmarks.push_back(new CullTraverse);
+  benchmarks.push_back(new CollisionPolySoup(false));
+  benchmarks.push_back(new CollisionPolySoup(true));
+  benchmarks.push_back(new VertexWriterBench);
+  benchmarks.push_back(new VertexReaderBench);
+  benchmarks.push_back(new BamLoad);
+  benchmarks.push_back(new TaskDispatchPoll);
+  benchmarks.push_back(new TaskDispatchThreaded(false));
+  benchmarks.push_back(new TaskDispatchThreaded(true));
+
+  pvector<BenchmarkResult> results;
+  for (Benchmark *bench : benchmarks) {
+    bool selected = (argc <= 1);
+    for (int i = 1; i < argc && !selected; ++i) {
+      selected = (bench->_name.find(argv[i]) != string::npos);
+    }
+
+    if (selected) {
+      if (list_only) {
+        std::cout << bench->_name << "\n";
+      } else {
+        cerr << bench->_name << "..." << std::flush;
+        results.push_back(run_benchmark(bench, min_time, num_samples));
+
+        const BenchmarkResult &result = results.back();
+        if (result._skipped) {
+          cerr << " skipped\n";
+        } else {
+          SampleStats stats(result._ns_per_unit);
+          cerr << " " << stats._median << " ns/" << result._unit << "\n";
+        }
+      }
+    }
+    delete bench;
+  }
+
+  if (list_only) {
+    return 0;
+  }
+
+  std::ofstream file;
+  ostream *out = &std::cout;
+  if (!output_filename.empty()) {
+    output_filename.set_text();
+    if (!output_filename.open_write(file)) {
+      cerr << "Unable to write " << output_filename << endl;
+      return 1;
+    }
+    out = &file;
+  }
+
+  if (format == "csv") {
+    write_csv(*out, results);
+  } else {
+    write_json(*out, results, min_time, num_samples);
+  }
+  return 0;
+}
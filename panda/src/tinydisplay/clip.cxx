@@ -11,6 +11,7 @@
 #define CLIP_ZMIN   (1<<4)
 #define CLIP_ZMAX   (1<<5)
 
+using std::max;
 using std::min;
 
 void gl_transform_to_viewport(GLContext *c,GLVertex *v)
@@ -406,7 +407,47 @@ void gl_draw_triangle_fill(GLContext *c,
   }
 #endif
 
-  (*c->zb_fill_tri)(c->zb,&p0->zp,&p1->zp,&p2->zp);
+  if (c->triangle_bin != nullptr) {
+    gl_bin_triangle(c->triangle_bin,&p0->zp,&p1->zp,&p2->zp);
+  } else {
+    (*c->zb_fill_tri)(c->zb,&p0->zp,&p1->zp,&p2->zp);
+  }
+}
+
+/* Set aside a triangle to be rasterized later */
+
+void gl_bin_triangle(ZTriangleBin *bin,
+                     ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  ZBufferPoint *p;
+  int ymin, ymax;
+
+  if (bin->num_triangles >= bin->max_triangles) {
+    int max_triangles = bin->max_triangles * 2 + 64;
+    p = (ZBufferPoint *)gl_malloc(max_triangles * 3 * sizeof(ZBufferPoint));
+    if (bin->points != nullptr) {
+      memcpy(p, bin->points, bin->num_triangles * 3 * sizeof(ZBufferPoint));
+      gl_free(bin->points);
+    }
+    bin->points = p;
+    bin->max_triangles = max_triangles;
+  }
+
+  p = bin->points + bin->num_triangles * 3;
+  p[0] = *p0;
+  p[1] = *p1;
+  p[2] = *p2;
+
+  ymin = min(p0->y, min(p1->y, p2->y));
+  ymax = max(p0->y, max(p1->y, p2->y));
+  if (bin->num_triangles == 0) {
+    bin->ymin = ymin;
+    bin->ymax = ymax;
+  } else {
+    bin->ymin = min(bin->ymin, ymin);
+    bin->ymax = max(bin->ymax, ymax);
+  }
+  bin->num_triangles++;
 }
 
 /* Render a clipped triangle in line mode */  
@@ -57,6 +57,28 @@ ConfigVariableBool td_perspective_textures
             "textures on the tinydisplay software renderer, for a small "
             "performance gain."));
 
+ConfigVariableBool td_batch_vertex_transform
+  ("td-batch-vertex-transform", true,
+   PRC_DESC("Configure this true to let the tinydisplay software renderer "
+            "transform all of the vertices of a Geom in one batch, using SSE2 "
+            "where it is available.  Set it false to transform each vertex "
+            "separately, as in earlier versions.  The results are the same "
+            "either way."));
+
+ConfigVariableBool td_parallel_raster
+  ("td-parallel-raster", false,
+   PRC_DESC("Configure this true to let the tinydisplay software renderer "
+            "rasterize the triangles of each Geom on several threads at once, "
+            "each thread filling its own band of rows of the frame buffer.  "
+            "The threads are those of the shared WorkerThreadPool; see "
+            "worker-thread-pool-size."));
+
+ConfigVariableInt td_parallel_raster_rows
+  ("td-parallel-raster-rows", 32,
+   PRC_DESC("The minimum number of rows of the frame buffer in each band "
+            "when td-parallel-raster is in effect.  Geoms that cover fewer "
+            "than twice this many rows are rasterized on one thread."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -29,5 +29,8 @@ extern ConfigVariableInt td_texture_ram;
 extern ConfigVariableBool td_ignore_mipmaps;
 extern ConfigVariableBool td_ignore_clamp;
 extern ConfigVariableBool td_perspective_textures;
+extern ConfigVariableBool td_batch_vertex_transform;
+extern ConfigVariableBool td_parallel_raster;
+extern ConfigVariableInt td_parallel_raster_rows;
 
 #endif
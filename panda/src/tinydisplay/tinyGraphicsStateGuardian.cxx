@@ -39,6 +39,7 @@
 #include "ztriangle_table.h"
 #include "store_pixel_table.h"
 #include "graphicsEngine.h"
+#include "workerThreadPool.h"
 
 using std::max;
 using std::min;
@@ -72,6 +73,7 @@ TinyGraphicsStateGuardian(GraphicsEngine *engine, GraphicsPipe *pipe,
   _c = nullptr;
   _vertices = nullptr;
   _vertices_size = 0;
+  memset(&_triangle_bin, 0, sizeof(_triangle_bin));
 }
 
 /**
@@ -155,6 +157,11 @@ free_pointers() {
     _vertices = nullptr;
   }
   _vertices_size = 0;
+
+  if (_triangle_bin.points != nullptr) {
+    gl_free(_triangle_bin.points);
+  }
+  memset(&_triangle_bin, 0, sizeof(_triangle_bin));
 }
 
 /**
@@ -685,14 +692,46 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
     needs_normal = false;
   }
 
+  // Transform all of the vertices in one batch, before going back to light
+  // them and fill in the remaining vertex attributes.
+  fetch_vertex_column(rvertex, _vertices[0].coord.v, 4, num_used_vertices, force);
+  if (_c->lighting_enabled) {
+    if (needs_normal && num_used_vertices > 0) {
+      fetch_vertex_column(rnormal, _vertices[0].normal.v, 3, num_used_vertices, force);
+
+      // Leave the current normal where the per-vertex path would have left
+      // it.
+      const V3 &n = _vertices[num_used_vertices - 1].normal;
+      _c->current_normal.v[0] = n.v[0];
+      _c->current_normal.v[1] = n.v[1];
+      _c->current_normal.v[2] = n.v[2];
+      _c->current_normal.v[3] = 0.0f;
+    } else {
+      for (i = 0; i < num_used_vertices; ++i) {
+        V3 &n = _vertices[i].normal;
+        n.v[0] = _c->current_normal.v[0];
+        n.v[1] = _c->current_normal.v[1];
+        n.v[2] = _c->current_normal.v[2];
+      }
+    }
+  }
+  if (td_batch_vertex_transform) {
+    gl_vertex_transform_array(_c, _vertices, num_used_vertices);
+  } else {
+    for (i = 0; i < num_used_vertices; ++i) {
+      GLVertex *v = &_vertices[i];
+      if (_c->lighting_enabled) {
+        _c->current_normal.v[0] = v->normal.v[0];
+        _c->current_normal.v[1] = v->normal.v[1];
+        _c->current_normal.v[2] = v->normal.v[2];
+        _c->current_normal.v[3] = 0.0f;
+      }
+      gl_vertex_transform(_c, v);
+    }
+  }
+
   for (i = 0; i < num_used_vertices; ++i) {
     GLVertex *v = &_vertices[i];
-    const LVecBase4 &d = rvertex.get_data4();
-
-    v->coord.v[0] = d[0];
-    v->coord.v[1] = d[1];
-    v->coord.v[2] = d[2];
-    v->coord.v[3] = d[3];
 
     // Texture coordinates.
     for (int si = 0; si < max_stage_index; ++si) {
@@ -722,19 +761,7 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
     v->color = _c->current_color;
 
     if (_c->lighting_enabled) {
-      if (needs_normal) {
-        const LVecBase3 &d = rnormal.get_data3();
-        _c->current_normal.v[0] = d[0];
-        _c->current_normal.v[1] = d[1];
-        _c->current_normal.v[2] = d[2];
-        _c->current_normal.v[3] = 0.0f;
-      }
-
-      gl_vertex_transform(_c, v);
       gl_shade_vertex(_c, v);
-
-    } else {
-      gl_vertex_transform(_c, v);
     }
 
     if (v->clip_code == 0) {
@@ -937,6 +964,14 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
   pixel_count_smooth_multitex3 = 0;
 #endif  // DO_PSTATS
 
+  // If other threads are available to help, set the triangles aside, so that
+  // they can be rasterized in parallel at end_draw_primitives().
+  _c->triangle_bin = nullptr;
+  if (td_parallel_raster && WorkerThreadPool::get_global_ptr()->is_parallel()) {
+    _triangle_bin.num_triangles = 0;
+    _c->triangle_bin = &_triangle_bin;
+  }
+
   return true;
 }
 
@@ -1169,6 +1204,10 @@ draw_tristrips(const GeomPrimitivePipelineReader *reader, bool force) {
 bool TinyGraphicsStateGuardian::
 draw_lines(const GeomPrimitivePipelineReader *reader, bool force) {
   PStatTimer timer(_draw_primitive_pcollector, reader->get_current_thread());
+
+  // These are drawn directly, so they must come after any triangles that
+  // have been set aside.
+  flush_triangle_bin();
 #ifndef NDEBUG
   if (tinydisplay_cat.is_spam()) {
     tinydisplay_cat.spam() << "draw_lines: " << *(reader->get_object()) << "\n";
@@ -1246,6 +1285,10 @@ draw_lines(const GeomPrimitivePipelineReader *reader, bool force) {
 bool TinyGraphicsStateGuardian::
 draw_points(const GeomPrimitivePipelineReader *reader, bool force) {
   PStatTimer timer(_draw_primitive_pcollector, reader->get_current_thread());
+
+  // These are drawn directly, so they must come after any triangles that
+  // have been set aside.
+  flush_triangle_bin();
 #ifndef NDEBUG
   if (tinydisplay_cat.is_spam()) {
     tinydisplay_cat.spam() << "draw_points: " << *(reader->get_object()) << "\n";
@@ -1319,6 +1362,8 @@ draw_points(const GeomPrimitivePipelineReader *reader, bool force) {
  */
 void TinyGraphicsStateGuardian::
 end_draw_primitives() {
+  flush_triangle_bin();
+  _c->triangle_bin = nullptr;
 
 #ifdef DO_PSTATS
   _pixel_count_white_untextured_pcollector.add_level(pixel_count_white_untextured);
@@ -1337,6 +1382,74 @@ end_draw_primitives() {
   GraphicsStateGuardian::end_draw_primitives();
 }
 
+/**
+ * Rasterizes the triangles that have been set aside since
+ * begin_draw_primitives().  If they cover enough rows of the frame buffer,
+ * the rows are divided into bands, which are filled in parallel by the
+ * threads of the WorkerThreadPool.  Every band visits the triangles in the
+ * order in which they were drawn, using the same fill function, so the
+ * result is exactly the same as rasterizing them one at a time.
+ */
+void TinyGraphicsStateGuardian::
+flush_triangle_bin() {
+  int num_triangles = _triangle_bin.num_triangles;
+  if (num_triangles == 0) {
+    return;
+  }
+  _triangle_bin.num_triangles = 0;
+
+  PStatTimer timer(_draw_primitive_pcollector);
+
+  ZB_fillTriangleFunc fill_tri = _c->zb_fill_tri;
+  ZBuffer *zb = _c->zb;
+  const ZBufferPoint *points = _triangle_bin.points;
+
+  WorkerThreadPool *pool = WorkerThreadPool::get_global_ptr();
+  int ymin = max(_triangle_bin.ymin, zb->clip_ymin);
+  int num_rows = min(_triangle_bin.ymax + 1, zb->clip_ymax) - ymin;
+  int num_bands = min((pool->get_num_threads() + 1) * 2,
+                      num_rows / max((int)td_parallel_raster_rows, 1));
+
+  if (num_bands < 2) {
+    for (int i = 0; i < num_triangles; ++i) {
+      // The fill functions may modify the points, so pass copies.
+      ZBufferPoint p0 = points[i * 3];
+      ZBufferPoint p1 = points[i * 3 + 1];
+      ZBufferPoint p2 = points[i * 3 + 2];
+      (*fill_tri)(zb, &p0, &p1, &p2);
+    }
+    return;
+  }
+
+  pool->parallel_for((size_t)num_bands, [&] (size_t n, Thread *current_thread) {
+    ZBuffer band_zb = *zb;
+    if (n != 0) {
+      band_zb.clip_ymin = ymin + (int)(((int64_t)num_rows * n) / num_bands);
+    }
+    if (n + 1 != (size_t)num_bands) {
+      band_zb.clip_ymax = ymin + (int)(((int64_t)num_rows * (n + 1)) / num_bands);
+    }
+
+    for (int i = 0; i < num_triangles; ++i) {
+      const ZBufferPoint *p = points + i * 3;
+
+      // The topmost band sees every triangle, since it also counts the
+      // pixels of each one (see ztriangle.h).  The others skip the triangles
+      // that miss them.
+      if (n != 0 &&
+          (max(p[0].y, max(p[1].y, p[2].y)) < band_zb.clip_ymin ||
+           min(p[0].y, min(p[1].y, p[2].y)) >= band_zb.clip_ymax)) {
+        continue;
+      }
+
+      ZBufferPoint p0 = p[0];
+      ZBufferPoint p1 = p[1];
+      ZBufferPoint p2 = p[2];
+      (*fill_tri)(&band_zb, &p0, &p1, &p2);
+    }
+  });
+}
+
 /**
  * Copy the pixels within the indicated display region from the framebuffer
  * into texture memory.
@@ -3150,6 +3263,62 @@ get_tex_wrap_func(SamplerState::WrapMode wrap_mode) {
   return &texcoord_repeat;
 }
 
+/**
+ * Copies the first num_components values of the reader's column, for each of
+ * num_rows rows starting at the reader's current row, to dest and to each
+ * subsequent GLVertex following it.  A missing fourth component is filled in
+ * as 1.  This reads directly from the array when the column consists of plain
+ * floats, which avoids going through the reader one row at a time.
+ */
+void TinyGraphicsStateGuardian::
+fetch_vertex_column(GeomVertexReader &reader, PN_stdfloat *dest,
+                    int num_components, int num_rows, bool force) {
+  nassertv(num_components == 3 || num_components == 4);
+  const GeomVertexColumn *column = reader.get_column();
+
+  const unsigned char *pointer = nullptr;
+  if (column->get_numeric_type() == GeomEnums::NT_float32 &&
+      column->get_num_components() >= 3) {
+    pointer = reader.get_array_handle()->get_read_pointer(force);
+  }
+
+  if (pointer != nullptr) {
+    size_t stride = reader.get_stride();
+    pointer += column->get_start() + (size_t)reader.get_read_row() * stride;
+    bool has_w = (column->get_num_components() >= 4);
+    for (int i = 0; i < num_rows; ++i) {
+      const float *data = (const float *)pointer;
+      dest[0] = data[0];
+      dest[1] = data[1];
+      dest[2] = data[2];
+      if (num_components == 4) {
+        dest[3] = has_w ? data[3] : 1.0f;
+      }
+      pointer += stride;
+      dest = (PN_stdfloat *)((unsigned char *)dest + sizeof(GLVertex));
+    }
+
+  } else if (num_components == 4) {
+    for (int i = 0; i < num_rows; ++i) {
+      const LVecBase4 &d = reader.get_data4();
+      dest[0] = d[0];
+      dest[1] = d[1];
+      dest[2] = d[2];
+      dest[3] = d[3];
+      dest = (PN_stdfloat *)((unsigned char *)dest + sizeof(GLVertex));
+    }
+
+  } else {
+    for (int i = 0; i < num_rows; ++i) {
+      const LVecBase3 &d = reader.get_data3();
+      dest[0] = d[0];
+      dest[1] = d[1];
+      dest[2] = d[2];
+      dest = (PN_stdfloat *)((unsigned char *)dest + sizeof(GLVertex));
+    }
+  }
+}
+
 /**
  * Generates invalid texture coordinates.  Used when texture coordinate params
  * are invalid or unsupported.
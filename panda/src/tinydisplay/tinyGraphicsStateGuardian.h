@@ -108,6 +108,7 @@ private:
   void do_issue_scissor();
 
   void set_scissor(PN_stdfloat left, PN_stdfloat right, PN_stdfloat bottom, PN_stdfloat top);
+  void flush_triangle_bin();
 
   bool apply_texture(TextureContext *tc);
   bool upload_texture(TinyTextureContext *gtc, bool force, bool uses_mipmaps);
@@ -144,6 +145,10 @@ private:
   static void texgen_simple(V2 &result, TexCoordData &tcdata);
   static void texgen_texmat(V2 &result, TexCoordData &tcdata);
   static void texgen_sphere_map(V2 &result, TexCoordData &tcdata);
+
+  static void fetch_vertex_column(GeomVertexReader &reader, PN_stdfloat *dest,
+                                  int num_components, int num_rows,
+                                  bool force);
 public:
   // Filled in by the Tiny*GraphicsWindow at begin_frame().
   ZBuffer *_current_frame_buffer;
@@ -180,6 +185,10 @@ private:
   GLVertex *_vertices;
   int _vertices_size;
 
+  // Collects the filled triangles of the current Geom when they are to be
+  // rasterized in parallel; see flush_triangle_bin().
+  ZTriangleBin _triangle_bin;
+
   static PStatCollector _vertices_immediate_pcollector;
   static PStatCollector _draw_transform_pcollector;
   static PStatCollector _pixel_count_white_untextured_pcollector;
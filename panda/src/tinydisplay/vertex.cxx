@@ -1,6 +1,11 @@
 #include "zgl.h"
 #include <string.h>
 
+#if !defined(STDFLOAT_DOUBLE) && (defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#define TD_VERTEX_SSE2
+#endif
+
 void gl_eval_viewport(GLContext * c) {
   GLViewport *v = &c->viewport;
   GLScissor *s = &c->scissor;
@@ -82,3 +87,121 @@ gl_vertex_transform(GLContext * c, GLVertex * v) {
 
   v->clip_code = gl_clipcode(v->pc.v[0], v->pc.v[1], v->pc.v[2], v->pc.v[3]);
 }
+
+#ifdef TD_VERTEX_SSE2
+/* Spreads the three low bits of a movemask result out to the even bits of a
+   clip code. */
+static const int clip_bits[8] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+
+/* Same as gl_clipcode(), for all of the components of pc at once */
+static inline int gl_clipcode_sse2(__m128 pc)
+{
+  __m128 w = _mm_shuffle_ps(pc, pc, _MM_SHUFFLE(3, 3, 3, 3));
+  w = _mm_mul_ps(w, _mm_set1_ps(1.0f + CLIP_EPSILON));
+  __m128 neg_w = _mm_xor_ps(w, _mm_set1_ps(-0.0f));
+  int lt = _mm_movemask_ps(_mm_cmplt_ps(pc, neg_w)) & 7;
+  int gt = _mm_movemask_ps(_mm_cmpgt_ps(pc, w)) & 7;
+  return clip_bits[lt] | (clip_bits[gt] << 1);
+}
+
+/* Returns the indicated column of the matrix, so that a row-major matrix can
+   be applied to a vector with a few broadcast multiply-adds.  The products
+   are summed in the same order as gl_vertex_transform(), so the results are
+   identical. */
+static inline __m128 gl_matrix_column(const M4 *m, int i)
+{
+  return _mm_setr_ps(m->m[0][i], m->m[1][i], m->m[2][i], m->m[3][i]);
+}
+#endif  /* TD_VERTEX_SSE2 */
+
+/* Transforms count vertices at once, which is equivalent to (but faster
+   than) calling gl_vertex_transform() on each of them.  Rather than reading
+   c->current_normal, the object-space normal of each vertex must already be
+   stored in its normal member if lighting is enabled. */
+void
+gl_vertex_transform_array(GLContext * c, GLVertex * v, int count) {
+#ifdef TD_VERTEX_SSE2
+  GLVertex *end = v + count;
+
+  if (c->lighting_enabled) {
+    __m128 mv0 = gl_matrix_column(&c->matrix_model_view, 0);
+    __m128 mv1 = gl_matrix_column(&c->matrix_model_view, 1);
+    __m128 mv2 = gl_matrix_column(&c->matrix_model_view, 2);
+    __m128 mv3 = gl_matrix_column(&c->matrix_model_view, 3);
+    __m128 p0 = gl_matrix_column(&c->matrix_projection, 0);
+    __m128 p1 = gl_matrix_column(&c->matrix_projection, 1);
+    __m128 p2 = gl_matrix_column(&c->matrix_projection, 2);
+    __m128 p3 = gl_matrix_column(&c->matrix_projection, 3);
+    __m128 n0 = gl_matrix_column(&c->matrix_model_view_inv, 0);
+    __m128 n1 = gl_matrix_column(&c->matrix_model_view_inv, 1);
+    __m128 n2 = gl_matrix_column(&c->matrix_model_view_inv, 2);
+    __m128 scale = _mm_set1_ps(c->normal_scale);
+
+    for (; v < end; ++v) {
+      /* eye coordinates needed for lighting */
+      __m128 ec = _mm_mul_ps(_mm_set1_ps(v->coord.v[0]), mv0);
+      ec = _mm_add_ps(ec, _mm_mul_ps(_mm_set1_ps(v->coord.v[1]), mv1));
+      ec = _mm_add_ps(ec, _mm_mul_ps(_mm_set1_ps(v->coord.v[2]), mv2));
+      ec = _mm_add_ps(ec, mv3);
+      _mm_storeu_ps(v->ec.v, ec);
+
+      /* projection coordinates */
+      __m128 pc = _mm_mul_ps(_mm_shuffle_ps(ec, ec, _MM_SHUFFLE(0, 0, 0, 0)), p0);
+      pc = _mm_add_ps(pc, _mm_mul_ps(_mm_shuffle_ps(ec, ec, _MM_SHUFFLE(1, 1, 1, 1)), p1));
+      pc = _mm_add_ps(pc, _mm_mul_ps(_mm_shuffle_ps(ec, ec, _MM_SHUFFLE(2, 2, 2, 2)), p2));
+      pc = _mm_add_ps(pc, _mm_mul_ps(_mm_shuffle_ps(ec, ec, _MM_SHUFFLE(3, 3, 3, 3)), p3));
+      _mm_storeu_ps(v->pc.v, pc);
+
+      __m128 n = _mm_mul_ps(_mm_set1_ps(v->normal.v[0]), n0);
+      n = _mm_add_ps(n, _mm_mul_ps(_mm_set1_ps(v->normal.v[1]), n1));
+      n = _mm_add_ps(n, _mm_mul_ps(_mm_set1_ps(v->normal.v[2]), n2));
+      n = _mm_mul_ps(n, scale);
+
+      float normal[4];
+      _mm_storeu_ps(normal, n);
+      v->normal.v[0] = normal[0];
+      v->normal.v[1] = normal[1];
+      v->normal.v[2] = normal[2];
+      if (c->normalize_enabled) {
+        gl_V3_Norm(&v->normal);
+      }
+
+      v->clip_code = gl_clipcode_sse2(pc);
+    }
+  } else {
+    /* no eye coordinates needed, no normal */
+    /* NOTE: W = 1 is assumed */
+    __m128 m0 = gl_matrix_column(&c->matrix_model_projection, 0);
+    __m128 m1 = gl_matrix_column(&c->matrix_model_projection, 1);
+    __m128 m2 = gl_matrix_column(&c->matrix_model_projection, 2);
+    __m128 m3 = gl_matrix_column(&c->matrix_model_projection, 3);
+    /* If the w row is constant, w is taken straight from m[15]. */
+    __m128 w_mask = c->matrix_model_projection_no_w_transform ?
+      _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)) :
+      _mm_castsi128_ps(_mm_set1_epi32(-1));
+    __m128 w_const = _mm_andnot_ps(w_mask, m3);
+
+    for (; v < end; ++v) {
+      __m128 pc = _mm_mul_ps(_mm_set1_ps(v->coord.v[0]), m0);
+      pc = _mm_add_ps(pc, _mm_mul_ps(_mm_set1_ps(v->coord.v[1]), m1));
+      pc = _mm_add_ps(pc, _mm_mul_ps(_mm_set1_ps(v->coord.v[2]), m2));
+      pc = _mm_add_ps(pc, m3);
+      pc = _mm_or_ps(_mm_and_ps(pc, w_mask), w_const);
+      _mm_storeu_ps(v->pc.v, pc);
+
+      v->clip_code = gl_clipcode_sse2(pc);
+    }
+  }
+
+#else  /* TD_VERTEX_SSE2 */
+  for (int i = 0; i < count; ++i) {
+    if (c->lighting_enabled) {
+      c->current_normal.v[0] = v[i].normal.v[0];
+      c->current_normal.v[1] = v[i].normal.v[1];
+      c->current_normal.v[2] = v[i].normal.v[2];
+      c->current_normal.v[3] = 0.0f;
+    }
+    gl_vertex_transform(c, &v[i]);
+  }
+#endif  /* TD_VERTEX_SSE2 */
+}
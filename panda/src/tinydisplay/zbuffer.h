@@ -174,6 +174,11 @@ struct ZBuffer {
   int reference_alpha;
   int blend_r, blend_g, blend_b, blend_a;
   ZB_storePixelFunc store_pix_func;
+
+  /* The triangle rasterizers only draw the rows in [clip_ymin, clip_ymax).
+     This is normally the whole buffer, but it is narrowed to one band at a
+     time when several threads share the rendering of a batch of triangles. */
+  int clip_ymin, clip_ymax;
 };
 
 struct ZBufferPoint {
@@ -136,6 +136,15 @@ typedef struct GLTexture {
   int total_bytecount;
 } GLTexture;
 
+/* Filled triangles that have been set aside, so that the whole batch can be
+   rasterized later by several threads, each into its own band of rows. */
+typedef struct ZTriangleBin {
+  ZBufferPoint *points;   /* three for each triangle */
+  int num_triangles;
+  int max_triangles;
+  int ymin, ymax;         /* the range of rows touched by the triangles */
+} ZTriangleBin;
+
 struct GLContext;
 
 typedef void (*gl_draw_triangle_func)(struct GLContext *c,
@@ -185,6 +194,9 @@ typedef struct GLContext {
   gl_draw_triangle_func draw_triangle_front,draw_triangle_back;
   ZB_fillTriangleFunc zb_fill_tri;
 
+  /* if not null, filled triangles are added to this instead of being drawn */
+  ZTriangleBin *triangle_bin;
+
   /* current vertex state */
   V4 current_color;
   V4 current_normal;
@@ -218,6 +230,8 @@ void gl_draw_triangle_line(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2);
 void gl_draw_triangle_fill(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2);
+void gl_bin_triangle(ZTriangleBin *bin,
+                     ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
 
 /* light.c */
 void gl_enable_disable_light(GLContext *c,int light,int v);
@@ -226,6 +240,7 @@ void gl_shade_vertex(GLContext *c,GLVertex *v);
 /* vertex.c */
 void gl_eval_viewport(GLContext *c);
 void gl_vertex_transform(GLContext * c, GLVertex * v);
+void gl_vertex_transform_array(GLContext * c, GLVertex * v, int count);
 
 /* image_util.c */
 void gl_convertRGB_to_5R6G5B(unsigned short *pixmap,unsigned char *rgb,
@@ -8,6 +8,7 @@
   ZPOINT *pz1;
   PIXEL *pp1;
   int part, update_left, update_right;
+  int line_y;
 
   int nb_lines, dx1, dy1, tmp, dx2, dy2;
 
@@ -53,7 +54,11 @@
 
   EARLY_OUT();
 
-  COUNT_PIXELS(PIXEL_COUNT, p0, p1, p2);
+  /* When the buffer is rendered in bands by several threads, only the
+     thread rendering the topmost band counts the pixels. */
+  if (zb->clip_ymin == 0) {
+    COUNT_PIXELS(PIXEL_COUNT, p0, p1, p2);
+  }
 
   /* we sort the vertex with increasing y */
   if (p1->y < p0->y) {
@@ -72,6 +77,10 @@
     p2 = t;
   }
 
+  /* skip the triangle if it lies entirely outside the rows we may draw */
+  if (p2->y < zb->clip_ymin || p0->y >= zb->clip_ymax)
+    return;
+
   /* we compute dXdx and dXdy for all interpolated values */
   
   fdx1 = (PN_stdfloat) (p1->x - p0->x);
@@ -213,6 +222,7 @@
 
   pp1 = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p0->y);
   pz1 = zb->zbuf + p0->y * zb->xsize;
+  line_y = p0->y;
 
   DRAW_INIT();
 
@@ -341,82 +351,88 @@
 
     while (nb_lines>0) {
       nb_lines--;
+      if (line_y >= zb->clip_ymax) {
+        /* the rest of the triangle is below the rows we may draw */
+        return;
+      }
+      if (line_y >= zb->clip_ymin) {
 #ifndef DRAW_LINE
-      /* generic draw line */
-      {
-        PIXEL *pp;
-        int n;
+        /* generic draw line */
+        {
+          PIXEL *pp;
+          int n;
 #ifdef INTERP_Z
-        ZPOINT *pz;
-        unsigned int z,zz;
+          ZPOINT *pz;
+          unsigned int z,zz;
 #endif
 #ifdef INTERP_RGB
-        UNUSED unsigned int or1,og1,ob1,oa1;
+          UNUSED unsigned int or1,og1,ob1,oa1;
 #endif
 #ifdef INTERP_ST
-        unsigned int s,t;
+          unsigned int s,t;
 #endif
 #ifdef INTERP_STZ
-        PN_stdfloat sz,tz;
+          PN_stdfloat sz,tz;
 #endif
 #ifdef INTERP_STZA
-        PN_stdfloat sza,tza;
+          PN_stdfloat sza,tza;
 #endif
 #ifdef INTERP_STZB
-        PN_stdfloat szb,tzb;
+          PN_stdfloat szb,tzb;
 #endif
 
-        n=(x2 >> 16) - x1;
-        pp=(PIXEL *)((char *)pp1 + x1 * PSZB);
+          n=(x2 >> 16) - x1;
+          pp=(PIXEL *)((char *)pp1 + x1 * PSZB);
 #ifdef INTERP_Z
-        pz=pz1+x1;
-        z=z1;
+          pz=pz1+x1;
+          z=z1;
 #endif
 #ifdef INTERP_RGB
-        or1 = r1;
-        og1 = g1;
-        ob1 = b1;
-        oa1 = a1;
+          or1 = r1;
+          og1 = g1;
+          ob1 = b1;
+          oa1 = a1;
 #endif
 #ifdef INTERP_ST
-        s=s1;
-        t=t1;
+          s=s1;
+          t=t1;
 #endif
 #ifdef INTERP_STZ
-        sz=sz1;
-        tz=tz1;
+          sz=sz1;
+          tz=tz1;
 #endif
 #ifdef INTERP_STZA
-        sza=sza1;
-        tza=tza1;
+          sza=sza1;
+          tza=tza1;
 #endif
 #ifdef INTERP_STZB
-        szb=szb1;
-        tzb=tzb1;
-#endif
-        while (n>=3) {
-          PUT_PIXEL(0);
-          PUT_PIXEL(1);
-          PUT_PIXEL(2);
-          PUT_PIXEL(3);
+          szb=szb1;
+          tzb=tzb1;
+#endif
+          while (n>=3) {
+            PUT_PIXEL(0);
+            PUT_PIXEL(1);
+            PUT_PIXEL(2);
+            PUT_PIXEL(3);
 #ifdef INTERP_Z
-          pz+=4;
+            pz+=4;
 #endif
-          pp=(PIXEL *)((char *)pp + 4 * PSZB);
-          n-=4;
-        }
-        while (n>=0) {
-          PUT_PIXEL(0);
+            pp=(PIXEL *)((char *)pp + 4 * PSZB);
+            n-=4;
+          }
+          while (n>=0) {
+            PUT_PIXEL(0);
 #ifdef INTERP_Z
-          pz+=1;
+            pz+=1;
 #endif
-          pp=(PIXEL *)((char *)pp + PSZB);
-          n-=1;
+            pp=(PIXEL *)((char *)pp + PSZB);
+            n-=1;
+          }
         }
-      }
 #else
-      DRAW_LINE();
+        DRAW_LINE();
 #endif
+      }
       
       /* left edge */
       error+=derror;
@@ -483,6 +499,7 @@
       /* screen coordinates */
       pp1=(PIXEL *)((char *)pp1 + zb->linesize);
       pz1+=zb->xsize;
+      line_y++;
     }
   }
 }
@@ -6,6 +6,7 @@
 #include "pStatPianoRoll.cxx"
 #include "pStatReader.cxx"
 #include "pStatServer.cxx"
+#include "pStatSessionFile.cxx"
 #include "pStatStripChart.cxx"
 #include "pStatThreadData.cxx"
 #include "pStatTimeline.cxx"
@@ -389,6 +389,9 @@ define_thread(int thread_index, const string &name, bool mark_alive) {
 
   if (_threads[thread_index]._data.is_null()) {
     _threads[thread_index]._data = new PStatThreadData(this);
+    if (_session_file != nullptr) {
+      _threads[thread_index]._data->set_session_file(_session_file, thread_index);
+    }
   }
 
   _is_dirty = true;
@@ -433,6 +436,22 @@ record_new_frame(int thread_index, int frame_number,
   _is_dirty = true;
 }
 
+/**
+ * Specifies a session file to which the frame data of each thread of this
+ * client will be moved as it ages, rather than being held in memory.  This
+ * should be called before any frame data has been recorded.
+ */
+void PStatClientData::
+set_session_file(PStatSessionFile *session_file) {
+  _session_file = session_file;
+
+  for (int thread_index = 0; thread_index < (int)_threads.size(); ++thread_index) {
+    if (_threads[thread_index]._data != nullptr) {
+      _threads[thread_index]._data->set_session_file(session_file, thread_index);
+    }
+  }
+}
+
 /**
  * Writes the client data in the form of a JSON output that can be loaded into
  * Chrome's event tracer.
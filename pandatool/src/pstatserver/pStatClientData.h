@@ -78,6 +78,8 @@ public:
   void record_new_frame(int thread_index, int frame_number,
                         PStatFrameData *frame_data);
 
+  void set_session_file(PStatSessionFile *session_file);
+
   void write_json(std::ostream &out, int pid = 0) const;
   void write_datagram(Datagram &dg) const;
   void read_datagram(DatagramIterator &scan);
@@ -90,6 +92,7 @@ private:
   bool _is_alive = false;
   mutable bool _is_dirty = false;
   PStatReader *_reader = nullptr;
+  PT(PStatSessionFile) _session_file;
 
   class Collector {
   public:
@@ -22,6 +22,9 @@
 #include "datagram.h"
 #include "datagramIterator.h"
 #include "connectionManager.h"
+#include "config_pstatclient.h"
+#include "mutexHolder.h"
+#include "string_utils.h"
 
 /**
  *
@@ -42,6 +45,19 @@ PStatReader(PStatServer *manager, PStatMonitor *monitor) :
   _udp_port = 0;
   _client_data = new PStatClientData(this);
   _monitor->set_client_data(_client_data);
+
+  _num_queued_frames = 0;
+  _decode_shutdown = false;
+#ifdef HAVE_THREADS
+  if (Thread::is_threading_supported()) {
+    for (int i = 0; i < pstats_decode_threads; ++i) {
+      PT(DecodeThread) thread = new DecodeThread(this, i);
+      if (thread->start(TP_normal, true)) {
+        _decode_threads.push_back(thread);
+      }
+    }
+  }
+#endif  // HAVE_THREADS
 }
 
 /**
@@ -49,6 +65,15 @@ PStatReader(PStatServer *manager, PStatMonitor *monitor) :
  */
 PStatReader::
 ~PStatReader() {
+  // Make sure no more frames arrive while we're shutting down the decode
+  // threads.
+  shutdown();
+  stop_decode_threads();
+
+  for (const FrameData &data : _queued_frame_data) {
+    delete data._frame_data;
+  }
+
   _manager->release_udp_port(_udp_port);
 }
 
@@ -201,6 +226,7 @@ handle_client_control_message(const PStatClientControlMessage &message) {
                               server_major_version, server_minor_version);
         _monitor->close();
       } else {
+        open_session_file(message);
         _monitor->hello_from(message._client_hostname, message._client_progname,
                              message._client_pid);
       }
@@ -280,17 +306,43 @@ handle_client_udp_data(const Datagram &datagram) {
     nassertv(initial_byte == 0);
   }
 
-  if (!_queued_frame_data.full()) {
-    FrameData data;
-    data._thread_index = source.get_uint16();
-    data._frame_number = source.get_uint32();
-    data._frame_data = new PStatFrameData;
-    data._frame_data->read_datagram(source, _client_data);
+  int thread_index = source.get_uint16();
+  int frame_number = source.get_uint32();
 
-    // Queue up the data till we're ready to handle it in a single-threaded
-    // way.
-    _queued_frame_data.push_back(data);
+  {
+    MutexHolder holder(_decode_lock);
+    if (_num_queued_frames >= queued_frame_records) {
+      // We're falling behind; drop this frame on the floor.
+      return;
+    }
+    ++_num_queued_frames;
+
+    if (!_decode_threads.empty()) {
+      // Hand off the rest of the work to the decode thread responsible for
+      // this client thread.
+      DecodeThread *thread = _decode_threads[thread_index % _decode_threads.size()];
+      RawFrameData raw;
+      raw._thread_index = thread_index;
+      raw._frame_number = frame_number;
+      raw._datagram = datagram;
+      raw._offset = source.get_current_index();
+      raw._version = _client_data;
+      thread->_raw_frames.push_back(std::move(raw));
+      thread->_cvar.notify();
+      return;
+    }
   }
+
+  FrameData data;
+  data._thread_index = thread_index;
+  data._frame_number = frame_number;
+  data._frame_data = new PStatFrameData;
+  data._frame_data->read_datagram(source, _client_data);
+
+  // Queue up the data till we're ready to handle it in a single-threaded
+  // way.
+  MutexHolder holder(_decode_lock);
+  _queued_frame_data.push_back(data);
 }
 
 /**
@@ -299,14 +351,25 @@ handle_client_udp_data(const Datagram &datagram) {
  */
 void PStatReader::
 dequeue_frame_data() {
-  if (_queued_frame_data.empty()) {
-    return;
+  QueuedFrameData queued_frame_data;
+  {
+    MutexHolder holder(_decode_lock);
+    if (_queued_frame_data.empty()) {
+      return;
+    }
+    queued_frame_data.swap(_queued_frame_data);
+    _num_queued_frames -= (int)queued_frame_data.size();
   }
 
-  do {
-    const FrameData &data = _queued_frame_data.front();
-    nassertv(_client_data != nullptr);
+  if (_client_data == nullptr) {
+    // The connection has been lost in the meantime.
+    for (const FrameData &data : queued_frame_data) {
+      delete data._frame_data;
+    }
+    return;
+  }
 
+  for (const FrameData &data : queued_frame_data) {
     // Check to see if any new collectors have level data.
     int num_levels = data._frame_data->get_num_levels();
     for (int i = 0; i < num_levels; i++) {
@@ -322,10 +385,7 @@ dequeue_frame_data() {
                                    data._frame_number,
                                    data._frame_data);
     _monitor->new_data(data._thread_index, data._frame_number);
-
-    _queued_frame_data.pop_front();
   }
-  while (!_queued_frame_data.empty());
 
   // Clean up old threads.
   for (int thread_index = 0; thread_index < _client_data->get_num_threads(); ++thread_index) {
@@ -338,3 +398,104 @@ dequeue_frame_data() {
     }
   }
 }
+
+/**
+ * Called when the client says hello.  If pstats-session-dir is set, creates a
+ * session file there to hold the client's older frame data.
+ */
+void PStatReader::
+open_session_file(const PStatClientControlMessage &message) {
+  Filename session_dir = pstats_session_dir;
+  if (session_dir.empty()) {
+    return;
+  }
+
+  std::string progname =
+    Filename(message._client_progname).get_basename_wo_extension();
+  if (progname.empty()) {
+    progname = "pstats";
+  }
+
+  // Don't clobber the file of another client that happens to have the same
+  // name and pid.
+  Filename filename;
+  int n = 0;
+  do {
+    std::ostringstream strm;
+    strm << progname << "-" << message._client_pid;
+    if (n != 0) {
+      strm << "-" << n;
+    }
+    strm << ".psts";
+    filename = Filename(session_dir, strm.str());
+    ++n;
+  } while (filename.exists());
+
+  PT(PStatSessionFile) session_file = new PStatSessionFile;
+  if (session_file->open(filename)) {
+    _client_data->set_session_file(session_file);
+  }
+}
+
+/**
+ * Stops and waits for all of the decode threads.  Any frames that they have
+ * not yet decoded are discarded.
+ */
+void PStatReader::
+stop_decode_threads() {
+  {
+    MutexHolder holder(_decode_lock);
+    _decode_shutdown = true;
+    for (DecodeThread *thread : _decode_threads) {
+      thread->_cvar.notify();
+    }
+  }
+
+  for (DecodeThread *thread : _decode_threads) {
+    thread->join();
+  }
+  _decode_threads.clear();
+}
+
+/**
+ *
+ */
+PStatReader::DecodeThread::
+DecodeThread(PStatReader *reader, int index) :
+  Thread("PStatDecode-" + format_string(index), "PStatDecode"),
+  _reader(reader),
+  _cvar(reader->_decode_lock)
+{
+}
+
+/**
+ * Decodes frames as they are handed to this thread by
+ * handle_client_udp_data(), and queues them up for dequeue_frame_data().
+ */
+void PStatReader::DecodeThread::
+thread_main() {
+  _reader->_decode_lock.acquire();
+  while (true) {
+    while (_raw_frames.empty() && !_reader->_decode_shutdown) {
+      _cvar.wait();
+    }
+    if (_reader->_decode_shutdown) {
+      break;
+    }
+
+    RawFrameData raw = std::move(_raw_frames.front());
+    _raw_frames.pop_front();
+    _reader->_decode_lock.release();
+
+    FrameData data;
+    data._thread_index = raw._thread_index;
+    data._frame_number = raw._frame_number;
+    data._frame_data = new PStatFrameData;
+    DatagramIterator source(raw._datagram, raw._offset);
+    data._frame_data->read_datagram(source, raw._version);
+
+    _reader->_decode_lock.acquire();
+    _reader->_queued_frame_data.push_back(data);
+  }
+  _reader->_decode_lock.release();
+}
@@ -22,7 +22,11 @@
 #include "connectionReader.h"
 #include "connectionWriter.h"
 #include "referenceCount.h"
-#include "circBuffer.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+#include "pdeque.h"
+#include "pvector.h"
 
 class PStatServer;
 class PStatMonitor;
@@ -61,6 +65,9 @@ private:
   void handle_client_udp_data(const Datagram &datagram);
   void dequeue_frame_data();
 
+  void open_session_file(const PStatClientControlMessage &message);
+  void stop_decode_threads();
+
 private:
   PStatServer *_manager;
   PT(PStatMonitor) _monitor;
@@ -80,8 +87,40 @@ private:
     int _frame_number;
     PStatFrameData *_frame_data;
   };
-  typedef CircBuffer<FrameData, queued_frame_records> QueuedFrameData;
+  typedef pdeque<FrameData> QueuedFrameData;
+
+  // A frame that has been received, but not yet decoded.
+  class RawFrameData {
+  public:
+    int _thread_index;
+    int _frame_number;
+    Datagram _datagram;
+    size_t _offset;
+    PT(PStatClientVersion) _version;
+  };
+  typedef pdeque<RawFrameData> RawFrames;
+
+  // The frames are decoded by a pool of these threads.  All of the frames of
+  // a particular client thread go to the same decode thread, so that they
+  // are delivered in the order they were received.
+  class DecodeThread : public Thread {
+  public:
+    DecodeThread(PStatReader *reader, int index);
+    virtual void thread_main();
+
+    PStatReader *_reader;
+    RawFrames _raw_frames;
+    ConditionVar _cvar;
+  };
+  typedef pvector<PT(DecodeThread)> DecodeThreads;
+  DecodeThreads _decode_threads;
+
+  // This protects the following members, as well as the _raw_frames of each
+  // decode thread.
+  Mutex _decode_lock;
   QueuedFrameData _queued_frame_data;
+  int _num_queued_frames;
+  bool _decode_shutdown;
 };
 
 #endif
@@ -0,0 +1,457 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatSessionFile.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "pStatSessionFile.h"
+#include "pStatFrameData.h"
+
+const char PStatSessionFile::_magic[4] = { 'P', 'S', 'T', 'S' };
+
+/**
+ *
+ */
+PStatSessionFile::
+PStatSessionFile() :
+  _size(0),
+  _write_failed(false)
+{
+}
+
+/**
+ *
+ */
+PStatSessionFile::
+~PStatSessionFile() {
+  close();
+}
+
+/**
+ * Creates the indicated file, replacing any file of the same name, and
+ * prepares it to receive chunks.  Returns true on success, false on failure.
+ */
+bool PStatSessionFile::
+open(const Filename &filename) {
+  close();
+
+  _filename = Filename::binary_filename(filename);
+  _filename.make_dir();
+  if (!_filename.open_write(_out)) {
+    nout << "Unable to create PStats session file " << _filename << "\n";
+    return false;
+  }
+
+  unsigned char header[6];
+  memcpy(header, _magic, 4);
+  header[4] = (unsigned char)(_version & 0xff);
+  header[5] = (unsigned char)(_version >> 8);
+  _out.write((const char *)header, sizeof(header));
+  _out.flush();
+  if (_out.fail()) {
+    nout << "Unable to write to PStats session file " << _filename << "\n";
+    _out.close();
+    _filename.unlink();
+    return false;
+  }
+
+  _size = sizeof(header);
+  _write_failed = false;
+  return true;
+}
+
+/**
+ * Closes and removes the file.  The file only holds data on behalf of the
+ * PStatThreadData objects that wrote it, so it has no further use once they
+ * are gone; use the monitor's save function to keep a capture.
+ */
+void PStatSessionFile::
+close() {
+  _mapping.clear();
+  _chunks.clear();
+  _free.clear();
+  if (is_open()) {
+    _out.close();
+    _filename.unlink();
+    _size = 0;
+  }
+}
+
+/**
+ * Writes a chunk holding the indicated frames, which must all belong to the
+ * indicated thread and must be listed in increasing order of frame number.
+ * The chunk goes into space left behind by released chunks if there is
+ * enough of it, or at the end of the file otherwise.
+ *
+ * Returns the offset of the chunk within the file, to be passed to
+ * read_chunk() and release_chunk() later, or 0 if the chunk could not be
+ * written.  Once a write has failed, for instance because the disk is full,
+ * all further writes fail as well, though the chunks already written can
+ * still be read.
+ */
+size_t PStatSessionFile::
+write_chunk(int thread_index, size_t num_frames, const int *frame_numbers,
+            const PStatFrameData *const *frames) {
+  if (!is_writable() || num_frames == 0) {
+    return 0;
+  }
+
+  vector_uchar body;
+  body.push_back((unsigned char)(thread_index & 0xff));
+  body.push_back((unsigned char)((thread_index >> 8) & 0xff));
+  add_varint(body, num_frames);
+
+  add_zigzag(body, frame_numbers[0]);
+  for (size_t i = 1; i < num_frames; ++i) {
+    nassertr(frame_numbers[i] > frame_numbers[i - 1], 0);
+    add_varint(body, (uint64_t)(frame_numbers[i] - frame_numbers[i - 1]));
+  }
+
+  for (size_t i = 0; i < num_frames; ++i) {
+    add_varint(body, frames[i]->get_num_events());
+    add_varint(body, frames[i]->get_num_levels());
+  }
+
+  // The collector index of each event, with the low bit set for a start
+  // event, followed by the collector index of each level.  Meanwhile, gather
+  // up the values by collector.
+  typedef pmap<int, pvector<uint32_t> > Columns;
+  Columns time_columns, level_columns;
+
+  for (size_t i = 0; i < num_frames; ++i) {
+    const PStatFrameData *frame = frames[i];
+    size_t num_events = frame->get_num_events();
+    for (size_t n = 0; n < num_events; ++n) {
+      int collector = frame->get_time_collector(n);
+      add_varint(body, ((uint64_t)collector << 1) | (frame->is_start(n) ? 1 : 0));
+      time_columns[collector].push_back(float_bits(frame->get_time(n)));
+    }
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    const PStatFrameData *frame = frames[i];
+    size_t num_levels = frame->get_num_levels();
+    for (size_t n = 0; n < num_levels; ++n) {
+      int collector = frame->get_level_collector(n);
+      add_varint(body, collector);
+      level_columns[collector].push_back(float_bits(frame->get_level(n)));
+    }
+  }
+
+  // Now the values themselves, one column per collector.  For non-negative
+  // floats, the bit patterns sort the same way as the values, so nearby
+  // values have nearby bit patterns.
+  for (Columns *columns : { &time_columns, &level_columns }) {
+    add_varint(body, columns->size());
+    for (const auto &item : *columns) {
+      add_varint(body, item.first);
+      add_varint(body, item.second.size());
+      int64_t prev = 0;
+      for (uint32_t bits : item.second) {
+        add_zigzag(body, (int64_t)bits - prev);
+        prev = bits;
+      }
+    }
+  }
+
+  unsigned char length[4];
+  uint32_t body_size = (uint32_t)body.size();
+  length[0] = (unsigned char)(body_size & 0xff);
+  length[1] = (unsigned char)((body_size >> 8) & 0xff);
+  length[2] = (unsigned char)((body_size >> 16) & 0xff);
+  length[3] = (unsigned char)((body_size >> 24) & 0xff);
+
+  size_t chunk_size = sizeof(length) + body.size();
+  size_t offset = allocate(chunk_size);
+  if (_mapping != nullptr && offset < _mapping->get_size()) {
+    // We're overwriting part of the file that is mapped, and the mapping
+    // isn't guaranteed to reflect that on every platform.
+    _mapping.clear();
+  }
+
+  _out.seekp(offset);
+  _out.write((const char *)length, sizeof(length));
+  _out.write((const char *)body.data(), body.size());
+  _out.flush();
+  if (_out.fail()) {
+    nout << "Unable to write to PStats session file " << _filename << "\n";
+    _write_failed = true;
+    return 0;
+  }
+
+  _chunks[offset] = chunk_size;
+  return offset;
+}
+
+/**
+ * Reads back the chunk written at the indicated offset, filling in the frame
+ * numbers and the frames.  Returns true on success, false if the chunk could
+ * not be read.
+ */
+bool PStatSessionFile::
+read_chunk(size_t offset, pvector<int> &frame_numbers,
+           pvector<PStatFrameData> &frames) {
+  frame_numbers.clear();
+  frames.clear();
+
+  if (_chunks.find(offset) == _chunks.end()) {
+    return false;
+  }
+
+  const unsigned char *p = map_range(offset, 4);
+  if (p == nullptr) {
+    return false;
+  }
+  size_t body_size = (size_t)p[0] | ((size_t)p[1] << 8) |
+    ((size_t)p[2] << 16) | ((size_t)p[3] << 24);
+
+  p = map_range(offset + 4, body_size);
+  if (p == nullptr || body_size < 2) {
+    return false;
+  }
+  const unsigned char *end = p + body_size;
+  p += 2;
+
+  // Every count below is checked against the number of bytes remaining,
+  // since each item it counts takes up at least one byte.
+  uint64_t num_frames;
+  if (!get_varint(p, end, num_frames) || num_frames > (uint64_t)(end - p)) {
+    return false;
+  }
+
+  frame_numbers.resize(num_frames);
+  int64_t frame_number;
+  if (num_frames == 0 || !get_zigzag(p, end, frame_number)) {
+    return false;
+  }
+  frame_numbers[0] = (int)frame_number;
+  for (size_t i = 1; i < num_frames; ++i) {
+    uint64_t delta;
+    if (!get_varint(p, end, delta)) {
+      return false;
+    }
+    frame_number += delta;
+    frame_numbers[i] = (int)frame_number;
+  }
+
+  pvector<uint64_t> counts(num_frames * 2);
+  uint64_t total_events = 0, total_levels = 0;
+  for (size_t i = 0; i < num_frames; ++i) {
+    if (!get_varint(p, end, counts[i * 2]) ||
+        !get_varint(p, end, counts[i * 2 + 1])) {
+      return false;
+    }
+    total_events += counts[i * 2];
+    total_levels += counts[i * 2 + 1];
+  }
+  if (total_events + total_levels > (uint64_t)(end - p)) {
+    return false;
+  }
+
+  pvector<uint64_t> collectors(total_events + total_levels);
+  for (uint64_t &collector : collectors) {
+    if (!get_varint(p, end, collector)) {
+      return false;
+    }
+  }
+
+  class Column {
+  public:
+    pvector<uint32_t> _values;
+    size_t _next = 0;
+  };
+  typedef pmap<uint64_t, Column> Columns;
+  Columns time_columns, level_columns;
+
+  for (Columns *columns : { &time_columns, &level_columns }) {
+    uint64_t num_columns;
+    if (!get_varint(p, end, num_columns) || num_columns > (uint64_t)(end - p)) {
+      return false;
+    }
+    for (uint64_t c = 0; c < num_columns; ++c) {
+      uint64_t collector, count;
+      if (!get_varint(p, end, collector) || !get_varint(p, end, count) ||
+          count > (uint64_t)(end - p)) {
+        return false;
+      }
+      Column &column = (*columns)[collector];
+      column._values.reserve(count);
+      int64_t value = 0;
+      for (uint64_t n = 0; n < count; ++n) {
+        int64_t delta;
+        if (!get_zigzag(p, end, delta)) {
+          return false;
+        }
+        value += delta;
+        column._values.push_back((uint32_t)value);
+      }
+    }
+  }
+
+  // Now deal the values back out to the frames, in the order in which the
+  // collector indices were listed.
+  frames.resize(num_frames);
+  const uint64_t *next_collector = collectors.data();
+  for (size_t i = 0; i < num_frames; ++i) {
+    PStatFrameData &frame = frames[i];
+    for (uint64_t n = 0; n < counts[i * 2]; ++n) {
+      uint64_t code = *next_collector++;
+      Columns::iterator ci = time_columns.find(code >> 1);
+      if (ci == time_columns.end() ||
+          (*ci).second._next >= (*ci).second._values.size()) {
+        return false;
+      }
+      double time = bits_float((*ci).second._values[(*ci).second._next++]);
+      if (code & 1) {
+        frame.add_start((int)(code >> 1), time);
+      } else {
+        frame.add_stop((int)(code >> 1), time);
+      }
+    }
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    PStatFrameData &frame = frames[i];
+    for (uint64_t n = 0; n < counts[i * 2 + 1]; ++n) {
+      uint64_t collector = *next_collector++;
+      Columns::iterator ci = level_columns.find(collector);
+      if (ci == level_columns.end() ||
+          (*ci).second._next >= (*ci).second._values.size()) {
+        return false;
+      }
+      frame.add_level((int)collector,
+                      bits_float((*ci).second._values[(*ci).second._next++]));
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Indicates that the chunk written at the indicated offset is no longer
+ * needed.  It can no longer be read, and its space will be reused by a later
+ * chunk.
+ */
+void PStatSessionFile::
+release_chunk(size_t offset) {
+  Ranges::iterator ci = _chunks.find(offset);
+  nassertv(ci != _chunks.end());
+  size_t length = (*ci).second;
+  _chunks.erase(ci);
+
+  // Merge the space with any free range on either side of it.
+  Ranges::iterator fi = _free.lower_bound(offset);
+  if (fi != _free.end() && (*fi).first == offset + length) {
+    length += (*fi).second;
+    fi = _free.erase(fi);
+  }
+  if (fi != _free.begin()) {
+    Ranges::iterator prev = fi;
+    --prev;
+    if ((*prev).first + (*prev).second == offset) {
+      (*prev).second += length;
+      return;
+    }
+  }
+  _free.insert(fi, Ranges::value_type(offset, length));
+}
+
+/**
+ * Finds room in the file for a chunk of the indicated length, and returns its
+ * offset.  This is the first free range that is large enough, or else the
+ * end of the file.
+ */
+size_t PStatSessionFile::
+allocate(size_t length) {
+  for (Ranges::iterator fi = _free.begin(); fi != _free.end(); ++fi) {
+    size_t offset = (*fi).first;
+    size_t available = (*fi).second;
+    if (available >= length) {
+      _free.erase(fi);
+      if (available > length) {
+        _free[offset + length] = available - length;
+      }
+      return offset;
+    }
+  }
+
+  // There's no room in the middle of the file.  If the last part of the file
+  // is free, we can at least start there.
+  size_t offset = _size;
+  if (!_free.empty()) {
+    Ranges::iterator last = _free.end();
+    --last;
+    if ((*last).first + (*last).second == _size) {
+      offset = (*last).first;
+      _free.erase(last);
+    }
+  }
+
+  _size = offset + length;
+  return offset;
+}
+
+/**
+ * Returns a pointer to the indicated range of bytes of the file, mapping (or
+ * remapping) the file as necessary, or nullptr if the range is not within the
+ * data written so far.
+ */
+const unsigned char *PStatSessionFile::
+map_range(size_t offset, size_t length) {
+  if (offset + length > _size || offset + length < offset) {
+    return nullptr;
+  }
+
+  if (_mapping == nullptr || offset + length > _mapping->get_size()) {
+    // The file has grown since we last mapped it.  Anything decoded from
+    // the old mapping has already been copied out, so we can let it go.
+    _mapping = new MappedFile;
+    if (!_mapping->open(_filename) ||
+        offset + length > _mapping->get_size()) {
+      nout << "Unable to map PStats session file " << _filename << "\n";
+      _mapping.clear();
+      return nullptr;
+    }
+  }
+
+  return _mapping->get_data() + offset;
+}
+
+/**
+ * Appends an unsigned integer, seven bits at a time, with the high bit of
+ * each byte set if more bytes follow.
+ */
+void PStatSessionFile::
+add_varint(vector_uchar &data, uint64_t value) {
+  while (value >= 0x80) {
+    data.push_back((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  data.push_back((unsigned char)value);
+}
+
+/**
+ * Reads an unsigned integer written by add_varint().  Returns false if the
+ * data runs out first or the encoding is invalid.
+ */
+bool PStatSessionFile::
+get_varint(const unsigned char *&p, const unsigned char *end,
+           uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (p >= end) {
+      return false;
+    }
+    unsigned char byte = *p++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,102 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatSessionFile.h
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#ifndef PSTATSESSIONFILE_H
+#define PSTATSESSIONFILE_H
+
+#include "pandatoolbase.h"
+#include "referenceCount.h"
+#include "filename.h"
+#include "mappedFile.h"
+#include "pointerTo.h"
+#include "pmap.h"
+#include "pvector.h"
+#include "vector_uchar.h"
+
+class PStatFrameData;
+
+/**
+ * A file on disk that holds frame data moved out of memory by the
+ * PStatThreadData objects of a single client, so that a long capture doesn't
+ * have to be held in memory in its entirety.
+ *
+ * The file is a sequence of chunks, each holding a run of consecutive frames
+ * of a single thread.  Within a chunk, the data is stored by column rather
+ * than by frame: first the frame numbers, then the collector indices of all
+ * the events, and then, for each collector, all of its timestamps in order,
+ * each stored as the difference from the previous one.  Since a collector's
+ * timestamps from one frame to the next tend to differ by about the same
+ * amount, these differences are small and pack into a few bytes each.
+ *
+ * Chunks are written as they fill up while the client is still streaming, and
+ * are read back through a memory mapping of the file.  When the oldest frames
+ * fall out of the history, their chunks are released, and the space they
+ * took up is reused for new chunks, so that the file stops growing once the
+ * history is full.
+ */
+class PStatSessionFile : public ReferenceCount {
+public:
+  PStatSessionFile();
+  ~PStatSessionFile();
+
+  bool open(const Filename &filename);
+  void close();
+
+  INLINE bool is_open() const;
+  INLINE bool is_writable() const;
+  INLINE const Filename &get_filename() const;
+  INLINE size_t get_file_size() const;
+  INLINE size_t get_num_chunks() const;
+
+  size_t write_chunk(int thread_index, size_t num_frames,
+                     const int *frame_numbers,
+                     const PStatFrameData *const *frames);
+  bool read_chunk(size_t offset, pvector<int> &frame_numbers,
+                  pvector<PStatFrameData> &frames);
+  void release_chunk(size_t offset);
+
+private:
+  size_t allocate(size_t length);
+  const unsigned char *map_range(size_t offset, size_t length);
+
+  static void add_varint(vector_uchar &data, uint64_t value);
+  INLINE static void add_zigzag(vector_uchar &data, int64_t value);
+  static bool get_varint(const unsigned char *&p, const unsigned char *end,
+                         uint64_t &value);
+  INLINE static bool get_zigzag(const unsigned char *&p,
+                                const unsigned char *end, int64_t &value);
+
+  INLINE static uint32_t float_bits(double value);
+  INLINE static double bits_float(uint32_t bits);
+
+private:
+  Filename _filename;
+  pofstream _out;
+  size_t _size;
+  bool _write_failed;
+
+  PT(MappedFile) _mapping;
+
+  // The offset and length of each chunk that has been written and not yet
+  // released, and of each range of the file that is available for reuse.
+  typedef pmap<size_t, size_t> Ranges;
+  Ranges _chunks;
+  Ranges _free;
+
+  static const char _magic[4];
+  static const uint16_t _version = 1;
+};
+
+#include "pStatSessionFile.I"
+
+#endif
@@ -17,6 +17,14 @@
 #include "pStatCollectorDef.h"
 #include "config_pstatclient.h"
 
+#include <algorithm>
+
+// The number of frames that are moved out to the session file at a time.
+static const size_t spilled_chunk_frames = 256;
+
+// The number of chunks read back from the session file that are kept in
+// memory.
+static const size_t max_loaded_chunks = 8;
 
 PStatFrameData PStatThreadData::_null_frame;
 
@@ -30,6 +38,7 @@ PStatThreadData(const PStatClientData *client_data) :
   _first_frame_number = 0;
   _history = pstats_history;
   _computed_elapsed_frames = false;
+  _thread_index = 0;
 }
 
 /**
@@ -37,6 +46,14 @@ PStatThreadData(const PStatClientData *client_data) :
  */
 PStatThreadData::
 ~PStatThreadData() {
+  for (LoadedChunk *loaded : _loaded) {
+    delete loaded;
+  }
+  if (_session_file != nullptr) {
+    for (const SpilledChunk &chunk : _spilled) {
+      _session_file->release_chunk(chunk._offset);
+    }
+  }
 }
 
 /**
@@ -53,6 +70,9 @@ get_latest_frame_number() const {
  */
 int PStatThreadData::
 get_oldest_frame_number() const {
+  if (!_spilled.empty()) {
+    return _spilled.front()._first_frame;
+  }
   nassertr(!_frames.empty(), 0);
   return _first_frame_number;
 }
@@ -63,6 +83,16 @@ get_oldest_frame_number() const {
  */
 bool PStatThreadData::
 has_frame(int frame_number) const {
+  if (frame_number < _first_frame_number && !_spilled.empty()) {
+    int ci = find_spilled_chunk(frame_number);
+    if (ci < 0 || frame_number > _spilled[ci]._last_frame) {
+      return false;
+    }
+    const LoadedChunk *loaded = load_chunk(ci);
+    return loaded != nullptr &&
+      loaded->_frame_numbers[find_loaded_frame(loaded, frame_number)] == frame_number;
+  }
+
   int rel_frame = frame_number - _first_frame_number;
 
   return (rel_frame >= 0 && rel_frame < (int)_frames.size() &&
@@ -76,6 +106,15 @@ has_frame(int frame_number) const {
  */
 const PStatFrameData &PStatThreadData::
 get_frame(int frame_number) const {
+  if (frame_number < _first_frame_number && !_spilled.empty()) {
+    const LoadedChunk *loaded =
+      load_chunk(std::max(find_spilled_chunk(frame_number), 0));
+    if (loaded != nullptr) {
+      return loaded->_frames[find_loaded_frame(loaded, frame_number)];
+    }
+    frame_number = _first_frame_number;
+  }
+
   int rel_frame = frame_number - _first_frame_number;
   int num_frames = _frames.size();
   if (rel_frame >= num_frames) {
@@ -121,6 +160,9 @@ get_latest_time() const {
  */
 double PStatThreadData::
 get_oldest_time() const {
+  if (!_spilled.empty()) {
+    return _spilled.front()._start_time;
+  }
   nassertr(!_frames.empty(), 0.0);
   return _frames.front()->get_start();
 }
@@ -144,6 +186,33 @@ get_frame_at_time(double time) const {
  */
 int PStatThreadData::
 get_frame_number_at_time(double time, int hint) const {
+  if (!_spilled.empty() && time < get_frame(_first_frame_number).get_start()) {
+    // It's in one of the chunks in the session file.  Find the last chunk
+    // that starts no later than the indicated time.
+    SpilledChunks::const_iterator ci =
+      std::upper_bound(_spilled.begin(), _spilled.end(), time,
+        [](double time, const SpilledChunk &chunk) {
+          return time < chunk._start_time;
+        });
+    if (ci == _spilled.begin()) {
+      return get_oldest_frame_number() - 1;
+    }
+    --ci;
+    const LoadedChunk *loaded = load_chunk(ci - _spilled.begin());
+    if (loaded == nullptr) {
+      return get_oldest_frame_number() - 1;
+    }
+    pvector<PStatFrameData>::const_iterator fi =
+      std::upper_bound(loaded->_frames.begin(), loaded->_frames.end(), time,
+        [](double time, const PStatFrameData &frame) {
+          return time < frame.get_start();
+        });
+    if (fi == loaded->_frames.begin()) {
+      return (*ci)._first_frame - 1;
+    }
+    return loaded->_frame_numbers[(fi - loaded->_frames.begin()) - 1];
+  }
+
   hint -= _first_frame_number;
   if (hint >= 0 && hint < (int)_frames.size()) {
     if (_frames[hint] != nullptr &&
@@ -185,7 +254,7 @@ get_frame_number_at_time(double time, int hint) const {
 
   double last = _frames[last_i]->get_start();
   double t = (time - first) / (last - first);
-  hint = std::max(0, (int)(t * (last_i - first_i))) + first_i;
+  hint = std::min(std::max(0, (int)(t * (last_i - first_i))) + first_i, last_i);
 
   // Find a frame around the guess that has data.
   if (_frames[hint] == nullptr) {
@@ -230,20 +299,21 @@ get_frame_number_at_time(double time, int hint) const {
  */
 int PStatThreadData::
 get_frame_number_after(double time, int start_at) const {
-  int i = std::max(0, start_at - _first_frame_number);
+  int latest = get_latest_frame_number();
+  int i = std::max(start_at, get_oldest_frame_number());
   double end = get_frame(i).get_end();
 
   while (end < time) {
     ++i;
-    if ((size_t)i >= _frames.size()) {
+    if (i > latest) {
       break;
     }
-    if (_frames[i] != nullptr) {
-      end = _frames[i]->get_end();
+    if (has_frame(i)) {
+      end = get_frame(i).get_end();
     }
   }
 
-  return _first_frame_number + i;
+  return i;
 }
 
 /**
@@ -318,6 +388,27 @@ get_history() const {
 bool PStatThreadData::
 prune_history(double time) {
   double oldest_allowable_time = time - _history;
+
+  // Frames in the session file are discarded a whole chunk at a time, and the
+  // space they took up is given back to the file for reuse.
+  while (!_spilled.empty() &&
+         _spilled.front()._end_time < oldest_allowable_time) {
+    size_t offset = _spilled.front()._offset;
+    for (LoadedChunks::iterator li = _loaded.begin(); li != _loaded.end(); ++li) {
+      if ((*li)->_offset == offset) {
+        delete *li;
+        _loaded.erase(li);
+        break;
+      }
+    }
+    _session_file->release_chunk(offset);
+    _spilled.pop_front();
+  }
+  if (!_spilled.empty()) {
+    // The frames in memory are all newer than the ones in the file.
+    return false;
+  }
+
   while (!_frames.empty() &&
          (_frames.front() == nullptr ||
           _frames.front()->is_time_empty() ||
@@ -343,6 +434,13 @@ record_new_frame(int frame_number, PStatFrameData *frame_data) {
   nassertv(frame_data != nullptr);
   nassertv(!frame_data->is_empty());
 
+  if (frame_number < _first_frame_number && !_spilled.empty()) {
+    // This frame arrived so late that the frames around it have already
+    // been moved out to the session file.
+    delete frame_data;
+    return;
+  }
+
   // First, remove all the old frames that fall outside of our history window.
   // Then, add enough empty frame definitions to account for the latest frame
   // number.  This might involve some skips, since we don't guarantee that we
@@ -375,6 +473,25 @@ record_new_frame(int frame_number, PStatFrameData *frame_data) {
 
   _frames[index] = frame_data;
   _computed_elapsed_frames = false;
+
+  if (_session_file != nullptr && _session_file->is_writable()) {
+    spill_frames();
+  }
+}
+
+/**
+ * Specifies a session file to which frames older than pstats-resident-history
+ * will be moved out of memory, and the index of this thread, which is
+ * recorded along with them.  This also increases the history to
+ * pstats-session-history.  This should be called before any frames have been
+ * recorded.
+ */
+void PStatThreadData::
+set_session_file(PStatSessionFile *session_file, int thread_index) {
+  nassertv(_spilled.empty());
+  _session_file = session_file;
+  _thread_index = thread_index;
+  _history = (session_file != nullptr) ? pstats_session_history : pstats_history;
 }
 
 /**
@@ -382,6 +499,16 @@ record_new_frame(int frame_number, PStatFrameData *frame_data) {
  */
 void PStatThreadData::
 write_datagram(Datagram &dg) const {
+  for (size_t ci = 0; ci < _spilled.size(); ++ci) {
+    const LoadedChunk *loaded = load_chunk(ci);
+    if (loaded != nullptr) {
+      for (size_t i = 0; i < loaded->_frames.size(); ++i) {
+        dg.add_int32(loaded->_frame_numbers[i]);
+        loaded->_frames[i].write_datagram(dg);
+      }
+    }
+  }
+
   int frame_number = _first_frame_number;
 
   for (PStatFrameData *frame_data : _frames) {
@@ -460,3 +587,136 @@ compute_elapsed_frames() const {
 
   _computed_elapsed_frames = true;
 }
+
+/**
+ * Moves the oldest frames out to the session file, a chunk at a time, until
+ * fewer than a chunk's worth of frames older than pstats-resident-history
+ * remain in memory.
+ */
+void PStatThreadData::
+spill_frames() {
+  // Keep enough frames in memory for get_elapsed_frames().
+  double resident_time = std::max((double)pstats_resident_history,
+                                  (double)pstats_average_time);
+  double oldest_resident_time = _frames.back()->get_start() - resident_time;
+
+  pvector<int> frame_numbers;
+  pvector<const PStatFrameData *> frames;
+  frame_numbers.reserve(spilled_chunk_frames);
+  frames.reserve(spilled_chunk_frames);
+
+  while (true) {
+    // Collect the oldest frames into a chunk, never including the latest
+    // frame.  Frames with no time data are dropped, as in prune_history().
+    frame_numbers.clear();
+    frames.clear();
+    size_t i = 0;
+    while (i + 1 < _frames.size() && frames.size() < spilled_chunk_frames) {
+      const PStatFrameData *frame = _frames[i];
+      if (frame != nullptr && !frame->is_time_empty()) {
+        if (frame->get_start() >= oldest_resident_time) {
+          break;
+        }
+        frame_numbers.push_back(_first_frame_number + (int)i);
+        frames.push_back(frame);
+      }
+      ++i;
+    }
+    if (frames.size() < spilled_chunk_frames) {
+      return;
+    }
+
+    size_t offset = _session_file->write_chunk(_thread_index, frames.size(),
+                                               frame_numbers.data(),
+                                               frames.data());
+    if (offset == 0) {
+      // We can't write any more to the file.  Keep the remaining frames in
+      // memory, but don't keep more of them than we normally would.
+      _history = pstats_history;
+      return;
+    }
+
+    SpilledChunk chunk;
+    chunk._offset = offset;
+    chunk._first_frame = frame_numbers.front();
+    chunk._last_frame = frame_numbers.back();
+    chunk._start_time = frames.front()->get_start();
+    chunk._end_time = frames.back()->get_start();
+    _spilled.push_back(chunk);
+
+    // Now remove them from memory, along with any gap that follows them.
+    while (i > 0 || (!_frames.empty() && _frames.front() == nullptr)) {
+      delete _frames.front();
+      _frames.pop_front();
+      ++_first_frame_number;
+      if (i > 0) {
+        --i;
+      }
+    }
+    _computed_elapsed_frames = false;
+  }
+}
+
+/**
+ * Returns the index of the last chunk in the session file that begins no
+ * later than the indicated frame, or -1 if the frame is older than all of
+ * them.
+ */
+int PStatThreadData::
+find_spilled_chunk(int frame_number) const {
+  SpilledChunks::const_iterator ci =
+    std::upper_bound(_spilled.begin(), _spilled.end(), frame_number,
+      [](int frame_number, const SpilledChunk &chunk) {
+        return frame_number < chunk._first_frame;
+      });
+  return (int)(ci - _spilled.begin()) - 1;
+}
+
+/**
+ * Returns the decoded contents of the indicated chunk of the session file,
+ * reading it from the file if it is not one of the recently used chunks.
+ * Returns nullptr if the chunk could not be read.
+ */
+const PStatThreadData::LoadedChunk *PStatThreadData::
+load_chunk(int ci) const {
+  nassertr(ci >= 0 && (size_t)ci < _spilled.size(), nullptr);
+  size_t offset = _spilled[ci]._offset;
+
+  for (LoadedChunks::iterator li = _loaded.begin(); li != _loaded.end(); ++li) {
+    if ((*li)->_offset == offset) {
+      std::rotate(_loaded.begin(), li, li + 1);
+      return _loaded.front();
+    }
+  }
+
+  LoadedChunk *loaded = new LoadedChunk;
+  loaded->_offset = offset;
+  if (_session_file == nullptr ||
+      !_session_file->read_chunk(offset, loaded->_frame_numbers, loaded->_frames) ||
+      loaded->_frames.empty()) {
+    nout << "Unable to read frames " << _spilled[ci]._first_frame << " to "
+         << _spilled[ci]._last_frame << " from PStats session file.\n";
+    delete loaded;
+    return nullptr;
+  }
+
+  if (_loaded.size() >= max_loaded_chunks) {
+    delete _loaded.back();
+    _loaded.pop_back();
+  }
+  _loaded.insert(_loaded.begin(), loaded);
+  return loaded;
+}
+
+/**
+ * Returns the index within the loaded chunk of the newest frame not newer
+ * than the indicated frame, or of the oldest frame in the chunk if they are
+ * all newer.
+ */
+int PStatThreadData::
+find_loaded_frame(const LoadedChunk *loaded, int frame_number) {
+  pvector<int>::const_iterator fi =
+    std::upper_bound(loaded->_frame_numbers.begin(),
+                     loaded->_frame_numbers.end(), frame_number);
+  return std::max((int)(fi - loaded->_frame_numbers.begin()) - 1, 0);
+}
@@ -18,11 +18,13 @@
 #include "datagram.h"
 #include "datagramIterator.h"
 #include "referenceCount.h"
+#include "pStatSessionFile.h"
+#include "pStatFrameData.h"
 
 #include "pdeque.h"
+#include "pvector.h"
 
 class PStatCollectorDef;
-class PStatFrameData;
 class PStatClientData;
 class PStatClientVersion;
 
@@ -32,6 +34,12 @@ class PStatClientVersion;
  * it automatically handles frames received out-of-order or skipped.  You can
  * ask for a particular frame by frame number or time and receive the data for
  * the nearest frame.
+ *
+ * If a PStatSessionFile is given, frames older than pstats-resident-history
+ * are moved out to the file in chunks, and are read back on demand when they
+ * are asked for.  A small number of recently read chunks is kept in memory,
+ * so a reference returned by get_frame() for such a frame remains valid at
+ * least until a few other old frames have been asked for.
  */
 class PStatThreadData : public ReferenceCount {
 public:
@@ -65,12 +73,39 @@ public:
 
   void record_new_frame(int frame_number, PStatFrameData *frame_data);
 
+  void set_session_file(PStatSessionFile *session_file, int thread_index);
+
   void write_datagram(Datagram &dg) const;
   void read_datagram(DatagramIterator &scan, PStatClientVersion *version);
 
 private:
   void compute_elapsed_frames() const;
 
+  // Describes a run of frames that has been moved out to the session file.
+  class SpilledChunk {
+  public:
+    size_t _offset;
+    int _first_frame;
+    int _last_frame;
+    double _start_time;
+    double _end_time;
+  };
+  typedef pdeque<SpilledChunk> SpilledChunks;
+
+  // The decoded contents of a SpilledChunk.
+  class LoadedChunk {
+  public:
+    size_t _offset;
+    pvector<int> _frame_numbers;
+    pvector<PStatFrameData> _frames;
+  };
+  typedef pvector<LoadedChunk *> LoadedChunks;
+
+  void spill_frames();
+  int find_spilled_chunk(int frame_number) const;
+  const LoadedChunk *load_chunk(int ci) const;
+  static int find_loaded_frame(const LoadedChunk *loaded, int frame_number);
+
   const PStatClientData *_client_data;
 
   typedef pdeque<PStatFrameData *> Frames;
@@ -84,6 +119,13 @@ private:
   mutable int _then_i;
   mutable int _now_i;
 
+  PT(PStatSessionFile) _session_file;
+  int _thread_index;
+  SpilledChunks _spilled;
+
+  // Most recently used first.
+  mutable LoadedChunks _loaded;
+
   static PStatFrameData _null_frame;
 };
 
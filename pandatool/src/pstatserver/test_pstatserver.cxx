@@ -0,0 +1,451 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_pstatserver.cxx
+ * @author agent
+ * @date 2026-10-16
+ */
+
+#include "pStatServer.h"
+#include "pStatMonitor.h"
+#include "pStatSessionFile.h"
+#include "pStatThreadData.h"
+#include "pStatFrameData.h"
+#include "pStatClientControlMessage.h"
+#include "pStatProperties.h"
+#include "config_pstatclient.h"
+#include "queuedConnectionManager.h"
+#include "connectionWriter.h"
+#include "randomizer.h"
+
+using std::cerr;
+using std::endl;
+
+static int num_failures = 0;
+
+#define check(condition) \
+  if (!(condition)) { \
+    cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+    ++num_failures; \
+  }
+
+/**
+ * Returns a frame with a few randomly timed events and levels, starting at
+ * the indicated time.
+ */
+static PStatFrameData *
+make_frame(Randomizer &random, double start) {
+  PStatFrameData *frame = new PStatFrameData;
+  frame->add_start(0, start);
+  double time = start;
+  int num_events = random.random_int(8);
+  for (int i = 0; i < num_events; ++i) {
+    int collector = 1 + random.random_int(200);
+    frame->add_start(collector, time);
+    time += random.random_real(0.002);
+    frame->add_stop(collector, time);
+  }
+  frame->add_stop(0, start + 1.0 / 60.0);
+
+  int num_levels = random.random_int(3);
+  for (int i = 0; i < num_levels; ++i) {
+    frame->add_level(random.random_int(5), random.random_real(1000.0));
+  }
+  return frame;
+}
+
+/**
+ * Returns true if the frame read back from the session file matches the
+ * original, at the single precision with which the client sends the values.
+ */
+static bool
+frames_match(const PStatFrameData &a, const PStatFrameData &b) {
+  if (a.get_num_events() != b.get_num_events() ||
+      a.get_num_levels() != b.get_num_levels()) {
+    return false;
+  }
+  for (size_t n = 0; n < a.get_num_events(); ++n) {
+    if (a.get_time_collector(n) != b.get_time_collector(n) ||
+        a.is_start(n) != b.is_start(n) ||
+        (PN_float32)a.get_time(n) != (PN_float32)b.get_time(n)) {
+      return false;
+    }
+  }
+  for (size_t n = 0; n < a.get_num_levels(); ++n) {
+    if (a.get_level_collector(n) != b.get_level_collector(n) ||
+        (PN_float32)a.get_level(n) != (PN_float32)b.get_level(n)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Writes a chunk of the indicated frames, and returns its offset.
+ */
+static size_t
+write_frames(PStatSessionFile *file, int thread_index, int first_frame,
+             const pvector<PStatFrameData *> &frames) {
+  pvector<int> frame_numbers;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    // Leave a gap now and then, as when frames are dropped.
+    frame_numbers.push_back(first_frame + (int)(i * 3 / 2));
+  }
+  return file->write_chunk(thread_index, frames.size(), frame_numbers.data(),
+                           frames.data());
+}
+
+/**
+ * Reads back a chunk written by write_frames(), and returns true if it
+ * matches.
+ */
+static bool
+read_frames(PStatSessionFile *file, size_t offset, int first_frame,
+            const pvector<PStatFrameData *> &frames) {
+  pvector<int> frame_numbers;
+  pvector<PStatFrameData> read_frames;
+  if (!file->read_chunk(offset, frame_numbers, read_frames) ||
+      read_frames.size() != frames.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frame_numbers[i] != first_frame + (int)(i * 3 / 2) ||
+        !frames_match(*frames[i], read_frames[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Tests that the chunks written to a session file read back the same.
+ */
+static void
+test_session_file_chunks() {
+  Randomizer random(1);
+  PT(PStatSessionFile) file = new PStatSessionFile;
+  Filename filename = Filename::temporary("", "pstats-", ".psts");
+  check(file->open(filename));
+  check(file->is_writable());
+
+  pvector<PStatFrameData *> frames[3];
+  size_t offsets[3];
+  for (int c = 0; c < 3; ++c) {
+    for (int i = 0; i < 50 * (c + 1); ++i) {
+      frames[c].push_back(make_frame(random, c * 10.0 + i / 60.0));
+    }
+    offsets[c] = write_frames(file, c, c * 1000 - 5, frames[c]);
+    check(offsets[c] != 0);
+  }
+  check(file->get_num_chunks() == 3);
+
+  // They can be read in any order, any number of times.
+  for (int c : { 2, 0, 1, 0 }) {
+    check(read_frames(file, offsets[c], c * 1000 - 5, frames[c]));
+  }
+
+  // A made-up offset, or a released chunk, doesn't read.
+  pvector<int> frame_numbers;
+  pvector<PStatFrameData> read_frames;
+  check(!file->read_chunk(offsets[1] + 1, frame_numbers, read_frames));
+  file->release_chunk(offsets[1]);
+  check(!file->read_chunk(offsets[1], frame_numbers, read_frames));
+  check(read_frames.empty());
+  check(file->get_num_chunks() == 2);
+
+  file->close();
+  check(!filename.exists());
+
+  for (int c = 0; c < 3; ++c) {
+    for (PStatFrameData *frame : frames[c]) {
+      delete frame;
+    }
+  }
+}
+
+/**
+ * Tests that the space of released chunks is reused, so that the file stays
+ * the same size when chunks are released as fast as they are written.
+ */
+static void
+test_session_file_reuse() {
+  Randomizer random(2);
+  PT(PStatSessionFile) file = new PStatSessionFile;
+  check(file->open(Filename::temporary("", "pstats-", ".psts")));
+
+  pvector<PStatFrameData *> frames;
+  for (int i = 0; i < 100; ++i) {
+    frames.push_back(make_frame(random, i / 60.0));
+  }
+  pvector<PStatFrameData *> small_frames;
+  small_frames.assign(frames.begin(), frames.begin() + 20);
+
+  // A chunk that fits in the space of a released one goes there.
+  size_t a = write_frames(file, 0, 0, frames);
+  size_t b = write_frames(file, 0, 200, frames);
+  size_t c = write_frames(file, 0, 400, frames);
+  size_t size = file->get_file_size();
+  file->release_chunk(b);
+  size_t d = write_frames(file, 1, 0, small_frames);
+  check(d == b);
+  size_t e = write_frames(file, 1, 100, small_frames);
+  check(e > d && e < c);
+  check(file->get_file_size() == size);
+
+  // Neighboring free space is merged together.
+  file->release_chunk(d);
+  file->release_chunk(e);
+  file->release_chunk(a);
+  size_t f = write_frames(file, 2, 0, frames);
+  size_t g = write_frames(file, 2, 200, frames);
+  check(f == a);
+  check(g == b);
+  check(file->get_file_size() == size);
+
+  check(read_frames(file, c, 400, frames));
+  check(read_frames(file, f, 0, frames));
+  check(read_frames(file, g, 200, frames));
+
+  // When the free space at the end isn't large enough, it's extended.
+  file->release_chunk(c);
+  size_t h = write_frames(file, 3, 0, frames);
+  check(h == c);
+  pvector<PStatFrameData *> large_frames = frames;
+  large_frames.insert(large_frames.end(), frames.begin(), frames.end());
+  file->release_chunk(h);
+  size_t i = write_frames(file, 3, 0, large_frames);
+  check(i == c);
+  check(file->get_file_size() > size);
+  check(read_frames(file, i, 0, large_frames));
+  check(read_frames(file, f, 0, frames));
+
+  // Keep a sliding window of chunks of the same size, as PStatThreadData
+  // does.
+  pdeque<size_t> window;
+  size_t steady_size = 0;
+  for (int n = 0; n < 200; ++n) {
+    window.push_back(write_frames(file, 4, 0, frames));
+    if (window.size() > 10) {
+      file->release_chunk(window.front());
+      window.pop_front();
+    }
+    if (n == 20) {
+      steady_size = file->get_file_size();
+    }
+  }
+  check(file->get_file_size() == steady_size);
+  check(read_frames(file, window.back(), 0, frames));
+
+  for (PStatFrameData *frame : frames) {
+    delete frame;
+  }
+}
+
+/**
+ * Tests that a PStatThreadData with a session file keeps the frames that are
+ * in the history, whether in memory or in the file, and that the file stops
+ * growing once the history is full.
+ */
+static void
+test_thread_data_session_history() {
+  ConfigVariableDouble &history = pstats_session_history;
+  ConfigVariableDouble &resident = pstats_resident_history;
+  ConfigVariableDouble &average_time = pstats_average_time;
+  double old_history = history;
+  double old_resident = resident;
+  double old_average_time = average_time;
+  history.set_value(30.0);
+  resident.set_value(2.0);
+  average_time.set_value(1.0);
+
+  Randomizer random(3);
+  PT(PStatSessionFile) file = new PStatSessionFile;
+  check(file->open(Filename::temporary("", "pstats-", ".psts")));
+  PT(PStatThreadData) thread_data = new PStatThreadData(nullptr);
+  thread_data->set_session_file(file, 0);
+
+  size_t size_at_history = 0;
+  int num_frames = 60 * 120;
+  for (int n = 0; n < num_frames; ++n) {
+    thread_data->record_new_frame(n, make_frame(random, n / 60.0));
+    if (n == 60 * 40) {
+      size_at_history = file->get_file_size();
+    }
+  }
+
+  // The file has stayed about the size it was when it first held the whole
+  // history.  It may have grown a little, since the chunks vary in size.
+  check(size_at_history > 0);
+  check(file->get_file_size() < size_at_history * 5 / 4);
+  check(file->get_num_chunks() <= 60 * 35 / 256);
+
+  // The oldest frames are in the file, and can still be retrieved.
+  int oldest = thread_data->get_oldest_frame_number();
+  check(oldest >= num_frames - 60 * 35 && oldest <= num_frames - 60 * 30);
+  check(thread_data->has_frame(oldest));
+  check(thread_data->get_frame(oldest).get_start() == (PN_float32)(oldest / 60.0));
+  check(thread_data->get_latest_frame_number() == num_frames - 1);
+  int middle = num_frames - 60 * 10;
+  check(thread_data->get_frame(middle).get_start() == (PN_float32)(middle / 60.0));
+
+  // Letting go of the thread data gives back its space in the file.
+  thread_data.clear();
+  check(file->get_num_chunks() == 0);
+
+  history.set_value(old_history);
+  resident.set_value(old_resident);
+  average_time.set_value(old_average_time);
+}
+
+/**
+ * A monitor that records the frames it is told about.
+ */
+class TestMonitor : public PStatMonitor {
+public:
+  TestMonitor(PStatServer *server) : PStatMonitor(server) {}
+
+  virtual std::string get_monitor_name() {
+    return "test";
+  }
+
+  virtual void new_data(int thread_index, int frame_number) {
+    const PStatFrameData &frame =
+      get_client_data()->get_thread_data(thread_index)->get_frame(frame_number);
+    _frames.push_back(std::make_pair(thread_index, frame_number));
+    _starts.push_back(frame.get_start());
+  }
+
+  pvector<std::pair<int, int> > _frames;
+  pvector<double> _starts;
+};
+
+class TestServer : public PStatServer {
+public:
+  virtual PStatMonitor *make_monitor(const NetAddress &address) {
+    _monitor = new TestMonitor(this);
+    return _monitor;
+  }
+
+  PT(TestMonitor) _monitor;
+};
+
+/**
+ * Sends frames from several client threads to a server over TCP, and checks
+ * that the server records the frames of each thread in the order they were
+ * sent, however many threads it uses to decode them.
+ */
+static void
+test_decode_order(int num_decode_threads) {
+  ConfigVariableInt &decode_threads = pstats_decode_threads;
+  int old_decode_threads = decode_threads;
+  decode_threads.set_value(num_decode_threads);
+
+  TestServer server;
+  int port = 0;
+  for (int p = 35000; p < 35100 && port == 0; ++p) {
+    if (server.listen(p)) {
+      port = p;
+    }
+  }
+  check(port != 0);
+
+  QueuedConnectionManager manager;
+  ConnectionWriter writer(&manager, 0);
+  writer.set_tcp_header_size(4);
+  PT(Connection) connection =
+    manager.open_TCP_client_connection("127.0.0.1", port, 1000);
+  check(connection != nullptr);
+  if (connection == nullptr) {
+    decode_threads.set_value(old_decode_threads);
+    return;
+  }
+
+  PStatClientControlMessage hello;
+  hello._type = PStatClientControlMessage::T_hello;
+  hello._client_hostname = "localhost";
+  hello._client_progname = "test_pstatserver";
+  hello._client_pid = 1;
+  hello._major_version = get_current_pstat_major_version();
+  hello._minor_version = get_current_pstat_minor_version();
+  Datagram datagram;
+  hello.encode(datagram);
+  check(writer.send(datagram, connection));
+
+  // Wait for the server to hear from the client before sending frames, or
+  // it will ignore them.
+  for (int i = 0; i < 300; ++i) {
+    server.poll();
+    if (server._monitor != nullptr && server._monitor->is_client_known()) {
+      break;
+    }
+    Thread::sleep(0.01);
+  }
+  check(server._monitor != nullptr && server._monitor->is_client_known());
+  if (server._monitor == nullptr) {
+    decode_threads.set_value(old_decode_threads);
+    return;
+  }
+
+  // The frames of the threads are interleaved, and each thread's frames
+  // start at a different time, so they can be told apart.
+  Randomizer random(4);
+  const int num_threads = 5;
+  const int num_frames = 80;
+  for (int n = 0; n < num_frames; ++n) {
+    for (int thread_index = 0; thread_index < num_threads; ++thread_index) {
+      PStatFrameData *frame = make_frame(random, thread_index * 100.0 + n / 60.0);
+      Datagram datagram;
+      datagram.add_uint8(0);
+      datagram.add_uint16(thread_index);
+      datagram.add_uint32(n);
+      frame->write_datagram(datagram);
+      check(writer.send(datagram, connection));
+      delete frame;
+    }
+  }
+
+  TestMonitor *monitor = server._monitor;
+  for (int i = 0; i < 500; ++i) {
+    server.poll();
+    if (monitor->_frames.size() >= num_threads * num_frames) {
+      break;
+    }
+    Thread::sleep(0.01);
+  }
+
+  check(monitor->_frames.size() == num_threads * num_frames);
+  int next_frame[num_threads] = { 0 };
+  for (size_t i = 0; i < monitor->_frames.size(); ++i) {
+    int thread_index = monitor->_frames[i].first;
+    int frame_number = monitor->_frames[i].second;
+    check(thread_index >= 0 && thread_index < num_threads);
+    if (thread_index >= 0 && thread_index < num_threads) {
+      check(frame_number == next_frame[thread_index]);
+      check(monitor->_starts[i] == (PN_float32)(thread_index * 100.0 + frame_number / 60.0));
+      next_frame[thread_index] = frame_number + 1;
+    }
+  }
+
+  manager.close_connection(connection);
+  decode_threads.set_value(old_decode_threads);
+}
+
+int
+main(int argc, char *argv[]) {
+  test_session_file_chunks();
+  test_session_file_reuse();
+  test_thread_data_session_history();
+  test_decode_order(0);
+  test_decode_order(3);
+
+  if (num_failures != 0) {
+    cerr << num_failures << " checks failed.\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+from panda3d import core
+import pytest
+
+# Skip these tests if we can't import egg.
+egg = pytest.importorskip("panda3d.egg")
+
+
+MODEL_EGG = """
+<CoordinateSystem> { Z-up }
+<Group> box {
+  <Dart> { 1 }
+  <VertexPool> vpool {
+    <Vertex> 0 { 0 0 0 <Dxyz> morph { 1 0 0 } }
+    <Vertex> 1 { 1 0 1 }
+    <Vertex> 2 { 0 0 2 }
+  }
+  <Polygon> { <VertexRef> { 0 1 2 <Ref> { vpool } } }
+  <Joint> root {
+    <Transform> { <Translate> { 0 0 0 } }
+    <VertexRef> { 0 <Ref> { vpool } }
+    <Joint> j1 {
+      <Transform> { <Translate> { 0 0 1 } }
+      <VertexRef> { 1 <Ref> { vpool } }
+      <Joint> j2 {
+        <Transform> { <Translate> { 0 0 1 } }
+        <VertexRef> { 2 <Ref> { vpool } }
+      }
+    }
+  }
+}
+"""
+
+ANIM_EGG = """
+<CoordinateSystem> { Z-up }
+<Table> {
+  <Bundle> box {
+    <Table> "<skeleton>" {
+      <Table> root {
+        <Xfm$Anim_S$> xform {
+          <Scalar> fps { 24 }
+          <S$Anim> h { <V> { 0 10 20 30 40 50 60 70 } }
+          <S$Anim> x { <V> { 0 0.1 0.2 0.3 0.4 0.5 0.6 0.7 } }
+        }
+        <Table> j1 {
+          <Xfm$Anim_S$> xform {
+            <Scalar> fps { 24 }
+            <S$Anim> p { <V> { 0 5 10 15 20 25 30 35 } }
+            <S$Anim> z { <V> { 1 } }
+          }
+          <Table> j2 {
+            <Xfm$Anim_S$> xform {
+              <Scalar> fps { 24 }
+              <S$Anim> r { <V> { 0 -5 -10 -15 -20 -25 -30 -35 } }
+              <S$Anim> z { <V> { 1 } }
+            }
+          }
+        }
+      }
+    }
+    <Table> morph {
+      <S$Anim> morph {
+        <Scalar> fps { 24 }
+        <V> { 0 0.125 0.25 0.375 0.5 0.625 0.75 0.875 }
+      }
+    }
+  }
+}
+"""
+
+
+def load_egg_text(text):
+    data = egg.EggData()
+    assert data.read(core.StringStream(text.encode("ascii")))
+    return core.NodePath(egg.load_egg_data(data))
+
+
+def get_part_values(bundle):
+    """Returns the net transform of every joint and the value of every slider
+    of the given PartBundle, keyed by name."""
+
+    values = {}
+    stack = [bundle]
+    while stack:
+        part = stack.pop()
+        if isinstance(part, core.CharacterJoint):
+            mat = core.LMatrix4()
+            part.get_net_transform(mat)
+            values[part.name] = mat
+        elif isinstance(part, core.CharacterSlider):
+            values[part.name] = part.get_value()
+        stack.extend(part.children)
+    return values
+
+
+def make_actors(model, anim):
+    from direct.actor.Actor import Actor
+
+    actors = []
+    for i in range(6):
+        actor = Actor(model, {"anim": anim})
+        actor.pose("anim", i + 1)
+        actors.append(actor)
+    return actors
+
+
+def test_part_bundle_updater(worker_thread_pool):
+    model = load_egg_text(MODEL_EGG)
+    anim = load_egg_text(ANIM_EGG)
+
+    serial_actors = make_actors(model, anim)
+    for actor in serial_actors:
+        assert actor.getPartBundle("modelRoot").update()
+
+    actors = make_actors(model, anim)
+    exposed = [actor.exposeJoint(None, "modelRoot", "j2") for actor in actors]
+
+    updater = core.PartBundleUpdater()
+    for actor in actors:
+        updater.add_bundle(actor.getPartBundle("modelRoot"))
+    assert updater.get_num_bundles() == len(actors)
+    assert updater.update()
+    assert updater.get_num_bundles() == 0
+
+    for actor, serial_actor, node in zip(actors, serial_actors, exposed):
+        values = get_part_values(actor.getPartBundle("modelRoot"))
+        serial_values = get_part_values(serial_actor.getPartBundle("modelRoot"))
+        assert set(values.keys()) == {"root", "j1", "j2", "morph"}
+        assert values == serial_values
+
+        # The exposed joint's node was set on this thread, afterwards.
+        assert node.get_mat() == values["j2"]
+
+    # Nothing changes the second time around.
+    for actor in actors:
+        updater.add_bundle(actor.getPartBundle("modelRoot"))
+    assert not updater.update()
+
+    for actor in serial_actors + actors:
+        actor.cleanup()
@@ -44,3 +44,32 @@ def test_collision_node_owner():
     del owner
     assert node.owner is None
 
+
+
+def test_collision_node_bvh_bam():
+    from panda3d.core import CollisionSphere, BamWriter, BamReader, DatagramBuffer
+
+    cnode = CollisionNode("test")
+    for i in range(32):
+        cnode.add_solid(CollisionSphere(i * 2, 0, 0, 0.5))
+
+    for minor_ver in (44, 46):
+        buffer = DatagramBuffer()
+        writer = BamWriter(buffer)
+        writer.set_file_minor_ver(minor_ver)
+        writer.init()
+        writer.write_object(cnode)
+        writer.flush()
+
+        reader = BamReader(DatagramBuffer(buffer.data))
+        reader.init()
+        copy = reader.read_object()
+        reader.resolve()
+
+        assert copy.get_num_solids() == 32
+        for i in range(32):
+            assert copy.get_solid(i).get_center() == cnode.get_solid(i).get_center()
+
+        # The hierarchy is only stored from version 46 on; otherwise it is
+        # built again on demand.
+        assert copy.has_bvh() == (minor_ver >= 46)
@@ -1,3 +1,4 @@
+import pytest
 from panda3d.core import CollisionTraverser, CollisionHandlerQueue
 from panda3d.core import NodePath, CollisionNode
 
@@ -29,3 +30,132 @@ def test_collision_traverser_pickle():
     # Two colliders must still be the same object; this only works with our own
     # version of the pickle module, in direct.stdpy.pickle.
     assert trav.get_handler(collider1) == trav.get_handler(collider2)
+
+
+def test_collision_traverser_parallel(worker_thread_pool):
+    from panda3d.core import CollisionSphere, CollisionPolygon, Point3
+
+    root = NodePath("root")
+    into = root.attach_new_node(CollisionNode("into"))
+    into.node().add_solid(CollisionPolygon(Point3(-10, -10, 0), Point3(10, -10, 0),
+                                           Point3(10, 10, 0), Point3(-10, 10, 0)))
+
+    handler = CollisionHandlerQueue()
+    trav = CollisionTraverser()
+    assert not trav.parallel_traversal
+
+    # Enough colliders to be divided over several passes.
+    for i in range(40):
+        collider = root.attach_new_node(CollisionNode("collider%d" % (i)))
+        collider.node().add_solid(CollisionSphere(0, 0, 0, 1))
+        collider.set_pos(i % 8 - 4, i // 8 - 4, 0.5 if i % 3 else 5)
+        trav.add_collider(collider, handler)
+
+    trav.traverse(root)
+    serial = sorted(entry.from_node_path.name for entry in handler.entries)
+
+    trav.parallel_traversal = True
+    trav.traverse(root)
+    parallel = [entry.from_node_path.name for entry in handler.entries]
+
+    # The set of collisions must be the same, even if the order isn't.
+    assert len(serial) > 0
+    assert sorted(parallel) == serial
+
+
+# Performs a parallel traversal with the number of worker threads given on the
+# command line, and prints the entries in the order they were delivered.
+PARALLEL_ORDER_SCRIPT = """
+import sys
+from panda3d.core import load_prc_file_data, NodePath, CollisionNode
+from panda3d.core import CollisionTraverser, CollisionHandlerQueue
+from panda3d.core import CollisionSphere, CollisionPolygon, Point3
+
+load_prc_file_data("", "worker-thread-pool-size " + sys.argv[1])
+
+root = NodePath("root")
+floor = root.attach_new_node(CollisionNode("floor"))
+floor.node().add_solid(CollisionPolygon(Point3(-10, -10, 0), Point3(10, -10, 0),
+                                        Point3(10, 10, 0), Point3(-10, 10, 0)))
+for i in range(4):
+    ball = root.attach_new_node(CollisionNode("ball%d" % (i)))
+    ball.node().add_solid(CollisionSphere(0, 0, 0, 1.5))
+    ball.set_pos(i * 2 - 3, i - 2, 1)
+
+handler = CollisionHandlerQueue()
+trav = CollisionTraverser()
+trav.parallel_traversal = True
+for i in range(40):
+    collider = root.attach_new_node(CollisionNode("collider%d" % (i)))
+    collider.node().add_solid(CollisionSphere(0, 0, 0, 1))
+    collider.set_pos(i % 8 - 4, i // 8 - 4, 0.5 if i % 3 else 5)
+    trav.add_collider(collider, handler)
+
+trav.traverse(root)
+for entry in handler.entries:
+    point = entry.get_surface_point(root)
+    print(entry.from_node_path.name, entry.into_node_path.name,
+          "%.4f %.4f %.4f" % (point[0], point[1], point[2]))
+"""
+
+
+def test_collision_traverser_parallel_order():
+    import subprocess
+    import sys
+
+    if sys.platform == "emscripten":
+        pytest.skip("cannot start a subprocess")
+
+    def traverse(num_threads):
+        output = subprocess.check_output(
+            [sys.executable, "-c", PARALLEL_ORDER_SCRIPT, str(num_threads)])
+        return output.decode().splitlines()
+
+    # The entries must come out in exactly the same order, whether there are
+    # no worker threads, one, or several.
+    entries = traverse(0)
+    assert len(entries) > 40
+    assert traverse(1) == entries
+    assert traverse(4) == entries
+
+
+def test_collision_traverser_bvh():
+    from panda3d.core import CollisionSphere, CollisionRay, ConfigVariableInt
+
+    root = NodePath("root")
+    into = root.attach_new_node(CollisionNode("into"))
+    for x in range(8):
+        for y in range(8):
+            into.node().add_solid(CollisionSphere(x * 3, y * 3, 0, 1))
+
+    handler = CollisionHandlerQueue()
+    trav = CollisionTraverser()
+
+    sphere = root.attach_new_node(CollisionNode("sphere"))
+    sphere.node().add_solid(CollisionSphere(0, 0, 0, 2))
+    sphere.set_pos(4.5, 4.5, 0)
+    trav.add_collider(sphere, handler)
+
+    ray = root.attach_new_node(CollisionNode("ray"))
+    ray.node().add_solid(CollisionRay((6, -5, 0), (0, 1, 0)))
+    trav.add_collider(ray, handler)
+
+    def collide():
+        trav.traverse(root)
+        return sorted((entry.from_node_path.name, str(entry.into_solid))
+                      for entry in handler.entries)
+
+    min_solids = ConfigVariableInt("collision-bvh-min-solids")
+    old_value = min_solids.value
+    try:
+        min_solids.value = 0
+        linear = collide()
+
+        min_solids.value = 16
+        hierarchy = collide()
+    finally:
+        min_solids.value = old_value
+
+    # The sphere touches four solids, and the ray passes through eight.
+    assert len(linear) == 12
+    assert hierarchy == linear
@@ -3,6 +3,12 @@ import pytest
 from panda3d import core
 from direct.showbase.ShowBase import ShowBase
 
+# Give the shared worker thread pool at least two threads, even on a machine
+# with a single core, so that the tests of the code paths that split their
+# work across it actually run them in parallel.  The pool is created on first
+# use, so this has to be loaded before any test runs.
+core.load_prc_file_data("worker-thread-pool", "worker-thread-pool-size 2")
+
 
 @pytest.fixture
 def base():
@@ -11,6 +17,17 @@ def base():
     base.destroy()
 
 
+@pytest.fixture
+def worker_thread_pool():
+    "Checks that the shared worker thread pool has more than one thread."
+    if not core.Thread.is_threading_supported():
+        pytest.skip("threading is not supported")
+
+    num_threads = core.ConfigVariableInt("worker-thread-pool-size").value
+    assert num_threads >= 2
+    yield num_threads
+
+
 @pytest.fixture
 def tk_toplevel():
     tk = pytest.importorskip('tkinter')
@@ -0,0 +1,108 @@
+import pytest
+
+direct = pytest.importorskip("panda3d.direct")
+core = pytest.importorskip("panda3d.core")
+
+
+DC_SOURCE = """
+dclass Avatar {
+  setXYH(int16 / 10, int16 / 10, uint8) broadcast;
+  setZ(int32) broadcast;
+  setBig(uint64, int64 / 100);
+  setScale(float64);
+  setName(string);
+  setRanged(uint8(0-100));
+  setPos : setXYH, setZ;
+};
+"""
+
+
+@pytest.fixture(scope="module")
+def dclass():
+    dc = direct.DCFile()
+    assert dc.read(core.StringStream(DC_SOURCE.encode()), "test.dc")
+    return dc.get_class_by_name("Avatar")
+
+
+def pack_args(field, args):
+    packer = direct.DCPacker()
+    packer.begin_pack(field)
+    assert field.pack_args(packer, args)
+    assert packer.end_pack()
+    return packer.get_bytes()
+
+
+def pack_object(field, args):
+    packer = direct.DCPacker()
+    packer.begin_pack(field)
+    packer.pack_object(args)
+    assert packer.end_pack()
+    return packer.get_bytes()
+
+
+def unpack_args(field, data):
+    packer = direct.DCPacker()
+    packer.set_unpack_data(data)
+    packer.begin_unpack(field)
+    value = field.unpack_args(packer)
+    assert packer.end_unpack()
+    return value
+
+
+def unpack_object(field, data):
+    packer = direct.DCPacker()
+    packer.set_unpack_data(data)
+    packer.begin_unpack(field)
+    value = packer.unpack_object()
+    assert packer.end_unpack()
+    return value
+
+
+def test_has_codec(dclass):
+    for name in ("setXYH", "setZ", "setBig", "setScale", "setPos"):
+        assert dclass.get_field_by_name(name).has_codec()
+
+    # Strings and range-limited parameters are left to DCPacker.
+    assert not dclass.get_field_by_name("setName").has_codec()
+    assert not dclass.get_field_by_name("setRanged").has_codec()
+
+
+@pytest.mark.parametrize("name,args", [
+    ("setXYH", (1.25, -3.0, 200)),
+    ("setXYH", [0, -12, 255]),
+    ("setZ", (-0x80000000,)),
+    ("setBig", (0xffffffffffffffff, -1234.5)),
+    ("setScale", (0.1,)),
+    ("setPos", (1.04, 2, 3, 4)),
+])
+def test_codec_round_trip(dclass, name, args):
+    field = dclass.get_field_by_name(name)
+    assert field.has_codec()
+
+    data = pack_args(field, args)
+    assert data == pack_object(field, args)
+    assert unpack_args(field, data) == unpack_object(field, data)
+
+
+def test_codec_out_of_range(dclass):
+    field = dclass.get_field_by_name("setXYH")
+
+    packer = direct.DCPacker()
+    packer.begin_pack(field)
+    with pytest.raises(ValueError):
+        field.pack_args(packer, (0, 0, 256))
+
+    packer = direct.DCPacker()
+    packer.begin_pack(field)
+    with pytest.raises(TypeError):
+        field.pack_args(packer, (0, 0))
+
+
+def test_codec_truncated(dclass):
+    field = dclass.get_field_by_name("setZ")
+
+    packer = direct.DCPacker()
+    packer.set_unpack_data(b"\x01\x02")
+    packer.begin_unpack(field)
+    with pytest.raises(RuntimeError):
+        field.unpack_args(packer)
@@ -0,0 +1,204 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture(scope='module')
+def tinydisplay_region():
+    """Creates and returns a DisplayRegion of a tinydisplay offscreen buffer."""
+
+    selection = core.GraphicsPipeSelection.get_global_ptr()
+    pipe = selection.make_module_pipe("p3tinydisplay")
+    if pipe is None or not pipe.is_valid():
+        pytest.skip("tinydisplay is not available")
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+    fbprops.set_rgba_bits(8, 8, 8, 8)
+    fbprops.depth_bits = 16
+
+    buffer = engine.make_output(
+        pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(256, 256),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("Cannot make tinydisplay buffer")
+
+    buffer.set_clear_color_active(True)
+    buffer.set_clear_color((0, 0, 0, 1))
+
+    yield buffer.make_display_region()
+
+    if buffer is not None:
+        engine.remove_window(buffer)
+
+
+def make_triangles():
+    """Returns a scene of many overlapping triangles, drawn once with a texture
+    and depth testing, and once more on top with alpha blending, so that the
+    result depends on the order in which the triangles are filled."""
+
+    vdata = core.GeomVertexData("tris", core.GeomVertexFormat.get_v3c4t2(), core.Geom.UH_static)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    color = core.GeomVertexWriter(vdata, "color")
+    texcoord = core.GeomVertexWriter(vdata, "texcoord")
+    tris = core.GeomTriangles(core.Geom.UH_static)
+
+    random = core.Randomizer(1)
+    for i in range(200):
+        center = core.Point3(random.random_real(8) - 4,
+                             random.random_real(10) + 10,
+                             random.random_real(8) - 4)
+        for j in range(3):
+            vertex.add_data3(center + core.Vec3(random.random_real(4) - 2,
+                                                random.random_real(2) - 1,
+                                                random.random_real(4) - 2))
+            color.add_data4(random.random_real(1), random.random_real(1),
+                            random.random_real(1), random.random_real(0.5) + 0.5)
+            texcoord.add_data2(random.random_real(2), random.random_real(2))
+        tris.add_next_vertices(3)
+
+    geom = core.Geom(vdata)
+    geom.add_primitive(tris)
+    gnode = core.GeomNode("tris")
+    gnode.add_geom(geom)
+
+    image = core.PNMImage(16, 16)
+    for x in range(16):
+        for y in range(16):
+            image.set_xel(x, y, (x ^ y) & 1, x / 16.0, y / 16.0)
+    texture = core.Texture("checker")
+    texture.load(image)
+
+    scene = core.NodePath("root")
+    scene.set_two_sided(True)
+
+    opaque = scene.attach_new_node(gnode)
+    opaque.set_texture(texture)
+
+    blended = scene.attach_new_node(gnode.make_copy())
+    blended.set_transparency(core.TransparencyAttrib.M_alpha)
+    blended.set_bin("fixed", 0)
+    blended.set_pos(0.5, -1, 0.5)
+
+    return scene
+
+
+def make_lit_triangles(lit):
+    """Returns a scene of non-uniformly scaled triangles with normals, some of
+    which are close to or behind the camera, so that they are clipped.  If lit
+    is True, the triangles are lit by a directional and a point light."""
+
+    vdata = core.GeomVertexData("tris", core.GeomVertexFormat.get_v3n3c4(), core.Geom.UH_static)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    normal = core.GeomVertexWriter(vdata, "normal")
+    color = core.GeomVertexWriter(vdata, "color")
+    tris = core.GeomTriangles(core.Geom.UH_static)
+
+    random = core.Randomizer(2)
+    for i in range(300):
+        center = core.Point3(random.random_real(12) - 6,
+                             random.random_real(24) - 4,
+                             random.random_real(12) - 6)
+        for j in range(3):
+            vertex.add_data3(center + core.Vec3(random.random_real(4) - 2,
+                                                random.random_real(2) - 1,
+                                                random.random_real(4) - 2))
+            normal.add_data3(random.random_real(2) - 1,
+                             random.random_real(2) - 1,
+                             random.random_real(2) - 1)
+            color.add_data4(random.random_real(1), random.random_real(1),
+                            random.random_real(1), 1)
+        tris.add_next_vertices(3)
+
+    geom = core.Geom(vdata)
+    geom.add_primitive(tris)
+    gnode = core.GeomNode("tris")
+    gnode.add_geom(geom)
+
+    scene = core.NodePath("root")
+    path = scene.attach_new_node(gnode)
+    path.set_two_sided(True)
+    path.set_hpr(10, 20, 30)
+    path.set_scale(1, 1.5, 0.75)
+
+    if lit:
+        material = core.Material()
+        material.diffuse = (1, 1, 1, 1)
+        material.specular = (1, 1, 1, 1)
+        material.shininess = 20
+        path.set_material(material)
+
+        dlight = scene.attach_new_node(core.DirectionalLight("dlight"))
+        dlight.set_hpr(30, -40, 0)
+        plight = scene.attach_new_node(core.PointLight("plight"))
+        plight.set_pos(2, 5, 3)
+        scene.set_light(dlight)
+        scene.set_light(plight)
+
+    return scene
+
+
+def render_scene(region, scene):
+    """Renders the scene and returns the contents of the framebuffer."""
+
+    region.camera = scene.attach_new_node(core.Camera("camera"))
+
+    texture = core.Texture("color")
+    region.window.add_render_texture(texture,
+                                     core.GraphicsOutput.RTM_copy_ram,
+                                     core.GraphicsOutput.RTP_color)
+    region.window.engine.render_frame()
+    region.window.clear_render_textures()
+    region.camera = core.NodePath()
+
+    return bytes(texture.get_ram_image())
+
+
+@pytest.mark.parametrize("rows", [8, 32])
+def test_tinydisplay_parallel_raster(tinydisplay_region, worker_thread_pool, rows):
+    parallel_raster = core.ConfigVariableBool("td-parallel-raster")
+    raster_rows = core.ConfigVariableInt("td-parallel-raster-rows")
+    old_parallel_raster = parallel_raster.value
+    old_raster_rows = raster_rows.value
+
+    try:
+        parallel_raster.value = False
+        serial = render_scene(tinydisplay_region, make_triangles())
+
+        # With these settings, the frame is split into several bands.
+        parallel_raster.value = True
+        raster_rows.value = rows
+        banded = render_scene(tinydisplay_region, make_triangles())
+    finally:
+        parallel_raster.value = old_parallel_raster
+        raster_rows.value = old_raster_rows
+
+    assert any(serial)
+    assert banded == serial
+
+
+@pytest.mark.parametrize("lit", [False, True])
+def test_tinydisplay_batch_vertex_transform(tinydisplay_region, lit):
+    batch_transform = core.ConfigVariableBool("td-batch-vertex-transform")
+    old_batch_transform = batch_transform.value
+
+    try:
+        batch_transform.value = False
+        scalar = render_scene(tinydisplay_region, make_lit_triangles(lit))
+
+        batch_transform.value = True
+        batch = render_scene(tinydisplay_region, make_lit_triangles(lit))
+    finally:
+        batch_transform.value = old_batch_transform
+
+    assert any(scalar)
+    assert batch == scalar
@@ -0,0 +1,315 @@
+import pytest
+
+direct = pytest.importorskip("panda3d.direct")
+core = pytest.importorskip("panda3d.core")
+net = pytest.importorskip("panda3d.net")
+
+
+CLIENT_OBJECT_SET_FIELD = 120
+CLIENT_OBJECT_SET_FIELD_DELTA = 122
+CLIENT_OBJECT_LEAVING = 132
+STATESERVER_OBJECT_SET_FIELD = 2020
+OBJECT_DELETE_CMU = 9006
+
+DC_SOURCE = """
+dclass Avatar {
+  setXYZ(int16, int16, int16) broadcast ram;
+  setChat(string) broadcast;
+};
+"""
+
+
+class Server:
+    """A bare server that the repositories connect to, which relays any
+    datagrams it is asked to from one connection to another.
+
+    A delta can only be decoded by the peer that saw the updates before it, so
+    the server passes what it reads through a repository of its own, standing
+    in for its end of the client connections, which turns the deltas back into
+    full updates.  Only the full updates are relayed to other clients."""
+
+    def __init__(self):
+        self.manager = net.QueuedConnectionManager()
+        self.listener = net.QueuedConnectionListener(self.manager, 0)
+        self.reader = net.QueuedConnectionReader(self.manager, 0)
+        self.writer = net.ConnectionWriter(self.manager, 0)
+
+        for self.port in range(34800, 34900):
+            self.rendezvous = self.manager.open_TCP_server_rendezvous(self.port, 16)
+            if self.rendezvous is not None:
+                break
+        else:
+            pytest.skip("Cannot open a TCP server rendezvous")
+
+        self.listener.add_connection(self.rendezvous)
+
+        self.decoder = make_repository()
+        self.to_decoder = self.connect(self.decoder)
+
+    def connect(self, repository):
+        """Connects the repository, and returns the server's end of the
+        connection."""
+
+        url = core.URLSpec("http://127.0.0.1:%d" % (self.port))
+        assert repository.try_connect_net(url)
+
+        for i in range(300):
+            self.manager.wait_for_readers(0.01)
+            self.listener.poll()
+            if self.listener.new_connection_available():
+                connection = net.PointerToConnection()
+                assert self.listener.get_new_connection(connection)
+                assert self.reader.add_connection(connection.p())
+                return connection.p()
+
+        pytest.fail("No incoming connection")
+
+    def read(self, count):
+        """Reads up to count datagrams, or as many as arrive in a few
+        seconds."""
+
+        datagrams = []
+        for i in range(300):
+            if len(datagrams) >= count:
+                break
+            self.manager.wait_for_readers(0.01)
+            self.reader.poll()
+            while self.reader.data_available():
+                datagram = net.NetDatagram()
+                if not self.reader.get_data(datagram):
+                    break
+                datagrams.append(datagram)
+
+        return datagrams
+
+    def relay(self, count, connection):
+        """Reads up to count datagrams, and sends them on to the indicated
+        connection, with any deltas decoded.  Returns the datagrams as they
+        were read."""
+
+        datagrams = self.read(count)
+        for datagram in datagrams:
+            assert self.writer.send(datagram, self.to_decoder)
+
+        decoded = receive(self.decoder, len(datagrams))
+        assert len(decoded) == len(datagrams)
+        for datagram in decoded:
+            assert get_msg_type(datagram) != CLIENT_OBJECT_SET_FIELD_DELTA
+            assert self.writer.send(datagram, connection)
+
+        return datagrams
+
+    def close(self):
+        self.manager.close_connection(self.rendezvous)
+
+
+@pytest.fixture
+def server():
+    server = Server()
+    yield server
+    server.close()
+
+
+def make_repository():
+    repository = direct.CConnectionRepository()
+    assert repository.get_dc_file().read(core.StringStream(DC_SOURCE.encode()), "test.dc")
+    repository.set_handle_datagrams_internally(False)
+    repository.set_want_field_deltas(True)
+    return repository
+
+
+def get_field_number(repository, name):
+    dclass = repository.get_dc_file().get_class_by_name("Avatar")
+    return dclass.get_field_by_name(name).get_number()
+
+
+def set_xyz(repository, do_id, x, y, z):
+    datagram = core.Datagram()
+    datagram.add_uint16(CLIENT_OBJECT_SET_FIELD)
+    datagram.add_uint32(do_id)
+    datagram.add_uint16(get_field_number(repository, "setXYZ"))
+    datagram.add_int16(x)
+    datagram.add_int16(y)
+    datagram.add_int16(z)
+    return datagram
+
+
+def object_message(msg_type, do_id):
+    datagram = core.Datagram()
+    datagram.add_uint16(msg_type)
+    datagram.add_uint32(do_id)
+    return datagram
+
+
+def get_msg_type(datagram):
+    return core.DatagramIterator(datagram).get_uint16()
+
+
+def get_xyz(datagram):
+    """Returns the doId and values of a setXYZ update."""
+
+    scan = core.DatagramIterator(datagram)
+    assert scan.get_uint16() == CLIENT_OBJECT_SET_FIELD
+    do_id = scan.get_uint32()
+    scan.get_uint16()
+    return do_id, (scan.get_int16(), scan.get_int16(), scan.get_int16())
+
+
+def receive(repository, count):
+    """Returns up to count datagrams received by the repository, or as many as
+    arrive in a few seconds."""
+
+    datagrams = []
+    for i in range(300):
+        if len(datagrams) >= count:
+            break
+        core.Thread.sleep(0.01)
+        while repository.check_datagram():
+            datagram = core.Datagram()
+            repository.get_datagram(datagram)
+            assert repository.get_msg_type() == get_msg_type(datagram)
+            datagrams.append(datagram)
+
+    return datagrams
+
+
+def send(repository, *datagrams):
+    for datagram in datagrams:
+        assert repository.send_datagram(datagram)
+    repository.flush()
+
+
+def test_connection_repository_field_deltas(server):
+    sender = make_repository()
+    receiver = make_repository()
+    server.connect(sender)
+    to_receiver = server.connect(receiver)
+
+    # The first update to a field is sent in full, and later ones only carry
+    # the elements that have changed.
+    send(sender, set_xyz(sender, 100, 1, 2, 3))
+    send(sender, set_xyz(sender, 100, 1, 2, 4))
+    send(sender, set_xyz(sender, 100, 7, 2, 4))
+    sent = server.relay(3, to_receiver)
+    assert list(map(get_msg_type, sent)) == [
+        CLIENT_OBJECT_SET_FIELD,
+        CLIENT_OBJECT_SET_FIELD_DELTA,
+        CLIENT_OBJECT_SET_FIELD_DELTA,
+    ]
+    assert sent[1].get_length() < sent[0].get_length()
+
+    # The server turns them back into ordinary updates before passing them on.
+    received = receive(receiver, 3)
+    assert list(map(get_xyz, received)) == [
+        (100, (1, 2, 3)),
+        (100, (1, 2, 4)),
+        (100, (7, 2, 4)),
+    ]
+
+    # Each object has its own previous value.
+    send(sender, set_xyz(sender, 101, 1, 2, 3))
+    sent = server.relay(1, to_receiver)
+    assert get_msg_type(sent[0]) == CLIENT_OBJECT_SET_FIELD
+    assert list(map(get_xyz, receive(receiver, 1))) == [(101, (1, 2, 3))]
+
+
+def test_connection_repository_field_deltas_deleted(server):
+    sender = make_repository()
+    receiver = make_repository()
+    to_sender = server.connect(sender)
+    to_receiver = server.connect(receiver)
+
+    send(sender, set_xyz(sender, 100, 1, 2, 3), set_xyz(sender, 101, 1, 2, 3))
+    server.relay(2, to_receiver)
+    assert len(receive(receiver, 2)) == 2
+
+    # Once an object is deleted, its next update is sent in full again.
+    send(sender, object_message(OBJECT_DELETE_CMU, 100))
+    send(sender, set_xyz(sender, 100, 1, 2, 4))
+    send(sender, set_xyz(sender, 100, 1, 2, 5))
+    sent = server.relay(3, to_receiver)
+    assert list(map(get_msg_type, sent)) == [
+        OBJECT_DELETE_CMU,
+        CLIENT_OBJECT_SET_FIELD,
+        CLIENT_OBJECT_SET_FIELD_DELTA,
+    ]
+
+    received = receive(receiver, 3)
+    assert get_msg_type(received[0]) == OBJECT_DELETE_CMU
+    assert list(map(get_xyz, received[1:])) == [(100, (1, 2, 4)), (100, (1, 2, 5))]
+
+    # The sender also forgets an object when it leaves its interest.
+    assert server.writer.send(object_message(CLIENT_OBJECT_LEAVING, 101), to_sender)
+    assert list(map(get_msg_type, receive(sender, 1))) == [CLIENT_OBJECT_LEAVING]
+    send(sender, set_xyz(sender, 101, 1, 2, 4))
+    sent = server.relay(1, to_receiver)
+    assert get_msg_type(sent[0]) == CLIENT_OBJECT_SET_FIELD
+    assert list(map(get_xyz, receive(receiver, 1))) == [(101, (1, 2, 4))]
+
+
+def test_connection_repository_update_coalescing(server):
+    sender = make_repository()
+    sender.set_want_update_coalescing(True)
+    server.connect(sender)
+
+    chat = core.Datagram()
+    chat.add_uint16(CLIENT_OBJECT_SET_FIELD)
+    chat.add_uint32(100)
+    chat.add_uint16(get_field_number(sender, "setChat"))
+    chat.add_string("hello")
+
+    # Only the latest update to the ram field is sent, but every update to the
+    # other field is.
+    for i in range(5):
+        assert sender.send_datagram(set_xyz(sender, 100, i, 0, 0))
+    assert sender.send_datagram(chat)
+    assert sender.send_datagram(chat)
+    assert sender.send_datagram(set_xyz(sender, 101, 9, 9, 9))
+    assert sender.send_datagram(set_xyz(sender, 100, 5, 0, 0))
+    assert server.read(1) == []
+
+    sender.flush_field_updates()
+    sent = server.read(4)
+    assert len(sent) == 4
+    assert get_msg_type(sent[0]) == CLIENT_OBJECT_SET_FIELD
+    assert sent[0].get_message() == chat.get_message()
+    assert sent[1].get_message() == chat.get_message()
+    assert get_xyz(sent[2]) == (101, (9, 9, 9))
+    assert get_xyz(sent[3]) == (100, (5, 0, 0))
+
+    # The coalesced update is the first one sent for the field, and the next
+    # one is sent as a delta against it.
+    assert sender.send_datagram(set_xyz(sender, 100, 5, 1, 0))
+    sender.flush_field_updates()
+    sent = server.read(1)
+    assert list(map(get_msg_type, sent)) == [CLIENT_OBJECT_SET_FIELD_DELTA]
+    assert server.read(1) == []
+
+
+def test_connection_repository_no_deltas_to_server(server):
+    # A server-side repository may be sending to many recipients, so it never
+    # sends deltas.
+    sender = make_repository()
+    sender.set_client_datagram(False)
+    server.connect(sender)
+
+    field = get_field_number(sender, "setXYZ")
+    for z in (3, 4, 5):
+        datagram = core.Datagram()
+        datagram.add_uint8(1)
+        datagram.add_uint64(4000)
+        datagram.add_uint64(5000)
+        datagram.add_uint16(STATESERVER_OBJECT_SET_FIELD)
+        datagram.add_uint32(100)
+        datagram.add_uint16(field)
+        datagram.add_int16(1)
+        datagram.add_int16(2)
+        datagram.add_int16(z)
+        send(sender, datagram)
+
+    sent = server.read(3)
+    assert len(sent) == 3
+    for datagram in sent:
+        scan = core.DatagramIterator(datagram)
+        scan.skip_bytes(17)
+        assert scan.get_uint16() == STATESERVER_OBJECT_SET_FIELD
@@ -0,0 +1,27 @@
+from panda3d.core import CompressionCodec, compress_string, decompress_string
+import pytest
+
+
+CODECS = [CompressionCodec.C_zlib, CompressionCodec.C_lz4, CompressionCodec.C_zstd]
+
+
+@pytest.mark.parametrize("codec", CODECS)
+def test_compress_string_codec(codec):
+    if not CompressionCodec.is_available(codec):
+        pytest.skip("codec not available")
+
+    # Large enough to span several blocks.
+    data = b'Panda3D rocks! ' * 20000 + bytes(range(256)) * 300
+    packed = compress_string(data, 6, codec)
+    assert len(packed) < len(data)
+    assert decompress_string(packed) == data
+
+    assert decompress_string(compress_string(b'', 6, codec)) == b''
+
+
+def test_compress_string_zlib_compatible():
+    import zlib
+
+    data = b'Panda3D rocks! ' * 100
+    assert zlib.decompress(compress_string(data, 6)) == data
+    assert decompress_string(zlib.compress(data)) == data
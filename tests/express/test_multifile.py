@@ -23,3 +23,75 @@ def test_multifile_password():
 
     m.set_encryption_password(b'\xc4\x97\xa1\x01\x85\xb6')
     assert m.get_encryption_password() == b'\xc4\x97\xa1\x01\x85\xb6'
+
+
+def test_multifile_mmap(tmp_path):
+    from panda3d.core import ConfigVariableBool, Filename
+
+    plain = bytes(range(256)) * 64
+    packed = b'Panda3D rocks! ' * 1000
+
+    filename = Filename.from_os_specific(str(tmp_path / 'test.mf'))
+    m = Multifile()
+    assert m.open_write(filename)
+    m.add_subfile('plain.bin', StringStream(plain), 0)
+    m.add_subfile('packed.bin', StringStream(packed), 6)
+    m.close()
+
+    var = ConfigVariableBool('multifile-mmap')
+    old_value = var.get_value()
+    var.set_value(True)
+    try:
+        m = Multifile()
+        assert m.open_read(filename)
+        assert not m.is_subfile_compressed(m.find_subfile('plain.bin'))
+        assert m.is_subfile_compressed(m.find_subfile('packed.bin'))
+
+        # Only the plain subfile can be read from the mapping.
+        assert m.is_subfile_mapped(m.find_subfile('plain.bin'))
+        assert not m.is_subfile_mapped(m.find_subfile('packed.bin'))
+
+        assert m.read_subfile(m.find_subfile('plain.bin')) == plain
+        assert m.read_subfile(m.find_subfile('packed.bin')) == packed
+
+        # The stream must be able to seek within the subfile.
+        stream = m.open_read_subfile(m.find_subfile('plain.bin'))
+        stream.seekg(258)
+        assert stream.read(4) == b'\x02\x03\x04\x05'
+        assert stream.tellg() == 262
+        Multifile.close_read_subfile(stream)
+        m.close()
+    finally:
+        var.set_value(old_value)
+
+    # Without multifile-mmap, nothing is mapped, but the data is the same.
+    m = Multifile()
+    assert m.open_read(filename)
+    assert not m.is_subfile_mapped(m.find_subfile('plain.bin'))
+    assert m.read_subfile(m.find_subfile('plain.bin')) == plain
+    m.close()
+
+
+def test_multifile_compression_codec():
+    from panda3d.core import CompressionCodec
+
+    codec = CompressionCodec.C_lz4
+    if not CompressionCodec.is_available(codec):
+        codec = CompressionCodec.C_zlib
+
+    packed = b'Panda3D rocks! ' * 1000
+
+    stream = StringStream()
+    m = Multifile()
+    assert m.open_write(stream)
+    m.set_compression_codec(codec)
+    assert m.get_compression_codec() == codec
+    m.add_subfile('packed.bin', StringStream(packed), 6)
+    m.close()
+
+    m = Multifile()
+    assert m.open_read(IStreamWrapper(stream))
+    assert m.is_subfile_compressed(m.find_subfile('packed.bin'))
+    assert m.get_subfile_length(m.find_subfile('packed.bin')) == len(packed)
+    assert m.read_subfile(m.find_subfile('packed.bin')) == packed
+    m.close()
@@ -0,0 +1,168 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture
+def cache_manager():
+    """Returns the GeomCacheManager, emptied, and without any minimum number of
+    frames that an entry is kept around.  The settings are restored after."""
+
+    mgr = core.GeomCacheManager.get_global_ptr()
+    min_frames = core.ConfigVariableInt("geom-cache-min-frames")
+    old_max_size = mgr.get_max_size()
+    old_min_frames = min_frames.value
+
+    mgr.flush()
+    min_frames.value = 0
+    yield mgr
+
+    mgr.set_max_size(old_max_size)
+    min_frames.value = old_min_frames
+    mgr.flush()
+
+
+@pytest.fixture(scope='module')
+def munge_region(graphics_pipe):
+    """Creates and returns a DisplayRegion of an offscreen buffer."""
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    yield buffer.make_display_region()
+
+    if buffer is not None:
+        engine.remove_window(buffer)
+
+
+def make_vertex_data(name="vdata"):
+    vdata = core.GeomVertexData(name, core.GeomVertexFormat.get_v3(), core.Geom.UH_static)
+    vdata.set_num_rows(1)
+    return vdata
+
+
+def is_cached(result):
+    # The cache entry holds the only other reference to a converted result.
+    return result.get_ref_count() > 1
+
+
+def test_geom_cache_sharded_eviction(cache_manager):
+    cache_manager.set_max_size(32)
+    format = core.GeomVertexFormat.get_v3c4()
+
+    sources = []
+    results = []
+    for i in range(200):
+        vdata = make_vertex_data()
+        sources.append(vdata)
+        results.append(vdata.convert_to(format))
+
+        # Each shard is kept to its share of the total.
+        assert cache_manager.get_total_size() <= 32
+
+    assert cache_manager.get_total_size() > 0
+    assert sum(map(is_cached, results)) == cache_manager.get_total_size()
+    assert all(map(is_cached, results[-4:]))
+
+    # The evicted results are released, and a flush releases the rest.
+    cache_manager.flush()
+    assert cache_manager.get_total_size() == 0
+    assert not any(map(is_cached, results))
+
+
+def test_geom_cache_second_chance(cache_manager):
+    cache_manager.set_max_size(64)
+    format = core.GeomVertexFormat.get_v3c4()
+    clock = core.ClockObject.get_global_clock()
+
+    hot = make_vertex_data("hot")
+    cold = make_vertex_data("cold")
+    hot_result = hot.convert_to(format)
+    cold_result = cold.convert_to(format)
+
+    sources = []
+    for i in range(500):
+        clock.tick()
+
+        # Using an entry doesn't move it in the list, but it's requeued rather
+        # than evicted when it comes up at the head of its shard.
+        hot.convert_to(format)
+
+        vdata = make_vertex_data()
+        vdata.convert_to(format)
+        sources.append(vdata)
+
+    assert cache_manager.get_total_size() <= 64
+    assert is_cached(hot_result)
+    assert not is_cached(cold_result)
+
+
+def get_munged_ref_counts(region, mgr):
+    """Renders a card a few times, and returns the reference count of its
+    vertex data after rendering, after flushing the geom cache, and after
+    rendering with a cache size of 0.  The munge cache entries hold a
+    reference to the vertex data they were munged from."""
+
+    scene = core.NodePath("root")
+    region.camera = scene.attach_new_node(core.Camera("camera"))
+
+    maker = core.CardMaker("card")
+    maker.set_frame(-1, 1, -1, 1)
+    maker.set_color(1, 0, 0, 1)
+    card = scene.attach_new_node(maker.generate())
+    card.set_y(5)
+    vdata = card.node().get_geom(0).get_vertex_data()
+
+    engine = region.window.engine
+    max_size = mgr.get_max_size()
+    engine.render_frame()
+    engine.render_frame()
+    rendered = vdata.get_ref_count()
+
+    mgr.flush()
+    flushed = vdata.get_ref_count()
+
+    mgr.set_max_size(0)
+    engine.render_frame()
+    engine.render_frame()
+    evicted = vdata.get_ref_count()
+
+    region.camera = core.NodePath()
+    mgr.set_max_size(max_size)
+    mgr.flush()
+    return rendered, flushed, evicted
+
+
+def test_geom_munge_thread_cache(munge_region, cache_manager):
+    thread_cache = core.ConfigVariableBool("geom-munge-thread-cache")
+    old_thread_cache = thread_cache.value
+
+    try:
+        thread_cache.value = False
+        uncached = get_munged_ref_counts(munge_region, cache_manager)
+
+        # The per-thread table of recent entries mustn't keep the entries
+        # alive once they are gone from the geom cache.
+        thread_cache.value = True
+        cached = get_munged_ref_counts(munge_region, cache_manager)
+    finally:
+        thread_cache.value = old_thread_cache
+
+    rendered, flushed, evicted = uncached
+    assert flushed < rendered
+    assert cached == uncached
@@ -0,0 +1,211 @@
+from panda3d import core
+
+
+def make_skinned_data(vertices, normals, blend_indices, blends):
+    array = core.GeomVertexArrayFormat()
+    array.add_column("vertex", 3, core.Geom.NT_float32, core.Geom.C_point)
+    array.add_column("normal", 3, core.Geom.NT_float32, core.Geom.C_normal)
+    blend_array = core.GeomVertexArrayFormat()
+    blend_array.add_column("transform_blend", 1, core.Geom.NT_uint16, core.Geom.C_index)
+
+    spec = core.GeomVertexAnimationSpec()
+    spec.set_panda()
+    format = core.GeomVertexFormat()
+    format.add_array(array)
+    format.add_array(blend_array)
+    format.set_animation(spec)
+    format = core.GeomVertexFormat.register_format(format)
+
+    table = core.TransformBlendTable()
+    for blend in blends:
+        table.add_blend(blend)
+    table.set_rows(core.SparseArray.range(0, len(vertices)))
+
+    vdata = core.GeomVertexData("test", format, core.Geom.UH_static)
+    vdata.set_num_rows(len(vertices))
+    vdata.set_transform_blend_table(table)
+
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    normal = core.GeomVertexWriter(vdata, "normal")
+    index = core.GeomVertexWriter(vdata, "transform_blend")
+    for v, n, bi in zip(vertices, normals, blend_indices):
+        vertex.add_data3(v)
+        normal.add_data3(n)
+        index.add_data1i(bi)
+
+    return vdata
+
+
+def test_geom_vertex_data_animate_vertices():
+    mats = [
+        core.LMatrix4.translate_mat(1, 2, 3),
+        core.LMatrix4.rotate_mat(30, (0, 0, 1)) * core.LMatrix4.translate_mat(-1, 0, 5),
+        core.LMatrix4.scale_mat(2, 1, 0.5) * core.LMatrix4.rotate_mat(45, (1, 0, 0)),
+    ]
+    blends = []
+    for i, mat in enumerate(mats):
+        transform = core.UserVertexTransform("joint%d" % i)
+        transform.set_matrix(mat)
+        blends.append(core.TransformBlend(transform, 1.0))
+
+    # Use enough rows, in runs of varying length, to cover both the blocked
+    # and the leftover rows of the skinning loop.
+    blend_indices = [0, 0, 0, 0, 0, 1, 1, 2, 2, 2, 2, 2, 2, 0, 1, 2, 2]
+    vertices = [(i * 0.5, 1 - i, i * i * 0.1) for i in range(len(blend_indices))]
+    normals = [core.LVector3(1, i, -2).normalized() for i in range(len(blend_indices))]
+
+    vdata = make_skinned_data(vertices, normals, blend_indices, blends)
+    animated = vdata.animate_vertices(True, core.Thread.get_current_thread())
+    assert animated is not vdata
+
+    vertex = core.GeomVertexReader(animated, "vertex")
+    normal = core.GeomVertexReader(animated, "normal")
+    for v, n, bi in zip(vertices, normals, blend_indices):
+        mat = mats[bi]
+        assert vertex.get_data3().almost_equal(mat.xform_point(v), 1e-4)
+
+        # Normals need the inverse transpose to stay perpendicular to the
+        # surface, and should come out normalized.
+        normal_mat = core.LMatrix4(mat)
+        normal_mat.invert_in_place()
+        normal_mat.transpose_in_place()
+        expected = normal_mat.xform_vec(n).normalized()
+        assert normal.get_data3().almost_equal(expected, 1e-4)
+
+
+def test_geom_vertex_data_bam_parallel_read():
+    vdata = core.GeomVertexData("test", core.GeomVertexFormat.get_v3c4(), core.Geom.UH_static)
+    vdata.set_num_rows(5000)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    color = core.GeomVertexWriter(vdata, "color")
+    for i in range(5000):
+        vertex.add_data3(i, -i, i * 0.5)
+        color.add_data4(i % 7 / 7.0, 0, 1, 1)
+    data = vdata.encode_to_bam_stream()
+
+    parallel = core.ConfigVariableBool("bam-parallel-read")
+    min_payload = core.ConfigVariableInt("bam-parallel-read-min-payload")
+    old_values = parallel.get_value(), min_payload.get_value()
+    parallel.set_value(True)
+    min_payload.set_value(1)
+    try:
+        copy = core.GeomVertexData.decode_from_bam_stream(data)
+    finally:
+        parallel.set_value(old_values[0])
+        min_payload.set_value(old_values[1])
+
+    assert copy.get_num_rows() == 5000
+    for i in range(vdata.get_num_arrays()):
+        assert copy.get_array(i).get_handle().get_data() == vdata.get_array(i).get_handle().get_data()
+
+
+def test_geom_vertex_data_animate_changed_transform():
+    transforms = [core.UserVertexTransform("joint%d" % i) for i in range(4)]
+    for i, transform in enumerate(transforms):
+        transform.set_matrix(core.LMatrix4.translate_mat(i, 0, 0))
+    blends = [core.TransformBlend(transform, 1.0) for transform in transforms]
+
+    blend_indices = [i // 4 for i in range(16)]
+    vertices = [(i, i * 0.5, 1) for i in range(16)]
+    normals = [(0, 0, 1)] * 16
+
+    vdata = make_skinned_data(vertices, normals, blend_indices, blends)
+    thread = core.Thread.get_current_thread()
+    vdata.animate_vertices(True, thread)
+
+    # Only the vertices of the moved transform need to be recomputed, but the
+    # result should be the same as computing everything from scratch.
+    mat = core.LMatrix4.rotate_mat(90, (1, 0, 0)) * core.LMatrix4.translate_mat(0, 5, 0)
+    transforms[2].set_matrix(mat)
+    animated = vdata.animate_vertices(True, thread)
+
+    vertex = core.GeomVertexReader(animated, "vertex")
+    normal = core.GeomVertexReader(animated, "normal")
+    for v, n, bi in zip(vertices, normals, blend_indices):
+        mat = transforms[bi].get_matrix()
+        assert vertex.get_data3().almost_equal(mat.xform_point(v), 1e-4)
+        assert normal.get_data3().almost_equal(mat.xform_vec(n), 1e-4)
+
+
+def test_geom_vertex_data_bam_parallel_read_scene(worker_thread_pool):
+    # A scene of many Geoms, each with its own vertex data and texture, is
+    # read with the payloads copied on the worker threads.
+    scene = core.NodePath("scene")
+    for i in range(16):
+        vdata = core.GeomVertexData("geom%d" % (i), core.GeomVertexFormat.get_v3n3t2(), core.Geom.UH_static)
+        vdata.set_num_rows(4000)
+        vertex = core.GeomVertexWriter(vdata, "vertex")
+        normal = core.GeomVertexWriter(vdata, "normal")
+        texcoord = core.GeomVertexWriter(vdata, "texcoord")
+        for j in range(4000):
+            vertex.add_data3(i, j, -j * 0.25)
+            normal.add_data3(0, 0, (i + j) % 3 - 1)
+            texcoord.add_data2(j / 4000.0, i / 16.0)
+
+        prim = core.GeomPoints(core.Geom.UH_static)
+        prim.add_next_vertices(4000)
+        geom = core.Geom(vdata)
+        geom.add_primitive(prim)
+
+        tex = core.Texture("tex%d" % (i))
+        tex.setup_2d_texture(64, 64, core.Texture.T_unsigned_byte, core.Texture.F_rgba8)
+        tex.set_ram_image(bytes((i * 7 + j) % 256 for j in range(64 * 64 * 4)))
+
+        node = core.GeomNode("node%d" % (i))
+        node.add_geom(geom, core.RenderState.make(core.TextureAttrib.make(tex)))
+        scene.attach_new_node(node)
+
+    data = scene.node().encode_to_bam_stream()
+
+    parallel = core.ConfigVariableBool("bam-parallel-read")
+    min_payload = core.ConfigVariableInt("bam-parallel-read-min-payload")
+    old_values = parallel.get_value(), min_payload.get_value()
+    parallel.set_value(True)
+    min_payload.set_value(1)
+    try:
+        copy = core.NodePath(core.PandaNode.decode_from_bam_stream(data))
+    finally:
+        parallel.set_value(old_values[0])
+        min_payload.set_value(old_values[1])
+
+    assert copy.get_num_children() == scene.get_num_children()
+    for orig_np, copy_np in zip(scene.get_children(), copy.get_children()):
+        orig_geom = orig_np.node().get_geom(0)
+        copy_geom = copy_np.node().get_geom(0)
+        orig_vdata = orig_geom.get_vertex_data()
+        copy_vdata = copy_geom.get_vertex_data()
+        assert copy_vdata.get_num_rows() == orig_vdata.get_num_rows()
+        for i in range(orig_vdata.get_num_arrays()):
+            assert copy_vdata.get_array(i).get_handle().get_data() == orig_vdata.get_array(i).get_handle().get_data()
+
+        orig_tex = orig_np.node().get_geom_state(0).get_attrib(core.TextureAttrib).get_texture()
+        copy_tex = copy_np.node().get_geom_state(0).get_attrib(core.TextureAttrib).get_texture()
+        assert bytes(copy_tex.get_ram_image()) == bytes(orig_tex.get_ram_image())
+
+
+def test_geom_vertex_data_bam_reversed_endian(worker_thread_pool):
+    # Large enough for the conversion to be split between the worker threads.
+    vdata = core.GeomVertexData("test", core.GeomVertexFormat.get_v3n3c4(), core.Geom.UH_static)
+    vdata.set_num_rows(20000)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    normal = core.GeomVertexWriter(vdata, "normal")
+    color = core.GeomVertexWriter(vdata, "color")
+    for i in range(20000):
+        vertex.add_data3(i, -i, i * 0.5)
+        normal.add_data3(0, i % 3 - 1, 1)
+        color.add_data4(i % 7 / 7.0, 0, 1, i % 2)
+
+    # Write the file in the other byte order, so that the data has to be
+    # converted both on the way out and on the way back in.
+    endian = core.ConfigVariableString("bam-endian")
+    old_value = endian.get_value()
+    endian.set_value("bigendian" if core.BamWriter.BE_native == core.BamWriter.BE_littleendian else "littleendian")
+    try:
+        data = vdata.encode_to_bam_stream()
+    finally:
+        endian.set_value(old_value)
+
+    copy = core.GeomVertexData.decode_from_bam_stream(data)
+    assert copy.get_num_rows() == 20000
+    for i in range(vdata.get_num_arrays()):
+        assert copy.get_array(i).get_handle().get_data() == vdata.get_array(i).get_handle().get_data()
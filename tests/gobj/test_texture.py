@@ -157,3 +157,63 @@ def test_texture_deepcopy():
     assert tex2.has_ram_image()
     img2 = tex2.get_ram_image()
     assert img2.get_ref_count() == 2
+
+
+def reference_mipmap_level(data, x_size, y_size, num_pages, num_components):
+    """ Box-filters one level of a mipmap chain, the slow way. """
+
+    to_x_size = max(x_size >> 1, 1)
+    to_y_size = max(y_size >> 1, 1)
+    dx = 1 if x_size > 1 else 0
+    dy = 1 if y_size > 1 else 0
+    result = []
+    for z in range(num_pages):
+        page = z * x_size * y_size
+        for y in range(to_y_size):
+            for x in range(to_x_size):
+                for c in range(num_components):
+                    samples = [
+                        data[(page + (y * 2 + j) * x_size + x * 2 + i) * num_components + c]
+                        for j in (0, dy) for i in (0, dx)
+                    ]
+                    result.append(samples)
+    return result, to_x_size, to_y_size
+
+
+def test_texture_generate_mipmaps_unsigned_byte():
+    # Odd sizes and several pages exercise the edges of the row filters.
+    x_size, y_size, num_pages = 37, 6, 3
+    data = array('B', ((i * 7919) % 251 for i in range(x_size * y_size * num_pages * 4)))
+
+    tex = Texture("")
+    tex.setup_2d_texture_array(x_size, y_size, num_pages, Texture.T_unsigned_byte, Texture.F_rgba8)
+    tex.set_ram_image(data)
+    tex.generate_ram_mipmap_images()
+
+    level = 1
+    while x_size > 1 or y_size > 1:
+        samples, x_size, y_size = reference_mipmap_level(data, x_size, y_size, num_pages, 4)
+        data = array('B', (sum(s) >> 2 for s in samples))
+        assert bytes(tex.get_ram_mipmap_image(level)) == data.tobytes()
+        level += 1
+    assert tex.get_num_ram_mipmap_images() == level
+
+
+def test_texture_generate_mipmaps_float():
+    x_size, y_size, num_pages = 1, 19, 2
+    data = array('f', (i * 0.37 - 5 for i in range(x_size * y_size * num_pages)))
+
+    tex = Texture("")
+    tex.setup_2d_texture_array(x_size, y_size, num_pages, Texture.T_float, Texture.F_r32)
+    tex.set_ram_image(data)
+    tex.generate_ram_mipmap_images()
+
+    level = 1
+    while x_size > 1 or y_size > 1:
+        samples, x_size, y_size = reference_mipmap_level(data, x_size, y_size, num_pages, 1)
+        data = array('f', (sum(s) / 4 for s in samples))
+        mipmap = array('f', bytes(tex.get_ram_mipmap_image(level)))
+        assert len(mipmap) == len(data)
+        for a, b in zip(mipmap, data):
+            assert abs(a - b) <= 1e-5 * max(1, abs(b))
+        level += 1
@@ -0,0 +1,137 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture(scope='module')
+def combiner_region(graphics_pipe):
+    """Creates and returns a DisplayRegion of an offscreen buffer."""
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    yield buffer.make_display_region()
+
+    if buffer is not None:
+        engine.remove_window(buffer)
+
+
+def render_scene(region, scene):
+    """Renders a frame of the scene, which gives the RigidBodyCombiner a chance
+    to pick up the new transforms of its children."""
+
+    camera = scene.attach_new_node(core.Camera("camera"))
+    camera.node().set_cull_bounds(core.OmniBoundingVolume())
+    region.camera = camera
+    region.window.engine.render_frame()
+    region.camera = core.NodePath()
+    camera.remove_node()
+
+
+def rounded(point):
+    return tuple(round(value, 3) for value in point)
+
+
+def get_internal_vertices(rbc):
+    """Returns the sorted positions of the vertices of the combiner's internal
+    scene, after they have been animated by the transforms of the bodies."""
+
+    thread = core.Thread.get_current_thread()
+    gnode = rbc.node().get_internal_scene().node()
+
+    vertices = []
+    for geom in gnode.get_geoms():
+        vdata = geom.get_animated_vertex_data(True, thread)
+        reader = core.GeomVertexReader(vdata, "vertex")
+        rows = set()
+        for prim in geom.get_primitives():
+            for i in range(prim.get_num_vertices()):
+                rows.add(prim.get_vertex(i))
+        for row in rows:
+            reader.set_row(row)
+            vertices.append(rounded(reader.get_data3()))
+
+    return sorted(vertices)
+
+
+def get_expected_vertices(rbc, num_removed=0):
+    """Returns the sorted positions that the vertices of the combiner's current
+    children should have.  The vertices of removed children are transformed
+    by the zero matrix, so they all come out as zero."""
+
+    vertices = []
+    for child in rbc.get_children():
+        mat = child.get_mat(rbc)
+        for x, z in ((-0.5, -0.5), (-0.5, 0.5), (0.5, -0.5), (0.5, 0.5)):
+            vertices.append(rounded(mat.xform_point((x, 0, z))))
+
+    vertices += [(0, 0, 0)] * (num_removed * 4)
+    return sorted(vertices)
+
+
+def test_rigid_body_combiner_collect_changes(combiner_region):
+    scene = core.NodePath("root")
+    rbc = scene.attach_new_node(core.RigidBodyCombiner("rbc"))
+
+    maker = core.CardMaker("card")
+    maker.set_frame(-0.5, 0.5, -0.5, 0.5)
+
+    children = []
+    for i in range(4):
+        child = rbc.attach_new_node(maker.generate())
+        child.set_pos(i * 2, 10, 0)
+        children.append(child)
+
+    rbc.node().collect()
+    render_scene(combiner_region, scene)
+    assert len(get_internal_vertices(rbc)) == 16
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc)
+
+    # A new child is collected into a Geom of its own.
+    added = rbc.attach_new_node(maker.generate())
+    added.set_pos_hpr(0, 10, 3, 45, 0, 0)
+    rbc.node().collect_changes()
+    render_scene(combiner_region, scene)
+    assert rbc.node().get_internal_scene().node().get_num_geoms() == 2
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc)
+
+    # A removed child leaves its vertices behind, zeroed by its transform.
+    children[1].detach_node()
+    rbc.node().collect_changes()
+    render_scene(combiner_region, scene)
+    assert rbc.node().get_internal_scene().node().get_num_geoms() == 2
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc, 1)
+
+    # Moving one child only takes effect once the combiner has been culled.
+    children[2].set_pos_hpr(-3, 12, 1, 0, 0, 90)
+    assert get_internal_vertices(rbc) != get_expected_vertices(rbc, 1)
+    render_scene(combiner_region, scene)
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc, 1)
+
+    added.set_z(-2)
+    render_scene(combiner_region, scene)
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc, 1)
+
+    # Once most of the vertices belong to removed children, the internal scene
+    # is rebuilt from scratch.
+    children[0].detach_node()
+    children[3].detach_node()
+    rbc.node().collect_changes()
+    render_scene(combiner_region, scene)
+    assert rbc.node().get_internal_scene().node().get_num_geoms() == 1
+    assert get_internal_vertices(rbc) == get_expected_vertices(rbc)
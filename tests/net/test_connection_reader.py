@@ -0,0 +1,346 @@
+from panda3d import core
+import pytest
+
+net = pytest.importorskip("panda3d.net")
+
+
+@pytest.fixture
+def use_epoll():
+    """Makes the readers and listeners created by the test use epoll."""
+
+    var = core.ConfigVariableBool("net-use-epoll")
+    old_value = var.value
+    var.value = True
+    yield
+    var.value = old_value
+
+
+@pytest.fixture
+def config_values():
+    """Restores any config variables that the test changes."""
+
+    saved = []
+
+    def set_value(name, value):
+        var = core.ConfigVariableInt(name)
+        saved.append((var, var.value))
+        var.value = value
+
+    yield set_value
+
+    for var, value in reversed(saved):
+        var.value = value
+
+
+def open_rendezvous(manager):
+    """Opens a TCP server rendezvous on a free port, and returns the
+    connection and the port."""
+
+    for port in range(34600, 34700):
+        rendezvous = manager.open_TCP_server_rendezvous(port, 16)
+        if rendezvous is not None:
+            return rendezvous, port
+
+    pytest.skip("Cannot open a TCP server rendezvous")
+
+
+def open_udp_connection(manager):
+    """Opens a UDP connection on a free port, and returns the connection and
+    the port."""
+
+    for port in range(34700, 34800):
+        connection = manager.open_UDP_connection(port)
+        if connection is not None:
+            return connection, port
+
+    pytest.skip("Cannot open a UDP connection")
+
+
+def accept_connection(manager, listener):
+    for i in range(300):
+        manager.wait_for_readers(0.01)
+        listener.poll()
+        if listener.new_connection_available():
+            new_connection = net.PointerToConnection()
+            assert listener.get_new_connection(new_connection)
+            return new_connection.p()
+
+    pytest.fail("No incoming connection")
+
+
+def make_payload(value):
+    """Returns the payload of a datagram whose length and contents depend on
+    the value."""
+
+    return bytes((value * 7 + i) & 0xff for i in range(value % 200))
+
+
+def read_datagrams(manager, reader, count):
+    """Reads up to count datagrams, or as many as arrive in a few seconds."""
+
+    datagrams = []
+    for i in range(300):
+        if len(datagrams) >= count:
+            break
+        manager.wait_for_readers(0.01)
+        reader.poll()
+        while reader.data_available():
+            datagram = net.NetDatagram()
+            if not reader.get_data(datagram):
+                break
+            datagrams.append(datagram)
+
+    return datagrams
+
+
+def send_values(writer, connection, *values):
+    for value in values:
+        datagram = net.NetDatagram()
+        datagram.add_int32(value)
+        assert writer.send(datagram, connection)
+
+
+def read_values(manager, reader, count, connections=None):
+    """Reads up to count datagrams, or as many as arrive in a few seconds, and
+    returns the values in them.  If connections is given, it is filled in with
+    the connection each value came in on, keyed by value // 10."""
+
+    values = []
+    for i in range(300):
+        if len(values) >= count:
+            break
+        manager.wait_for_readers(0.01)
+        datagram = net.NetDatagram()
+        while reader.data_available() and reader.get_data(datagram):
+            value = core.DatagramIterator(datagram).get_int32()
+            values.append(value)
+            if connections is not None:
+                connections[value // 10] = datagram.get_connection()
+
+    return sorted(values)
+
+
+@pytest.mark.parametrize("num_threads", [0, 2])
+def test_connection_reader_epoll(use_epoll, num_threads):
+    manager = net.QueuedConnectionManager()
+    listener = net.QueuedConnectionListener(manager, 0)
+    reader = net.QueuedConnectionReader(manager, num_threads)
+    writer = net.ConnectionWriter(manager, 0)
+
+    if not reader.is_using_epoll():
+        reader.shutdown()
+        pytest.skip("epoll is not available")
+
+    rendezvous, port = open_rendezvous(manager)
+    listener.add_connection(rendezvous)
+
+    clients = [manager.open_TCP_client_connection("127.0.0.1", port, 1000)
+               for i in range(4)]
+    assert None not in clients
+
+    # Accept the incoming connections.
+    accepted = 0
+    for i in range(300):
+        if accepted >= len(clients):
+            break
+        manager.wait_for_readers(0.01)
+        listener.poll()
+        while listener.new_connection_available():
+            new_connection = net.PointerToConnection()
+            assert listener.get_new_connection(new_connection)
+            assert reader.add_connection(new_connection.p())
+            accepted += 1
+    assert accepted == len(clients)
+
+    # Each datagram should be read exactly once, even though several arrive
+    # on each socket at once.
+    for i, client in enumerate(clients):
+        send_values(writer, client, i * 10, i * 10 + 1, i * 10 + 2)
+
+    connections = {}
+    values = read_values(manager, reader, 12, connections)
+    assert values == sorted(i * 10 + j for i in range(4) for j in range(3))
+    assert len(connections) == 4
+
+    # Closing a client is noticed as an end-of-file on the server side.
+    manager.close_connection(clients[0])
+    reset = None
+    for i in range(300):
+        manager.wait_for_readers(0.01)
+        reader.data_available()
+        if manager.reset_connection_available():
+            reset = net.PointerToConnection()
+            assert manager.get_reset_connection(reset)
+            break
+    assert reset is not None
+    assert reset.p() == connections[0]
+    manager.close_connection(reset.p())
+
+    # A removed connection is no longer read from.
+    assert reader.remove_connection(connections[1])
+    for i in (1, 2, 3):
+        send_values(writer, clients[i], i * 10 + 5)
+    assert read_values(manager, reader, 3) == [25, 35]
+
+    reader.shutdown()
+    manager.close_connection(rendezvous)
+
+
+@pytest.mark.parametrize("raw", [False, True])
+@pytest.mark.parametrize("batch_size", [1, 32])
+@pytest.mark.parametrize("pool_size", [0, 4])
+def test_connection_reader_udp(config_values, raw, batch_size, pool_size):
+    config_values("net-max-batch-size", batch_size)
+    config_values("net-datagram-pool-size", pool_size)
+
+    manager = net.QueuedConnectionManager()
+    reader = net.QueuedConnectionReader(manager, 0)
+    writer = net.ConnectionWriter(manager, 0)
+    reader.set_raw_mode(raw)
+    writer.set_raw_mode(raw)
+
+    incoming, port = open_udp_connection(manager)
+    outgoing = manager.open_UDP_connection()
+    assert reader.add_connection(incoming)
+
+    address = net.NetAddress()
+    assert address.set_host("127.0.0.1", port)
+
+    # The datagrams are sent a few at a time, so that several can be read
+    # with one call but the socket's buffer doesn't overflow.  All of them are
+    # held on to, so the reader can't reuse the buffers they were read into.
+    datagrams = []
+    for start in range(0, 200, 25):
+        for value in range(start, start + 25):
+            datagram = net.NetDatagram()
+            datagram.add_int32(value)
+            datagram.append_data(make_payload(value))
+            assert writer.send(datagram, outgoing, address)
+
+        datagrams += read_datagrams(manager, reader, start + 25 - len(datagrams))
+
+    values = []
+    for datagram in datagrams:
+        scan = core.DatagramIterator(datagram)
+        value = scan.get_int32()
+        assert scan.get_remaining_bytes() == make_payload(value)
+        values.append(value)
+
+    assert sorted(values) == list(range(200))
+
+    manager.close_connection(incoming)
+    manager.close_connection(outgoing)
+
+
+@pytest.mark.parametrize("raw", [False, True])
+@pytest.mark.parametrize("pool_size", [0, 4])
+def test_connection_reader_tcp(config_values, raw, pool_size):
+    config_values("net-datagram-pool-size", pool_size)
+    config_values("net-datagram-pool-max-buffer", 1000)
+
+    manager = net.QueuedConnectionManager()
+    listener = net.QueuedConnectionListener(manager, 0)
+    reader = net.QueuedConnectionReader(manager, 0)
+    writer = net.ConnectionWriter(manager, 0)
+    reader.set_raw_mode(raw)
+    writer.set_raw_mode(raw)
+
+    rendezvous, port = open_rendezvous(manager)
+    listener.add_connection(rendezvous)
+    client = manager.open_TCP_client_connection("127.0.0.1", port, 1000)
+    assert client is not None
+    server = accept_connection(manager, listener)
+    assert reader.add_connection(server)
+
+    # Some of these are too large to be kept in the pool afterwards.
+    sizes = [0, 1, 100, 999, 1000, 1001, 5000, 70000]
+    messages = [bytes((size * 3 + i) & 0xff for i in range(size))
+                for size in sizes]
+    for message in messages:
+        datagram = net.NetDatagram()
+        datagram.append_data(message)
+        assert writer.send(datagram, client)
+
+    if raw:
+        # Without the header, there's no telling where each datagram ends,
+        # but all of the bytes should come through in order.
+        received = b""
+        for i in range(300):
+            if len(received) >= sum(sizes):
+                break
+            received += b"".join(datagram.get_message() for datagram
+                                 in read_datagrams(manager, reader, 1))
+        assert received == b"".join(messages)
+    else:
+        datagrams = read_datagrams(manager, reader, len(sizes))
+        assert [datagram.get_message() for datagram in datagrams] == messages
+
+    manager.close_connection(client)
+    manager.close_connection(server)
+    manager.close_connection(rendezvous)
+
+
+@pytest.mark.parametrize("num_threads", [1, 2])
+def test_connection_writer_threaded(config_values, num_threads):
+    config_values("net-max-batch-size", 8)
+
+    manager = net.QueuedConnectionManager()
+    listener = net.QueuedConnectionListener(manager, 0)
+    reader = net.QueuedConnectionReader(manager, 0)
+    writer = net.ConnectionWriter(manager, num_threads)
+
+    rendezvous, port = open_rendezvous(manager)
+    listener.add_connection(rendezvous)
+
+    # Several TCP and UDP connections, each with its own receiving end, so
+    # the order in which the datagrams arrive can be checked per connection.
+    outgoing = []
+    incoming = []
+    for i in range(3):
+        client = manager.open_TCP_client_connection("127.0.0.1", port, 1000)
+        assert client is not None
+        server = accept_connection(manager, listener)
+        assert reader.add_connection(server)
+        outgoing.append((client, None))
+        incoming.append(server)
+
+    for i in range(3):
+        connection, udp_port = open_udp_connection(manager)
+        assert reader.add_connection(connection)
+        address = net.NetAddress()
+        assert address.set_host("127.0.0.1", udp_port)
+        outgoing.append((manager.open_UDP_connection(), address))
+        incoming.append(connection)
+
+    # The datagrams are queued all at once, so that the writer threads pick
+    # up several at a time for each connection.
+    num_values = 20
+    for value in range(num_values):
+        for i, (connection, address) in enumerate(outgoing):
+            datagram = net.NetDatagram()
+            datagram.add_int32(i * 1000 + value)
+            datagram.append_data(make_payload(i * 1000 + value))
+            if address is None:
+                assert writer.send(datagram, connection)
+            else:
+                assert writer.send(datagram, connection, address)
+
+    datagrams = read_datagrams(manager, reader, num_values * len(outgoing))
+
+    received = {}
+    for datagram in datagrams:
+        scan = core.DatagramIterator(datagram)
+        value = scan.get_int32()
+        assert scan.get_remaining_bytes() == make_payload(value)
+        i = incoming.index(datagram.get_connection())
+        received.setdefault(i, []).append(value)
+
+    for i in range(len(outgoing)):
+        assert received.get(i) == [i * 1000 + value for value in range(num_values)]
+
+    writer.shutdown()
+    for connection, address in outgoing:
+        manager.close_connection(connection)
+    for connection in incoming:
+        manager.close_connection(connection)
+    manager.close_connection(rendezvous)
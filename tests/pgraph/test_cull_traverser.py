@@ -0,0 +1,91 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture(scope='module')
+def cull_region(graphics_pipe):
+    """Creates and returns a DisplayRegion of an offscreen buffer."""
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    yield buffer.make_display_region()
+
+    if buffer is not None:
+        engine.remove_window(buffer)
+
+
+def cull_draw_order(region):
+    """Renders a scene of many subtrees into the given region, and returns the
+    names of the nodes that were drawn, in the order in which the cull
+    traversal passed them on."""
+
+    drawn = []
+
+    scene = core.NodePath("root")
+    scene.set_bin("unsorted", 0)
+
+    camera = scene.attach_new_node(core.Camera("camera"))
+    region.camera = camera
+
+    maker = core.CardMaker("card")
+    maker.set_frame(-0.1, 0.1, -0.1, 0.1)
+
+    for i in range(16):
+        branch = scene.attach_new_node("branch%d" % (i))
+
+        # Every third branch is behind the camera, and should be culled.
+        branch.set_pos((i % 4 - 1.5) * 0.5, -10 if i % 3 == 0 else 10, 0)
+
+        for j in range(4):
+            branch.attach_new_node(maker.generate()).set_x(j * 0.1 - 0.15)
+
+            name = "draw%d.%d" % (i, j)
+            callback = core.CallbackNode(name)
+            callback.set_bounds(core.BoundingSphere((0, 0, 0), 0.1))
+            callback.set_draw_callback(core.PythonCallbackObject(
+                lambda data, name=name: drawn.append(name)))
+            branch.attach_new_node(callback).set_x(j * 0.1 - 0.15)
+
+    region.window.engine.render_frame()
+    region.camera = core.NodePath()
+    return drawn
+
+
+def test_cull_parallel(cull_region, worker_thread_pool):
+    parallel_cull = core.ConfigVariableBool("parallel-cull")
+    min_vertices = core.ConfigVariableInt("parallel-cull-min-vertices")
+    old_parallel_cull = parallel_cull.value
+    old_min_vertices = min_vertices.value
+
+    try:
+        parallel_cull.value = False
+        serial = cull_draw_order(cull_region)
+
+        # Make every branch large enough to go to another thread.
+        parallel_cull.value = True
+        min_vertices.value = 1
+        parallel = cull_draw_order(cull_region)
+    finally:
+        parallel_cull.value = old_parallel_cull
+        min_vertices.value = old_min_vertices
+
+    assert len(serial) == 40
+    assert not any(name.startswith("draw0.") for name in serial)
+    assert parallel == serial
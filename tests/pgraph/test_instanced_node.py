@@ -0,0 +1,232 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture(scope='module')
+def instance_region(graphics_pipe):
+    """Creates and returns a DisplayRegion of an offscreen buffer."""
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+    fbprops.set_rgba_bits(8, 8, 8, 8)
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(128, 128),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    buffer.set_clear_color_active(True)
+    buffer.set_clear_color((0, 0, 0, 1))
+
+    yield buffer.make_display_region()
+
+    if buffer is not None:
+        engine.remove_window(buffer)
+
+
+@pytest.fixture
+def config_values():
+    """Restores any config variables that the test changes."""
+
+    saved = []
+
+    def set_value(var, value):
+        saved.append((var, var.value))
+        var.value = value
+
+    yield set_value
+
+    for var, value in reversed(saved):
+        var.value = value
+
+
+def instance_grid(count, singular=True):
+    """Returns the position, rotation and scale of each of a count by count
+    grid of instances.  The instances are spread out in depth as well, so that
+    some of them are beyond the far plane of the cull frustum.  If singular is
+    True, some have a zero scale, which is never in view."""
+
+    spacing = 14.0 / (count - 1)
+    for i in range(count):
+        for j in range(count):
+            k = i * count + j
+            pos = ((i - (count - 1) * 0.5) * spacing, 4 + (k % 5) * 8,
+                   (j - (count - 1) * 0.5) * spacing)
+            if singular and k % 11 == 0:
+                scale = (0, 0, 0)
+            else:
+                scale = (1, 1, 1 + (k % 3) * 0.5)
+            yield pos, (k * 17, 0, 0), scale
+
+
+def make_card(size, color=(1, 1, 1, 1)):
+    maker = core.CardMaker("card")
+    maker.set_frame(-size, size, -size, size)
+    maker.set_color(color)
+    card = core.NodePath(maker.generate())
+    card.set_two_sided(True)
+    return card
+
+
+def make_instanced_scene(count, clip_plane=False):
+    """Returns a scene with a grid of instances of an InstancedNode, each of
+    which holds a nested InstancedNode."""
+
+    scene = core.NodePath("root")
+
+    outer = core.InstancedNode("outer")
+    for pos, hpr, scale in instance_grid(count):
+        outer.instances.append(pos, hpr, scale)
+
+    spacing = 14.0 / (count - 1)
+    inner = core.InstancedNode("inner")
+    inner.instances.append((0, 0, 0))
+    inner.instances.append((spacing * 0.4, 0, spacing * 0.4))
+
+    inner_path = scene.attach_new_node(outer).attach_new_node(inner)
+    offset = inner_path.attach_new_node("offset")
+    offset.set_x(spacing * 0.1)
+    make_card(spacing * 0.15).reparent_to(offset)
+
+    if clip_plane:
+        # Clip planes don't cull instances, only the nodes below them.
+        plane = core.PlaneNode("plane", core.Plane((1, 0, 0), (0, 0, 0)))
+        scene.set_clip_plane(scene.attach_new_node(plane))
+
+    return scene
+
+
+def render_scene(region, scene, cull=True):
+    """Renders the scene and returns the contents of the framebuffer.  The
+    camera sees the whole grid of instances, but if cull is True, the scene is
+    culled against a narrower frustum, so only the instances that pass the
+    cull show up in the image."""
+
+    camera = scene.attach_new_node(core.Camera("camera"))
+    lens = core.OrthographicLens()
+    lens.set_film_size(16, 16)
+    lens.set_near_far(1, 100)
+    camera.node().set_lens(lens)
+
+    if cull:
+        cull_lens = core.PerspectiveLens()
+        cull_lens.set_fov(40)
+        cull_lens.set_near_far(1, 30)
+        camera.node().set_cull_bounds(cull_lens.make_bounds())
+    else:
+        camera.node().set_cull_bounds(core.OmniBoundingVolume())
+
+    region.camera = camera
+
+    texture = core.Texture("color")
+    region.window.add_render_texture(texture,
+                                     core.GraphicsOutput.RTM_copy_ram,
+                                     core.GraphicsOutput.RTP_color)
+    region.window.engine.render_frame()
+    region.window.clear_render_textures()
+    region.camera = core.NodePath()
+
+    return bytes(texture.get_ram_image())
+
+
+@pytest.mark.parametrize("clip_plane", [False, True])
+def test_instanced_node_cull_soa(instance_region, config_values, clip_plane):
+    instance_list_soa = core.ConfigVariableBool("instance-list-soa")
+
+    config_values(instance_list_soa, False)
+    scene = make_instanced_scene(8, clip_plane)
+    unculled = render_scene(instance_region, scene, cull=False)
+    scalar = render_scene(instance_region, make_instanced_scene(8, clip_plane))
+
+    config_values(instance_list_soa, True)
+    soa = render_scene(instance_region, make_instanced_scene(8, clip_plane))
+
+    assert any(scalar)
+    assert scalar != unculled
+    assert soa == scalar
+
+
+def test_instanced_node_fake_cull_soa(instance_region, config_values):
+    # The culled instances are drawn separately, after being removed from the
+    # instance list with without().
+    config_values(core.ConfigVariableBool("fake-view-frustum-cull"), True)
+    instance_list_soa = core.ConfigVariableBool("instance-list-soa")
+
+    config_values(instance_list_soa, False)
+    scalar = render_scene(instance_region, make_instanced_scene(8))
+
+    config_values(instance_list_soa, True)
+    soa = render_scene(instance_region, make_instanced_scene(8))
+
+    assert any(scalar)
+    assert soa == scalar
+
+
+def test_instanced_node_cull_clusters(instance_region, config_values):
+    # The instances are only clustered if there are enough of them.
+    config_values(core.ConfigVariableBool("instance-list-soa"), True)
+    cluster_size = core.ConfigVariableInt("instance-list-cluster-size")
+
+    config_values(cluster_size, 0)
+    unculled = render_scene(instance_region, make_instanced_scene(16), cull=False)
+    unclustered = render_scene(instance_region, make_instanced_scene(16))
+    assert any(unclustered)
+    assert unclustered != unculled
+
+    for size in (4, 32):
+        cluster_size.value = size
+        clustered = render_scene(instance_region, make_instanced_scene(16))
+        assert clustered == unclustered
+
+
+def make_lod_scene(instanced):
+    """Returns a scene with a grid of copies of an LODNode, either as instances
+    of an InstancedNode or as separate nodes.  The near level is red and the
+    far level is green."""
+
+    lod = core.LODNode("lod")
+    lod.add_switch(20, 0)
+    lod.add_switch(100, 20)
+    lod_path = core.NodePath(lod)
+    make_card(0.3, (1, 0, 0, 1)).reparent_to(lod_path)
+    make_card(0.3, (0, 1, 0, 1)).reparent_to(lod_path)
+
+    scene = core.NodePath("root")
+    if instanced:
+        instanced_node = core.InstancedNode("instances")
+        for pos, hpr, scale in instance_grid(8, singular=False):
+            instanced_node.instances.append(pos, hpr, scale)
+        lod_path.reparent_to(scene.attach_new_node(instanced_node))
+    else:
+        for pos, hpr, scale in instance_grid(8, singular=False):
+            instance = scene.attach_new_node("instance")
+            instance.set_pos_hpr_scale(pos, hpr, scale)
+            lod_path.instance_to(instance)
+
+    return scene
+
+
+@pytest.mark.parametrize("soa", [False, True])
+def test_instanced_node_lod(instance_region, config_values, soa):
+    config_values(core.ConfigVariableBool("instance-list-soa"), soa)
+
+    separate = render_scene(instance_region, make_lod_scene(False), cull=False)
+    instanced = render_scene(instance_region, make_lod_scene(True), cull=False)
+
+    # Both levels should be in use.  The image is stored in BGRA order.
+    colors = set(separate[i:i + 3] for i in range(0, len(separate), 4))
+    assert b'\x00\x00\xff' in colors
+    assert b'\x00\xff\x00' in colors
+
+    assert instanced == separate
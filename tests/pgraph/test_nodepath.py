@@ -227,6 +227,80 @@ def test_nodepath_flatten_tags_same_value():
     assert len(path.children) == 2
 
 
+def make_flatten_scene():
+    from panda3d.core import NodePath, GeomNode, Geom, GeomTriangles
+    from panda3d.core import GeomVertexData, GeomVertexFormat, GeomVertexWriter
+
+    # Some of the blocks share this subtree, which can't be flattened on
+    # another thread.
+    shared = NodePath("shared")
+    shared.attach_new_node("lamp").set_z(2)
+
+    root = NodePath("root")
+    city = root.attach_new_node("city")
+    for i in range(40):
+        block = city.attach_new_node("block%d" % i)
+        block.set_pos(i * 10, i % 3, 0)
+        if i % 5 == 0:
+            shared.instance_to(block)
+        for j in range(4):
+            vdata = GeomVertexData("tri", GeomVertexFormat.get_v3c4(), Geom.UH_static)
+            vertex = GeomVertexWriter(vdata, "vertex")
+            color = GeomVertexWriter(vdata, "color")
+            for k in range(3):
+                vertex.add_data3(j + k, k * 0.5, i)
+                color.add_data4(k / 3.0, j / 4.0, 1, 1)
+            tris = GeomTriangles(Geom.UH_static)
+            tris.add_vertices(0, 1, 2)
+            geom = Geom(vdata)
+            geom.add_primitive(tris)
+            node = GeomNode("geom%d" % j)
+            node.add_geom(geom)
+            if j % 2:
+                block.attach_new_node("group").attach_new_node(node)
+            else:
+                block.attach_new_node(node)
+    return root
+
+
+def flattened_contents(root):
+    contents = []
+    for path in root.find_all_matches("**"):
+        node = path.node()
+        entry = [path.get_name(), node.get_num_children()]
+        if node.is_geom_node():
+            for geom in node.get_geoms():
+                vdata = geom.get_vertex_data()
+                entry.append(vdata.get_num_rows())
+                for i in range(vdata.get_num_arrays()):
+                    entry.append(vdata.get_array(i).get_handle().get_data())
+                for prim in geom.get_primitives():
+                    entry.append(list(prim.get_vertex_list()))
+        contents.append(entry)
+    return contents
+
+
+def test_nodepath_flatten_parallel(worker_thread_pool):
+    from panda3d.core import ConfigVariableBool, ConfigVariableInt
+
+    serial = make_flatten_scene()
+    serial.flatten_strong()
+
+    parallel = ConfigVariableBool("parallel-flatten")
+    min_nodes = ConfigVariableInt("parallel-flatten-min-nodes")
+    old_values = parallel.get_value(), min_nodes.get_value()
+    parallel.set_value(True)
+    min_nodes.set_value(1)
+    try:
+        scene = make_flatten_scene()
+        scene.flatten_strong()
+    finally:
+        parallel.set_value(old_values[0])
+        min_nodes.set_value(old_values[1])
+
+    assert flattened_contents(scene) == flattened_contents(serial)
+
+
 def test_nodepath_python_tags():
     from panda3d.core import NodePath
 
@@ -1,4 +1,6 @@
+import pytest
 from panda3d.core import TransformState, Mat4, Mat3
+from panda3d.core import ConfigVariableBool, ConfigVariableDouble
 
 
 def test_transform_identity():
@@ -66,3 +68,45 @@ def test_transform_invalid():
 
     state2 = TransformState.make_invalid()
     assert state.this == state2.this
+
+
+def test_transform_cache_unique():
+    # Equivalent transforms must share a pointer, no matter which shard of
+    # the cache they end up in.
+    states = [TransformState.make_pos((i, i * 2, 0)) for i in range(200)]
+    for i, state in enumerate(states):
+        assert TransformState.make_pos((i, i * 2, 0)).this == state.this
+
+    cached = set(state.this for state in TransformState.get_states())
+    assert all(state.this in cached for state in states)
+    assert TransformState.get_num_states() >= len(states)
+    assert TransformState.validate_states()
+
+    # Collection may not remove states that are still referenced.
+    TransformState.garbage_collect()
+    for i, state in enumerate(states):
+        assert TransformState.make_pos((i, i * 2, 0)).this == state.this
+    assert TransformState.validate_states()
+
+
+def test_transform_garbage_collect_small_rate():
+    if not ConfigVariableBool("garbage-collect-states").value:
+        pytest.skip("garbage-collect-states is disabled")
+
+    # Even when the rate is too low to visit a single state of a shard per
+    # pass, every unreferenced state must still be collected eventually.
+    rate = ConfigVariableDouble("garbage-collect-states-rate")
+    old_rate = rate.value
+    rate.value = 0.001
+    try:
+        states = [TransformState.make_pos((i, -i, 0.5)) for i in range(20)]
+        pointers = set(state.this for state in states)
+        del states
+
+        for i in range(100):
+            TransformState.garbage_collect()
+
+        cached = set(state.this for state in TransformState.get_states())
+        assert not (pointers & cached)
+    finally:
+        rate.value = old_rate
@@ -1,3 +1,4 @@
+import pytest
 from panda3d.core import PNMImage, PNMImageHeader
 from random import randint
 
@@ -107,3 +108,85 @@ def test_pnmimage_mult_sub_image():
     assert final_color[0][1] == dst_color[0][1]
     assert final_color[1][0] == dst_color[1][0]
     assert final_color[1][1][0] == dst_color[1][1][0] * src_color[0] and final_color[1][1][1] == dst_color[1][1][1] * src_color[1] and final_color[1][1][2] == dst_color[1][1][2] * src_color[2]
+
+
+def test_pnmimage_filter_from():
+    # Large enough to be filtered on multiple threads.
+    src = PNMImage(600, 400, 4)
+    src.fill(0.25, 0.5, 0.75)
+    src.alpha_fill(1.0)
+    for x in range(600):
+        src.set_xel_a(x, 0, (1, 0, 0, 0))
+
+    for method in ("box_filter_from", "gaussian_filter_from"):
+        dest = PNMImage(301, 203, 4)
+        getattr(dest, method)(1.0, src)
+
+        # Away from the modified top row, the result should be uniform.
+        for y in (20, 100, 202):
+            for x in (0, 150, 300):
+                assert dest.get_xel_a(x, y).almost_equal((0.25, 0.5, 0.75, 1.0), 1 / 255.0)
+
+        # The top row is the same all the way across.
+        assert dest.get_xel_a(0, 0).almost_equal(dest.get_xel_a(150, 0), 1 / 255.0)
+        assert dest.get_xel_a(300, 0).almost_equal(dest.get_xel_a(150, 0), 1 / 255.0)
+        assert dest.get_red(150, 0) > 0.25
+
+    dest = PNMImage(300, 200, 4)
+    dest.quick_filter_from(src)
+    assert dest.get_xel_a(150, 100).almost_equal((0.25, 0.5, 0.75, 1.0), 1 / 255.0)
+    assert dest.get_xel_a(150, 0).almost_equal((0.625, 0.25, 0.375, 0.5), 1 / 255.0)
+
+
+# Filters a noisy gradient with the number of worker threads given on the
+# command line, and prints the value of every channel of every pixel.
+FILTER_SCRIPT = """
+import sys
+from panda3d.core import load_prc_file_data, PNMImage
+
+load_prc_file_data("", "worker-thread-pool-size " + sys.argv[1])
+
+src = PNMImage(600, 400, 4)
+for y in range(400):
+    for x in range(600):
+        noise = ((x * 37 + y * 91) % 101) / 100.0
+        src.set_xel_a(x, y, (x / 600.0, y / 400.0, noise, 1.0 - noise * 0.5))
+
+results = []
+for method in ("box_filter_from", "gaussian_filter_from"):
+    dest = PNMImage(301, 203, 4)
+    getattr(dest, method)(1.5, src)
+    results.append(dest)
+
+dest = PNMImage(300, 200, 4)
+dest.quick_filter_from(src)
+results.append(dest)
+
+for dest in results:
+    for y in range(dest.get_y_size()):
+        print(" ".join("%.5f %.5f %.5f %.5f" % tuple(dest.get_xel_a(x, y))
+                       for x in range(dest.get_x_size())))
+"""
+
+
+def test_pnmimage_filter_from_threads():
+    import subprocess
+    import sys
+
+    if sys.platform == "emscripten":
+        pytest.skip("cannot start a subprocess")
+
+    def filter_image(num_threads):
+        output = subprocess.check_output(
+            [sys.executable, "-c", FILTER_SCRIPT, str(num_threads)])
+        return [[float(value) for value in line.split()]
+                for line in output.decode().splitlines()]
+
+    # The image is large enough to be filtered on several threads, if there
+    # are any, and the result must be the same as without them.
+    serial = filter_image(0)
+    parallel = filter_image(4)
+    assert len(serial) == 203 * 2 + 200
+    assert len(parallel) == len(serial)
+    for serial_row, parallel_row in zip(serial, parallel):
+        assert parallel_row == pytest.approx(serial_row, abs=1e-4)
@@ -590,3 +590,115 @@ def test_task_get_sort(task_manager):
     t2.remove()
     tm.step()
     assert len(l) == 4
+
+
+def test_work_stealing_chain(task_manager):
+    tm = task_manager
+    # Don't start the threads until all of the tasks have been added.
+    tm.setupTaskChain(TASK_CHAIN_NAME, numThreads=0, workStealing=True)
+    chain = tm.mgr.findTaskChain(TASK_CHAIN_NAME)
+    assert chain.getWorkStealing()
+
+    l = []
+    def _testWorkStealing(sort, task):
+        l.append(sort)
+        return task.done
+
+    for i in range(200):
+        tm.add(_testWorkStealing, 'testWorkStealing', sort=i % 5, priority=i % 3,
+               extraArgs=[i % 5], appendTask=True, taskChain=TASK_CHAIN_NAME)
+    chain.setNumThreads(4)
+    chain.waitForTasks()
+
+    # Tasks with different sort values must never overlap.
+    assert len(l) == 200
+    assert l == sorted(l)
+    chain.stopThreads()
+
+
+def test_work_stealing_chain_priority(task_manager):
+    tm = task_manager
+    tm.setupTaskChain(TASK_CHAIN_NAME, numThreads=0, workStealing=True)
+    chain = tm.mgr.findTaskChain(TASK_CHAIN_NAME)
+
+    l = []
+    def _testWorkStealingPriority(priority, task):
+        l.append(priority)
+        return task.done
+
+    # With a single thread, nothing is stolen, so the tasks within one sort
+    # value are run strictly in order of decreasing priority.
+    for i in range(50):
+        priority = (i * 7) % 11
+        tm.add(_testWorkStealingPriority, 'testWorkStealingPriority', sort=0,
+               priority=priority, extraArgs=[priority], appendTask=True,
+               taskChain=TASK_CHAIN_NAME)
+    chain.setNumThreads(1)
+    chain.waitForTasks()
+
+    assert len(l) == 50
+    assert l == sorted(l, reverse=True)
+    chain.stopThreads()
+
+
+def test_work_stealing_chain_frame_budget(task_manager):
+    tm = task_manager
+    tm.setupTaskChain(TASK_CHAIN_NAME, numThreads=0, workStealing=True,
+                      frameBudget=0.001)
+    chain = tm.mgr.findTaskChain(TASK_CHAIN_NAME)
+    assert chain.getFrameBudget() == 0.001
+
+    l = []
+    def _testWorkStealingBudget(task):
+        core.Thread.sleep(0.005)
+        l.append(None)
+        return task.done
+
+    for i in range(8):
+        tm.add(_testWorkStealingBudget, 'testWorkStealingBudget',
+               taskChain=TASK_CHAIN_NAME)
+    chain.setNumThreads(2)
+
+    # Each task uses up the whole budget, so no more than one task per thread
+    # may be started in each frame.
+    counts = []
+    for i in range(100):
+        core.Thread.sleep(0.05)
+        counts.append(len(l))
+        if len(l) == 8:
+            break
+        tm.clock.tick()
+        tm.step()
+
+    assert len(l) == 8
+    assert counts[0] <= 2
+    for before, after in zip(counts, counts[1:]):
+        assert after - before <= 2
+    chain.stopThreads()
+
+
+def test_work_stealing_chain_timeslice_priority(task_manager):
+    tm = task_manager
+    tm.setupTaskChain(TASK_CHAIN_NAME, numThreads=0, workStealing=True,
+                      timeslicePriority=True)
+    chain = tm.mgr.findTaskChain(TASK_CHAIN_NAME)
+    assert chain.getTimeslicePriority()
+
+    counts = {1: 0, 4: 0}
+    def _testWorkStealingTimeslice(priority, task):
+        core.Thread.sleep(0.002)
+        counts[priority] += 1
+        return task.cont
+
+    # Both tasks take the same time to run, so the one with the higher
+    # priority should be given most of the time.
+    for priority in counts:
+        tm.add(_testWorkStealingTimeslice, 'testWorkStealingTimeslice',
+               priority=priority, extraArgs=[priority], appendTask=True,
+               taskChain=TASK_CHAIN_NAME)
+    chain.setNumThreads(2)
+    core.Thread.sleep(0.5)
+    chain.stopThreads()
+
+    assert counts[1] > 0
+    assert counts[4] > counts[1] * 2